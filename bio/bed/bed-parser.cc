@@ -109,6 +109,40 @@ auto BedParser::Next() -> absl::StatusOr<std::unique_ptr<BedEntry>> {
   }
 
   auto entry = std::make_unique<BedEntry>();
+  std::optional<std::string> line = NextFeatureLine();
+  if (line.has_value()) {
+    RETURN_IF_ERROR(ParseLine(*line, entry.get()));
+  }
+  return entry;
+}
+
+auto BedParser::NextSampled(const FractionalSampler& sampler)
+    -> absl::StatusOr<std::unique_ptr<BedEntry>> {
+  for (std::optional<std::string> line = NextFeatureLine(); line.has_value();
+       line = NextFeatureLine()) {
+    // Sample by the interval: the chrom, start and end fields. Names are
+    // often "." or shared by many entries.
+    absl::string_view key = *line;
+    const std::vector<absl::string_view> fields =
+        absl::StrSplit(key, absl::MaxSplits('\t', 3));
+    if (fields.size() > 3) {
+      key.remove_suffix(fields[3].size() + 1);
+    }
+    if (sampler.Keep(key)) {
+      auto entry = std::make_unique<BedEntry>();
+      RETURN_IF_ERROR(ParseLine(*line, entry.get()));
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+auto BedParser::Skip() -> absl::Status {
+  NextFeatureLine();
+  return absl::OkStatus();
+}
+
+auto BedParser::NextFeatureLine() -> std::optional<std::string> {
   for (std::optional<std::string> line = NextLine(); line.has_value();
        line = NextLine()) {
     if (line->empty() || absl::StartsWith(*line, kCommentPrefix) ||
@@ -116,88 +150,89 @@ auto BedParser::Next() -> absl::StatusOr<std::unique_ptr<BedEntry>> {
         absl::StartsWith(*line, kBrowserPrefix)) {
       continue;
     }
+    return line;
+  }
+  return std::nullopt;
+}
 
-    // Split line and check.
-    const std::vector<std::string> parts = absl::StrSplit(*line, '\t');
-    if (parts.size() < kMinBedFields) {
-      return absl::InvalidArgumentError(absl::StrFormat(
-          "Line %d: Expected at least %d fields but got only %d", line_number(),
-          kMinBedFields, parts.size()));
-    }
-    if (num_fields_ == 0) {
-      // If this is the first line that contains a feature, save the number of
-      // fields. All subsequent lines must contain the same number of fields.
-      num_fields_ = parts.size();
-    } else {
-      if (parts.size() != num_fields_) {
-        return absl::InvalidArgumentError(
-            absl::StrFormat("line %d: Expected %d fields but got %d",
-                            line_number(), num_fields_, parts.size()));
-      }
+auto BedParser::ParseLine(absl::string_view line,
+                          absl::Nonnull<BedEntry*> entry) -> absl::Status {
+  // Split line and check.
+  const std::vector<std::string> parts = absl::StrSplit(line, '\t');
+  if (parts.size() < kMinBedFields) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Line %d: Expected at least %d fields but got only %d", line_number(),
+        kMinBedFields, parts.size()));
+  }
+  if (num_fields_ == 0) {
+    // If this is the first line that contains a feature, save the number of
+    // fields. All subsequent lines must contain the same number of fields.
+    num_fields_ = parts.size();
+  } else {
+    if (parts.size() != num_fields_) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("line %d: Expected %d fields but got %d",
+                          line_number(), num_fields_, parts.size()));
     }
+  }
 
-    // Parse required fields.
-    entry->chromosome = parts[0];
-    ASSIGN_OR_RETURN(entry->start,
-                     ParseInt<uint64_t>(parts[1], "feature start"));
-    ASSIGN_OR_RETURN(entry->end, ParseInt<uint64_t>(parts[2], "feature end"));
-
-    // Parse optional fields.
-    if (parts.size() < 4) {
-      break;
-    }
-    entry->name = parts[3];
+  // Parse required fields.
+  entry->chromosome = parts[0];
+  ASSIGN_OR_RETURN(entry->start, ParseInt<uint64_t>(parts[1], "feature start"));
+  ASSIGN_OR_RETURN(entry->end, ParseInt<uint64_t>(parts[2], "feature end"));
 
-    if (parts.size() < 5) {
-      break;
-    }
-    ASSIGN_OR_RETURN(entry->score, ParseInt<uint32_t>(parts[4], "score"));
+  // Parse optional fields.
+  if (parts.size() < 4) {
+    return absl::OkStatus();
+  }
+  entry->name = parts[3];
 
-    if (parts.size() < 6) {
-      break;
-    }
-    ASSIGN_OR_RETURN(entry->strand, ParseStrand(parts[5]));
+  if (parts.size() < 5) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(entry->score, ParseInt<uint32_t>(parts[4], "score"));
 
-    if (parts.size() < 7) {
-      break;
-    }
-    ASSIGN_OR_RETURN(entry->thick_start,
-                     ParseInt<uint64_t>(parts[6], "thick start"));
+  if (parts.size() < 6) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(entry->strand, ParseStrand(parts[5]));
 
-    if (parts.size() < 8) {
-      break;
-    }
-    ASSIGN_OR_RETURN(entry->thick_end,
-                     ParseInt<uint64_t>(parts[7], "thick end"));
+  if (parts.size() < 7) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(entry->thick_start,
+                   ParseInt<uint64_t>(parts[6], "thick start"));
 
-    if (parts.size() < 9) {
-      break;
-    }
-    // TODO: Add validation for rgb
-    entry->item_rgb = parts[8];
+  if (parts.size() < 8) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(entry->thick_end, ParseInt<uint64_t>(parts[7], "thick end"));
 
-    // Block count, block sizes, and block starts are all required for BED12+
-    // files.
-    if (parts.size() < 10) {
-      break;
-    }
-    if (parts.size() != 12) {
-      return absl::InvalidArgumentError(absl::StrFormat(
-          "Line %d: Expected 12 fields but got %d. Block count, block sizes, "
-          "and block starts are all required for BED12+",
-          line_number(), parts.size()));
-    }
-    ASSIGN_OR_RETURN(const uint64_t block_count,
-                     ParseInt<uint64_t>(parts[9], "block size"));
-    const std::string block_sizes = parts[10];
-    const std::string block_starts = parts[11];
-    ASSIGN_OR_RETURN(
-        entry->sub_blocks,
-        ParseSubBlocks(line_number(), block_count, block_sizes, block_starts));
-    break;
+  if (parts.size() < 9) {
+    return absl::OkStatus();
   }
+  // TODO: Add validation for rgb
+  entry->item_rgb = parts[8];
 
-  return entry;
+  // Block count, block sizes, and block starts are all required for BED12+
+  // files.
+  if (parts.size() < 10) {
+    return absl::OkStatus();
+  }
+  if (parts.size() != 12) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Line %d: Expected 12 fields but got %d. Block count, block sizes, "
+        "and block starts are all required for BED12+",
+        line_number(), parts.size()));
+  }
+  ASSIGN_OR_RETURN(const uint64_t block_count,
+                   ParseInt<uint64_t>(parts[9], "block size"));
+  const std::string block_sizes = parts[10];
+  const std::string block_starts = parts[11];
+  ASSIGN_OR_RETURN(
+      entry->sub_blocks,
+      ParseSubBlocks(line_number(), block_count, block_sizes, block_starts));
+  return absl::OkStatus();
 }
 
 }  // namespace bio
@@ -17,13 +17,17 @@
 
 #include <cstdlib>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "bio/bed/bed.h"
 #include "bio/common/line-parser-base.h"
+#include "bio/common/sampler.h"
 #include "gxl/file/file.h"
 
 namespace bio {
@@ -46,7 +50,26 @@ class BedParser : public LineParserBase {
   // Returns the next BED entry from the file.
   auto Next() -> absl::StatusOr<std::unique_ptr<BedEntry>>;
 
+  // Returns the next BED entry that `sampler` keeps, or nullptr at the end of
+  // the file. Entries are sampled by their chrom, start and end fields, so
+  // entries are kept independently even when they share a name. Rejected
+  // lines are not parsed or validated.
+  auto NextSampled(const FractionalSampler& sampler)
+      -> absl::StatusOr<std::unique_ptr<BedEntry>>;
+
+  // Skips the next BED entry without parsing it. Always returns OK; the
+  // status matches FastqParser::Skip(), which can fail on a truncated entry.
+  auto Skip() -> absl::Status;
+
  private:
+  // Returns the next feature line, skipping comment, track, browser and empty
+  // lines, or std::nullopt at the end of the file.
+  auto NextFeatureLine() -> std::optional<std::string>;
+
+  // Parses a feature line into `entry`.
+  auto ParseLine(absl::string_view line, absl::Nonnull<BedEntry*> entry)
+      -> absl::Status;
+
   // Used to track the number of BED fields used by the file and whether
   // subsequent lines contain the same number of fields.
   int num_fields_;
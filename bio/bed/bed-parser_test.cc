@@ -14,13 +14,18 @@
 
 #include "bio/bed/bed-parser.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "bio/bed/bed.h"
+#include "bio/common/sampler.h"
 #include "bio/common/sequence.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -360,5 +365,66 @@ TEST(BedParser, NextBed12) {
   }
 }
 
+TEST(BedParser, NextSampled) {
+  for (uint64_t seed = 0; seed < 8; ++seed) {
+    std::unique_ptr<BedParser> parser =
+        BedParser::NewOrDie("bio/bed/testdata/bed6-genome-browser.bed");
+    const FractionalSampler sampler = *FractionalSampler::New(0.5, seed);
+    std::vector<std::string> expected;
+    for (const auto& [name, interval] :
+         {std::pair{"Pos1", "chr7\t127471196\t127472363"},
+          std::pair{"Neg1", "chr7\t127475864\t127477031"}}) {
+      if (sampler.Keep(interval)) {
+        expected.push_back(name);
+      }
+    }
+    std::vector<std::string> actual;
+    while (true) {
+      absl::StatusOr<std::unique_ptr<BedEntry>> entry =
+          parser->NextSampled(sampler);
+      ASSERT_THAT(entry, IsOk());
+      if (*entry == nullptr) {
+        break;
+      }
+      actual.push_back((*entry)->name.value_or(""));
+    }
+    EXPECT_EQ(actual, expected) << seed;
+  }
+}
+
+TEST(BedParser, NextSampledUnnamed) {
+  // The entries are all named ".", so sampling by name would keep all or none
+  // of them.
+  std::unique_ptr<BedParser> parser =
+      BedParser::NewOrDie("bio/bed/testdata/bed6-unnamed.bed");
+  const FractionalSampler sampler = *FractionalSampler::New(0.5, 1);
+  std::vector<uint64_t> starts;
+  while (true) {
+    absl::StatusOr<std::unique_ptr<BedEntry>> entry =
+        parser->NextSampled(sampler);
+    ASSERT_THAT(entry, IsOk());
+    if (*entry == nullptr) {
+      break;
+    }
+    starts.push_back((*entry)->start);
+  }
+  EXPECT_GT(starts.size(), 0);
+  EXPECT_LT(starts.size(), 20);
+  for (uint64_t start : starts) {
+    EXPECT_TRUE(sampler.Keep(absl::StrCat("chr1\t", start, "\t", start + 500)))
+        << start;
+  }
+}
+
+TEST(BedParser, Skip) {
+  std::unique_ptr<BedParser> parser =
+      BedParser::NewOrDie("bio/bed/testdata/bed6-genome-browser.bed");
+  ASSERT_THAT(parser->Skip(), IsOk());
+  absl::StatusOr<std::unique_ptr<BedEntry>> entry = parser->Next();
+  ASSERT_THAT(entry, IsOk());
+  ASSERT_NE(*entry, nullptr);
+  EXPECT_EQ((*entry)->name, "Neg1");
+}
+
 }  // namespace
 }  // namespace bio
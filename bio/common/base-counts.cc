@@ -0,0 +1,156 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/base-counts.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+#include "absl/strings/string_view.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+// Counts the bases in `sequence` one byte at a time.
+auto CountBasesScalar(absl::string_view sequence, BaseCounts* counts) -> void {
+  for (char base : sequence) {
+    switch (base) {
+      case 'A':
+      case 'a':
+        ++counts->a;
+        break;
+      case 'C':
+      case 'c':
+        ++counts->c;
+        break;
+      case 'G':
+      case 'g':
+        ++counts->g;
+        break;
+      case 'T':
+      case 't':
+        ++counts->t;
+        break;
+      case 'N':
+      case 'n':
+        ++counts->n;
+        break;
+      default:
+        break;
+    }
+    if (base >= 'a' && base <= 'z') {
+      ++counts->soft_masked;
+    }
+  }
+}
+
+#if defined(__SSE2__)
+
+// The number of 16-byte vectors that can be accumulated in 8-bit lanes before
+// a lane could overflow.
+static constexpr size_t kMaxVectorsPerBlock = 255;
+
+// Returns the sum of the 16 8-bit lanes of `v`.
+auto SumLanes(__m128i v) -> uint64_t {
+  const __m128i sums = _mm_sad_epu8(v, _mm_setzero_si128());
+  return static_cast<uint64_t>(_mm_cvtsi128_si32(sums)) +
+         static_cast<uint64_t>(_mm_extract_epi16(sums, 4));
+}
+
+// Counts the bases in the longest prefix of `sequence` whose size is a multiple
+// of 16 and returns the size of that prefix.
+auto CountBasesSse2(absl::string_view sequence, BaseCounts* counts) -> size_t {
+  const __m128i case_mask = _mm_set1_epi8(static_cast<char>(0xdf));
+  const __m128i a = _mm_set1_epi8('A');
+  const __m128i c = _mm_set1_epi8('C');
+  const __m128i g = _mm_set1_epi8('G');
+  const __m128i t = _mm_set1_epi8('T');
+  const __m128i n = _mm_set1_epi8('N');
+  const __m128i before_lower = _mm_set1_epi8('a' - 1);
+  const __m128i after_lower = _mm_set1_epi8('z' + 1);
+
+  const size_t size = sequence.size() - sequence.size() % 16;
+  size_t i = 0;
+  while (i < size) {
+    __m128i a_counts = _mm_setzero_si128();
+    __m128i c_counts = _mm_setzero_si128();
+    __m128i g_counts = _mm_setzero_si128();
+    __m128i t_counts = _mm_setzero_si128();
+    __m128i n_counts = _mm_setzero_si128();
+    __m128i lower_counts = _mm_setzero_si128();
+    const size_t block_end = std::min(size, i + 16 * kMaxVectorsPerBlock);
+    for (; i < block_end; i += 16) {
+      const __m128i bytes = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(sequence.data() + i));
+      // Clearing bit 5 maps lowercase letters to uppercase; the only other
+      // byte that maps to an uppercase letter is the letter itself.
+      const __m128i upper = _mm_and_si128(bytes, case_mask);
+      // Matching lanes are all ones (-1), so subtracting the mask increments
+      // the count.
+      a_counts = _mm_sub_epi8(a_counts, _mm_cmpeq_epi8(upper, a));
+      c_counts = _mm_sub_epi8(c_counts, _mm_cmpeq_epi8(upper, c));
+      g_counts = _mm_sub_epi8(g_counts, _mm_cmpeq_epi8(upper, g));
+      t_counts = _mm_sub_epi8(t_counts, _mm_cmpeq_epi8(upper, t));
+      n_counts = _mm_sub_epi8(n_counts, _mm_cmpeq_epi8(upper, n));
+      const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(bytes, before_lower),
+                                          _mm_cmplt_epi8(bytes, after_lower));
+      lower_counts = _mm_sub_epi8(lower_counts, lower);
+    }
+    counts->a += SumLanes(a_counts);
+    counts->c += SumLanes(c_counts);
+    counts->g += SumLanes(g_counts);
+    counts->t += SumLanes(t_counts);
+    counts->n += SumLanes(n_counts);
+    counts->soft_masked += SumLanes(lower_counts);
+  }
+  return size;
+}
+
+#endif  // defined(__SSE2__)
+
+}  // namespace
+
+auto BaseCounts::operator+=(const BaseCounts& rhs) -> BaseCounts& {
+  a += rhs.a;
+  c += rhs.c;
+  g += rhs.g;
+  t += rhs.t;
+  n += rhs.n;
+  other += rhs.other;
+  soft_masked += rhs.soft_masked;
+  return *this;
+}
+
+auto BaseCounts::operator==(const BaseCounts& rhs) const -> bool {
+  return a == rhs.a && c == rhs.c && g == rhs.g && t == rhs.t && n == rhs.n &&
+         other == rhs.other && soft_masked == rhs.soft_masked;
+}
+
+auto CountBases(absl::string_view sequence) -> BaseCounts {
+  BaseCounts counts;
+  size_t counted = 0;
+#if defined(__SSE2__)
+  counted = CountBasesSse2(sequence, &counts);
+#endif
+  CountBasesScalar(sequence.substr(counted), &counts);
+  counts.other = sequence.size() - (counts.acgt() + counts.n);
+  return counts;
+}
+
+}  // namespace bio
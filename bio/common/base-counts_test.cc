@@ -0,0 +1,103 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/base-counts.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+// Counts the bases in `sequence` one character at a time.
+auto NaiveCountBases(const std::string& sequence) -> BaseCounts {
+  BaseCounts counts;
+  for (char base : sequence) {
+    switch (base) {
+      case 'A':
+      case 'a':
+        ++counts.a;
+        break;
+      case 'C':
+      case 'c':
+        ++counts.c;
+        break;
+      case 'G':
+      case 'g':
+        ++counts.g;
+        break;
+      case 'T':
+      case 't':
+        ++counts.t;
+        break;
+      case 'N':
+      case 'n':
+        ++counts.n;
+        break;
+      default:
+        ++counts.other;
+        break;
+    }
+    if (base >= 'a' && base <= 'z') {
+      ++counts.soft_masked;
+    }
+  }
+  return counts;
+}
+
+TEST(CountBases, Empty) {
+  const BaseCounts counts = CountBases("");
+  EXPECT_EQ(counts, BaseCounts());
+  EXPECT_EQ(counts.total(), 0);
+  EXPECT_EQ(counts.gc_fraction(), 0.0);
+}
+
+TEST(CountBases, Short) {
+  const BaseCounts counts = CountBases("ACGTacgtNnRY");
+  EXPECT_EQ(counts.a, 2);
+  EXPECT_EQ(counts.c, 2);
+  EXPECT_EQ(counts.g, 2);
+  EXPECT_EQ(counts.t, 2);
+  EXPECT_EQ(counts.n, 2);
+  EXPECT_EQ(counts.other, 2);
+  EXPECT_EQ(counts.soft_masked, 5);
+  EXPECT_EQ(counts.total(), 12);
+  EXPECT_EQ(counts.acgt(), 8);
+  EXPECT_DOUBLE_EQ(counts.gc_fraction(), 0.5);
+}
+
+TEST(CountBases, MatchesNaive) {
+  // Includes every byte value and is long enough to overflow 8-bit lane
+  // counters if they were not flushed.
+  std::string sequence;
+  for (int i = 0; i < 20000; ++i) {
+    sequence.push_back(static_cast<char>((i * 7919) % 256));
+    sequence.append("ACGTNacgtn");
+  }
+  for (size_t size : {1, 15, 16, 17, 100, 4079, 4080, 4081, 70000}) {
+    const std::string prefix = sequence.substr(0, size);
+    EXPECT_EQ(CountBases(prefix), NaiveCountBases(prefix)) << "size " << size;
+  }
+  EXPECT_EQ(CountBases(sequence), NaiveCountBases(sequence));
+}
+
+TEST(BaseCounts, Add) {
+  BaseCounts counts = CountBases("ACGT");
+  counts += CountBases("nnxx");
+  EXPECT_EQ(counts, CountBases("ACGTnnxx"));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,108 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf-file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/gzi-index.h"
+#include "bio/common/random-access-file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+
+auto BgzfFile::New(absl::string_view path, absl::string_view gzi_path,
+                   size_t cache_blocks)
+    -> absl::StatusOr<std::unique_ptr<BgzfFile>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<RandomAccessFile> file,
+                   RandomAccessFile::New(path));
+  absl::StatusOr<GziIndex> index = GziIndex::Read(gzi_path);
+  if (absl::IsNotFound(index.status())) {
+    index = GziIndex::Build(*file);
+  }
+  if (!index.ok()) {
+    return index.status();
+  }
+  return std::unique_ptr<BgzfFile>(
+      new BgzfFile(std::move(file), *std::move(index), cache_blocks));
+}
+
+auto BgzfFile::Read(uint64_t offset, size_t size, std::string* out) const
+    -> absl::Status {
+  out->clear();
+  out->reserve(size);
+  const GziEntry& entry = index_.Find(offset);
+  uint64_t compressed_offset = entry.compressed_offset;
+  uint64_t block_start = entry.uncompressed_offset;
+  while (out->size() < size) {
+    if (compressed_offset >= file_->size()) {
+      return absl::OutOfRangeError(absl::StrFormat(
+          "%s: expected %d bytes at offset %d but the data ends after %d",
+          file_->path(), size, offset, out->size()));
+    }
+    ASSIGN_OR_RETURN(std::shared_ptr<const Block> block,
+                     GetBlock(compressed_offset));
+    const uint64_t position = offset + out->size();
+    if (position < block_start + block->data.size()) {
+      const size_t skip = position - block_start;
+      out->append(block->data, skip,
+                  std::min(size - out->size(), block->data.size() - skip));
+    }
+    compressed_offset += block->compressed_size;
+    block_start += block->data.size();
+  }
+  return absl::OkStatus();
+}
+
+auto BgzfFile::GetBlock(uint64_t compressed_offset) const
+    -> absl::StatusOr<std::shared_ptr<const Block>> {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (std::shared_ptr<const Block>* block = cache_.Get(compressed_offset);
+        block != nullptr) {
+      return *block;
+    }
+  }
+
+  // Decompress without holding the lock so that other threads can read other
+  // blocks. Two threads that miss on the same block both decompress it.
+  std::string compressed;
+  RETURN_IF_ERROR(file_->Read(compressed_offset,
+                              std::min<uint64_t>(kBgzfHeaderSize,
+                                                 file_->size() -
+                                                     compressed_offset),
+                              &compressed));
+  ASSIGN_OR_RETURN(const size_t block_size, BgzfBlockSize(compressed));
+  RETURN_IF_ERROR(file_->Read(compressed_offset, block_size, &compressed));
+  auto block = std::make_shared<Block>();
+  block->compressed_size = block_size;
+  RETURN_IF_ERROR(InflateBgzfBlock(compressed, &block->data));
+
+  absl::MutexLock lock(&mutex_);
+  cache_.Put(compressed_offset, block);
+  return block;
+}
+
+}  // namespace bio
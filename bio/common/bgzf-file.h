@@ -0,0 +1,104 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_BGZF_FILE_H_
+#define BIO_COMMON_BGZF_FILE_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/gzi-index.h"
+#include "bio/common/lru-cache.h"
+#include "bio/common/random-access-file.h"
+
+namespace bio {
+
+// A BGZF-compressed file that supports reads at offsets in the uncompressed
+// stream. A read decompresses only the blocks that overlap it, located with a
+// .gzi index, and recently decompressed blocks are kept in a bounded LRU cache.
+//
+// Reads may be issued from several threads at once.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<BgzfFile> file,
+//                  BgzfFile::New("path/to/in.fa.gz", "path/to/in.fa.gz.gzi"));
+// std::string buffer;
+// RETURN_IF_ERROR(file->Read(/*offset=*/1 << 20, /*size=*/100, &buffer));
+// ```
+class BgzfFile {
+ public:
+  // The default number of decompressed blocks kept in the cache.
+  static constexpr size_t kDefaultCacheBlocks = 64;
+
+  // Opens the BGZF file at `path` with the .gzi index at `gzi_path`. If
+  // `gzi_path` does not exist, the index is built by scanning the block
+  // headers. At most `cache_blocks` decompressed blocks, each at most 64 KiB,
+  // are cached.
+  static auto New(absl::string_view path, absl::string_view gzi_path,
+                  size_t cache_blocks = kDefaultCacheBlocks)
+      -> absl::StatusOr<std::unique_ptr<BgzfFile>>;
+
+  BgzfFile(const BgzfFile&) = delete;
+  auto operator=(const BgzfFile&) -> BgzfFile& = delete;
+
+  // Reads `size` bytes of uncompressed data starting at uncompressed `offset`
+  // into `out`, replacing its contents. Returns an OutOfRange error if the
+  // data ends before `size` bytes have been read.
+  auto Read(uint64_t offset, size_t size, std::string* out) const
+      -> absl::Status;
+
+  // Returns the block index.
+  auto index() const -> const GziIndex& { return index_; }
+
+ private:
+  // A decompressed block.
+  struct Block {
+    std::string data;
+
+    // The size of the compressed block in the file.
+    size_t compressed_size;
+  };
+
+  BgzfFile(std::unique_ptr<RandomAccessFile> file, GziIndex index,
+           size_t cache_blocks)
+      : file_(std::move(file)),
+        index_(std::move(index)),
+        cache_(cache_blocks) {}
+
+  // Returns the decompressed block at `compressed_offset`, from the cache if
+  // possible.
+  auto GetBlock(uint64_t compressed_offset) const
+      -> absl::StatusOr<std::shared_ptr<const Block>>;
+
+  std::unique_ptr<RandomAccessFile> file_;
+  GziIndex index_;
+
+  mutable absl::Mutex mutex_;
+  mutable LruCache<uint64_t, std::shared_ptr<const Block>> cache_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_BGZF_FILE_H_
@@ -0,0 +1,116 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf-file.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/test-files.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+// The uncompressed size of each block of the test file.
+static constexpr size_t kBlockSize = 1000;
+
+// Writes `data` to a BGZF file of kBlockSize blocks and returns its path.
+auto WriteBgzf(const std::string& name, const std::string& data)
+    -> std::string {
+  std::string contents;
+  for (size_t i = 0; i < data.size(); i += kBlockSize) {
+    EXPECT_THAT(DeflateBgzfBlock(data.substr(i, kBlockSize), 6, &contents),
+                IsOk());
+  }
+  contents.append(BgzfEofBlock());
+  return WriteTempFile(name, contents);
+}
+
+auto TestData() -> std::string {
+  std::string data;
+  for (int i = 0; data.size() < 10 * kBlockSize + 123; ++i) {
+    data.append(std::to_string(i));
+  }
+  return data;
+}
+
+TEST(BgzfFile, ReadAcrossBlocks) {
+  const std::string data = TestData();
+  const std::string path = WriteBgzf("read.gz", data);
+  absl::StatusOr<std::unique_ptr<BgzfFile>> file =
+      BgzfFile::New(path, path + ".gzi", /*cache_blocks=*/2);
+  ASSERT_THAT(file, IsOk());
+  EXPECT_EQ((*file)->index().entries().size(), 11);
+
+  std::string buffer;
+  for (const auto& [offset, size] : std::vector<std::pair<size_t, size_t>>{
+           {0, 10}, {995, 10}, {1000, 1000}, {2500, 5000}, {0, data.size()},
+           {data.size() - 1, 1}, {data.size(), 0}}) {
+    ASSERT_THAT((*file)->Read(offset, size, &buffer), IsOk());
+    EXPECT_EQ(buffer, data.substr(offset, size))
+        << "offset " << offset << " size " << size;
+  }
+  EXPECT_THAT((*file)->Read(data.size() - 5, 10, &buffer),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(BgzfFile, ReadsWithGziFile) {
+  const std::string data = TestData();
+  const std::string path = WriteBgzf("with-gzi.gz", data);
+  std::unique_ptr<BgzfFile> built = *BgzfFile::New(path, path + ".gzi");
+  WriteTempFile("with-gzi.gz.gzi", built->index().Serialize());
+
+  absl::StatusOr<std::unique_ptr<BgzfFile>> file =
+      BgzfFile::New(path, path + ".gzi");
+  ASSERT_THAT(file, IsOk());
+  EXPECT_EQ((*file)->index().entries(), built->index().entries());
+  std::string buffer;
+  ASSERT_THAT((*file)->Read(4321, 100, &buffer), IsOk());
+  EXPECT_EQ(buffer, data.substr(4321, 100));
+}
+
+TEST(BgzfFile, ConcurrentReads) {
+  const std::string data = TestData();
+  const std::string path = WriteBgzf("concurrent.gz", data);
+  std::unique_ptr<BgzfFile> file =
+      *BgzfFile::New(path, path + ".gzi", /*cache_blocks=*/3);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&file, &data, t]() {
+      std::string buffer;
+      for (size_t offset = t * 7; offset + 300 < data.size(); offset += 97) {
+        ASSERT_THAT(file->Read(offset, 300, &buffer), IsOk());
+        ASSERT_EQ(buffer, data.substr(offset, 300));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,169 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf-reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The maximum number of batches in flight per thread.
+static constexpr size_t kPendingBatchesPerThread = 2;
+
+// Decompresses the consecutive BGZF blocks in `blocks`.
+auto InflateBlocks(absl::string_view blocks) -> absl::StatusOr<std::string> {
+  std::string data;
+  std::string block_data;
+  while (!blocks.empty()) {
+    ASSIGN_OR_RETURN(const size_t size, BgzfBlockSize(blocks));
+    RETURN_IF_ERROR(InflateBgzfBlock(blocks.substr(0, size), &block_data));
+    data.append(block_data);
+    blocks.remove_prefix(size);
+  }
+  return data;
+}
+
+}  // namespace
+
+BgzfReader::BgzfReader(absl::Nonnull<gxl::File*> file,
+                       const BgzfReaderOptions& options)
+    : file_(file),
+      options_(options),
+      pool_(std::make_unique<ThreadPool>(options.num_threads)),
+      queue_(std::make_unique<TaskQueue<Batch>>(pool_.get())) {
+  options_.blocks_per_task = std::max<size_t>(options_.blocks_per_task, 1);
+}
+
+BgzfReader::~BgzfReader() {
+  queue_.reset();
+  file_->Close(gxl::file::Defaults()).IgnoreError();
+}
+
+auto BgzfReader::New(absl::string_view path, const BgzfReaderOptions& options)
+    -> absl::StatusOr<std::unique_ptr<BgzfReader>> {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
+  return std::make_unique<BgzfReader>(file, options);
+}
+
+auto BgzfReader::Read(size_t size, std::string* out) -> absl::Status {
+  RETURN_IF_ERROR(status_);
+  out->clear();
+  while (out->size() < size) {
+    if (batch_offset_ == batch_.size()) {
+      absl::StatusOr<bool> more = NextBatch();
+      if (!more.ok()) {
+        status_ = more.status();
+        return status_;
+      }
+      if (!*more) {
+        break;
+      }
+      continue;
+    }
+    const size_t n =
+        std::min(size - out->size(), batch_.size() - batch_offset_);
+    out->append(batch_, batch_offset_, n);
+    batch_offset_ += n;
+  }
+  position_ += out->size();
+  return absl::OkStatus();
+}
+
+auto BgzfReader::NextBatch() -> absl::StatusOr<bool> {
+  const size_t max_pending = kPendingBatchesPerThread * pool_->num_threads();
+  while (!file_eof_ && queue_->pending() < max_pending) {
+    std::string blocks;
+    const absl::Status status = ReadBlocks(&blocks);
+    if (!blocks.empty()) {
+      queue_->Submit([blocks = std::move(blocks)]() {
+        absl::StatusOr<std::string> data = InflateBlocks(blocks);
+        if (!data.ok()) {
+          return Batch{.status = data.status()};
+        }
+        return Batch{.data = *std::move(data)};
+      });
+    }
+    if (!status.ok()) {
+      // Hand the error back after the blocks that were read before it.
+      file_eof_ = true;
+      queue_->Submit([status]() { return Batch{.status = status}; });
+    }
+  }
+  std::optional<Batch> batch = queue_->Next();
+  if (!batch.has_value()) {
+    return false;
+  }
+  RETURN_IF_ERROR(batch->status);
+  batch_ = std::move(batch->data);
+  batch_offset_ = 0;
+  return true;
+}
+
+auto BgzfReader::ReadBlocks(std::string* out) -> absl::Status {
+  std::string block;
+  for (size_t i = 0; i < options_.blocks_per_task && !file_eof_; ++i) {
+    RETURN_IF_ERROR(ReadBlock(&block));
+    out->append(block);
+  }
+  return absl::OkStatus();
+}
+
+auto BgzfReader::ReadBlock(std::string* out) -> absl::Status {
+  out->resize(kBgzfHeaderSize);
+  const size_t header_size = file_->Read(out->data(), kBgzfHeaderSize);
+  if (header_size == 0) {
+    file_eof_ = true;
+    out->clear();
+    return absl::OkStatus();
+  }
+  if (header_size < kBgzfHeaderSize) {
+    return absl::DataLossError(absl::StrFormat(
+        "Offset %d: Truncated BGZF block header", file_offset_));
+  }
+  absl::StatusOr<size_t> size = BgzfBlockSize(*out);
+  if (!size.ok()) {
+    return absl::Status(size.status().code(),
+                        absl::StrFormat("Offset %d: %s", file_offset_,
+                                        size.status().message()));
+  }
+  out->resize(*size);
+  const size_t rest = *size - kBgzfHeaderSize;
+  if (file_->Read(out->data() + kBgzfHeaderSize, rest) < rest) {
+    return absl::DataLossError(
+        absl::StrFormat("Offset %d: Truncated BGZF block", file_offset_));
+  }
+  file_offset_ += *size;
+  return absl::OkStatus();
+}
+
+}  // namespace bio
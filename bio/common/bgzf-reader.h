@@ -0,0 +1,116 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_BGZF_READER_H_
+#define BIO_COMMON_BGZF_READER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+
+// Options for BgzfReader.
+struct BgzfReaderOptions {
+  // The number of threads that decompress blocks.
+  size_t num_threads = 4;
+
+  // The number of BGZF blocks decompressed together by a single task.
+  size_t blocks_per_task = 16;
+};
+
+// Reader for the uncompressed stream of a BGZF file, such as a BAM file. The
+// file is read sequentially on the calling thread and batches of blocks are
+// decompressed ahead of the reader on a pool of threads.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<BgzfReader> reader,
+//                  BgzfReader::New("path/to/in.bam", {.num_threads = 8}));
+// std::string magic;
+// RETURN_IF_ERROR(reader->Read(4, &magic));
+// ```
+class BgzfReader {
+ public:
+  BgzfReader(absl::Nonnull<gxl::File*> file, const BgzfReaderOptions& options);
+
+  // Waits for any blocks being decompressed and closes the file.
+  ~BgzfReader();
+
+  BgzfReader(const BgzfReader&) = delete;
+  auto operator=(const BgzfReader&) -> BgzfReader& = delete;
+
+  // Opens the BGZF file at `path`.
+  static auto New(absl::string_view path, const BgzfReaderOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<BgzfReader>>;
+
+  // Reads up to `size` bytes of uncompressed data into `out`, replacing its
+  // contents. Fewer than `size` bytes are read only at the end of the stream.
+  // Once an error has been returned, every later call returns it as well.
+  auto Read(size_t size, std::string* out) -> absl::Status;
+
+  // Returns the number of uncompressed bytes read so far.
+  auto tell() const -> uint64_t { return position_; }
+
+ private:
+  // The decompressed contents of a batch of blocks.
+  struct Batch {
+    absl::Status status;
+    std::string data;
+  };
+
+  // Appends up to BgzfReaderOptions::blocks_per_task complete compressed
+  // blocks to `out`. On error, `out` holds the blocks read before it.
+  auto ReadBlocks(std::string* out) -> absl::Status;
+
+  // Reads the next complete compressed block into `out`, replacing its
+  // contents. `out` is left empty at the end of the file.
+  auto ReadBlock(std::string* out) -> absl::Status;
+
+  // Moves on to the next decompressed batch. Returns false at the end of the
+  // stream.
+  auto NextBatch() -> absl::StatusOr<bool>;
+
+  gxl::File* file_;
+  BgzfReaderOptions options_;
+  bool file_eof_ = false;
+
+  // The offset of the next compressed block in the file.
+  uint64_t file_offset_ = 0;
+
+  // The pool must outlive the queue, whose destructor waits for its tasks.
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<TaskQueue<Batch>> queue_;
+
+  // The batch being read and the offset of its next unread byte.
+  std::string batch_;
+  size_t batch_offset_ = 0;
+
+  uint64_t position_ = 0;
+  absl::Status status_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_BGZF_READER_H_
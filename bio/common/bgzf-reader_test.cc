@@ -0,0 +1,124 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf-reader.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/test-files.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+// The uncompressed size of each block of the test file.
+static constexpr size_t kBlockSize = 1000;
+
+// Returns `data` compressed into BGZF blocks of kBlockSize bytes, without the
+// end-of-file block.
+auto Compress(const std::string& data) -> std::string {
+  std::string contents;
+  for (size_t i = 0; i < data.size(); i += kBlockSize) {
+    EXPECT_THAT(DeflateBgzfBlock(data.substr(i, kBlockSize), 6, &contents),
+                IsOk());
+  }
+  return contents;
+}
+
+auto TestData() -> std::string {
+  std::string data;
+  for (int i = 0; data.size() < 100 * kBlockSize + 123; ++i) {
+    data.append(std::to_string(i));
+  }
+  return data;
+}
+
+TEST(BgzfReader, ReadsWholeStream) {
+  const std::string data = TestData();
+  const std::string path =
+      WriteTempFile("whole.gz", Compress(data) + std::string(BgzfEofBlock()));
+  absl::StatusOr<std::unique_ptr<BgzfReader>> reader =
+      BgzfReader::New(path, {.num_threads = 3, .blocks_per_task = 4});
+  ASSERT_THAT(reader, IsOk());
+
+  std::string read;
+  std::string buffer;
+  for (size_t size = 1; read.size() < data.size(); size = size * 3 + 1) {
+    ASSERT_THAT((*reader)->Read(size, &buffer), IsOk());
+    read.append(buffer);
+  }
+  EXPECT_EQ(read, data);
+  EXPECT_EQ((*reader)->tell(), data.size());
+
+  ASSERT_THAT((*reader)->Read(10, &buffer), IsOk());
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(BgzfReader, ShortReadAtEnd) {
+  const std::string path = WriteTempFile("short.gz", Compress("ACGT"));
+  std::unique_ptr<BgzfReader> reader = *BgzfReader::New(path);
+  std::string buffer;
+  ASSERT_THAT(reader->Read(10, &buffer), IsOk());
+  EXPECT_EQ(buffer, "ACGT");
+}
+
+TEST(BgzfReader, EmptyFile) {
+  std::unique_ptr<BgzfReader> reader =
+      *BgzfReader::New("bio/common/testdata/empty");
+  std::string buffer = "stale";
+  ASSERT_THAT(reader->Read(10, &buffer), IsOk());
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(BgzfReader, TruncatedBlock) {
+  const std::string data = TestData();
+  std::string contents = Compress(data);
+  contents.resize(contents.size() - 10);
+  std::unique_ptr<BgzfReader> reader = *BgzfReader::New(
+      WriteTempFile("truncated.gz", contents), {.blocks_per_task = 8});
+
+  // The blocks before the truncated one are still returned.
+  std::string buffer;
+  ASSERT_THAT(reader->Read(data.size() - kBlockSize, &buffer), IsOk());
+  EXPECT_EQ(buffer, data.substr(0, data.size() - kBlockSize));
+  EXPECT_THAT(reader->Read(kBlockSize, &buffer),
+              StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(reader->Read(kBlockSize, &buffer),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(BgzfReader, NotBgzf) {
+  std::unique_ptr<BgzfReader> reader =
+      *BgzfReader::New("bio/common/testdata/lines");
+  std::string buffer;
+  EXPECT_FALSE(reader->Read(10, &buffer).ok());
+}
+
+TEST(BgzfReader, MissingFile) {
+  EXPECT_THAT(BgzfReader::New(gxl::JoinPath(TempDir(), "absent.gz")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
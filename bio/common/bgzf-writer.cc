@@ -0,0 +1,164 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf-writer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The maximum number of batches in flight per thread.
+static constexpr size_t kPendingBatchesPerThread = 2;
+
+// Compresses `data` into consecutive BGZF blocks.
+auto DeflateBlocks(absl::string_view data, int level)
+    -> absl::StatusOr<std::string> {
+  std::string blocks;
+  while (!data.empty()) {
+    RETURN_IF_ERROR(
+        DeflateBgzfBlock(data.substr(0, kBgzfMaxDataSize), level, &blocks));
+    data.remove_prefix(std::min(data.size(), kBgzfMaxDataSize));
+  }
+  return blocks;
+}
+
+auto WriteString(gxl::File* file, absl::string_view data) -> absl::Status {
+  const size_t size = file->WriteString(data);
+  if (size != data.size()) {
+    return absl::DataLossError(absl::StrFormat(
+        "Expected to write %d bytes but wrote %d", data.size(), size));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+BgzfWriter::BgzfWriter(absl::Nonnull<gxl::File*> file,
+                       const BgzfWriterOptions& options)
+    : file_(file),
+      options_(options),
+      pool_(std::make_unique<ThreadPool>(options.num_threads)),
+      queue_(std::make_unique<TaskQueue<Batch>>(pool_.get())) {
+  options_.blocks_per_task = std::max<size_t>(options_.blocks_per_task, 1);
+}
+
+BgzfWriter::~BgzfWriter() {
+  if (!closed_) {
+    Close().IgnoreError();
+  }
+}
+
+auto BgzfWriter::New(absl::string_view path, const BgzfWriterOptions& options)
+    -> absl::StatusOr<std::unique_ptr<BgzfWriter>> {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "w", &file, gxl::file::Defaults()));
+  return std::make_unique<BgzfWriter>(file, options);
+}
+
+auto BgzfWriter::Write(absl::string_view data) -> absl::Status {
+  if (closed_) {
+    return absl::FailedPreconditionError("The writer is closed");
+  }
+  RETURN_IF_ERROR(status_);
+  const size_t batch_size = options_.blocks_per_task * kBgzfMaxDataSize;
+  while (!data.empty()) {
+    const size_t size = std::min(data.size(), batch_size - buffer_.size());
+    buffer_.append(data.substr(0, size));
+    data.remove_prefix(size);
+    if (buffer_.size() == batch_size) {
+      RETURN_IF_ERROR(SubmitBuffer());
+    }
+  }
+  return absl::OkStatus();
+}
+
+auto BgzfWriter::Flush() -> absl::Status {
+  if (closed_) {
+    return absl::FailedPreconditionError("The writer is closed");
+  }
+  RETURN_IF_ERROR(status_);
+  return SubmitBuffer();
+}
+
+auto BgzfWriter::Close() -> absl::Status {
+  if (closed_) {
+    return status_;
+  }
+  closed_ = true;
+  if (status_.ok()) {
+    status_ = SubmitBuffer();
+  }
+  while (status_.ok() && queue_->pending() > 0) {
+    status_ = WriteNextBatch();
+  }
+  if (status_.ok()) {
+    status_ = WriteString(file_, BgzfEofBlock());
+  }
+  // Wait for any tasks left after an error before closing the file.
+  queue_.reset();
+  const absl::Status close_status = file_->Close(gxl::file::Defaults());
+  if (status_.ok()) {
+    status_ = close_status;
+  }
+  return status_;
+}
+
+auto BgzfWriter::SubmitBuffer() -> absl::Status {
+  if (buffer_.empty()) {
+    return absl::OkStatus();
+  }
+  const size_t max_pending = kPendingBatchesPerThread * pool_->num_threads();
+  while (queue_->pending() >= max_pending) {
+    RETURN_IF_ERROR(WriteNextBatch());
+  }
+  queue_->Submit([data = std::exchange(buffer_, std::string()),
+                  level = options_.level]() {
+    absl::StatusOr<std::string> blocks = DeflateBlocks(data, level);
+    if (!blocks.ok()) {
+      return Batch{.status = blocks.status()};
+    }
+    return Batch{.data = *std::move(blocks)};
+  });
+  return absl::OkStatus();
+}
+
+auto BgzfWriter::WriteNextBatch() -> absl::Status {
+  std::optional<Batch> batch = queue_->Next();
+  if (batch.has_value()) {
+    status_ = batch->status;
+    if (status_.ok()) {
+      status_ = WriteString(file_, batch->data);
+    }
+  }
+  return status_;
+}
+
+}  // namespace bio
@@ -0,0 +1,112 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_BGZF_WRITER_H_
+#define BIO_COMMON_BGZF_WRITER_H_
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+
+// Options for BgzfWriter.
+struct BgzfWriterOptions {
+  // The number of threads that compress blocks.
+  size_t num_threads = 4;
+
+  // The zlib compression level, from 0 to 9.
+  int level = 6;
+
+  // The number of BGZF blocks compressed together by a single task.
+  size_t blocks_per_task = 16;
+};
+
+// Writer for BGZF files, such as BAM files. Data is buffered on the calling
+// thread and batches of full blocks are compressed on a pool of threads, then
+// written to the file in order.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<BgzfWriter> writer,
+//                  BgzfWriter::New("path/to/out.gz", {.num_threads = 8}));
+// RETURN_IF_ERROR(writer->Write(data));
+// RETURN_IF_ERROR(writer->Close());
+// ```
+class BgzfWriter {
+ public:
+  BgzfWriter(absl::Nonnull<gxl::File*> file, const BgzfWriterOptions& options);
+
+  // Closes the writer if Close() has not been called, ignoring any error.
+  ~BgzfWriter();
+
+  BgzfWriter(const BgzfWriter&) = delete;
+  auto operator=(const BgzfWriter&) -> BgzfWriter& = delete;
+
+  // Creates the BGZF file at `path`.
+  static auto New(absl::string_view path, const BgzfWriterOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<BgzfWriter>>;
+
+  // Appends `data` to the uncompressed stream. Once an error has been
+  // returned, every later call returns it as well. Returns
+  // FailedPreconditionError after Close().
+  auto Write(absl::string_view data) -> absl::Status;
+
+  // Ends the current block, so that the next byte written starts a new block.
+  // Returns FailedPreconditionError after Close().
+  auto Flush() -> absl::Status;
+
+  // Compresses and writes any buffered data, writes the end-of-file block and
+  // closes the file.
+  auto Close() -> absl::Status;
+
+ private:
+  // The compressed blocks of a batch.
+  struct Batch {
+    absl::Status status;
+    std::string data;
+  };
+
+  // Hands the buffered data to the pool to be compressed.
+  auto SubmitBuffer() -> absl::Status;
+
+  // Writes the oldest compressed batch to the file.
+  auto WriteNextBatch() -> absl::Status;
+
+  gxl::File* file_;
+  BgzfWriterOptions options_;
+  bool closed_ = false;
+
+  // Data that has not been handed to the pool yet.
+  std::string buffer_;
+
+  // The pool must outlive the queue, whose destructor waits for its tasks.
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<TaskQueue<Batch>> queue_;
+
+  absl::Status status_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_BGZF_WRITER_H_
@@ -0,0 +1,134 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf-writer.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-reader.h"
+#include "bio/common/bgzf.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+auto TestData(size_t size) -> std::string {
+  std::string data;
+  for (int i = 0; data.size() < size; ++i) {
+    data.append(std::to_string(i * 7919 % 100003));
+  }
+  data.resize(size);
+  return data;
+}
+
+auto ReadAll(const std::string& path) -> std::string {
+  std::unique_ptr<BgzfReader> reader = *BgzfReader::New(path);
+  std::string data;
+  EXPECT_THAT(reader->Read(1 << 30, &data), IsOk());
+  return data;
+}
+
+auto ReadContents(const std::string& path) -> std::string {
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents(path, &contents, gxl::file::Defaults()),
+              IsOk());
+  return contents;
+}
+
+TEST(BgzfWriter, RoundTrip) {
+  const std::string data = TestData(3 << 20);
+  const std::string path = gxl::JoinPath(TempDir(), "round-trip.gz");
+  absl::StatusOr<std::unique_ptr<BgzfWriter>> writer =
+      BgzfWriter::New(path, {.num_threads = 3, .blocks_per_task = 2});
+  ASSERT_THAT(writer, IsOk());
+  for (size_t i = 0, size = 1; i < data.size(); i += size, size = size * 5) {
+    ASSERT_THAT((*writer)->Write(absl::string_view(data).substr(i, size)),
+                IsOk());
+  }
+  ASSERT_THAT((*writer)->Close(), IsOk());
+
+  EXPECT_EQ(ReadAll(path), data);
+  const std::string contents = ReadContents(path);
+  EXPECT_TRUE(absl::EndsWith(contents, BgzfEofBlock()));
+}
+
+TEST(BgzfWriter, FlushEndsBlock) {
+  const std::string path = gxl::JoinPath(TempDir(), "flush.gz");
+  std::unique_ptr<BgzfWriter> writer = *BgzfWriter::New(path);
+  ASSERT_THAT(writer->Write("header"), IsOk());
+  ASSERT_THAT(writer->Flush(), IsOk());
+  ASSERT_THAT(writer->Write("records"), IsOk());
+  ASSERT_THAT(writer->Close(), IsOk());
+
+  const std::string contents = ReadContents(path);
+  absl::StatusOr<size_t> block_size = BgzfBlockSize(contents);
+  ASSERT_THAT(block_size, IsOk());
+  EXPECT_THAT(BgzfUncompressedSize(contents.substr(0, *block_size)),
+              IsOkAndHolds(6));
+  EXPECT_EQ(ReadAll(path), "headerrecords");
+}
+
+TEST(BgzfWriter, Empty) {
+  const std::string path = gxl::JoinPath(TempDir(), "empty.gz");
+  ASSERT_THAT((*BgzfWriter::New(path))->Close(), IsOk());
+  EXPECT_EQ(ReadContents(path), BgzfEofBlock());
+}
+
+TEST(BgzfWriter, CloseOnDestruction) {
+  const std::string path = gxl::JoinPath(TempDir(), "destroyed.gz");
+  {
+    std::unique_ptr<BgzfWriter> writer = *BgzfWriter::New(path);
+    ASSERT_THAT(writer->Write("ACGT"), IsOk());
+  }
+  EXPECT_EQ(ReadAll(path), "ACGT");
+}
+
+TEST(BgzfWriter, WriteAfterClose) {
+  const std::string path = gxl::JoinPath(TempDir(), "write-after-close.gz");
+  std::unique_ptr<BgzfWriter> writer = *BgzfWriter::New(path);
+  ASSERT_THAT(writer->Close(), IsOk());
+  EXPECT_THAT(writer->Write("ACGT"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(writer->Flush(), StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(writer->Close(), IsOk());
+}
+
+TEST(BgzfWriter, InvalidLevel) {
+  const std::string path = gxl::JoinPath(TempDir(), "invalid-level.gz");
+  std::unique_ptr<BgzfWriter> writer = *BgzfWriter::New(path, {.level = 42});
+  ASSERT_THAT(writer->Write("ACGT"), IsOk());
+  EXPECT_FALSE(writer->Close().ok());
+  EXPECT_FALSE(writer->Write("ACGT").ok());
+}
+
+TEST(BgzfWriter, MissingDirectory) {
+  EXPECT_FALSE(
+      BgzfWriter::New(gxl::JoinPath(TempDir(), "absent/out.gz")).ok());
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,198 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// A BGZF header with an empty BSIZE field: gzip magic, deflate, FEXTRA, no
+// modification time, unknown OS and a 6-byte extra field holding the 'BC'
+// subfield.
+static constexpr char kHeaderTemplate[kBgzfHeaderSize] = {
+    '\x1f', '\x8b', '\x08', '\x04', '\x00', '\x00', '\x00', '\x00', '\x00',
+    '\xff', '\x06', '\x00', 'B',    'C',    '\x02', '\x00', '\x00', '\x00',
+};
+
+// The empty block that ends a BGZF file.
+static constexpr char kEofBlock[] =
+    "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff\x06\x00\x42\x43\x02\x00\x1b\x00"
+    "\x03\x00\x00\x00\x00\x00\x00\x00\x00\x00";
+
+// The offset of BSIZE, the total block size minus 1, in the header.
+static constexpr size_t kBlockSizeOffset = 16;
+
+// The window bits for raw deflate streams, without a zlib or gzip wrapper.
+static constexpr int kRawDeflateWindowBits = -15;
+
+// The default memory level of deflateInit().
+static constexpr int kDeflateMemLevel = 8;
+
+auto LoadLittleEndian16(const char* data) -> uint32_t {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+  return bytes[0] | (static_cast<uint32_t>(bytes[1]) << 8);
+}
+
+auto LoadLittleEndian32(const char* data) -> uint32_t {
+  return LoadLittleEndian16(data) | (LoadLittleEndian16(data + 2) << 16);
+}
+
+auto StoreLittleEndian32(uint32_t value, char* data) -> void {
+  for (int i = 0; i < 4; ++i) {
+    data[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+}  // namespace
+
+auto BgzfEofBlock() -> absl::string_view {
+  return absl::string_view(kEofBlock, sizeof(kEofBlock) - 1);
+}
+
+auto BgzfBlockSize(absl::string_view header) -> absl::StatusOr<size_t> {
+  if (header.size() < kBgzfHeaderSize) {
+    return absl::DataLossError(absl::StrFormat(
+        "Truncated BGZF header: expected %d bytes but got %d",
+        kBgzfHeaderSize, header.size()));
+  }
+  // Only the fields that identify a BGZF block are checked; the others may be
+  // set by the writer.
+  if (header[0] != kHeaderTemplate[0] || header[1] != kHeaderTemplate[1] ||
+      header[2] != kHeaderTemplate[2] ||
+      (header[3] & kHeaderTemplate[3]) == 0 ||
+      LoadLittleEndian16(header.data() + 10) < 6 || header[12] != 'B' ||
+      header[13] != 'C' || LoadLittleEndian16(header.data() + 14) != 2) {
+    return absl::DataLossError("Invalid BGZF block header");
+  }
+  const size_t size = LoadLittleEndian16(header.data() + kBlockSizeOffset) + 1;
+  const size_t header_size = 12 + LoadLittleEndian16(header.data() + 10);
+  if (size < header_size + kBgzfFooterSize) {
+    return absl::DataLossError(
+        absl::StrFormat("Invalid BGZF block size: %d", size));
+  }
+  return size;
+}
+
+auto BgzfUncompressedSize(absl::string_view block) -> absl::StatusOr<size_t> {
+  if (block.size() < kBgzfHeaderSize + kBgzfFooterSize) {
+    return absl::DataLossError(
+        absl::StrFormat("Truncated BGZF block of %d bytes", block.size()));
+  }
+  return LoadLittleEndian32(block.data() + block.size() - 4);
+}
+
+auto InflateBgzfBlock(absl::string_view block, std::string* out)
+    -> absl::Status {
+  ASSIGN_OR_RETURN(const size_t block_size, BgzfBlockSize(block));
+  if (block_size != block.size()) {
+    return absl::DataLossError(absl::StrFormat(
+        "BGZF block size mismatch: header records %d bytes but got %d",
+        block_size, block.size()));
+  }
+  const size_t header_size = 12 + LoadLittleEndian16(block.data() + 10);
+  const absl::string_view footer = block.substr(block.size() - kBgzfFooterSize);
+  const uint32_t expected_crc = LoadLittleEndian32(footer.data());
+  const size_t expected_size = LoadLittleEndian32(footer.data() + 4);
+  if (expected_size > kBgzfMaxBlockSize) {
+    return absl::DataLossError(absl::StrFormat(
+        "Invalid BGZF uncompressed size: %d", expected_size));
+  }
+  const absl::string_view compressed = block.substr(
+      header_size, block.size() - header_size - kBgzfFooterSize);
+
+  out->resize(expected_size);
+  z_stream stream = {};
+  if (inflateInit2(&stream, kRawDeflateWindowBits) != Z_OK) {
+    return absl::InternalError("Failed to initialize zlib inflate");
+  }
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+  stream.avail_in = compressed.size();
+  stream.next_out = reinterpret_cast<Bytef*>(out->data());
+  stream.avail_out = out->size();
+  const int result = inflate(&stream, Z_FINISH);
+  const size_t inflated = stream.total_out;
+  inflateEnd(&stream);
+  if (result != Z_STREAM_END || inflated != expected_size) {
+    return absl::DataLossError(absl::StrFormat(
+        "Failed to inflate BGZF block: zlib error %d", result));
+  }
+  const uint32_t crc = crc32(
+      crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(out->data()),
+      out->size());
+  if (crc != expected_crc) {
+    return absl::DataLossError("BGZF block CRC32 mismatch");
+  }
+  return absl::OkStatus();
+}
+
+auto DeflateBgzfBlock(absl::string_view data, int level, std::string* out)
+    -> absl::Status {
+  if (data.size() > kBgzfMaxDataSize) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Cannot compress %d bytes into one BGZF block; the maximum is %d",
+        data.size(), kBgzfMaxDataSize));
+  }
+  // Compress directly into `out`, after room for the header.
+  const size_t start = out->size();
+  out->resize(start + kBgzfMaxBlockSize);
+  char* block = out->data() + start;
+  z_stream stream = {};
+  if (deflateInit2(&stream, level, Z_DEFLATED, kRawDeflateWindowBits,
+                   kDeflateMemLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+    out->resize(start);
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Failed to initialize zlib deflate at level %d", level));
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(block + kBgzfHeaderSize);
+  stream.avail_out = kBgzfMaxBlockSize - kBgzfHeaderSize - kBgzfFooterSize;
+  const int result = deflate(&stream, Z_FINISH);
+  const size_t compressed_size = stream.total_out;
+  deflateEnd(&stream);
+  if (result != Z_STREAM_END) {
+    out->resize(start);
+    return absl::InternalError(
+        absl::StrFormat("Failed to deflate BGZF block: zlib error %d", result));
+  }
+
+  const size_t block_size = kBgzfHeaderSize + compressed_size + kBgzfFooterSize;
+  std::copy(kHeaderTemplate, kHeaderTemplate + kBgzfHeaderSize, block);
+  block[kBlockSizeOffset] = static_cast<char>((block_size - 1) & 0xff);
+  block[kBlockSizeOffset + 1] = static_cast<char>((block_size - 1) >> 8);
+  char* footer = block + kBgzfHeaderSize + compressed_size;
+  StoreLittleEndian32(
+      crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(data.data()),
+            data.size()),
+      footer);
+  StoreLittleEndian32(data.size(), footer + 4);
+  out->resize(start + block_size);
+  return absl::OkStatus();
+}
+
+}  // namespace bio
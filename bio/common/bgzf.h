@@ -0,0 +1,69 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_BGZF_H_
+#define BIO_COMMON_BGZF_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// BGZF is the blocked gzip format used by bgzip, BAM and tabix: a series of
+// independent gzip members of at most 64 KiB each, whose header records the
+// compressed size of the member. See section 4.1 of
+// https://samtools.github.io/hts-specs/SAMv1.pdf for more details.
+
+// The size of the gzip header of a BGZF block, including the BC subfield.
+inline constexpr size_t kBgzfHeaderSize = 18;
+
+// The size of the gzip footer (CRC32 and ISIZE) of a BGZF block.
+inline constexpr size_t kBgzfFooterSize = 8;
+
+// The maximum size of a BGZF block, compressed or uncompressed.
+inline constexpr size_t kBgzfMaxBlockSize = 1 << 16;
+
+// The maximum number of bytes compressed into a single block by
+// DeflateBgzfBlock(), chosen so that incompressible data still fits.
+inline constexpr size_t kBgzfMaxDataSize = 0xff00;
+
+// Returns the empty block that marks the end of a BGZF file.
+auto BgzfEofBlock() -> absl::string_view;
+
+// Returns the total compressed size of the BGZF block that starts with
+// `header`, which must hold at least kBgzfHeaderSize bytes.
+auto BgzfBlockSize(absl::string_view header) -> absl::StatusOr<size_t>;
+
+// Returns the uncompressed size recorded in the footer of `block`, a complete
+// BGZF block.
+auto BgzfUncompressedSize(absl::string_view block) -> absl::StatusOr<size_t>;
+
+// Decompresses `block`, a complete BGZF block, into `out`, replacing its
+// contents. The CRC32 and uncompressed size in the footer are verified.
+auto InflateBgzfBlock(absl::string_view block, std::string* out)
+    -> absl::Status;
+
+// Compresses `data`, which must be at most kBgzfMaxDataSize bytes, into a
+// single BGZF block at zlib compression `level` and appends it to `out`.
+auto DeflateBgzfBlock(absl::string_view data, int level, std::string* out)
+    -> absl::Status;
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_BGZF_H_
@@ -0,0 +1,98 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/bgzf.h"
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+
+TEST(Bgzf, RoundTrip) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data.append("ACGTTGCA");
+  }
+  std::string block = "prefix";
+  ASSERT_THAT(DeflateBgzfBlock(data, 6, &block), IsOk());
+  ASSERT_EQ(block.substr(0, 6), "prefix");
+  block.erase(0, 6);
+
+  EXPECT_THAT(BgzfBlockSize(block), IsOkAndHolds(block.size()));
+  EXPECT_THAT(BgzfUncompressedSize(block), IsOkAndHolds(data.size()));
+  std::string inflated;
+  ASSERT_THAT(InflateBgzfBlock(block, &inflated), IsOk());
+  EXPECT_EQ(inflated, data);
+}
+
+TEST(Bgzf, IncompressibleMaxSize) {
+  std::string data(kBgzfMaxDataSize, '\0');
+  uint32_t state = 1;
+  for (char& c : data) {
+    state = state * 1664525 + 1013904223;
+    c = static_cast<char>(state >> 24);
+  }
+  std::string block;
+  ASSERT_THAT(DeflateBgzfBlock(data, 9, &block), IsOk());
+  EXPECT_LE(block.size(), kBgzfMaxBlockSize);
+  std::string inflated;
+  ASSERT_THAT(InflateBgzfBlock(block, &inflated), IsOk());
+  EXPECT_EQ(inflated, data);
+}
+
+TEST(Bgzf, TooLarge) {
+  std::string block;
+  EXPECT_THAT(
+      DeflateBgzfBlock(std::string(kBgzfMaxDataSize + 1, 'A'), 6, &block),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(Bgzf, EofBlock) {
+  EXPECT_EQ(BgzfEofBlock().size(), 28);
+  EXPECT_THAT(BgzfBlockSize(BgzfEofBlock()), IsOkAndHolds(28));
+  std::string inflated = "previous contents";
+  EXPECT_THAT(InflateBgzfBlock(BgzfEofBlock(), &inflated), IsOk());
+  EXPECT_EQ(inflated, "");
+}
+
+TEST(Bgzf, Corrupt) {
+  std::string block;
+  ASSERT_THAT(DeflateBgzfBlock("ACGTACGTACGT", 6, &block), IsOk());
+
+  std::string bad_magic = block;
+  bad_magic[0] = 'x';
+  EXPECT_THAT(BgzfBlockSize(bad_magic), StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(BgzfBlockSize(block.substr(0, 10)),
+              StatusIs(absl::StatusCode::kDataLoss));
+
+  std::string bad_crc = block;
+  bad_crc[bad_crc.size() - 8] ^= 1;
+  std::string inflated;
+  EXPECT_THAT(InflateBgzfBlock(bad_crc, &inflated),
+              StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(InflateBgzfBlock(block.substr(0, block.size() - 1), &inflated),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+}  // namespace
+}  // namespace bio
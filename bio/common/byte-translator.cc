@@ -0,0 +1,94 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/byte-translator.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+#include "bio/common/cpu.h"
+
+#if defined(BIO_HAVE_TARGET_SSSE3)
+#include <tmmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+#if defined(BIO_HAVE_TARGET_SSSE3)
+// Translates the whole 16-byte blocks of `data` with a pshufb per active row
+// of `table`, and returns the number of bytes translated.
+BIO_TARGET_SSSE3 auto TranslateSsse3(const std::array<uint8_t, 256>& table,
+                                     const std::array<uint8_t, 16>& active_rows,
+                                     size_t num_active_rows, char* data,
+                                     size_t size) -> size_t {
+  __m128i rows[16];
+  __m128i row_ids[16];
+  for (size_t r = 0; r < num_active_rows; ++r) {
+    rows[r] = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(&table[active_rows[r] * 16]));
+    row_ids[r] = _mm_set1_epi8(static_cast<char>(active_rows[r]));
+  }
+  const __m128i low_mask = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i* block = reinterpret_cast<__m128i*>(data + i);
+    const __m128i bytes = _mm_loadu_si128(block);
+    const __m128i low = _mm_and_si128(bytes, low_mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask);
+    __m128i result = bytes;
+    for (size_t r = 0; r < num_active_rows; ++r) {
+      const __m128i in_row = _mm_cmpeq_epi8(high, row_ids[r]);
+      const __m128i mapped = _mm_shuffle_epi8(rows[r], low);
+      result = _mm_or_si128(_mm_and_si128(in_row, mapped),
+                            _mm_andnot_si128(in_row, result));
+    }
+    _mm_storeu_si128(block, result);
+  }
+  return i;
+}
+#endif
+
+}  // namespace
+
+ByteTranslator::ByteTranslator(const std::array<uint8_t, 256>& table)
+    : table_(table), active_rows_{}, num_active_rows_(0) {
+  for (size_t row = 0; row < 16; ++row) {
+    for (size_t column = 0; column < 16; ++column) {
+      const size_t byte = row * 16 + column;
+      if (table_[byte] != byte) {
+        active_rows_[num_active_rows_++] = row;
+        break;
+      }
+    }
+  }
+}
+
+auto ByteTranslator::Translate(char* data, size_t size) const -> void {
+  if (num_active_rows_ == 0) {
+    return;
+  }
+  size_t i = 0;
+#if defined(BIO_HAVE_TARGET_SSSE3)
+  if (CpuHasSsse3()) {
+    i = TranslateSsse3(table_, active_rows_, num_active_rows_, data, size);
+  }
+#endif
+  for (; i < size; ++i) {
+    data[i] = static_cast<char>(table_[static_cast<uint8_t>(data[i])]);
+  }
+}
+
+}  // namespace bio
@@ -0,0 +1,69 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_BYTE_TRANSLATOR_H_
+#define BIO_COMMON_BYTE_TRANSLATOR_H_
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "absl/base/nullability.h"
+
+namespace bio {
+
+// Maps every byte of a buffer through a 256-entry lookup table, such as for
+// binning quality scores or changing the case of bases.
+//
+// On CPUs with SSSE3, 16 bytes are translated per step, whatever the
+// compiler flags. The table is split into 16 rows by the high nibble of the
+// input byte; each row that changes any byte is looked up with a pshufb on
+// the low nibble and blended into the output.
+// Tables that only change a few rows, such as those over the printable
+// quality range, take a few shuffles per 16 bytes.
+//
+// Example usage:
+//
+// ```
+// std::array<uint8_t, 256> table = ...;
+// const ByteTranslator translator(table);
+// translator.Translate(&sequence->quality);
+// ```
+class ByteTranslator {
+ public:
+  explicit ByteTranslator(const std::array<uint8_t, 256>& table);
+
+  // Replaces each byte `b` of `data` with `table[b]`.
+  auto Translate(absl::Nonnull<std::string*> data) const -> void {
+    Translate(data->data(), data->size());
+  }
+
+  // Replaces each of the `size` bytes `b` at `data` with `table[b]`.
+  auto Translate(char* data, size_t size) const -> void;
+
+  // Returns the lookup table.
+  auto table() const -> const std::array<uint8_t, 256>& { return table_; }
+
+ private:
+  std::array<uint8_t, 256> table_;
+
+  // The high nibbles whose row of the table is not the identity.
+  std::array<uint8_t, 16> active_rows_;
+  size_t num_active_rows_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_BYTE_TRANSLATOR_H_
@@ -0,0 +1,115 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/byte-translator.h"
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "bio/common/cpu.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+auto IdentityTable() -> std::array<uint8_t, 256> {
+  std::array<uint8_t, 256> table;
+  for (size_t i = 0; i < table.size(); ++i) {
+    table[i] = static_cast<uint8_t>(i);
+  }
+  return table;
+}
+
+auto TranslateScalar(const std::array<uint8_t, 256>& table,
+                     const std::string& data) -> std::string {
+  std::string result = data;
+  for (char& byte : result) {
+    byte = static_cast<char>(table[static_cast<uint8_t>(byte)]);
+  }
+  return result;
+}
+
+TEST(ByteTranslator, Identity) {
+  const ByteTranslator translator(IdentityTable());
+  std::string data = "ACGT acgt !#~";
+  translator.Translate(&data);
+  EXPECT_EQ(data, "ACGT acgt !#~");
+}
+
+TEST(ByteTranslator, UpperCase) {
+  std::array<uint8_t, 256> table = IdentityTable();
+  for (int c = 'a'; c <= 'z'; ++c) {
+    table[c] = static_cast<uint8_t>(c - 'a' + 'A');
+  }
+  const ByteTranslator translator(table);
+  std::string data = "acgtnACGTNacgtnACGTNxyz";
+  translator.Translate(&data);
+  EXPECT_EQ(data, "ACGTNACGTNACGTNACGTNXYZ");
+}
+
+TEST(ByteTranslator, MatchesScalar) {
+  std::mt19937 rng(1);
+  for (int trial = 0; trial < 200; ++trial) {
+    std::array<uint8_t, 256> table = IdentityTable();
+    // Change a random subset of rows, from none to all of them.
+    const int num_changes = rng() % 300;
+    for (int i = 0; i < num_changes; ++i) {
+      table[rng() % 256] = static_cast<uint8_t>(rng());
+    }
+    const ByteTranslator translator(table);
+    std::string data(rng() % 100, '\0');
+    for (char& byte : data) {
+      byte = static_cast<char>(rng());
+    }
+    const std::string expected = TranslateScalar(table, data);
+    translator.Translate(&data);
+    ASSERT_EQ(data, expected) << "trial " << trial;
+  }
+}
+
+TEST(ByteTranslator, Ssse3MatchesScalar) {
+  if (!CpuHasSsse3()) {
+    GTEST_SKIP() << "The CPU does not support SSSE3.";
+  }
+  // Long buffers, so that most bytes go through the pshufb kernel and the
+  // rest through the scalar loop.
+  std::mt19937 rng(2);
+  for (int trial = 0; trial < 50; ++trial) {
+    std::array<uint8_t, 256> table = IdentityTable();
+    const int num_changes = rng() % 300;
+    for (int i = 0; i < num_changes; ++i) {
+      table[rng() % 256] = static_cast<uint8_t>(rng());
+    }
+    const ByteTranslator translator(table);
+    std::string data(1000 + rng() % 16, '\0');
+    for (char& byte : data) {
+      byte = static_cast<char>(rng());
+    }
+    const std::string expected = TranslateScalar(table, data);
+    translator.Translate(&data);
+    ASSERT_EQ(data, expected) << "trial " << trial;
+  }
+}
+
+TEST(ByteTranslator, Empty) {
+  const ByteTranslator translator(IdentityTable());
+  std::string data;
+  translator.Translate(&data);
+  EXPECT_EQ(data, "");
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,62 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_CPU_H_
+#define BIO_COMMON_CPU_H_
+
+// Helpers for choosing SIMD kernels at run time, so that the default x86-64
+// build, whose baseline is SSE2, still uses newer instructions where the CPU
+// has them.
+//
+// Example usage:
+//
+// ```
+// #if defined(BIO_HAVE_TARGET_SSSE3)
+// BIO_TARGET_SSSE3 auto CountSsse3(absl::string_view data) -> size_t { ... }
+// #endif
+//
+// auto Count(absl::string_view data) -> size_t {
+// #if defined(BIO_HAVE_TARGET_SSSE3)
+//   if (CpuHasSsse3()) {
+//     return CountSsse3(data);
+//   }
+// #endif
+//   ...
+// }
+// ```
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+// Defined when functions can be compiled for SSSE3 with BIO_TARGET_SSSE3,
+// whatever the compiler flags. Such functions may include <tmmintrin.h> and
+// must only be called when CpuHasSsse3() is true.
+#define BIO_HAVE_TARGET_SSSE3 1
+#define BIO_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+namespace bio {
+
+// Returns whether the CPU supports SSSE3.
+inline auto CpuHasSsse3() -> bool {
+#if defined(BIO_HAVE_TARGET_SSSE3)
+  static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+  return has_ssse3;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_CPU_H_
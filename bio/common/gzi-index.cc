@@ -0,0 +1,135 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/gzi-index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/random-access-file.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+auto LoadLittleEndian64(const char* data) -> uint64_t {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return value;
+}
+
+auto AppendLittleEndian64(uint64_t value, std::string* out) -> void {
+  for (int i = 0; i < 8; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+}  // namespace
+
+auto GziIndex::Read(absl::string_view path) -> absl::StatusOr<GziIndex> {
+  std::string contents;
+  RETURN_IF_ERROR(gxl::GetContents(path, &contents, gxl::file::Defaults()));
+  return Parse(contents);
+}
+
+auto GziIndex::Parse(absl::string_view contents) -> absl::StatusOr<GziIndex> {
+  if (contents.size() < 8) {
+    return absl::DataLossError("Truncated GZI index: missing entry count");
+  }
+  const uint64_t count = LoadLittleEndian64(contents.data());
+  if ((contents.size() - 8) / 16 != count || (contents.size() - 8) % 16 != 0) {
+    return absl::DataLossError(absl::StrFormat(
+        "GZI index of %d bytes does not hold %d entries", contents.size(),
+        count));
+  }
+  GziIndex index;
+  index.entries_.reserve(count + 1);
+  for (uint64_t i = 0; i < count; ++i) {
+    const char* entry = contents.data() + 8 + 16 * i;
+    const GziEntry& previous = index.entries_.back();
+    GziEntry next = {
+        .compressed_offset = LoadLittleEndian64(entry),
+        .uncompressed_offset = LoadLittleEndian64(entry + 8),
+    };
+    if (next.compressed_offset <= previous.compressed_offset ||
+        next.uncompressed_offset < previous.uncompressed_offset) {
+      return absl::DataLossError(
+          absl::StrFormat("GZI index entry %d is out of order", i));
+    }
+    index.entries_.push_back(next);
+  }
+  return index;
+}
+
+auto GziIndex::Build(const RandomAccessFile& file)
+    -> absl::StatusOr<GziIndex> {
+  GziIndex index;
+  uint64_t compressed_offset = 0;
+  uint64_t uncompressed_offset = 0;
+  std::string header;
+  std::string footer;
+  while (compressed_offset < file.size()) {
+    RETURN_IF_ERROR(file.Read(compressed_offset, kBgzfHeaderSize, &header));
+    ASSIGN_OR_RETURN(const size_t block_size, BgzfBlockSize(header));
+    RETURN_IF_ERROR(file.Read(compressed_offset + block_size - 4, 4, &footer));
+    const size_t data_size =
+        static_cast<unsigned char>(footer[0]) |
+        (static_cast<unsigned char>(footer[1]) << 8) |
+        (static_cast<unsigned char>(footer[2]) << 16) |
+        (static_cast<size_t>(static_cast<unsigned char>(footer[3])) << 24);
+    // Empty blocks, such as the end-of-file marker, are not indexed.
+    if (compressed_offset > 0 && data_size > 0) {
+      index.entries_.push_back({
+          .compressed_offset = compressed_offset,
+          .uncompressed_offset = uncompressed_offset,
+      });
+    }
+    compressed_offset += block_size;
+    uncompressed_offset += data_size;
+  }
+  return index;
+}
+
+auto GziIndex::Serialize() const -> std::string {
+  std::string contents;
+  contents.reserve(8 + 16 * (entries_.size() - 1));
+  AppendLittleEndian64(entries_.size() - 1, &contents);
+  for (size_t i = 1; i < entries_.size(); ++i) {
+    AppendLittleEndian64(entries_[i].compressed_offset, &contents);
+    AppendLittleEndian64(entries_[i].uncompressed_offset, &contents);
+  }
+  return contents;
+}
+
+auto GziIndex::Find(uint64_t uncompressed_offset) const -> const GziEntry& {
+  auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), uncompressed_offset,
+      [](uint64_t offset, const GziEntry& entry) {
+        return offset < entry.uncompressed_offset;
+      });
+  return *std::prev(it);
+}
+
+}  // namespace bio
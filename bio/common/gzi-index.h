@@ -0,0 +1,77 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_GZI_INDEX_H_
+#define BIO_COMMON_GZI_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/random-access-file.h"
+
+namespace bio {
+
+// The start of a BGZF block in the compressed and uncompressed streams.
+struct GziEntry {
+  uint64_t compressed_offset;
+  uint64_t uncompressed_offset;
+
+  // Checks for equality.
+  auto operator==(const GziEntry& rhs) const -> bool {
+    return compressed_offset == rhs.compressed_offset &&
+           uncompressed_offset == rhs.uncompressed_offset;
+  }
+};
+
+// A .gzi index, as written by `bgzip -i`, which maps uncompressed offsets in a
+// BGZF file to the blocks that contain them.
+//
+// The file is a little-endian uint64 entry count followed by that many pairs of
+// little-endian uint64 compressed and uncompressed block offsets. The first
+// block, at offset 0 in both streams, is implied.
+class GziIndex {
+ public:
+  // Constructs an index that only holds the first block.
+  GziIndex() : entries_({{.compressed_offset = 0, .uncompressed_offset = 0}}) {}
+
+  // Reads the index from the .gzi file at `path`.
+  static auto Read(absl::string_view path) -> absl::StatusOr<GziIndex>;
+
+  // Parses the index from the contents of a .gzi file.
+  static auto Parse(absl::string_view contents) -> absl::StatusOr<GziIndex>;
+
+  // Builds the index by reading the header and footer of every block in
+  // `file`, a BGZF file.
+  static auto Build(const RandomAccessFile& file) -> absl::StatusOr<GziIndex>;
+
+  // Serializes the index to the contents of a .gzi file.
+  auto Serialize() const -> std::string;
+
+  // Returns the last indexed block that starts at or before
+  // `uncompressed_offset`.
+  auto Find(uint64_t uncompressed_offset) const -> const GziEntry&;
+
+  // Returns the indexed blocks, including the first block, in file order.
+  auto entries() const -> const std::vector<GziEntry>& { return entries_; }
+
+ private:
+  std::vector<GziEntry> entries_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_GZI_INDEX_H_
@@ -0,0 +1,86 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/gzi-index.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/random-access-file.h"
+#include "bio/common/test-files.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+
+TEST(GziIndex, Empty) {
+  const GziIndex index;
+  EXPECT_THAT(index.entries(), ElementsAre(GziEntry{0, 0}));
+  EXPECT_EQ(index.Serialize(), std::string(8, '\0'));
+}
+
+TEST(GziIndex, ParseAndSerialize) {
+  const std::string contents(
+      "\x02\x00\x00\x00\x00\x00\x00\x00"
+      "\x64\x00\x00\x00\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+      "\xc8\x00\x00\x00\x00\x00\x00\x00\x00\x02\x00\x00\x00\x00\x00\x00",
+      40);
+  absl::StatusOr<GziIndex> index = GziIndex::Parse(contents);
+  ASSERT_THAT(index, IsOk());
+  EXPECT_THAT(index->entries(),
+              ElementsAre(GziEntry{0, 0}, GziEntry{100, 256},
+                          GziEntry{200, 512}));
+  EXPECT_EQ(index->Serialize(), contents);
+
+  EXPECT_EQ(index->Find(0), (GziEntry{0, 0}));
+  EXPECT_EQ(index->Find(255), (GziEntry{0, 0}));
+  EXPECT_EQ(index->Find(256), (GziEntry{100, 256}));
+  EXPECT_EQ(index->Find(100000), (GziEntry{200, 512}));
+}
+
+TEST(GziIndex, ParseInvalid) {
+  EXPECT_THAT(GziIndex::Parse("\x01"), StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(GziIndex::Parse(std::string("\x01\0\0\0\0\0\0\0", 8)),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(GziIndex, Build) {
+  std::string contents;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_THAT(DeflateBgzfBlock(std::string(100, 'A' + i), 6, &contents),
+                IsOk());
+  }
+  const size_t block_size = contents.size() / 3;
+  contents.append(BgzfEofBlock());
+  std::unique_ptr<RandomAccessFile> file =
+      *RandomAccessFile::New(WriteTempFile("build.gz", contents));
+
+  absl::StatusOr<GziIndex> index = GziIndex::Build(*file);
+  ASSERT_THAT(index, IsOk());
+  EXPECT_THAT(index->entries(),
+              ElementsAre(GziEntry{0, 0}, GziEntry{block_size, 100},
+                          GziEntry{2 * block_size, 200}));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,36 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_HASH_H_
+#define BIO_COMMON_HASH_H_
+
+#include <cstdint>
+
+namespace bio {
+
+// The finalizer of the splitmix64 generator, a bijection of 64-bit values that
+// spreads every input bit over all output bits. It is used to turn structured
+// values, such as sequence words or seeds, into well-distributed hashes.
+inline auto Mix64(uint64_t x) -> uint64_t {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_HASH_H_
@@ -0,0 +1,32 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/hash.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+TEST(Mix64, Splitmix64) {
+  EXPECT_EQ(Mix64(0), 0);
+  // The first output of splitmix64 seeded with 0.
+  EXPECT_EQ(Mix64(0x9e3779b97f4a7c15ULL), 0xe220a8397b1dcdafULL);
+  EXPECT_NE(Mix64(1), Mix64(2));
+}
+
+}  // namespace
+}  // namespace bio
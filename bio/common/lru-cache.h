@@ -0,0 +1,105 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_LRU_CACHE_H_
+#define BIO_COMMON_LRU_CACHE_H_
+
+#include <cstdlib>
+#include <list>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+
+namespace bio {
+
+// A map that holds at most a fixed number of entries, evicting the least
+// recently used entry to make room for a new one. LruCache is not thread-safe.
+//
+// Example usage:
+//
+// ```
+// LruCache<uint64_t, std::string> cache(/*capacity=*/16);
+// if (const std::string* block = cache.Get(offset); block != nullptr) {
+//   return *block;
+// }
+// cache.Put(offset, ReadBlock(offset));
+// ```
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  // Constructs a cache that holds at most `capacity` entries. A cache with a
+  // capacity of 0 holds nothing.
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  LruCache(const LruCache&) = delete;
+  auto operator=(const LruCache&) -> LruCache& = delete;
+
+  // Returns the value for `key` and marks it as the most recently used entry,
+  // or returns nullptr if `key` is not in the cache. The pointer is valid until
+  // the next call to Put() or Clear().
+  auto Get(const Key& key) -> Value* {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Inserts or replaces the value for `key`, marking it as the most recently
+  // used entry and evicting the least recently used entry if the cache is
+  // full.
+  auto Put(const Key& key, Value value) -> void {
+    if (capacity_ == 0) {
+      return;
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+    if (entries_.size() == capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    index_.emplace(key, entries_.begin());
+  }
+
+  // Removes all entries.
+  auto Clear() -> void {
+    index_.clear();
+    entries_.clear();
+  }
+
+  // Returns the number of entries in the cache.
+  auto size() const -> size_t { return entries_.size(); }
+
+  // Returns the maximum number of entries in the cache.
+  auto capacity() const -> size_t { return capacity_; }
+
+ private:
+  using Entry = std::pair<Key, Value>;
+
+  size_t capacity_;
+
+  // Entries from the most to the least recently used.
+  std::list<Entry> entries_;
+  absl::flat_hash_map<Key, typename std::list<Entry>::iterator> index_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_LRU_CACHE_H_
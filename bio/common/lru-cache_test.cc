@@ -0,0 +1,76 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/lru-cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+TEST(LruCache, GetAndPut) {
+  LruCache<int, std::string> cache(2);
+  EXPECT_EQ(cache.capacity(), 2);
+  EXPECT_EQ(cache.Get(1), nullptr);
+
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  EXPECT_EQ(cache.size(), 2);
+  ASSERT_NE(cache.Get(1), nullptr);
+  EXPECT_EQ(*cache.Get(1), "one");
+  EXPECT_EQ(*cache.Get(2), "two");
+}
+
+TEST(LruCache, EvictsLeastRecentlyUsed) {
+  LruCache<int, std::string> cache(2);
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  // Using 1 makes 2 the least recently used entry.
+  EXPECT_NE(cache.Get(1), nullptr);
+  cache.Put(3, "three");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.Get(2), nullptr);
+  EXPECT_EQ(*cache.Get(1), "one");
+  EXPECT_EQ(*cache.Get(3), "three");
+}
+
+TEST(LruCache, Replace) {
+  LruCache<int, std::string> cache(2);
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  cache.Put(1, "uno");
+  cache.Put(3, "three");
+  EXPECT_EQ(cache.Get(2), nullptr);
+  EXPECT_EQ(*cache.Get(1), "uno");
+}
+
+TEST(LruCache, ZeroCapacity) {
+  LruCache<int, std::string> cache(0);
+  cache.Put(1, "one");
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.Get(1), nullptr);
+}
+
+TEST(LruCache, Clear) {
+  LruCache<int, std::string> cache(2);
+  cache.Put(1, "one");
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.Get(1), nullptr);
+}
+
+}  // namespace
+}  // namespace bio
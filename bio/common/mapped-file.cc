@@ -0,0 +1,72 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/mapped-file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+auto MappedFile::New(absl::string_view path)
+    -> absl::StatusOr<std::unique_ptr<MappedFile>> {
+  const std::string path_str(path);
+  const int fd = open(path_str.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(
+        errno, absl::StrFormat("Failed to open %s", path_str));
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    const int error = errno;
+    close(fd);
+    return absl::ErrnoToStatus(
+        error, absl::StrFormat("Failed to stat %s", path_str));
+  }
+  const size_t size = info.st_size;
+  void* address = nullptr;
+  // mmap() rejects empty mappings; an empty file maps to no memory.
+  if (size > 0) {
+    address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+      const int error = errno;
+      close(fd);
+      return absl::ErrnoToStatus(
+          error, absl::StrFormat("Failed to map %s", path_str));
+    }
+  }
+  // The mapping stays valid after the descriptor is closed.
+  close(fd);
+  return std::unique_ptr<MappedFile>(new MappedFile(path, address, size));
+}
+
+MappedFile::~MappedFile() {
+  if (address_ != nullptr) {
+    munmap(address_, size_);
+  }
+}
+
+}  // namespace bio
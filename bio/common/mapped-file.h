@@ -0,0 +1,68 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_MAPPED_FILE_H_
+#define BIO_COMMON_MAPPED_FILE_H_
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// A read-only, memory-mapped file. Opening a file maps it without reading it;
+// pages are loaded by the operating system as they are accessed.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<MappedFile> file,
+//                  MappedFile::New("path/to/in.sdx"));
+// absl::string_view contents = file->data();
+// ```
+class MappedFile {
+ public:
+  // Maps the file at `path`.
+  static auto New(absl::string_view path)
+      -> absl::StatusOr<std::unique_ptr<MappedFile>>;
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+  // Returns the contents of the file. The address of the first byte is page
+  // aligned.
+  auto data() const -> absl::string_view {
+    return absl::string_view(static_cast<const char*>(address_), size_);
+  }
+
+  // Returns the path of the file.
+  auto path() const -> absl::string_view { return path_; }
+
+ private:
+  MappedFile(absl::string_view path, void* address, size_t size)
+      : path_(path), address_(address), size_(size) {}
+
+  std::string path_;
+  void* address_;
+  size_t size_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_MAPPED_FILE_H_
@@ -0,0 +1,57 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/mapped-file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/common/test-files.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+TEST(MappedFile, Contents) {
+  const std::string path = WriteTempFile("mapped.txt", "mapped contents");
+  absl::StatusOr<std::unique_ptr<MappedFile>> file = MappedFile::New(path);
+  ASSERT_THAT(file, IsOk());
+  EXPECT_EQ((*file)->data(), "mapped contents");
+  EXPECT_EQ((*file)->path(), path);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>((*file)->data().data()) % 8, 0);
+}
+
+TEST(MappedFile, Empty) {
+  absl::StatusOr<std::unique_ptr<MappedFile>> file =
+      MappedFile::New(WriteTempFile("empty.txt", ""));
+  ASSERT_THAT(file, IsOk());
+  EXPECT_TRUE((*file)->data().empty());
+}
+
+TEST(MappedFile, Missing) {
+  EXPECT_THAT(MappedFile::New(gxl::JoinPath(TempDir(), "missing.txt")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,242 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/minimal-perfect-hash.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace bio {
+namespace {
+
+// The number of levels after which construction gives up. Each level holds on
+// the order of 1/e^(1/gamma) of the keys of the previous one, so this is never
+// reached in practice with distinct keys.
+static constexpr uint64_t kMaxLevels = 64;
+
+// The number of bit words per rank sample.
+static constexpr size_t kRankBlockWords = 8;
+
+// The number of header words: the key count and the level count.
+static constexpr size_t kHeaderWords = 2;
+
+// The MurmurHash3 64-bit finalizer.
+auto Mix(uint64_t value) -> uint64_t {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// Returns the bit hit by `key` in a level of `num_bits` bits.
+auto LevelPosition(uint64_t key, uint64_t level, uint64_t num_bits)
+    -> uint64_t {
+  const uint64_t hash = Mix(key + (level + 1) * 0x9e3779b97f4a7c15ULL);
+  // Maps the hash to [0, num_bits) without a division.
+  return absl::Uint128High64(absl::uint128(hash) * num_bits);
+}
+
+auto TestBit(absl::Span<const uint64_t> words, uint64_t bit) -> bool {
+  return (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+auto SetBit(uint64_t bit, std::vector<uint64_t>* words) -> void {
+  (*words)[bit / 64] |= uint64_t{1} << (bit % 64);
+}
+
+auto AppendWord(uint64_t word, std::string* out) -> void {
+  for (int i = 0; i < 8; ++i) {
+    out->push_back(static_cast<char>((word >> (8 * i)) & 0xff));
+  }
+}
+
+}  // namespace
+
+auto StableHash64(absl::string_view key) -> uint64_t {
+  uint64_t hash = Mix(key.size() ^ 0x243f6a8885a308d3ULL);
+  while (!key.empty()) {
+    uint64_t word = 0;
+    const size_t size = std::min<size_t>(key.size(), 8);
+    for (size_t i = 0; i < size; ++i) {
+      word |= static_cast<uint64_t>(static_cast<unsigned char>(key[i]))
+              << (8 * i);
+    }
+    hash = Mix(hash ^ word) + 0x9e3779b97f4a7c15ULL;
+    key.remove_prefix(size);
+  }
+  return Mix(hash);
+}
+
+auto MinimalPerfectHash::Build(absl::Span<const uint64_t> keys, double gamma)
+    -> absl::StatusOr<std::string> {
+  if (!(gamma >= 1.0)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("gamma must be at least 1 but is %f", gamma));
+  }
+  std::vector<uint64_t> remaining(keys.begin(), keys.end());
+  {
+    std::vector<uint64_t> sorted = remaining;
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+      return absl::InvalidArgumentError("Keys are not distinct");
+    }
+  }
+
+  std::vector<uint64_t> level_offsets = {0};
+  std::vector<uint64_t> bits;
+  for (uint64_t level = 0; !remaining.empty(); ++level) {
+    if (level == kMaxLevels) {
+      return absl::InternalError(absl::StrFormat(
+          "%d keys remain after %d levels", remaining.size(), kMaxLevels));
+    }
+    const uint64_t num_words = std::max<uint64_t>(
+        (static_cast<uint64_t>(std::ceil(gamma * remaining.size())) + 63) / 64,
+        1);
+    const uint64_t num_bits = num_words * 64;
+    std::vector<uint64_t> hit(num_words, 0);
+    std::vector<uint64_t> collided(num_words, 0);
+    for (uint64_t key : remaining) {
+      const uint64_t position = LevelPosition(key, level, num_bits);
+      SetBit(position, TestBit(hit, position) ? &collided : &hit);
+    }
+    std::vector<uint64_t> next;
+    for (uint64_t key : remaining) {
+      if (TestBit(collided, LevelPosition(key, level, num_bits))) {
+        next.push_back(key);
+      }
+    }
+    for (uint64_t i = 0; i < num_words; ++i) {
+      bits.push_back(hit[i] & ~collided[i]);
+    }
+    level_offsets.push_back(level_offsets.back() + num_bits);
+    remaining = std::move(next);
+  }
+
+  std::string data;
+  AppendWord(keys.size(), &data);
+  AppendWord(level_offsets.size() - 1, &data);
+  for (uint64_t offset : level_offsets) {
+    AppendWord(offset, &data);
+  }
+  for (uint64_t word : bits) {
+    AppendWord(word, &data);
+  }
+  uint64_t rank = 0;
+  for (size_t i = 0; i < bits.size(); ++i) {
+    if (i % kRankBlockWords == 0) {
+      AppendWord(rank, &data);
+    }
+    rank += std::popcount(bits[i]);
+  }
+  return data;
+}
+
+auto MinimalPerfectHash::View(absl::string_view data)
+    -> absl::StatusOr<MinimalPerfectHash> {
+  static_assert(std::endian::native == std::endian::little,
+                "MinimalPerfectHash::View() requires a little-endian host");
+  if (reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) != 0 ||
+      data.size() % sizeof(uint64_t) != 0) {
+    return absl::InvalidArgumentError(
+        "Minimal perfect hash data must be 8-byte aligned and sized");
+  }
+  const absl::Span<const uint64_t> words(
+      reinterpret_cast<const uint64_t*>(data.data()),
+      data.size() / sizeof(uint64_t));
+  if (words.size() < kHeaderWords) {
+    return absl::DataLossError("Truncated minimal perfect hash header");
+  }
+  MinimalPerfectHash hash;
+  hash.size_ = words[0];
+  const uint64_t num_levels = words[1];
+  if (num_levels > kMaxLevels ||
+      words.size() < kHeaderWords + num_levels + 1) {
+    return absl::DataLossError("Invalid minimal perfect hash level count");
+  }
+  hash.level_offsets_ = words.subspan(kHeaderWords, num_levels + 1);
+  // Levels are whole, non-empty words of the bit array.
+  if (hash.level_offsets_[0] != 0) {
+    return absl::DataLossError("Invalid minimal perfect hash level offsets");
+  }
+  for (size_t level = 0; level < num_levels; ++level) {
+    const uint64_t start = hash.level_offsets_[level];
+    const uint64_t end = hash.level_offsets_[level + 1];
+    if (end <= start || end % 64 != 0) {
+      return absl::DataLossError("Invalid minimal perfect hash level offsets");
+    }
+  }
+  const absl::Span<const uint64_t> body =
+      words.subspan(kHeaderWords + num_levels + 1);
+  const uint64_t num_words = hash.level_offsets_.back() / 64;
+  if (num_words > body.size() ||
+      body.size() - num_words !=
+          (num_words + kRankBlockWords - 1) / kRankBlockWords) {
+    return absl::DataLossError("Minimal perfect hash size mismatch");
+  }
+  hash.bits_ = body.subspan(0, num_words);
+  hash.ranks_ = body.subspan(num_words);
+  // Lookups return ranks, which callers use as indices, so check that the
+  // rank samples match the bits and that they count exactly `size_` keys.
+  uint64_t rank = 0;
+  for (size_t i = 0; i < hash.bits_.size(); ++i) {
+    if (i % kRankBlockWords == 0 && hash.ranks_[i / kRankBlockWords] != rank) {
+      return absl::DataLossError("Invalid minimal perfect hash ranks");
+    }
+    rank += std::popcount(hash.bits_[i]);
+  }
+  if (rank != hash.size_) {
+    return absl::DataLossError("Minimal perfect hash key count mismatch");
+  }
+  return hash;
+}
+
+auto MinimalPerfectHash::Lookup(uint64_t key) const
+    -> std::optional<uint64_t> {
+  for (size_t level = 0; level + 1 < level_offsets_.size(); ++level) {
+    const uint64_t start = level_offsets_[level];
+    const uint64_t bit =
+        start + LevelPosition(key, level, level_offsets_[level + 1] - start);
+    if (TestBit(bits_, bit)) {
+      return Rank(bit);
+    }
+  }
+  return std::nullopt;
+}
+
+auto MinimalPerfectHash::Rank(uint64_t bit) const -> uint64_t {
+  const uint64_t word = bit / 64;
+  uint64_t rank = ranks_[word / kRankBlockWords];
+  for (uint64_t i = word - word % kRankBlockWords; i < word; ++i) {
+    rank += std::popcount(bits_[i]);
+  }
+  const uint64_t below = (uint64_t{1} << (bit % 64)) - 1;
+  return rank + std::popcount(bits_[word] & below);
+}
+
+}  // namespace bio
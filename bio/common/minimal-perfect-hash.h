@@ -0,0 +1,100 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_MINIMAL_PERFECT_HASH_H_
+#define BIO_COMMON_MINIMAL_PERFECT_HASH_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace bio {
+
+// Returns a 64-bit hash of `key` that is stable across processes and
+// platforms, unlike absl::Hash, so that it can be stored in files.
+auto StableHash64(absl::string_view key) -> uint64_t;
+
+// A minimal perfect hash function, which maps each of a fixed set of n distinct
+// 64-bit keys to a distinct slot in [0, n), in about 4 bits per key.
+//
+// The construction follows BBHash (Limasset et al., 2017): keys are hashed into
+// a bit array of gamma * n bits; the bits hit by exactly one key are kept, and
+// the colliding keys move on to a smaller array at the next level. A key's slot
+// is the number of kept bits before its bit, found with sampled ranks.
+//
+// The function is stored in a flat array of little-endian 64-bit words so that
+// it can be used in place from a memory-mapped file. A MinimalPerfectHash
+// does not own that storage.
+//
+// Keys outside of the set map to an arbitrary slot or to none, so callers must
+// verify the slot's contents.
+//
+// Example usage:
+//
+// ```
+// std::vector<uint64_t> keys = ...;
+// ASSIGN_OR_RETURN(std::string data, MinimalPerfectHash::Build(keys));
+// ASSIGN_OR_RETURN(MinimalPerfectHash hash, MinimalPerfectHash::View(data));
+// std::optional<uint64_t> slot = hash.Lookup(keys[0]);
+// ```
+class MinimalPerfectHash {
+ public:
+  // The default number of bits per key in each level. Larger values use more
+  // space but make construction and lookups faster.
+  static constexpr double kDefaultGamma = 2.0;
+
+  // Builds the function for `keys`, which must be distinct, and returns its
+  // serialized form. The size of the result is a multiple of 8 bytes.
+  static auto Build(absl::Span<const uint64_t> keys,
+                    double gamma = kDefaultGamma)
+      -> absl::StatusOr<std::string>;
+
+  // Returns a function that reads the serialized form in `data`, which must
+  // outlive it and be 8-byte aligned.
+  static auto View(absl::string_view data)
+      -> absl::StatusOr<MinimalPerfectHash>;
+
+  // Returns the slot of `key`, or std::nullopt if `key` is not in the set.
+  // std::nullopt is not returned for every key outside of the set.
+  auto Lookup(uint64_t key) const -> std::optional<uint64_t>;
+
+  // Returns the number of keys.
+  auto size() const -> uint64_t { return size_; }
+
+ private:
+  MinimalPerfectHash() = default;
+
+  // Returns the number of set bits before `bit`.
+  auto Rank(uint64_t bit) const -> uint64_t;
+
+  uint64_t size_ = 0;
+
+  // The bit offset of the start of each level, followed by the total number of
+  // bits.
+  absl::Span<const uint64_t> level_offsets_;
+  absl::Span<const uint64_t> bits_;
+
+  // The number of set bits before each block of kRankBlockWords words.
+  absl::Span<const uint64_t> ranks_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_MINIMAL_PERFECT_HASH_H_
@@ -0,0 +1,174 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/minimal-perfect-hash.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+// Holds serialized data in 8-byte aligned storage.
+class AlignedData {
+ public:
+  explicit AlignedData(const std::string& data)
+      : words_(data.size() / sizeof(uint64_t)) {
+    std::memcpy(words_.data(), data.data(), data.size());
+  }
+
+  auto view() const -> absl::string_view {
+    return absl::string_view(reinterpret_cast<const char*>(words_.data()),
+                             words_.size() * sizeof(uint64_t));
+  }
+
+ private:
+  std::vector<uint64_t> words_;
+};
+
+TEST(StableHash64, Deterministic) {
+  EXPECT_EQ(StableHash64("chr1"), StableHash64(std::string("chr1")));
+  EXPECT_NE(StableHash64("chr1"), StableHash64("chr2"));
+  EXPECT_NE(StableHash64(""), StableHash64(absl::string_view("\0", 1)));
+  // Pins the hash, which is stored in files.
+  EXPECT_EQ(StableHash64("NM_000546.6"), 0x2699c64fe6b07194);
+}
+
+TEST(MinimalPerfectHash, MapsKeysToDistinctSlots) {
+  std::mt19937_64 rng(1);
+  for (size_t num_keys : {1, 2, 63, 64, 1000, 100000}) {
+    std::vector<uint64_t> keys;
+    absl::flat_hash_set<uint64_t> seen;
+    while (keys.size() < num_keys) {
+      const uint64_t key = rng();
+      if (seen.insert(key).second) {
+        keys.push_back(key);
+      }
+    }
+    absl::StatusOr<std::string> data = MinimalPerfectHash::Build(keys);
+    ASSERT_THAT(data, IsOk());
+    const AlignedData aligned(*data);
+    absl::StatusOr<MinimalPerfectHash> hash =
+        MinimalPerfectHash::View(aligned.view());
+    ASSERT_THAT(hash, IsOk());
+    EXPECT_EQ(hash->size(), num_keys);
+
+    std::vector<bool> used(num_keys, false);
+    for (uint64_t key : keys) {
+      const std::optional<uint64_t> slot = hash->Lookup(key);
+      ASSERT_TRUE(slot.has_value());
+      ASSERT_LT(*slot, num_keys);
+      EXPECT_FALSE(used[*slot]) << "slot " << *slot << " used twice";
+      used[*slot] = true;
+    }
+    if (num_keys == 100000) {
+      // The space used, including the rank samples, is about 4 bits per key.
+      EXPECT_LT(data->size() * 8.0 / num_keys, 5.0);
+    }
+  }
+}
+
+TEST(MinimalPerfectHash, StringKeys) {
+  std::vector<uint64_t> keys;
+  for (int i = 0; i < 5000; ++i) {
+    keys.push_back(StableHash64(absl::StrCat("transcript_", i)));
+  }
+  absl::StatusOr<std::string> data = MinimalPerfectHash::Build(keys);
+  ASSERT_THAT(data, IsOk());
+  const AlignedData aligned(*data);
+  const MinimalPerfectHash hash = *MinimalPerfectHash::View(aligned.view());
+  absl::flat_hash_set<uint64_t> slots;
+  for (uint64_t key : keys) {
+    slots.insert(*hash.Lookup(key));
+  }
+  EXPECT_EQ(slots.size(), keys.size());
+}
+
+TEST(MinimalPerfectHash, Empty) {
+  absl::StatusOr<std::string> data = MinimalPerfectHash::Build({});
+  ASSERT_THAT(data, IsOk());
+  const AlignedData aligned(*data);
+  absl::StatusOr<MinimalPerfectHash> hash =
+      MinimalPerfectHash::View(aligned.view());
+  ASSERT_THAT(hash, IsOk());
+  EXPECT_EQ(hash->size(), 0);
+  EXPECT_EQ(hash->Lookup(42), std::nullopt);
+}
+
+TEST(MinimalPerfectHash, DuplicateKeys) {
+  EXPECT_THAT(MinimalPerfectHash::Build({1, 2, 1}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MinimalPerfectHash, InvalidData) {
+  const std::string data = *MinimalPerfectHash::Build({1, 2, 3});
+  const AlignedData truncated(data.substr(0, data.size() - 8));
+  EXPECT_THAT(MinimalPerfectHash::View(truncated.view()),
+              StatusIs(absl::StatusCode::kDataLoss));
+  const AlignedData aligned(data);
+  EXPECT_THAT(MinimalPerfectHash::View(aligned.view().substr(1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MinimalPerfectHash, CorruptData) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    keys.push_back(i * 7919);
+  }
+  const std::string data = *MinimalPerfectHash::Build(keys);
+  uint64_t num_levels;
+  std::memcpy(&num_levels, data.data() + 8, 8);
+  ASSERT_GT(num_levels, 1);
+
+  // Returns `data` with the word at `index` replaced by `value`.
+  const auto with_word = [&](size_t index, uint64_t value) {
+    std::string corrupt = data;
+    std::memcpy(&corrupt[index * 8], &value, 8);
+    return corrupt;
+  };
+  const size_t first_offset = 2;
+  const size_t last_offset = first_offset + num_levels;
+  const size_t last_rank = data.size() / 8 - 1;
+  for (const std::string& corrupt : {
+           with_word(0, keys.size() + 1),
+           with_word(first_offset, 64),
+           with_word(first_offset + 1, 0),
+           with_word(first_offset + 1, 65),
+           with_word(last_offset, std::numeric_limits<uint64_t>::max() - 63),
+           with_word(last_rank, 12345),
+       }) {
+    const AlignedData aligned(corrupt);
+    EXPECT_THAT(MinimalPerfectHash::View(aligned.view()),
+                StatusIs(absl::StatusCode::kDataLoss));
+  }
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,81 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/random-access-file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+auto RandomAccessFile::New(absl::string_view path)
+    -> absl::StatusOr<std::unique_ptr<RandomAccessFile>> {
+  const std::string path_str(path);
+  const int fd = open(path_str.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(
+        errno, absl::StrFormat("Failed to open %s", path_str));
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    const int error = errno;
+    close(fd);
+    return absl::ErrnoToStatus(
+        error, absl::StrFormat("Failed to stat %s", path_str));
+  }
+  return std::unique_ptr<RandomAccessFile>(
+      new RandomAccessFile(path, fd, static_cast<uint64_t>(info.st_size)));
+}
+
+RandomAccessFile::~RandomAccessFile() { close(fd_); }
+
+auto RandomAccessFile::Read(uint64_t offset, size_t size,
+                            std::string* out) const -> absl::Status {
+  out->resize(size);
+  size_t done = 0;
+  while (done < size) {
+    const ssize_t n =
+        pread(fd_, out->data() + done, size - done, offset + done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return absl::ErrnoToStatus(
+          errno, absl::StrFormat("Failed to read %s at offset %d", path_,
+                                 offset + done));
+    }
+    if (n == 0) {
+      out->resize(done);
+      return absl::OutOfRangeError(absl::StrFormat(
+          "%s: expected %d bytes at offset %d but the file ends after %d",
+          path_, size, offset, done));
+    }
+    done += n;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace bio
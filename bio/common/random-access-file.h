@@ -0,0 +1,74 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_RANDOM_ACCESS_FILE_H_
+#define BIO_COMMON_RANDOM_ACCESS_FILE_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// A read-only file that supports positioned reads. Reads do not share a file
+// position, so a RandomAccessFile can be read from several threads at once.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<RandomAccessFile> file,
+//                  RandomAccessFile::New("path/to/in.fasta"));
+// std::string buffer;
+// RETURN_IF_ERROR(file->Read(/*offset=*/1024, /*size=*/100, &buffer));
+// ```
+class RandomAccessFile {
+ public:
+  // Opens the file at `path`.
+  static auto New(absl::string_view path)
+      -> absl::StatusOr<std::unique_ptr<RandomAccessFile>>;
+
+  ~RandomAccessFile();
+
+  RandomAccessFile(const RandomAccessFile&) = delete;
+  auto operator=(const RandomAccessFile&) -> RandomAccessFile& = delete;
+
+  // Reads `size` bytes starting at `offset` into `out`, replacing its
+  // contents. Returns an OutOfRange error if the file ends before `size` bytes
+  // have been read.
+  auto Read(uint64_t offset, size_t size, std::string* out) const
+      -> absl::Status;
+
+  // Returns the size of the file when it was opened.
+  auto size() const -> uint64_t { return size_; }
+
+  // Returns the path of the file.
+  auto path() const -> absl::string_view { return path_; }
+
+ private:
+  RandomAccessFile(absl::string_view path, int fd, uint64_t size)
+      : path_(path), fd_(fd), size_(size) {}
+
+  std::string path_;
+  int fd_;
+  uint64_t size_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_RANDOM_ACCESS_FILE_H_
@@ -0,0 +1,66 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/random-access-file.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/common/test-files.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+TEST(RandomAccessFile, Read) {
+  const std::string path = WriteTempFile("random-access.txt", "0123456789");
+  absl::StatusOr<std::unique_ptr<RandomAccessFile>> file =
+      RandomAccessFile::New(path);
+  ASSERT_THAT(file, IsOk());
+  EXPECT_EQ((*file)->size(), 10);
+  EXPECT_EQ((*file)->path(), path);
+
+  std::string buffer = "previous contents";
+  EXPECT_THAT((*file)->Read(3, 4, &buffer), IsOk());
+  EXPECT_EQ(buffer, "3456");
+  EXPECT_THAT((*file)->Read(0, 10, &buffer), IsOk());
+  EXPECT_EQ(buffer, "0123456789");
+  EXPECT_THAT((*file)->Read(10, 0, &buffer), IsOk());
+  EXPECT_EQ(buffer, "");
+}
+
+TEST(RandomAccessFile, ReadPastEnd) {
+  const std::string path = WriteTempFile("random-access.txt", "0123456789");
+  std::unique_ptr<RandomAccessFile> file = *RandomAccessFile::New(path);
+  std::string buffer;
+  EXPECT_THAT(file->Read(8, 4, &buffer),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_EQ(buffer, "89");
+}
+
+TEST(RandomAccessFile, Missing) {
+  EXPECT_THAT(RandomAccessFile::New(gxl::JoinPath(TempDir(), "missing.txt")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,49 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/sampler.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/hash.h"
+#include "bio/common/minimal-perfect-hash.h"
+
+namespace bio {
+
+auto FractionalSampler::New(double fraction, uint64_t seed)
+    -> absl::StatusOr<FractionalSampler> {
+  if (!(fraction >= 0.0 && fraction <= 1.0)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "The sampling fraction must be between 0 and 1 but is %f", fraction));
+  }
+  const double threshold = std::ldexp(fraction, 64);
+  if (threshold >= std::ldexp(1.0, 64)) {
+    return FractionalSampler(fraction, seed, 0, /*keep_all=*/true);
+  }
+  return FractionalSampler(fraction, seed, static_cast<uint64_t>(threshold),
+                           /*keep_all=*/false);
+}
+
+auto FractionalSampler::Keep(absl::string_view key) const -> bool {
+  return keep_all_ ||
+         Mix64(StableHash64(key) ^ Mix64(seed_ + 0x9e3779b97f4a7c15ULL)) <
+             threshold_;
+}
+
+}  // namespace bio
@@ -0,0 +1,178 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_SAMPLER_H_
+#define BIO_COMMON_SAMPLER_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// Keeps a seeded, deterministic fraction of records, decided by hashing a key
+// such as the read name. Records with the same key are always kept or dropped
+// together, so the mates of paired files, or the alignments of a read, stay
+// consistent across files and runs.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(FractionalSampler sampler,
+//                  FractionalSampler::New(/*fraction=*/0.1, /*seed=*/7));
+// if (sampler.Keep(read.name)) {
+//   ...
+// }
+// ```
+class FractionalSampler {
+ public:
+  // Creates a sampler that keeps `fraction` of the keys, which must be between
+  // 0 and 1 inclusive. Different seeds select independent subsets.
+  static auto New(double fraction, uint64_t seed = 0)
+      -> absl::StatusOr<FractionalSampler>;
+
+  // Checks whether records with `key` are kept.
+  auto Keep(absl::string_view key) const -> bool;
+
+  // Returns the fraction of keys that are kept.
+  auto fraction() const -> double { return fraction_; }
+
+ private:
+  FractionalSampler(double fraction, uint64_t seed, uint64_t threshold,
+                    bool keep_all)
+      : fraction_(fraction),
+        seed_(seed),
+        threshold_(threshold),
+        keep_all_(keep_all) {}
+
+  double fraction_;
+  uint64_t seed_;
+
+  // Keys whose hash is below the threshold are kept.
+  uint64_t threshold_;
+  bool keep_all_;
+};
+
+// Keeps a uniform random sample of at most `k` records from a stream of
+// unknown length, in O(k) memory.
+//
+// This is Li's Algorithm L: rather than drawing a random number per record,
+// the sampler draws the number of records to skip before the next one enters
+// the reservoir, so skipped records need not be parsed at all. Callers check
+// Accept() for each record and only construct those that are accepted.
+//
+// Example usage:
+//
+// ```
+// ReservoirSampler<FastqSequence> sampler(/*k=*/1000, /*seed=*/7);
+// while (!parser->eof()) {
+//   if (!sampler.Accept()) {
+//     RETURN_IF_ERROR(parser->Skip());
+//     continue;
+//   }
+//   ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+//   if (read != nullptr) {
+//     sampler.Add(*std::move(read));
+//   }
+// }
+// std::vector<FastqSequence> sample = std::move(sampler).Finish();
+// ```
+template <typename T>
+class ReservoirSampler {
+ public:
+  explicit ReservoirSampler(size_t k, uint64_t seed = 0)
+      : k_(k), rng_(seed) {
+    reservoir_.reserve(k_);
+    if (k_ > 0) {
+      w_ = std::exp(std::log(Uniform()) / k_);
+    }
+  }
+
+  // Advances to the next record of the stream and returns whether it is
+  // sampled. If so, it must be passed to Add() before the next call.
+  auto Accept() -> bool {
+    ++seen_;
+    if (reservoir_.size() < k_) {
+      slot_ = reservoir_.size();
+      if (slot_ + 1 == k_) {
+        ScheduleNext();
+      }
+      return true;
+    }
+    if (k_ == 0 || seen_ < next_) {
+      return false;
+    }
+    slot_ = std::uniform_int_distribution<size_t>(0, k_ - 1)(rng_);
+    w_ *= std::exp(std::log(Uniform()) / k_);
+    ScheduleNext();
+    return true;
+  }
+
+  // Adds the record that was just accepted.
+  auto Add(T record) -> void {
+    if (slot_ == reservoir_.size()) {
+      reservoir_.push_back(std::move(record));
+    } else {
+      reservoir_[slot_] = std::move(record);
+    }
+  }
+
+  // Offers the next record, adding it if it is sampled.
+  auto Offer(T record) -> void {
+    if (Accept()) {
+      Add(std::move(record));
+    }
+  }
+
+  // Returns the number of records seen.
+  auto seen() const -> uint64_t { return seen_; }
+
+  // Returns the sampled records, in no particular order.
+  auto Finish() && -> std::vector<T> { return std::move(reservoir_); }
+
+ private:
+  // Returns a random number in (0, 1).
+  auto Uniform() -> double {
+    double u = 0.0;
+    while (u == 0.0) {
+      u = std::uniform_real_distribution<double>(0.0, 1.0)(rng_);
+    }
+    return u;
+  }
+
+  // Draws the index of the next record to enter the reservoir.
+  auto ScheduleNext() -> void {
+    const double skip = std::floor(std::log(Uniform()) / std::log1p(-w_));
+    next_ = seen_ + 1 +
+            (skip < 1e18 ? static_cast<uint64_t>(skip) : uint64_t{1} << 62);
+  }
+
+  size_t k_;
+  std::mt19937_64 rng_;
+  std::vector<T> reservoir_;
+  double w_ = 0.0;
+  uint64_t seen_ = 0;
+  uint64_t next_ = 0;
+  size_t slot_ = 0;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_SAMPLER_H_
@@ -0,0 +1,146 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::UnorderedElementsAre;
+
+auto CountKept(const FractionalSampler& sampler, int num_keys) -> int {
+  int kept = 0;
+  for (int i = 0; i < num_keys; ++i) {
+    kept += sampler.Keep(absl::StrCat("SRR001666.", i)) ? 1 : 0;
+  }
+  return kept;
+}
+
+TEST(FractionalSampler, KeepsTheFraction) {
+  for (double fraction : {0.01, 0.1, 0.5, 0.9}) {
+    absl::StatusOr<FractionalSampler> sampler =
+        FractionalSampler::New(fraction, 42);
+    ASSERT_THAT(sampler, IsOk());
+    EXPECT_DOUBLE_EQ(sampler->fraction(), fraction);
+    EXPECT_NEAR(CountKept(*sampler, 100000), 100000 * fraction, 1000)
+        << fraction;
+  }
+}
+
+TEST(FractionalSampler, KeepsNoneOrAll) {
+  absl::StatusOr<FractionalSampler> none = FractionalSampler::New(0.0);
+  ASSERT_THAT(none, IsOk());
+  EXPECT_EQ(CountKept(*none, 10000), 0);
+  absl::StatusOr<FractionalSampler> all = FractionalSampler::New(1.0);
+  ASSERT_THAT(all, IsOk());
+  EXPECT_EQ(CountKept(*all, 10000), 10000);
+}
+
+TEST(FractionalSampler, IsDeterministicPerSeed) {
+  absl::StatusOr<FractionalSampler> a = FractionalSampler::New(0.5, 1);
+  absl::StatusOr<FractionalSampler> b = FractionalSampler::New(0.5, 1);
+  absl::StatusOr<FractionalSampler> c = FractionalSampler::New(0.5, 2);
+  ASSERT_THAT(a, IsOk());
+  ASSERT_THAT(b, IsOk());
+  ASSERT_THAT(c, IsOk());
+  int same_seed_differences = 0;
+  int other_seed_differences = 0;
+  for (int i = 0; i < 10000; ++i) {
+    const std::string key = absl::StrCat("read", i);
+    same_seed_differences += a->Keep(key) != b->Keep(key) ? 1 : 0;
+    other_seed_differences += a->Keep(key) != c->Keep(key) ? 1 : 0;
+  }
+  EXPECT_EQ(same_seed_differences, 0);
+  EXPECT_NEAR(other_seed_differences, 5000, 300);
+}
+
+TEST(FractionalSampler, RejectsInvalidFractions) {
+  EXPECT_THAT(FractionalSampler::New(-0.1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(FractionalSampler::New(1.5),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(FractionalSampler::New(std::nan("")),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ReservoirSampler, KeepsShortStreams) {
+  ReservoirSampler<int> sampler(5);
+  for (int i = 0; i < 3; ++i) {
+    sampler.Offer(i);
+  }
+  EXPECT_EQ(sampler.seen(), 3);
+  EXPECT_THAT(std::move(sampler).Finish(), UnorderedElementsAre(0, 1, 2));
+}
+
+TEST(ReservoirSampler, KeepsNothingForZeroSize) {
+  ReservoirSampler<int> sampler(0);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(sampler.Accept());
+  }
+  EXPECT_TRUE(std::move(sampler).Finish().empty());
+}
+
+TEST(ReservoirSampler, SamplesUniformly) {
+  // Each of 20 records should be in a sample of 5 a quarter of the time.
+  static constexpr int kTrials = 20000;
+  std::vector<int> counts(20, 0);
+  for (int trial = 0; trial < kTrials; ++trial) {
+    ReservoirSampler<int> sampler(5, trial);
+    for (int i = 0; i < 20; ++i) {
+      sampler.Offer(i);
+    }
+    const std::vector<int> sample = std::move(sampler).Finish();
+    ASSERT_EQ(sample.size(), 5);
+    for (int i : sample) {
+      ++counts[i];
+    }
+  }
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_NEAR(counts[i], kTrials / 4, kTrials / 40) << i;
+  }
+}
+
+TEST(ReservoirSampler, SkipsMostRecordsOfLongStreams) {
+  ReservoirSampler<int> sampler(10, 3);
+  int accepted = 0;
+  for (int i = 0; i < 1000000; ++i) {
+    if (sampler.Accept()) {
+      sampler.Add(i);
+      ++accepted;
+    }
+  }
+  // About k * (1 + ln(n / k)) records enter the reservoir.
+  EXPECT_LT(accepted, 300);
+  const std::vector<int> sample = std::move(sampler).Finish();
+  EXPECT_EQ(sample.size(), 10);
+  EXPECT_GT(*std::max_element(sample.begin(), sample.end()), 10);
+}
+
+}  // namespace
+}  // namespace bio
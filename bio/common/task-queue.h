@@ -0,0 +1,157 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_TASK_QUEUE_H_
+#define BIO_COMMON_TASK_QUEUE_H_
+
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/thread-pool.h"
+
+namespace bio {
+
+// Runs tasks that produce a result of type T on a ThreadPool and hands the
+// results back to the caller, either in the order the tasks were submitted or
+// in the order in which they complete.
+//
+// The queue is meant to be driven from a single thread, which submits tasks and
+// retrieves their results. The caller bounds the amount of work in flight by
+// checking pending() before submitting more tasks.
+//
+// Example usage:
+//
+// ```
+// ThreadPool pool(/*num_threads=*/4);
+// TaskQueue<Result> queue(&pool, /*ordered=*/true);
+// while (HasMoreInput()) {
+//   if (queue.pending() >= kMaxPending) {
+//     Consume(*queue.Next());
+//   }
+//   queue.Submit([input = ReadInput()]() { return Process(input); });
+// }
+// while (queue.pending() > 0) {
+//   Consume(*queue.Next());
+// }
+// ```
+template <typename T>
+class TaskQueue {
+ public:
+  // Constructs a queue that runs tasks on `pool`, which must outlive the
+  // queue.
+  explicit TaskQueue(absl::Nonnull<ThreadPool*> pool, bool ordered = true)
+      : pool_(pool),
+        ordered_(ordered),
+        state_(std::make_shared<State>()),
+        next_submit_(0),
+        next_result_(0) {}
+
+  // Waits for any running tasks to finish. Their results are discarded.
+  ~TaskQueue() {
+    absl::MutexLock lock(&state_->mutex);
+    state_->mutex.Await(absl::Condition(
+        +[](State* state) { return state->running == 0; }, state_.get()));
+  }
+
+  TaskQueue(const TaskQueue&) = delete;
+  auto operator=(const TaskQueue&) -> TaskQueue& = delete;
+
+  // Schedules `task` to run on the pool.
+  auto Submit(std::function<T()> task) -> void {
+    const size_t id = next_submit_++;
+    {
+      absl::MutexLock lock(&state_->mutex);
+      ++state_->running;
+    }
+    pool_->Schedule(
+        [state = state_, ordered = ordered_, id, task = std::move(task)]() {
+          T result = task();
+          absl::MutexLock lock(&state->mutex);
+          state->done.emplace(id, std::move(result));
+          if (!ordered) {
+            state->completion_order.push(id);
+          }
+          --state->running;
+        });
+  }
+
+  // Blocks until the next result is available and returns it, or returns
+  // std::nullopt if there are no pending tasks.
+  auto Next() -> std::optional<T> {
+    if (pending() == 0) {
+      return std::nullopt;
+    }
+    absl::MutexLock lock(&state_->mutex);
+    size_t id = next_result_;
+    if (ordered_) {
+      state_->awaited = id;
+      state_->mutex.Await(absl::Condition(
+          +[](State* state) { return state->done.contains(state->awaited); },
+          state_.get()));
+    } else {
+      state_->mutex.Await(absl::Condition(
+          +[](State* state) { return !state->completion_order.empty(); },
+          state_.get()));
+      id = state_->completion_order.front();
+      state_->completion_order.pop();
+    }
+    auto it = state_->done.find(id);
+    T result = std::move(it->second);
+    state_->done.erase(it);
+    ++next_result_;
+    return result;
+  }
+
+  // Returns the number of tasks whose results have not been retrieved yet.
+  auto pending() const -> size_t { return next_submit_ - next_result_; }
+
+ private:
+  // State shared with the tasks running on the pool.
+  struct State {
+    absl::Mutex mutex;
+
+    // Results that have not been retrieved yet, by submission index.
+    absl::flat_hash_map<size_t, T> done ABSL_GUARDED_BY(mutex);
+
+    // Submission indexes in completion order. Only used if not ordered.
+    std::queue<size_t> completion_order ABSL_GUARDED_BY(mutex);
+
+    // The number of tasks that have been submitted but have not finished.
+    size_t running ABSL_GUARDED_BY(mutex) = 0;
+
+    // The submission index that Next() is waiting for, if ordered.
+    size_t awaited ABSL_GUARDED_BY(mutex) = 0;
+  };
+
+  ThreadPool* pool_;
+  bool ordered_;
+  std::shared_ptr<State> state_;
+
+  // The number of tasks submitted and the number of results retrieved. If
+  // ordered, `next_result_` is also the index of the next result to return.
+  size_t next_submit_;
+  size_t next_result_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_TASK_QUEUE_H_
@@ -0,0 +1,107 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/task-queue.h"
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "bio/common/thread-pool.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::testing::UnorderedElementsAreArray;
+
+TEST(TaskQueue, NextWithoutTasks) {
+  ThreadPool pool(2);
+  TaskQueue<int> queue(&pool);
+  EXPECT_EQ(queue.pending(), 0);
+  EXPECT_EQ(queue.Next(), std::nullopt);
+}
+
+TEST(TaskQueue, Ordered) {
+  ThreadPool pool(4);
+  TaskQueue<int> queue(&pool, /*ordered=*/true);
+
+  // The first task finishes last.
+  absl::Notification release;
+  queue.Submit([&release]() {
+    release.WaitForNotification();
+    return 0;
+  });
+  for (int i = 1; i < 50; ++i) {
+    queue.Submit([i]() { return i; });
+  }
+  EXPECT_EQ(queue.pending(), 50);
+  release.Notify();
+
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(queue.Next(), i);
+  }
+  EXPECT_EQ(queue.pending(), 0);
+  EXPECT_EQ(queue.Next(), std::nullopt);
+}
+
+TEST(TaskQueue, Unordered) {
+  ThreadPool pool(4);
+  TaskQueue<int> queue(&pool, /*ordered=*/false);
+
+  // The first task cannot finish until another result has been retrieved.
+  absl::Notification release;
+  queue.Submit([&release]() {
+    release.WaitForNotification();
+    return 0;
+  });
+  std::vector<int> expected = {0};
+  for (int i = 1; i < 20; ++i) {
+    queue.Submit([i]() { return i; });
+    expected.push_back(i);
+  }
+
+  std::vector<int> actual;
+  actual.push_back(*queue.Next());
+  release.Notify();
+  while (queue.pending() > 0) {
+    actual.push_back(*queue.Next());
+  }
+  EXPECT_NE(actual.front(), 0);
+  EXPECT_THAT(actual, UnorderedElementsAreArray(expected));
+}
+
+TEST(TaskQueue, InterleavedSubmitAndNext) {
+  ThreadPool pool(2);
+  TaskQueue<int> queue(&pool);
+  std::vector<int> results;
+  for (int i = 0; i < 100; ++i) {
+    if (queue.pending() >= 4) {
+      results.push_back(*queue.Next());
+    }
+    queue.Submit([i]() { return i * 2; });
+  }
+  while (queue.pending() > 0) {
+    results.push_back(*queue.Next());
+  }
+  ASSERT_EQ(results.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(results[i], i * 2);
+  }
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,49 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/temp-file.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+auto SystemTempDir() -> std::string {
+  std::error_code error;
+  std::string dir = std::filesystem::temp_directory_path(error).string();
+  return error ? "/tmp" : dir;
+}
+
+}  // namespace
+
+auto TempFilePath(absl::string_view dir, absl::string_view prefix)
+    -> std::string {
+  static const uint64_t process_id =
+      (uint64_t{std::random_device()()} << 32) | std::random_device()();
+  static std::atomic<uint64_t> num_files = 0;
+  return gxl::JoinPath(
+      dir.empty() ? SystemTempDir() : std::string(dir),
+      absl::StrFormat("%s-%016x-%d.tmp", prefix, process_id, num_files++));
+}
+
+}  // namespace bio
@@ -0,0 +1,40 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_TEMP_FILE_H_
+#define BIO_COMMON_TEMP_FILE_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// Returns the path of a new temporary file named `prefix`-<id>.tmp in `dir`,
+// or in the system temporary directory if `dir` is empty. The id is unique
+// within the process and random across processes, so that concurrent jobs can
+// share a directory. The file is not created.
+//
+// Example usage:
+//
+// ```
+// const std::string path = TempFilePath(options.temp_dir, "bio-sort");
+// RETURN_IF_ERROR(gxl::Open(path, "w", &file, gxl::file::Defaults()));
+// ```
+auto TempFilePath(absl::string_view dir, absl::string_view prefix)
+    -> std::string;
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_TEMP_FILE_H_
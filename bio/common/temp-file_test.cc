@@ -0,0 +1,40 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/temp-file.h"
+
+#include <string>
+
+#include "absl/strings/match.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+TEST(TempFilePath, Unique) {
+  const std::string first = TempFilePath("/data/tmp", "bio-test");
+  const std::string second = TempFilePath("/data/tmp", "bio-test");
+  EXPECT_TRUE(absl::StartsWith(first, "/data/tmp/bio-test-")) << first;
+  EXPECT_TRUE(absl::EndsWith(first, ".tmp")) << first;
+  EXPECT_NE(first, second);
+}
+
+TEST(TempFilePath, SystemTempDir) {
+  const std::string path = TempFilePath("", "bio-test");
+  EXPECT_FALSE(absl::StartsWith(path, "bio-test")) << path;
+  EXPECT_TRUE(absl::StrContains(path, "/bio-test-")) << path;
+}
+
+}  // namespace
+}  // namespace bio
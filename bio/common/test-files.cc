@@ -0,0 +1,36 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/test-files.h"
+
+#include <string>
+
+#include "absl/status/status_matchers.h"
+#include "absl/strings/string_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+
+auto WriteTempFile(absl::string_view name, absl::string_view contents)
+    -> std::string {
+  const std::string path = gxl::JoinPath(::testing::TempDir(), name);
+  EXPECT_THAT(gxl::SetContents(path, contents, gxl::file::Defaults()),
+              ::absl_testing::IsOk());
+  return path;
+}
+
+}  // namespace bio
@@ -0,0 +1,40 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_TEST_FILES_H_
+#define BIO_COMMON_TEST_FILES_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// Writes `contents` to the file `name` in the test temporary directory and
+// returns its path. Fails the current test if the file cannot be written.
+//
+// Use it for inputs that tests generate; check small fixed inputs into the
+// testdata directory of the package instead.
+//
+// Example usage:
+//
+// ```
+// const std::string path = WriteTempFile("reads.fastq", MakeRecords(1000));
+// ```
+auto WriteTempFile(absl::string_view name, absl::string_view contents)
+    -> std::string;
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_TEST_FILES_H_
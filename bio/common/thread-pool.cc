@@ -0,0 +1,82 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/thread-pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+
+namespace bio {
+
+ThreadPool::ThreadPool(size_t num_threads) : outstanding_(0), stopping_(false) {
+  num_threads = std::max<size_t>(num_threads, 1);
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this]() { WorkLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+auto ThreadPool::Schedule(std::function<void()> fn) -> void {
+  absl::MutexLock lock(&mutex_);
+  queue_.push(std::move(fn));
+  ++outstanding_;
+}
+
+auto ThreadPool::Wait() -> void {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &ThreadPool::IsIdle));
+}
+
+auto ThreadPool::HasWorkOrStopping() const -> bool {
+  return !queue_.empty() || stopping_;
+}
+
+auto ThreadPool::IsIdle() const -> bool { return outstanding_ == 0; }
+
+auto ThreadPool::WorkLoop() -> void {
+  while (true) {
+    std::function<void()> fn;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &ThreadPool::HasWorkOrStopping));
+      // Drain the queue before stopping so that the destructor runs every
+      // scheduled function.
+      if (queue_.empty()) {
+        return;
+      }
+      fn = std::move(queue_.front());
+      queue_.pop();
+    }
+    fn();
+    absl::MutexLock lock(&mutex_);
+    --outstanding_;
+  }
+}
+
+}  // namespace bio
@@ -0,0 +1,83 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_THREAD_POOL_H_
+#define BIO_COMMON_THREAD_POOL_H_
+
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace bio {
+
+// A fixed-size pool of worker threads that run scheduled functions in FIFO
+// order.
+//
+// Example usage:
+//
+// ```
+// ThreadPool pool(/*num_threads=*/4);
+// for (const auto& sequence : sequences) {
+//   pool.Schedule([&sequence]() {
+//     // Do stuff with `sequence`.
+//   });
+// }
+// pool.Wait();
+// ```
+class ThreadPool {
+ public:
+  // Starts `num_threads` worker threads. At least one thread is always
+  // started.
+  explicit ThreadPool(size_t num_threads);
+
+  // Waits for all scheduled functions to finish and joins the worker threads.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+  // Schedules `fn` to run on one of the worker threads.
+  auto Schedule(std::function<void()> fn) -> void;
+
+  // Blocks until all functions scheduled so far have finished running.
+  auto Wait() -> void;
+
+  // Returns the number of worker threads.
+  auto num_threads() const -> size_t { return threads_.size(); }
+
+ private:
+  // Conditions for absl::Mutex::Await().
+  auto HasWorkOrStopping() const -> bool ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  auto IsIdle() const -> bool ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // The main loop of each worker thread.
+  auto WorkLoop() -> void;
+
+  absl::Mutex mutex_;
+  std::queue<std::function<void()>> queue_ ABSL_GUARDED_BY(mutex_);
+
+  // The number of functions that are queued or running.
+  size_t outstanding_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_THREAD_POOL_H_
@@ -0,0 +1,59 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/thread-pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+TEST(ThreadPool, RunsAllScheduledFunctions) {
+  std::atomic<int> count = 0;
+  {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.num_threads(), 4);
+    for (int i = 0; i < 1000; ++i) {
+      pool.Schedule([&count]() { ++count; });
+    }
+  }
+  EXPECT_EQ(count, 1000);
+}
+
+TEST(ThreadPool, Wait) {
+  ThreadPool pool(3);
+  std::vector<int> values(100, 0);
+  for (size_t i = 0; i < values.size(); ++i) {
+    pool.Schedule([&values, i]() { values[i] = static_cast<int>(i * i); });
+  }
+  pool.Wait();
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], static_cast<int>(i * i));
+  }
+}
+
+TEST(ThreadPool, AtLeastOneThread) {
+  ThreadPool pool(0);
+  EXPECT_EQ(pool.num_threads(), 1);
+  std::atomic<bool> ran = false;
+  pool.Schedule([&ran]() { ran = true; });
+  pool.Wait();
+  EXPECT_TRUE(ran);
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,64 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_COMMON_VARINT_H_
+#define BIO_COMMON_VARINT_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+#include "absl/base/nullability.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// The maximum size of an encoded 64-bit varint.
+static constexpr size_t kMaxVarintSize = 10;
+
+// Appends `value` to `out` as a little-endian base-128 varint, as in Protocol
+// Buffers: 7 bits per byte, with the high bit set on all but the last byte.
+inline auto AppendVarint(uint64_t value, absl::Nonnull<std::string*> out)
+    -> void {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+// Decodes a varint from the front of `data` and removes it. Returns
+// std::nullopt, leaving `data` unchanged, if `data` does not start with a
+// valid varint.
+inline auto ConsumeVarint(absl::Nonnull<absl::string_view*> data)
+    -> std::optional<uint64_t> {
+  uint64_t value = 0;
+  for (size_t i = 0; i < data->size() && i < kMaxVarintSize; ++i) {
+    const uint8_t byte = static_cast<uint8_t>((*data)[i]);
+    if (i == kMaxVarintSize - 1 && byte > 1) {
+      return std::nullopt;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      data->remove_prefix(i + 1);
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace bio
+
+#endif  // BIO_COMMON_VARINT_H_
@@ -0,0 +1,69 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/common/varint.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+TEST(Varint, RoundTrip) {
+  std::string data;
+  const uint64_t values[] = {0, 1, 127, 128, 300, 1ULL << 35,
+                             std::numeric_limits<uint64_t>::max()};
+  for (uint64_t value : values) {
+    AppendVarint(value, &data);
+  }
+  absl::string_view remaining = data;
+  for (uint64_t value : values) {
+    EXPECT_EQ(ConsumeVarint(&remaining), value);
+  }
+  EXPECT_TRUE(remaining.empty());
+}
+
+TEST(Varint, Encoding) {
+  std::string data;
+  AppendVarint(300, &data);
+  EXPECT_EQ(data, "\xac\x02");
+  data.clear();
+  AppendVarint(std::numeric_limits<uint64_t>::max(), &data);
+  EXPECT_EQ(data.size(), kMaxVarintSize);
+}
+
+TEST(Varint, Invalid) {
+  absl::string_view truncated = "\x80\x80";
+  EXPECT_EQ(ConsumeVarint(&truncated), std::nullopt);
+  EXPECT_EQ(truncated.size(), 2);
+
+  absl::string_view empty;
+  EXPECT_EQ(ConsumeVarint(&empty), std::nullopt);
+
+  // 11 bytes, or 10 bytes with more than 64 bits.
+  const std::string too_long(10, '\xff');
+  absl::string_view data = too_long;
+  EXPECT_EQ(ConsumeVarint(&data), std::nullopt);
+  const std::string overflow = std::string(9, '\xff') + "\x02";
+  data = overflow;
+  EXPECT_EQ(ConsumeVarint(&data), std::nullopt);
+}
+
+}  // namespace
+}  // namespace bio
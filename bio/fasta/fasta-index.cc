@@ -0,0 +1,180 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/fasta-index.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "bio/common/strings.h"
+#include "gxl/file/file.h"
+#include "gxl/file/filelineiter.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+static constexpr char kDescriptionPrefix[] = ">";
+
+// The number of tab-separated fields on each line of a .fai file.
+static constexpr size_t kNumFields = 5;
+
+}  // namespace
+
+auto FastaIndexEntry::string() const -> std::string {
+  return absl::StrCat(name, "\t", length, "\t", offset, "\t", line_bases, "\t",
+                      line_width);
+}
+
+auto FastaIndex::Read(absl::string_view path) -> absl::StatusOr<FastaIndex> {
+  std::string contents;
+  RETURN_IF_ERROR(gxl::GetContents(path, &contents, gxl::file::Defaults()));
+  return Parse(contents);
+}
+
+auto FastaIndex::Parse(absl::string_view contents)
+    -> absl::StatusOr<FastaIndex> {
+  FastaIndex index;
+  int line_number = 0;
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    ++line_number;
+    line = absl::StripSuffix(line, "\r");
+    if (line.empty()) {
+      continue;
+    }
+    const std::vector<absl::string_view> fields = absl::StrSplit(line, '\t');
+    if (fields.size() != kNumFields) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Line %d: Expected %d fields but found %d",
+                          line_number, kNumFields, fields.size()));
+    }
+    FastaIndexEntry entry = {.name = std::string(fields[0])};
+    uint64_t* const values[] = {&entry.length, &entry.offset,
+                                &entry.line_bases, &entry.line_width};
+    for (size_t i = 0; i < 4; ++i) {
+      if (!absl::SimpleAtoi(fields[i + 1], values[i])) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Line %d: Invalid number: '%s'", line_number,
+                            fields[i + 1]));
+      }
+    }
+    if (entry.length > 0 &&
+        (entry.line_bases == 0 || entry.line_width < entry.line_bases)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Line %d: Invalid line layout: %d bases in %d bytes", line_number,
+          entry.line_bases, entry.line_width));
+    }
+    RETURN_IF_ERROR(index.Add(std::move(entry)));
+  }
+  return index;
+}
+
+auto FastaIndex::Build(absl::string_view path) -> absl::StatusOr<FastaIndex> {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
+
+  FastaIndex index;
+  std::optional<FastaIndexEntry> current;
+  // Whether the current sequence has had a line shorter than the others,
+  // which must be its last.
+  bool short_line_seen = false;
+  uint64_t offset = 0;
+  int line_number = 0;
+  // N.B. `file` is automatically closed by FileLines.
+  for (const std::string& line : gxl::FileLines(file->filename(), file)) {
+    ++line_number;
+    const uint64_t line_width = line.size() + 1;
+    if (absl::StartsWith(line, kDescriptionPrefix)) {
+      if (current.has_value()) {
+        RETURN_IF_ERROR(index.Add(*std::move(current)));
+      }
+      const absl::string_view description =
+          absl::StripSuffix(absl::StripPrefix(line, kDescriptionPrefix), "\r");
+      current = FastaIndexEntry{
+          .name = FirstWord(description),
+          .length = 0,
+          .offset = offset + line_width,
+          .line_bases = 0,
+          .line_width = 0,
+      };
+      short_line_seen = false;
+      offset += line_width;
+      continue;
+    }
+    offset += line_width;
+
+    const uint64_t bases = absl::StripSuffix(line, "\r").size();
+    if (bases == 0) {
+      short_line_seen = current.has_value();
+      continue;
+    }
+    if (!current.has_value()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "%s: Line %d: Sequence data before the first header", path,
+          line_number));
+    }
+    if (current->line_bases == 0) {
+      current->line_bases = bases;
+      current->line_width = line_width;
+    } else if (short_line_seen || bases > current->line_bases ||
+               (bases == current->line_bases &&
+                line_width != current->line_width)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "%s: Line %d: Sequence %s has lines of different lengths", path,
+          line_number, current->name));
+    }
+    short_line_seen = bases < current->line_bases;
+    current->length += bases;
+  }
+  if (current.has_value()) {
+    RETURN_IF_ERROR(index.Add(*std::move(current)));
+  }
+  return index;
+}
+
+auto FastaIndex::Serialize() const -> std::string {
+  std::string contents;
+  for (const FastaIndexEntry& entry : entries_) {
+    absl::StrAppend(&contents, entry.string(), "\n");
+  }
+  return contents;
+}
+
+auto FastaIndex::Find(absl::string_view name) const -> const FastaIndexEntry* {
+  auto it = by_name_.find(name);
+  return it == by_name_.end() ? nullptr : &entries_[it->second];
+}
+
+auto FastaIndex::Add(FastaIndexEntry entry) -> absl::Status {
+  if (!by_name_.emplace(entry.name, entries_.size()).second) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Duplicate sequence name: %s", entry.name));
+  }
+  entries_.push_back(std::move(entry));
+  return absl::OkStatus();
+}
+
+}  // namespace bio
@@ -0,0 +1,103 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_FASTA_INDEX_H_
+#define BIO_FASTA_FASTA_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// The location of a sequence in a FASTA file, as recorded in a .fai index.
+struct FastaIndexEntry {
+  // The sequence name, up to the first whitespace character.
+  std::string name;
+
+  // The number of bases in the sequence.
+  uint64_t length;
+
+  // The byte offset of the first base of the sequence in the (uncompressed)
+  // file.
+  uint64_t offset;
+
+  // The number of bases on each line.
+  uint64_t line_bases;
+
+  // The number of bytes on each line, including the line terminator.
+  uint64_t line_width;
+
+  // Returns the byte offset of the 0-based `position` in the sequence.
+  auto ByteOffset(uint64_t position) const -> uint64_t {
+    return offset + position / line_bases * line_width +
+           position % line_bases;
+  }
+
+  // Checks for equality.
+  auto operator==(const FastaIndexEntry& rhs) const -> bool {
+    return name == rhs.name && length == rhs.length && offset == rhs.offset &&
+           line_bases == rhs.line_bases && line_width == rhs.line_width;
+  }
+
+  // Serializes the entry to its .fai line, without a trailing newline.
+  auto string() const -> std::string;
+};
+
+// A .fai index, as written by `samtools faidx`, which records where each
+// sequence of a FASTA file starts and how its lines are laid out. Every line of
+// a sequence except the last must hold the same number of bases.
+//
+// See https://www.htslib.org/doc/faidx.html for more details.
+class FastaIndex {
+ public:
+  FastaIndex() = default;
+
+  // Reads the index from the .fai file at `path`.
+  static auto Read(absl::string_view path) -> absl::StatusOr<FastaIndex>;
+
+  // Parses the index from the contents of a .fai file.
+  static auto Parse(absl::string_view contents) -> absl::StatusOr<FastaIndex>;
+
+  // Builds the index of the uncompressed FASTA file at `path`.
+  static auto Build(absl::string_view path) -> absl::StatusOr<FastaIndex>;
+
+  // Serializes the index to the contents of a .fai file.
+  auto Serialize() const -> std::string;
+
+  // Returns the entry for the sequence named `name`, or nullptr if there is no
+  // such sequence.
+  auto Find(absl::string_view name) const -> const FastaIndexEntry*;
+
+  // Returns the entries in file order.
+  auto entries() const -> const std::vector<FastaIndexEntry>& {
+    return entries_;
+  }
+
+ private:
+  // Appends `entry`, failing if a sequence of the same name was already added.
+  auto Add(FastaIndexEntry entry) -> absl::Status;
+
+  std::vector<FastaIndexEntry> entries_;
+  absl::flat_hash_map<std::string, size_t> by_name_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_FASTA_INDEX_H_
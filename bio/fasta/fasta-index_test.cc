@@ -0,0 +1,97 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/fasta-index.h"
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/common/test-files.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+
+TEST(FastaIndexEntry, ByteOffset) {
+  const FastaIndexEntry entry = {
+      .name = "chr1",
+      .length = 57,
+      .offset = 23,
+      .line_bases = 10,
+      .line_width = 11,
+  };
+  EXPECT_EQ(entry.ByteOffset(0), 23);
+  EXPECT_EQ(entry.ByteOffset(9), 32);
+  EXPECT_EQ(entry.ByteOffset(10), 34);
+  EXPECT_EQ(entry.ByteOffset(56), 23 + 5 * 11 + 6);
+  EXPECT_EQ(entry.string(), "chr1\t57\t23\t10\t11");
+}
+
+TEST(FastaIndex, Read) {
+  absl::StatusOr<FastaIndex> index =
+      FastaIndex::Read("bio/fasta/testdata/indexed.fasta.fai");
+  ASSERT_THAT(index, IsOk());
+  EXPECT_THAT(index->entries(),
+              ElementsAre(FastaIndexEntry{"chr1", 57, 23, 10, 11},
+                          FastaIndexEntry{"chr2", 16, 92, 8, 9},
+                          FastaIndexEntry{"chrM", 5, 116, 5, 6}));
+  ASSERT_NE(index->Find("chr2"), nullptr);
+  EXPECT_EQ(index->Find("chr2")->offset, 92);
+  EXPECT_EQ(index->Find("chr3"), nullptr);
+}
+
+TEST(FastaIndex, BuildMatchesFile) {
+  absl::StatusOr<FastaIndex> built =
+      FastaIndex::Build("bio/fasta/testdata/indexed.fasta");
+  ASSERT_THAT(built, IsOk());
+  std::string expected;
+  ASSERT_THAT(gxl::GetContents("bio/fasta/testdata/indexed.fasta.fai",
+                               &expected, gxl::file::Defaults()),
+              IsOk());
+  EXPECT_EQ(built->Serialize(), expected);
+}
+
+TEST(FastaIndex, BuildCarriageReturns) {
+  absl::StatusOr<FastaIndex> index = FastaIndex::Build(WriteTempFile(
+      "crlf.fasta", ">a desc\r\nACGT\r\nAC\r\n>b\r\nGG\r\n"));
+  ASSERT_THAT(index, IsOk());
+  EXPECT_THAT(index->entries(), ElementsAre(FastaIndexEntry{"a", 6, 9, 4, 6},
+                                            FastaIndexEntry{"b", 2, 23, 2, 4}));
+}
+
+TEST(FastaIndex, BuildUnevenLines) {
+  EXPECT_THAT(FastaIndex::Build(
+                  WriteTempFile("uneven.fasta", ">a\nACGT\nAC\nACGT\n")),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(FastaIndex, ParseInvalid) {
+  EXPECT_THAT(FastaIndex::Parse("chr1\t10\t5\t10\n"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(FastaIndex::Parse("chr1\t10\t5\tten\t11\n"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(FastaIndex::Parse("chr1\t10\t5\t10\t11\nchr1\t10\t20\t10\t11\n"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace bio
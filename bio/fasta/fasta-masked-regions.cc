@@ -0,0 +1,301 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/fasta-masked-regions.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "bio/bed/bed-writer.h"
+#include "bio/bed/bed.h"
+#include "bio/common/strings.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+static constexpr char kDescriptionPrefix = '>';
+
+// The number of bases classified per step.
+static constexpr size_t kBlockSize = 64;
+
+// Bitmasks of the bases in a block that are lowercase and that are N.
+struct BlockMasks {
+  uint64_t lower = 0;
+  uint64_t n = 0;
+};
+
+auto IsLower(char base) -> bool { return base >= 'a' && base <= 'z'; }
+
+auto IsN(char base) -> bool { return base == 'N' || base == 'n'; }
+
+// Classifies up to kBlockSize bases one at a time.
+auto ClassifyScalar(absl::string_view bases) -> BlockMasks {
+  BlockMasks masks;
+  for (size_t i = 0; i < bases.size(); ++i) {
+    masks.lower |= static_cast<uint64_t>(IsLower(bases[i])) << i;
+    masks.n |= static_cast<uint64_t>(IsN(bases[i])) << i;
+  }
+  return masks;
+}
+
+#if defined(__SSE2__)
+
+// Classifies exactly kBlockSize bases starting at `data`, 16 at a time.
+auto ClassifySse2(const char* data) -> BlockMasks {
+  const __m128i case_mask = _mm_set1_epi8(static_cast<char>(0xdf));
+  const __m128i n = _mm_set1_epi8('N');
+  const __m128i before_lower = _mm_set1_epi8('a' - 1);
+  const __m128i after_lower = _mm_set1_epi8('z' + 1);
+  BlockMasks masks;
+  for (size_t i = 0; i < kBlockSize; i += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(bytes, before_lower),
+                                        _mm_cmplt_epi8(bytes, after_lower));
+    const __m128i is_n = _mm_cmpeq_epi8(_mm_and_si128(bytes, case_mask), n);
+    masks.lower |= static_cast<uint64_t>(_mm_movemask_epi8(lower)) << i;
+    masks.n |= static_cast<uint64_t>(_mm_movemask_epi8(is_n)) << i;
+  }
+  return masks;
+}
+
+#endif  // defined(__SSE2__)
+
+auto Classify(absl::string_view bases) -> BlockMasks {
+#if defined(__SSE2__)
+  if (bases.size() == kBlockSize) {
+    return ClassifySse2(bases.data());
+  }
+#endif
+  return ClassifyScalar(bases);
+}
+
+}  // namespace
+
+MaskedRegionScanner::MaskedRegionScanner(
+    absl::Nullable<BedWriter*> soft_mask_writer,
+    absl::Nullable<BedWriter*> gap_writer, const MaskedRegionOptions& options)
+    : soft_mask_({.writer = soft_mask_writer,
+                  .min_length = options.min_soft_mask_length}),
+      gap_({.writer = gap_writer, .min_length = options.min_gap_length}) {}
+
+auto MaskedRegionScanner::Start(absl::string_view name) -> absl::Status {
+  if (started_) {
+    RETURN_IF_ERROR(Finish());
+  }
+  name_ = std::string(name);
+  started_ = true;
+  position_ = 0;
+  return absl::OkStatus();
+}
+
+auto MaskedRegionScanner::Feed(absl::string_view bases) -> absl::Status {
+  if (!started_) {
+    return absl::FailedPreconditionError(
+        "Feed() called before Start() or after Finish()");
+  }
+  if (!pending_.empty()) {
+    const size_t size = std::min(kBlockSize - pending_.size(), bases.size());
+    pending_.append(bases.data(), size);
+    bases.remove_prefix(size);
+    if (pending_.size() < kBlockSize) {
+      return absl::OkStatus();
+    }
+    Scan(pending_);
+    pending_.clear();
+  }
+  while (bases.size() >= kBlockSize) {
+    Scan(bases.substr(0, kBlockSize));
+    bases.remove_prefix(kBlockSize);
+  }
+  pending_.assign(bases.data(), bases.size());
+  RETURN_IF_ERROR(Flush(&soft_mask_));
+  return Flush(&gap_);
+}
+
+auto MaskedRegionScanner::Finish() -> absl::Status {
+  if (!started_) {
+    return absl::OkStatus();
+  }
+  started_ = false;
+  if (!pending_.empty()) {
+    Scan(pending_);
+    pending_.clear();
+  }
+  for (Run* run : {&soft_mask_, &gap_}) {
+    if (run->open) {
+      Close(position_, run);
+    }
+    RETURN_IF_ERROR(Flush(run));
+  }
+  return absl::OkStatus();
+}
+
+auto MaskedRegionScanner::Scan(absl::string_view block) -> void {
+  const BlockMasks masks = Classify(block);
+  if (soft_mask_.writer != nullptr) {
+    Track(masks.lower, block.size(), position_, &soft_mask_);
+  }
+  if (gap_.writer != nullptr) {
+    Track(masks.n, block.size(), position_, &gap_);
+  }
+  position_ += block.size();
+}
+
+auto MaskedRegionScanner::Track(uint64_t mask, size_t size, uint64_t position,
+                                Run* run) -> void {
+  const uint64_t open_mask = size == kBlockSize ? ~uint64_t{0}
+                                                : (uint64_t{1} << size) - 1;
+  // Most blocks lie entirely inside or outside of a run.
+  if (mask == (run->open ? open_mask : 0)) {
+    return;
+  }
+  // Bit i is set if base i is in a different class from base i - 1, where the
+  // base before the block is the last base of the previous block.
+  uint64_t boundaries =
+      (mask ^ ((mask << 1) | static_cast<uint64_t>(run->open))) & open_mask;
+  while (boundaries != 0) {
+    const uint64_t boundary = position + std::countr_zero(boundaries);
+    if (run->open) {
+      Close(boundary, run);
+    } else {
+      run->open = true;
+      run->start = boundary;
+    }
+    boundaries &= boundaries - 1;
+  }
+}
+
+auto MaskedRegionScanner::Close(uint64_t end, Run* run) -> void {
+  run->open = false;
+  if (end - run->start >= run->min_length) {
+    run->done.push_back({.chromosome = name_, .start = run->start, .end = end});
+  }
+}
+
+auto MaskedRegionScanner::Flush(Run* run) -> absl::Status {
+  if (run->writer != nullptr && !run->done.empty()) {
+    RETURN_IF_ERROR(run->writer->Write(run->done));
+  }
+  run->done.clear();
+  return absl::OkStatus();
+}
+
+auto ExtractMaskedRegions(absl::Nonnull<FastaParser*> parser,
+                          absl::Nullable<BedWriter*> soft_mask_writer,
+                          absl::Nullable<BedWriter*> gap_writer,
+                          const MaskedRegionOptions& options) -> absl::Status {
+  MaskedRegionScanner scanner(soft_mask_writer, gap_writer, options);
+  while (!parser->eof()) {
+    std::optional<std::unique_ptr<FastaSequence>> sequence =
+        parser->Next(options.truncate_names);
+    if (!sequence.has_value()) {
+      break;
+    }
+    RETURN_IF_ERROR(scanner.Start((*sequence)->name));
+    RETURN_IF_ERROR(scanner.Feed((*sequence)->sequence));
+  }
+  return scanner.Finish();
+}
+
+auto ExtractMaskedRegionsFromFile(absl::string_view path,
+                                  absl::Nullable<BedWriter*> soft_mask_writer,
+                                  absl::Nullable<BedWriter*> gap_writer,
+                                  const MaskedRegionOptions& options)
+    -> absl::Status {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
+
+  MaskedRegionScanner scanner(soft_mask_writer, gap_writer, options);
+  std::string buffer(std::max<size_t>(options.chunk_size, 1), '\0');
+  std::string header;
+  bool in_header = false;
+  bool at_line_start = true;
+  bool started = false;
+  absl::Status status;
+  auto start = [&]() -> absl::Status {
+    started = true;
+    absl::string_view name = absl::StripSuffix(header, "\r");
+    return scanner.Start(options.truncate_names ? FirstWord(name)
+                                                : std::string(name));
+  };
+  while (status.ok()) {
+    const size_t size = file->Read(buffer.data(), buffer.size());
+    if (size == 0) {
+      break;
+    }
+    absl::string_view chunk(buffer.data(), size);
+    while (!chunk.empty() && status.ok()) {
+      if (at_line_start && chunk.front() == kDescriptionPrefix) {
+        in_header = true;
+        header.clear();
+        chunk.remove_prefix(1);
+      }
+      const size_t newline = chunk.find('\n');
+      absl::string_view line = chunk.substr(0, newline);
+      chunk.remove_prefix(newline == absl::string_view::npos ? chunk.size()
+                                                             : newline + 1);
+      at_line_start = newline != absl::string_view::npos;
+      if (in_header) {
+        header.append(line);
+        if (at_line_start) {
+          in_header = false;
+          status = start();
+        }
+        continue;
+      }
+      line = absl::StripSuffix(line, "\r");
+      if (line.empty()) {
+        continue;
+      }
+      if (!started) {
+        status = absl::InvalidArgumentError(absl::StrFormat(
+            "%s: sequence data before the first header", path));
+        continue;
+      }
+      status = scanner.Feed(line);
+    }
+  }
+  if (status.ok() && in_header) {
+    // The last header is not followed by a newline.
+    status = start();
+  }
+  if (status.ok()) {
+    status = scanner.Finish();
+  }
+  const absl::Status close_status = file->Close(gxl::file::Defaults());
+  RETURN_IF_ERROR(status);
+  return close_status;
+}
+
+}  // namespace bio
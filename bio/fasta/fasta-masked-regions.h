@@ -0,0 +1,162 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_FASTA_MASKED_REGIONS_H_
+#define BIO_FASTA_FASTA_MASKED_REGIONS_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "bio/bed/bed-writer.h"
+#include "bio/bed/bed.h"
+#include "bio/fasta/fasta-parser.h"
+
+namespace bio {
+
+// Options for extracting soft-masked regions and gaps from FASTA sequences.
+struct MaskedRegionOptions {
+  // The minimum length of a run of lowercase bases to be reported.
+  size_t min_soft_mask_length = 1;
+
+  // The minimum length of a run of N bases to be reported.
+  size_t min_gap_length = 1;
+
+  // Whether sequence names are truncated to their first word.
+  bool truncate_names = true;
+
+  // The number of bytes read at a time by ExtractMaskedRegionsFromFile.
+  size_t chunk_size = 1 << 20;
+};
+
+// Finds runs of lowercase (soft-masked) bases and runs of N bases in sequences
+// that are fed to it in pieces of any size, and writes them as BED3 entries.
+// Runs that span several pieces are reported once, so a sequence of any length
+// can be scanned with bounded memory.
+//
+// Bytes are classified 64 at a time into bitmasks, using SSE2 where available,
+// and run boundaries are found by scanning the bits that differ from their
+// predecessor. Bases are buffered across calls to Feed(), so that short pieces
+// such as FASTA lines are still classified in full blocks; only the last
+// partial block of a sequence is classified one base at a time.
+//
+// Example usage:
+//
+// ```
+// MaskedRegionScanner scanner(soft_mask_writer.get(), gap_writer.get(), {});
+// RETURN_IF_ERROR(scanner.Start("chr1"));
+// for (absl::string_view line : lines) {
+//   RETURN_IF_ERROR(scanner.Feed(line));
+// }
+// RETURN_IF_ERROR(scanner.Finish());
+// ```
+class MaskedRegionScanner {
+ public:
+  // Constructs a scanner that writes soft-masked regions to `soft_mask_writer`
+  // and gaps to `gap_writer`. Either writer may be null, in which case those
+  // regions are not reported.
+  MaskedRegionScanner(absl::Nullable<BedWriter*> soft_mask_writer,
+                      absl::Nullable<BedWriter*> gap_writer,
+                      const MaskedRegionOptions& options);
+
+  // Starts a new sequence named `name`, finishing the current one if any.
+  auto Start(absl::string_view name) -> absl::Status;
+
+  // Scans the next bases of the current sequence.
+  auto Feed(absl::string_view bases) -> absl::Status;
+
+  // Reports the runs that extend to the end of the current sequence.
+  auto Finish() -> absl::Status;
+
+ private:
+  // A run of bases of one class.
+  struct Run {
+    absl::Nullable<BedWriter*> writer;
+    size_t min_length;
+
+    // Whether the last base scanned belongs to the run.
+    bool open = false;
+
+    // The start of the open run.
+    uint64_t start = 0;
+
+    // Runs that have ended but have not been written yet.
+    std::vector<BedEntry> done;
+  };
+
+  // Classifies `block` and updates both runs with it.
+  auto Scan(absl::string_view block) -> void;
+
+  // Updates `run` with the classification of `size` bases starting at
+  // `position`, where bit i of `mask` is set if base i is in the class.
+  auto Track(uint64_t mask, size_t size, uint64_t position, Run* run) -> void;
+
+  // Closes `run` at `end`.
+  auto Close(uint64_t end, Run* run) -> void;
+
+  // Writes and clears the completed runs.
+  auto Flush(Run* run) -> absl::Status;
+
+  Run soft_mask_;
+  Run gap_;
+  std::string name_;
+  bool started_ = false;
+
+  // The number of bases scanned in the current sequence.
+  uint64_t position_ = 0;
+
+  // Bases fed but not scanned yet, fewer than one block.
+  std::string pending_;
+};
+
+// Writes the soft-masked regions and gaps of every sequence read from `parser`
+// as BED3 entries. Each sequence is held in memory in full by the parser; use
+// ExtractMaskedRegionsFromFile to bound memory use on long sequences.
+auto ExtractMaskedRegions(absl::Nonnull<FastaParser*> parser,
+                          absl::Nullable<BedWriter*> soft_mask_writer,
+                          absl::Nullable<BedWriter*> gap_writer,
+                          const MaskedRegionOptions& options = {})
+    -> absl::Status;
+
+// Writes the soft-masked regions and gaps of every sequence in the FASTA file
+// at `path` as BED3 entries. The file is read in chunks of
+// MaskedRegionOptions::chunk_size bytes, so memory use does not depend on the
+// sequence lengths.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<BedWriter> repeats,
+//                  BedWriter::New("path/to/repeats.bed"));
+// ASSIGN_OR_RETURN(std::unique_ptr<BedWriter> gaps,
+//                  BedWriter::New("path/to/gaps.bed"));
+// RETURN_IF_ERROR(ExtractMaskedRegionsFromFile(
+//     "path/to/genome.fasta", repeats.get(), gaps.get(),
+//     {.min_gap_length = 10}));
+// RETURN_IF_ERROR(repeats->Close());
+// RETURN_IF_ERROR(gaps->Close());
+// ```
+auto ExtractMaskedRegionsFromFile(absl::string_view path,
+                                  absl::Nullable<BedWriter*> soft_mask_writer,
+                                  absl::Nullable<BedWriter*> gap_writer,
+                                  const MaskedRegionOptions& options = {})
+    -> absl::Status;
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_FASTA_MASKED_REGIONS_H_
@@ -0,0 +1,193 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/fasta-masked-regions.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/bed/bed-writer.h"
+#include "bio/common/test-files.h"
+#include "bio/fasta/fasta-parser.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+static constexpr char kTestFile[] = "bio/fasta/testdata/soft-masked.fasta";
+
+auto ReadFile(const std::string& path) -> std::string {
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents(path, &contents, gxl::file::Defaults()),
+              IsOk());
+  return contents;
+}
+
+// Returns the BED3 lines for the runs of bases in `sequence` for which
+// `in_class` is true, computed one base at a time.
+template <typename Predicate>
+auto NaiveRuns(absl::string_view name, absl::string_view sequence,
+               Predicate in_class) -> std::string {
+  std::string bed;
+  size_t i = 0;
+  while (i < sequence.size()) {
+    if (!in_class(sequence[i])) {
+      ++i;
+      continue;
+    }
+    const size_t start = i;
+    while (i < sequence.size() && in_class(sequence[i])) {
+      ++i;
+    }
+    absl::StrAppend(&bed, name, "\t", start, "\t", i, "\n");
+  }
+  return bed;
+}
+
+TEST(ExtractMaskedRegions, Parser) {
+  const std::string soft_mask_path = gxl::JoinPath(TempDir(), "soft.bed");
+  const std::string gap_path = gxl::JoinPath(TempDir(), "gap.bed");
+  std::unique_ptr<BedWriter> soft_mask_writer =
+      BedWriter::NewOrDie(soft_mask_path);
+  std::unique_ptr<BedWriter> gap_writer = BedWriter::NewOrDie(gap_path);
+  std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(kTestFile);
+
+  EXPECT_THAT(ExtractMaskedRegions(parser.get(), soft_mask_writer.get(),
+                                   gap_writer.get()),
+              IsOk());
+  EXPECT_THAT(soft_mask_writer->Close(), IsOk());
+  EXPECT_THAT(gap_writer->Close(), IsOk());
+
+  EXPECT_EQ(ReadFile(soft_mask_path),
+            "chr1\t4\t8\n"
+            "chr1\t20\t22\n");
+  EXPECT_EQ(ReadFile(gap_path),
+            "chr1\t8\t12\n"
+            "chr1\t20\t22\n"
+            "chr2\t0\t8\n");
+}
+
+TEST(ExtractMaskedRegionsFromFile, MatchesParser) {
+  for (size_t chunk_size : {1, 3, 7, 64, 1 << 20}) {
+    const std::string gap_path = gxl::JoinPath(TempDir(), "gap.bed");
+    std::unique_ptr<BedWriter> gap_writer = BedWriter::NewOrDie(gap_path);
+    EXPECT_THAT(
+        ExtractMaskedRegionsFromFile(kTestFile, /*soft_mask_writer=*/nullptr,
+                                     gap_writer.get(),
+                                     {.chunk_size = chunk_size}),
+        IsOk());
+    EXPECT_THAT(gap_writer->Close(), IsOk());
+    EXPECT_EQ(ReadFile(gap_path),
+              "chr1\t8\t12\n"
+              "chr1\t20\t22\n"
+              "chr2\t0\t8\n")
+        << "chunk size " << chunk_size;
+  }
+}
+
+TEST(ExtractMaskedRegionsFromFile, MinLengthAndCarriageReturns) {
+  const std::string fasta_path =
+      WriteTempFile("crlf.fasta",
+                    ">seq1 description\r\nACnNNa\r\nccGT\r\n>seq2\r\nNNn");
+  const std::string soft_mask_path = gxl::JoinPath(TempDir(), "soft.bed");
+  const std::string gap_path = gxl::JoinPath(TempDir(), "gap.bed");
+  std::unique_ptr<BedWriter> soft_mask_writer =
+      BedWriter::NewOrDie(soft_mask_path);
+  std::unique_ptr<BedWriter> gap_writer = BedWriter::NewOrDie(gap_path);
+
+  EXPECT_THAT(ExtractMaskedRegionsFromFile(
+                  fasta_path, soft_mask_writer.get(), gap_writer.get(),
+                  {.min_soft_mask_length = 2, .min_gap_length = 3,
+                   .chunk_size = 5}),
+              IsOk());
+  EXPECT_THAT(soft_mask_writer->Close(), IsOk());
+  EXPECT_THAT(gap_writer->Close(), IsOk());
+
+  EXPECT_EQ(ReadFile(soft_mask_path), "seq1\t5\t8\n");
+  EXPECT_EQ(ReadFile(gap_path),
+            "seq1\t2\t5\n"
+            "seq2\t0\t3\n");
+}
+
+TEST(ExtractMaskedRegionsFromFile, SequenceBeforeHeader) {
+  const std::string fasta_path =
+      WriteTempFile("headless.fasta", "ACGT\n>seq\nACGT\n");
+  EXPECT_THAT(ExtractMaskedRegionsFromFile(fasta_path, nullptr, nullptr),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ExtractMaskedRegionsFromFile, MissingFile) {
+  EXPECT_FALSE(
+      ExtractMaskedRegionsFromFile("bio/fasta/testdata/missing.fasta",
+                                   nullptr, nullptr)
+          .ok());
+}
+
+TEST(MaskedRegionScanner, FeedBeforeStart) {
+  MaskedRegionScanner scanner(nullptr, nullptr, {});
+  EXPECT_THAT(scanner.Feed("ACGT"),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MaskedRegionScanner, MatchesNaiveAcrossPieces) {
+  std::mt19937 rng(42);
+  static constexpr char kAlphabet[] = "ACGTacgtNnRy";
+  std::string sequence;
+  for (int i = 0; i < 5000; ++i) {
+    // Draw runs of random lengths so that runs cross block boundaries.
+    const char base = kAlphabet[rng() % (sizeof(kAlphabet) - 1)];
+    sequence.append(rng() % 150 + 1, base);
+  }
+
+  const std::string soft_mask_path = gxl::JoinPath(TempDir(), "soft.bed");
+  const std::string gap_path = gxl::JoinPath(TempDir(), "gap.bed");
+  std::unique_ptr<BedWriter> soft_mask_writer =
+      BedWriter::NewOrDie(soft_mask_path);
+  std::unique_ptr<BedWriter> gap_writer = BedWriter::NewOrDie(gap_path);
+  MaskedRegionScanner scanner(soft_mask_writer.get(), gap_writer.get(), {});
+  EXPECT_THAT(scanner.Start("seq"), IsOk());
+  absl::string_view remaining = sequence;
+  while (!remaining.empty()) {
+    const size_t size = std::min<size_t>(rng() % 200, remaining.size());
+    EXPECT_THAT(scanner.Feed(remaining.substr(0, size)), IsOk());
+    remaining.remove_prefix(size);
+  }
+  EXPECT_THAT(scanner.Finish(), IsOk());
+  EXPECT_THAT(soft_mask_writer->Close(), IsOk());
+  EXPECT_THAT(gap_writer->Close(), IsOk());
+
+  EXPECT_EQ(ReadFile(soft_mask_path),
+            NaiveRuns("seq", sequence,
+                      [](char base) { return base >= 'a' && base <= 'z'; }));
+  EXPECT_EQ(ReadFile(gap_path),
+            NaiveRuns("seq", sequence,
+                      [](char base) { return base == 'N' || base == 'n'; }));
+}
+
+}  // namespace
+}  // namespace bio
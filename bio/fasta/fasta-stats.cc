@@ -0,0 +1,186 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/fasta-stats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/bedgraph/bedgraph-writer.h"
+#include "bio/bedgraph/bedgraph.h"
+#include "bio/common/base-counts.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The maximum number of sequences in flight per thread.
+static constexpr size_t kPendingSequencesPerThread = 2;
+
+auto IsN(char base) -> bool { return base == 'N' || base == 'n'; }
+
+auto FindGaps(absl::string_view sequence, size_t min_gap_length)
+    -> std::vector<SequenceGap> {
+  std::vector<SequenceGap> gaps;
+  size_t i = 0;
+  while (i < sequence.size()) {
+    if (!IsN(sequence[i])) {
+      ++i;
+      continue;
+    }
+    const size_t start = i;
+    while (i < sequence.size() && IsN(sequence[i])) {
+      ++i;
+    }
+    if (i - start >= min_gap_length) {
+      gaps.push_back({.start = start, .end = i});
+    }
+  }
+  return gaps;
+}
+
+auto ComputeGcWindows(const std::string& name, absl::string_view sequence,
+                      size_t window_size, size_t window_step)
+    -> std::vector<BedGraphEntry> {
+  // Keep the counts of the current window and update them as it slides, so
+  // that each base is counted at most twice whatever the step.
+  uint64_t gc = 0;
+  uint64_t acgt = 0;
+  const auto add = [&gc, &acgt](absl::string_view bases) {
+    const BaseCounts counts = CountBases(bases);
+    gc += counts.g + counts.c;
+    acgt += counts.acgt();
+  };
+  const auto remove = [&gc, &acgt](absl::string_view bases) {
+    const BaseCounts counts = CountBases(bases);
+    gc -= counts.g + counts.c;
+    acgt -= counts.acgt();
+  };
+
+  std::vector<BedGraphEntry> windows;
+  size_t previous_start = 0;
+  size_t previous_end = 0;
+  for (size_t start = 0; start < sequence.size(); start += window_step) {
+    const size_t end = std::min(start + window_size, sequence.size());
+    if (start >= previous_end) {
+      gc = 0;
+      acgt = 0;
+      add(sequence.substr(start, end - start));
+    } else {
+      remove(sequence.substr(previous_start, start - previous_start));
+      add(sequence.substr(previous_end, end - previous_end));
+    }
+    previous_start = start;
+    previous_end = end;
+    if (acgt > 0) {
+      windows.push_back({
+          .chromosome = name,
+          .start = start,
+          .end = end,
+          .value = static_cast<double>(gc) / acgt,
+      });
+    }
+    if (end == sequence.size()) {
+      break;
+    }
+  }
+  return windows;
+}
+
+}  // namespace
+
+auto ComputeFastaSequenceStats(const FastaSequence& sequence,
+                               const FastaStatsOptions& options)
+    -> FastaSequenceStats {
+  FastaSequenceStats stats = {
+      .name = sequence.name,
+      .length = sequence.size(),
+      .counts = CountBases(sequence.sequence),
+  };
+  if (stats.counts.n > 0) {
+    stats.gaps = FindGaps(sequence.sequence,
+                          std::max<size_t>(options.min_gap_length, 1));
+  }
+  if (options.window_size > 0) {
+    const size_t step =
+        options.window_step > 0 ? options.window_step : options.window_size;
+    stats.gc_windows = ComputeGcWindows(sequence.name, sequence.sequence,
+                                        options.window_size, step);
+  }
+  return stats;
+}
+
+auto ComputeFastaStats(absl::Nonnull<FastaParser*> parser,
+                       const FastaStatsOptions& options,
+                       absl::Nullable<BedGraphWriter*> gc_writer)
+    -> absl::StatusOr<std::vector<FastaSequenceStats>> {
+  std::vector<FastaSequenceStats> results;
+  auto consume = [&results,
+                  gc_writer](FastaSequenceStats stats) -> absl::Status {
+    if (gc_writer != nullptr) {
+      RETURN_IF_ERROR(gc_writer->Write(stats.gc_windows));
+      stats.gc_windows.clear();
+    }
+    results.push_back(std::move(stats));
+    return absl::OkStatus();
+  };
+
+  if (options.num_threads <= 1) {
+    while (!parser->eof()) {
+      std::optional<std::unique_ptr<FastaSequence>> sequence =
+          parser->Next(options.truncate_names);
+      if (!sequence.has_value()) {
+        break;
+      }
+      RETURN_IF_ERROR(consume(ComputeFastaSequenceStats(**sequence, options)));
+    }
+    return results;
+  }
+
+  ThreadPool pool(options.num_threads);
+  TaskQueue<FastaSequenceStats> queue(&pool);
+  const size_t max_pending = kPendingSequencesPerThread * options.num_threads;
+  while (!parser->eof()) {
+    std::optional<std::unique_ptr<FastaSequence>> sequence =
+        parser->Next(options.truncate_names);
+    if (!sequence.has_value()) {
+      break;
+    }
+    if (queue.pending() >= max_pending) {
+      RETURN_IF_ERROR(consume(*queue.Next()));
+    }
+    std::shared_ptr<const FastaSequence> shared = std::move(*sequence);
+    queue.Submit([shared, &options]() {
+      return ComputeFastaSequenceStats(*shared, options);
+    });
+  }
+  while (queue.pending() > 0) {
+    RETURN_IF_ERROR(consume(*queue.Next()));
+  }
+  return results;
+}
+
+}  // namespace bio
@@ -0,0 +1,118 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_FASTA_STATS_H_
+#define BIO_FASTA_FASTA_STATS_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "bio/bedgraph/bedgraph-writer.h"
+#include "bio/bedgraph/bedgraph.h"
+#include "bio/common/base-counts.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+
+namespace bio {
+
+// Options for computing FASTA statistics.
+struct FastaStatsOptions {
+  // The size of the GC windows. If 0, GC windows are not computed.
+  size_t window_size = 0;
+
+  // The distance between the starts of consecutive GC windows. If 0, the
+  // windows are tiled, i.e. the step is the window size.
+  size_t window_step = 0;
+
+  // The minimum length of a run of N bases to be reported as a gap.
+  size_t min_gap_length = 1;
+
+  // The number of threads to spread sequences across. If 1 or less, the
+  // sequences are processed on the calling thread.
+  size_t num_threads = 1;
+
+  // Whether sequence names are truncated to their first word.
+  bool truncate_names = true;
+};
+
+// A run of N bases, in 0-based, half-open coordinates.
+struct SequenceGap {
+  uint64_t start;
+  uint64_t end;
+
+  // Checks for equality.
+  auto operator==(const SequenceGap& rhs) const -> bool {
+    return start == rhs.start && end == rhs.end;
+  }
+};
+
+// Statistics for a single FASTA sequence.
+struct FastaSequenceStats {
+  // The sequence name.
+  std::string name;
+
+  // The sequence length.
+  uint64_t length = 0;
+
+  // The base composition of the whole sequence.
+  BaseCounts counts;
+
+  // Runs of N bases of at least FastaStatsOptions::min_gap_length.
+  std::vector<SequenceGap> gaps;
+
+  // The GC fraction of each window, as the fraction of A, C, G and T bases
+  // that are G or C. Windows that contain no A, C, G or T bases are omitted.
+  // The last window is truncated at the end of the sequence.
+  std::vector<BedGraphEntry> gc_windows;
+};
+
+// Computes the statistics for a single sequence.
+auto ComputeFastaSequenceStats(const FastaSequence& sequence,
+                               const FastaStatsOptions& options)
+    -> FastaSequenceStats;
+
+// Computes the statistics for every sequence read from `parser`, in file
+// order. Sequences are processed in parallel across
+// FastaStatsOptions::num_threads threads.
+//
+// If `gc_writer` is not null, the GC windows of each sequence are written to
+// it as soon as the sequence has been processed, in file order, and are not
+// kept in the returned statistics.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastaParser> parser,
+//                  FastaParser::New("path/to/genome.fasta"));
+// ASSIGN_OR_RETURN(std::unique_ptr<BedGraphWriter> writer,
+//                  BedGraphWriter::New("path/to/gc.bedgraph"));
+// ASSIGN_OR_RETURN(
+//     std::vector<FastaSequenceStats> stats,
+//     ComputeFastaStats(parser.get(),
+//                       {.window_size = 1000, .num_threads = 8},
+//                       writer.get()));
+// RETURN_IF_ERROR(writer->Close());
+// ```
+auto ComputeFastaStats(absl::Nonnull<FastaParser*> parser,
+                       const FastaStatsOptions& options,
+                       absl::Nullable<BedGraphWriter*> gc_writer = nullptr)
+    -> absl::StatusOr<std::vector<FastaSequenceStats>>;
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_FASTA_STATS_H_
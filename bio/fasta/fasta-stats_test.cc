@@ -0,0 +1,183 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/fasta-stats.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/bedgraph/bedgraph-writer.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::testing::ElementsAre;
+using ::testing::TempDir;
+
+static constexpr char kTestFile[] = "bio/fasta/testdata/soft-masked.fasta";
+
+TEST(ComputeFastaSequenceStats, Counts) {
+  const FastaSequence sequence = {
+      .name = "seq",
+      .sequence = "ACGTacgtNNNNACGTGGCCnnAT",
+  };
+  const FastaSequenceStats stats = ComputeFastaSequenceStats(sequence, {});
+  EXPECT_EQ(stats.name, "seq");
+  EXPECT_EQ(stats.length, 24);
+  EXPECT_EQ(stats.counts.a, 4);
+  EXPECT_EQ(stats.counts.c, 5);
+  EXPECT_EQ(stats.counts.g, 5);
+  EXPECT_EQ(stats.counts.t, 4);
+  EXPECT_EQ(stats.counts.n, 6);
+  EXPECT_EQ(stats.counts.other, 0);
+  EXPECT_EQ(stats.counts.soft_masked, 6);
+  EXPECT_THAT(stats.gaps, ElementsAre(SequenceGap{.start = 8, .end = 12},
+                                      SequenceGap{.start = 20, .end = 22}));
+  EXPECT_TRUE(stats.gc_windows.empty());
+}
+
+TEST(ComputeFastaSequenceStats, MinGapLength) {
+  const FastaSequence sequence = {
+      .name = "seq",
+      .sequence = "NACGTNNNACNN",
+  };
+  const FastaSequenceStats stats =
+      ComputeFastaSequenceStats(sequence, {.min_gap_length = 2});
+  EXPECT_THAT(stats.gaps, ElementsAre(SequenceGap{.start = 5, .end = 8},
+                                      SequenceGap{.start = 10, .end = 12}));
+}
+
+TEST(ComputeFastaSequenceStats, TiledWindows) {
+  const FastaSequence sequence = {
+      .name = "seq",
+      .sequence = "NNNNNNNNGCGCGCGCAT",
+  };
+  const FastaSequenceStats stats =
+      ComputeFastaSequenceStats(sequence, {.window_size = 8});
+  ASSERT_EQ(stats.gc_windows.size(), 2);
+  EXPECT_EQ(stats.gc_windows[0].string(), "seq\t8\t16\t1.00");
+  EXPECT_EQ(stats.gc_windows[1].string(), "seq\t16\t18\t0.00");
+}
+
+TEST(ComputeFastaSequenceStats, SlidingWindows) {
+  const FastaSequence sequence = {
+      .name = "seq",
+      .sequence = "NNNNNNNNGCGCGCGCAT",
+  };
+  const FastaSequenceStats stats = ComputeFastaSequenceStats(
+      sequence, {.window_size = 8, .window_step = 4});
+  ASSERT_EQ(stats.gc_windows.size(), 3);
+  EXPECT_EQ(stats.gc_windows[0].string(), "seq\t4\t12\t1.00");
+  EXPECT_EQ(stats.gc_windows[1].string(), "seq\t8\t16\t1.00");
+  EXPECT_EQ(stats.gc_windows[2].string(), "seq\t12\t18\t0.67");
+}
+
+TEST(ComputeFastaSequenceStats, UnalignedWindows) {
+  const std::string bases = "GGATCCATTAGCGCNNATGCAAAGGT";
+  const FastaSequence sequence = {.name = "seq", .sequence = bases};
+  for (const auto& [size, step] : {std::pair<size_t, size_t>{6, 4},
+                                   {7, 3},
+                                   {5, 9}}) {
+    const FastaSequenceStats stats = ComputeFastaSequenceStats(
+        sequence, {.window_size = size, .window_step = step});
+    ASSERT_FALSE(stats.gc_windows.empty());
+    for (const BedGraphEntry& window : stats.gc_windows) {
+      EXPECT_EQ(window.start % step, 0) << window.string();
+      const BaseCounts counts = CountBases(
+          std::string(bases.substr(window.start, window.end - window.start)));
+      EXPECT_DOUBLE_EQ(window.value, counts.gc_fraction()) << window.string();
+    }
+    if (step <= size) {
+      EXPECT_EQ(stats.gc_windows.back().end, bases.size());
+    }
+  }
+}
+
+TEST(ComputeFastaStats, SingleThreaded) {
+  std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(kTestFile);
+  absl::StatusOr<std::vector<FastaSequenceStats>> stats =
+      ComputeFastaStats(parser.get(), {});
+  ASSERT_THAT(stats, IsOk());
+  ASSERT_EQ(stats->size(), 2);
+  EXPECT_EQ((*stats)[0].name, "chr1");
+  EXPECT_EQ((*stats)[0].length, 24);
+  EXPECT_EQ((*stats)[0].counts.soft_masked, 6);
+  EXPECT_EQ((*stats)[1].name, "chr2");
+  EXPECT_EQ((*stats)[1].length, 18);
+  EXPECT_THAT((*stats)[1].gaps, ElementsAre(SequenceGap{.start = 0, .end = 8}));
+}
+
+TEST(ComputeFastaStats, MultiThreadedMatchesSingleThreaded) {
+  std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(kTestFile);
+  absl::StatusOr<std::vector<FastaSequenceStats>> expected =
+      ComputeFastaStats(parser.get(), {.window_size = 8});
+  ASSERT_THAT(expected, IsOk());
+
+  parser = FastaParser::NewOrDie(kTestFile);
+  absl::StatusOr<std::vector<FastaSequenceStats>> actual =
+      ComputeFastaStats(parser.get(), {.window_size = 8, .num_threads = 4});
+  ASSERT_THAT(actual, IsOk());
+
+  ASSERT_EQ(actual->size(), expected->size());
+  for (size_t i = 0; i < actual->size(); ++i) {
+    EXPECT_EQ((*actual)[i].name, (*expected)[i].name);
+    EXPECT_EQ((*actual)[i].counts, (*expected)[i].counts);
+    EXPECT_EQ((*actual)[i].gaps, (*expected)[i].gaps);
+    ASSERT_EQ((*actual)[i].gc_windows.size(),
+              (*expected)[i].gc_windows.size());
+    for (size_t j = 0; j < (*actual)[i].gc_windows.size(); ++j) {
+      EXPECT_EQ((*actual)[i].gc_windows[j].string(),
+                (*expected)[i].gc_windows[j].string());
+    }
+  }
+}
+
+TEST(ComputeFastaStats, WritesGcWindows) {
+  const std::string output_path = gxl::JoinPath(TempDir(), "gc.bedgraph");
+  std::unique_ptr<BedGraphWriter> writer =
+      BedGraphWriter::NewOrDie(output_path);
+  std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(kTestFile);
+  absl::StatusOr<std::vector<FastaSequenceStats>> stats = ComputeFastaStats(
+      parser.get(), {.window_size = 8, .num_threads = 2}, writer.get());
+  ASSERT_THAT(stats, IsOk());
+  EXPECT_THAT(writer->Close(), IsOk());
+
+  ASSERT_EQ(stats->size(), 2);
+  EXPECT_TRUE((*stats)[0].gc_windows.empty());
+  EXPECT_TRUE((*stats)[1].gc_windows.empty());
+
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents(output_path, &contents, gxl::file::Defaults()),
+              IsOk());
+  EXPECT_EQ(contents,
+            "chr1\t0\t8\t0.50\n"
+            "chr1\t8\t16\t0.50\n"
+            "chr1\t16\t24\t0.67\n"
+            "chr2\t8\t16\t1.00\n"
+            "chr2\t16\t18\t0.00\n");
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,120 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/indexed-fasta-reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-file.h"
+#include "bio/common/random-access-file.h"
+#include "bio/fasta/fasta-index.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+static constexpr char kFaiExtension[] = ".fai";
+static constexpr char kGziExtension[] = ".gzi";
+
+// The first two bytes of every gzip member.
+static constexpr char kGzipMagic[] = "\x1f\x8b";
+
+}  // namespace
+
+auto IndexedFastaReader::New(absl::string_view path,
+                             const IndexedFastaReaderOptions& options)
+    -> absl::StatusOr<std::unique_ptr<IndexedFastaReader>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<RandomAccessFile> file,
+                   RandomAccessFile::New(path));
+  std::string magic;
+  const bool compressed =
+      file->Read(0, 2, &magic).ok() && magic == kGzipMagic;
+
+  const std::string fai_path = absl::StrCat(path, kFaiExtension);
+  absl::StatusOr<FastaIndex> index = FastaIndex::Read(fai_path);
+  if (absl::IsNotFound(index.status()) && !compressed) {
+    index = FastaIndex::Build(path);
+  }
+  if (!index.ok()) {
+    return index.status();
+  }
+
+  std::unique_ptr<BgzfFile> bgzf;
+  if (compressed) {
+    file.reset();
+    ASSIGN_OR_RETURN(bgzf,
+                     BgzfFile::New(path, absl::StrCat(path, kGziExtension),
+                                   options.cache_blocks));
+  }
+  return std::unique_ptr<IndexedFastaReader>(new IndexedFastaReader(
+      *std::move(index), std::move(file), std::move(bgzf)));
+}
+
+auto IndexedFastaReader::Fetch(absl::string_view name, uint64_t start,
+                               uint64_t end) const
+    -> absl::StatusOr<std::string> {
+  const FastaIndexEntry* entry = index_.Find(name);
+  if (entry == nullptr) {
+    return absl::NotFoundError(absl::StrFormat("Unknown sequence: %s", name));
+  }
+  if (start > end || end > entry->length) {
+    return absl::OutOfRangeError(
+        absl::StrFormat("Region %s:%d-%d is outside of the sequence of length "
+                        "%d",
+                        name, start, end, entry->length));
+  }
+  if (start == end) {
+    return std::string();
+  }
+
+  const uint64_t first_byte = entry->ByteOffset(start);
+  const uint64_t last_byte = entry->ByteOffset(end - 1);
+  const size_t size = last_byte - first_byte + 1;
+  std::string bases;
+  if (bgzf_ != nullptr) {
+    RETURN_IF_ERROR(bgzf_->Read(first_byte, size, &bases));
+  } else {
+    RETURN_IF_ERROR(file_->Read(first_byte, size, &bases));
+  }
+  // Remove the line terminators within the range.
+  bases.erase(std::remove_if(bases.begin(), bases.end(),
+                             [](char c) { return c == '\n' || c == '\r'; }),
+              bases.end());
+  if (bases.size() != end - start) {
+    return absl::DataLossError(absl::StrFormat(
+        "Region %s:%d-%d holds %d bases; the index does not match the file",
+        name, start, end, bases.size()));
+  }
+  return bases;
+}
+
+auto IndexedFastaReader::Fetch(absl::string_view name) const
+    -> absl::StatusOr<std::string> {
+  const FastaIndexEntry* entry = index_.Find(name);
+  if (entry == nullptr) {
+    return absl::NotFoundError(absl::StrFormat("Unknown sequence: %s", name));
+  }
+  return Fetch(name, 0, entry->length);
+}
+
+}  // namespace bio
@@ -0,0 +1,99 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_INDEXED_FASTA_READER_H_
+#define BIO_FASTA_INDEXED_FASTA_READER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-file.h"
+#include "bio/common/random-access-file.h"
+#include "bio/fasta/fasta-index.h"
+
+namespace bio {
+
+// Options for IndexedFastaReader.
+struct IndexedFastaReaderOptions {
+  // The number of decompressed BGZF blocks, each at most 64 KiB, kept in the
+  // cache of a compressed file.
+  size_t cache_blocks = BgzfFile::kDefaultCacheBlocks;
+};
+
+// Reads regions of sequences from a FASTA file, either uncompressed or
+// compressed with `bgzip`, using its .fai index.
+//
+// For a file at `path`, the .fai index is read from `path`.fai and, if the file
+// is compressed, the .gzi block index from `path`.gzi. A missing .fai index of
+// an uncompressed file and a missing .gzi index are built when the file is
+// opened. Only the BGZF blocks that overlap a region are decompressed, and
+// recently used blocks are cached.
+//
+// Fetch() may be called from several threads at once.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<IndexedFastaReader> reader,
+//                  IndexedFastaReader::New("path/to/genome.fa.gz"));
+// ASSIGN_OR_RETURN(std::string bases,
+//                  reader->Fetch("chr1", /*start=*/10000, /*end=*/10100));
+// ```
+class IndexedFastaReader {
+ public:
+  // Opens the FASTA file at `path` and its indexes.
+  static auto New(absl::string_view path,
+                  const IndexedFastaReaderOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<IndexedFastaReader>>;
+
+  IndexedFastaReader(const IndexedFastaReader&) = delete;
+  auto operator=(const IndexedFastaReader&) -> IndexedFastaReader& = delete;
+
+  // Returns the bases of sequence `name` in the 0-based, half-open range
+  // [`start`, `end`). Returns a NotFound error if there is no such sequence and
+  // an OutOfRange error if the range does not lie within the sequence.
+  auto Fetch(absl::string_view name, uint64_t start, uint64_t end) const
+      -> absl::StatusOr<std::string>;
+
+  // Returns the whole sequence `name`.
+  auto Fetch(absl::string_view name) const -> absl::StatusOr<std::string>;
+
+  // Returns the .fai index.
+  auto index() const -> const FastaIndex& { return index_; }
+
+  // Returns whether the file is BGZF-compressed.
+  auto compressed() const -> bool { return bgzf_ != nullptr; }
+
+ private:
+  IndexedFastaReader(FastaIndex index, std::unique_ptr<RandomAccessFile> file,
+                     std::unique_ptr<BgzfFile> bgzf)
+      : index_(std::move(index)),
+        file_(std::move(file)),
+        bgzf_(std::move(bgzf)) {}
+
+  FastaIndex index_;
+
+  // Exactly one of `file_` and `bgzf_` is set.
+  std::unique_ptr<RandomAccessFile> file_;
+  std::unique_ptr<BgzfFile> bgzf_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_INDEXED_FASTA_READER_H_
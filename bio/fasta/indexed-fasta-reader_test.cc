@@ -0,0 +1,98 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/indexed-fasta-reader.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+
+static constexpr char kFastaPath[] = "bio/fasta/testdata/indexed.fasta";
+static constexpr char kCompressedPath[] =
+    "bio/fasta/testdata/indexed.fasta.gz";
+
+// Returns every sequence in kFastaPath, read with FastaParser.
+auto ReadSequences() -> std::vector<FastaSequence> {
+  std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(kFastaPath);
+  std::vector<FastaSequence> sequences;
+  while (!parser->eof()) {
+    std::optional<std::unique_ptr<FastaSequence>> sequence =
+        parser->Next(/*truncate_name=*/true);
+    if (!sequence.has_value()) {
+      break;
+    }
+    sequences.push_back(**sequence);
+  }
+  return sequences;
+}
+
+class IndexedFastaReaderTest : public ::testing::TestWithParam<const char*> {};
+
+TEST_P(IndexedFastaReaderTest, FetchMatchesParser) {
+  absl::StatusOr<std::unique_ptr<IndexedFastaReader>> reader =
+      IndexedFastaReader::New(GetParam(), {.cache_blocks = 2});
+  ASSERT_THAT(reader, IsOk());
+  EXPECT_EQ((*reader)->compressed(), GetParam() == kCompressedPath);
+
+  const std::vector<FastaSequence> sequences = ReadSequences();
+  ASSERT_EQ(sequences.size(), 3);
+  for (const FastaSequence& sequence : sequences) {
+    EXPECT_THAT((*reader)->Fetch(sequence.name),
+                IsOkAndHolds(sequence.sequence));
+    for (size_t start = 0; start <= sequence.size(); ++start) {
+      for (size_t end = start; end <= sequence.size(); end += 3) {
+        EXPECT_THAT((*reader)->Fetch(sequence.name, start, end),
+                    IsOkAndHolds(sequence.sequence.substr(start, end - start)))
+            << sequence.name << ":" << start << "-" << end;
+      }
+    }
+  }
+}
+
+TEST_P(IndexedFastaReaderTest, Errors) {
+  std::unique_ptr<IndexedFastaReader> reader =
+      *IndexedFastaReader::New(GetParam());
+  EXPECT_THAT(reader->Fetch("chr3", 0, 1),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(reader->Fetch("chr2", 10, 17),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_THAT(reader->Fetch("chr2", 10, 5),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+INSTANTIATE_TEST_SUITE_P(IndexedFastaReader, IndexedFastaReaderTest,
+                         ::testing::Values(kFastaPath, kCompressedPath));
+
+TEST(IndexedFastaReader, Missing) {
+  EXPECT_THAT(IndexedFastaReader::New("bio/fasta/testdata/missing.fasta"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
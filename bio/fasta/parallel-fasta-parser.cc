@@ -0,0 +1,175 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/parallel-fasta-parser.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "bio/common/strings.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fasta/fasta.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+static constexpr char kDescriptionPrefix[] = ">";
+
+// The separator at which chunks are split: the end of a line followed by the
+// start of a record.
+static constexpr char kRecordBoundary[] = "\n>";
+
+// The maximum number of chunks in flight per thread.
+static constexpr size_t kPendingChunksPerThread = 2;
+
+}  // namespace
+
+auto ParseFastaChunk(absl::string_view chunk, bool truncate_name)
+    -> std::vector<std::unique_ptr<FastaSequence>> {
+  std::vector<std::unique_ptr<FastaSequence>> sequences;
+  std::unique_ptr<FastaSequence> current;
+  // As in FastaParser, lines before the first header belong to the first
+  // sequence.
+  std::string leading;
+  while (!chunk.empty()) {
+    const size_t newline = chunk.find('\n');
+    const absl::string_view line = chunk.substr(0, newline);
+    chunk.remove_prefix(newline == absl::string_view::npos ? chunk.size()
+                                                           : newline + 1);
+    if (line.empty()) {
+      continue;
+    }
+    if (absl::StartsWith(line, kDescriptionPrefix)) {
+      if (current != nullptr) {
+        sequences.push_back(std::move(current));
+      }
+      current = std::make_unique<FastaSequence>();
+      const std::string name =
+          truncate_name ? FirstWord(line) : std::string(line);
+      current->name = std::string(absl::StripPrefix(name, kDescriptionPrefix));
+      current->sequence = std::exchange(leading, std::string());
+      continue;
+    }
+    absl::StrAppend(current != nullptr ? &current->sequence : &leading, line);
+  }
+  if (current != nullptr) {
+    sequences.push_back(std::move(current));
+  } else if (!leading.empty()) {
+    auto sequence = std::make_unique<FastaSequence>();
+    sequence->sequence = std::move(leading);
+    sequences.push_back(std::move(sequence));
+  }
+  return sequences;
+}
+
+ParallelFastaParser::ParallelFastaParser(
+    absl::Nonnull<gxl::File*> file, const ParallelFastaParserOptions& options)
+    : file_(file),
+      options_(options),
+      pool_(std::make_unique<ThreadPool>(options.num_threads)),
+      queue_(std::make_unique<TaskQueue<Batch>>(pool_.get(), options.ordered)) {
+  options_.chunk_size = std::max<size_t>(options_.chunk_size, 1);
+}
+
+ParallelFastaParser::~ParallelFastaParser() {
+  queue_.reset();
+  file_->Close(gxl::file::Defaults()).IgnoreError();
+}
+
+auto ParallelFastaParser::New(absl::string_view path,
+                              const ParallelFastaParserOptions& options)
+    -> absl::StatusOr<std::unique_ptr<ParallelFastaParser>> {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
+  return std::make_unique<ParallelFastaParser>(file, options);
+}
+
+auto ParallelFastaParser::NewOrDie(absl::string_view path,
+                                   const ParallelFastaParserOptions& options)
+    -> std::unique_ptr<ParallelFastaParser> {
+  absl::StatusOr<std::unique_ptr<ParallelFastaParser>> parser =
+      New(path, options);
+  CHECK_OK(parser.status());
+  return std::move(parser.value());
+}
+
+auto ParallelFastaParser::Next()
+    -> std::optional<std::unique_ptr<FastaSequence>> {
+  while (batch_index_ == batch_.size()) {
+    const size_t max_pending = kPendingChunksPerThread * pool_->num_threads();
+    while (queue_->pending() < max_pending) {
+      std::optional<std::string> chunk = ReadChunk();
+      if (!chunk.has_value()) {
+        break;
+      }
+      queue_->Submit([chunk = *std::move(chunk),
+                      truncate_name = options_.truncate_name]() {
+        return ParseFastaChunk(chunk, truncate_name);
+      });
+    }
+    std::optional<Batch> batch = queue_->Next();
+    if (!batch.has_value()) {
+      return std::nullopt;
+    }
+    batch_ = *std::move(batch);
+    batch_index_ = 0;
+  }
+  return std::move(batch_[batch_index_++]);
+}
+
+auto ParallelFastaParser::ReadChunk() -> std::optional<std::string> {
+  while (!file_eof_) {
+    const size_t old_size = pending_.size();
+    pending_.resize(old_size + options_.chunk_size);
+    const size_t size =
+        file_->Read(pending_.data() + old_size, options_.chunk_size);
+    pending_.resize(old_size + size);
+    if (size == 0) {
+      file_eof_ = true;
+      break;
+    }
+    // `pending_` has no record boundary before the bytes just read, so only
+    // they need to be searched, along with the newline that may precede them.
+    const size_t search_start = old_size > 0 ? old_size - 1 : 0;
+    const size_t boundary =
+        absl::string_view(pending_).substr(search_start).rfind(kRecordBoundary);
+    if (boundary == absl::string_view::npos) {
+      continue;
+    }
+    const size_t chunk_size = search_start + boundary + 1;
+    std::string chunk = pending_.substr(0, chunk_size);
+    pending_.erase(0, chunk_size);
+    return chunk;
+  }
+  if (pending_.empty()) {
+    return std::nullopt;
+  }
+  return std::exchange(pending_, std::string());
+}
+
+}  // namespace bio
@@ -0,0 +1,130 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_PARALLEL_FASTA_PARSER_H_
+#define BIO_FASTA_PARALLEL_FASTA_PARSER_H_
+
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fasta/fasta.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+
+// Options for ParallelFastaParser.
+struct ParallelFastaParserOptions {
+  // The number of threads that parse records.
+  size_t num_threads = 4;
+
+  // The number of bytes read from the file at a time. Each chunk handed to a
+  // parsing thread holds at least this many bytes, except the last, and ends
+  // at a record boundary.
+  size_t chunk_size = 4 << 20;
+
+  // Whether records are returned in file order. Otherwise they are returned as
+  // soon as their chunk has been parsed, which keeps all threads busy when
+  // chunks take uneven time to parse.
+  bool ordered = true;
+
+  // Whether sequence names are truncated to their first word, as with
+  // FastaParser::Next(/*truncate_name=*/true).
+  bool truncate_name = false;
+};
+
+// Parser for FASTA files that parses records on a pool of threads. This suits
+// files with many short records, such as protein and transcript databases.
+//
+// The file is read in chunks that are split at the start of a record (a line
+// starting with '>'), and each chunk is parsed on a worker thread. The records
+// are the same as those returned by FastaParser.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<ParallelFastaParser> parser,
+//                  ParallelFastaParser::New("path/to/uniprot.fasta",
+//                                           {.num_threads = 16}));
+// for (std::optional<std::unique_ptr<FastaSequence>> sequence =
+//          parser->Next();
+//      sequence.has_value(); sequence = parser->Next()) {
+//   // Do stuff with `sequence`
+// }
+// ```
+class ParallelFastaParser {
+ public:
+  ParallelFastaParser(absl::Nonnull<gxl::File*> file,
+                      const ParallelFastaParserOptions& options);
+
+  // Waits for any chunks being parsed and closes the file.
+  ~ParallelFastaParser();
+
+  ParallelFastaParser(const ParallelFastaParser&) = delete;
+  auto operator=(const ParallelFastaParser&) -> ParallelFastaParser& = delete;
+
+  // Constructs a new ParallelFastaParser from the specified path.
+  static auto New(absl::string_view path,
+                  const ParallelFastaParserOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<ParallelFastaParser>>;
+
+  // Constructs a new ParallelFastaParser from the specified file path or
+  // terminates the program if constructing the parser fails.
+  static auto NewOrDie(absl::string_view path,
+                       const ParallelFastaParserOptions& options = {})
+      -> std::unique_ptr<ParallelFastaParser>;
+
+  // Returns the next sequence, or std::nullopt once all sequences have been
+  // returned.
+  auto Next() -> std::optional<std::unique_ptr<FastaSequence>>;
+
+ private:
+  using Batch = std::vector<std::unique_ptr<FastaSequence>>;
+
+  // Returns the next chunk of the file that ends at a record boundary, or
+  // std::nullopt at the end of the file.
+  auto ReadChunk() -> std::optional<std::string>;
+
+  gxl::File* file_;
+  ParallelFastaParserOptions options_;
+  bool file_eof_ = false;
+
+  // Bytes read from the file that have not been handed out in a chunk. They
+  // start at a record boundary.
+  std::string pending_;
+
+  // The pool must outlive the queue, whose destructor waits for its tasks.
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<TaskQueue<Batch>> queue_;
+
+  // The batch being returned by Next() and the index of its next record.
+  Batch batch_;
+  size_t batch_index_ = 0;
+};
+
+// Parses the records in `chunk`, which holds whole FASTA records. Exposed for
+// testing.
+auto ParseFastaChunk(absl::string_view chunk, bool truncate_name)
+    -> std::vector<std::unique_ptr<FastaSequence>>;
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_PARALLEL_FASTA_PARSER_H_
@@ -0,0 +1,147 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/parallel-fasta-parser.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "bio/common/test-files.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+
+using NamedSequence = std::pair<std::string, std::string>;
+
+auto ParseWithFastaParser(const std::string& path, bool truncate_name)
+    -> std::vector<NamedSequence> {
+  std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(path);
+  std::vector<NamedSequence> sequences;
+  while (!parser->eof()) {
+    std::optional<std::unique_ptr<FastaSequence>> sequence =
+        parser->Next(truncate_name);
+    if (!sequence.has_value()) {
+      break;
+    }
+    sequences.emplace_back((*sequence)->name, (*sequence)->sequence);
+  }
+  return sequences;
+}
+
+auto ParseInParallel(const std::string& path,
+                     const ParallelFastaParserOptions& options)
+    -> std::vector<NamedSequence> {
+  std::unique_ptr<ParallelFastaParser> parser =
+      ParallelFastaParser::NewOrDie(path, options);
+  std::vector<NamedSequence> sequences;
+  for (std::optional<std::unique_ptr<FastaSequence>> sequence = parser->Next();
+       sequence.has_value(); sequence = parser->Next()) {
+    sequences.emplace_back((*sequence)->name, (*sequence)->sequence);
+  }
+  return sequences;
+}
+
+// Writes a FASTA file with many short records and returns its path.
+auto WriteManyRecords() -> std::string {
+  std::string contents;
+  for (int i = 0; i < 500; ++i) {
+    absl::StrAppend(&contents, ">protein_", i, " description ", i, "\n");
+    for (int j = 0; j <= i % 4; ++j) {
+      absl::StrAppend(&contents, std::string(i % 37 + 1, 'A' + j), "\n");
+    }
+    if (i % 50 == 0) {
+      absl::StrAppend(&contents, "\n");
+    }
+  }
+  return WriteTempFile("many.fasta", contents);
+}
+
+TEST(ParseFastaChunk, Records) {
+  std::vector<std::unique_ptr<FastaSequence>> sequences =
+      ParseFastaChunk(">a first\nAC\nGT\n\n>b\nTT", /*truncate_name=*/true);
+  ASSERT_EQ(sequences.size(), 2);
+  EXPECT_EQ(sequences[0]->name, "a");
+  EXPECT_EQ(sequences[0]->sequence, "ACGT");
+  EXPECT_EQ(sequences[1]->name, "b");
+  EXPECT_EQ(sequences[1]->sequence, "TT");
+}
+
+TEST(ParseFastaChunk, LeadingLines) {
+  std::vector<std::unique_ptr<FastaSequence>> sequences =
+      ParseFastaChunk("NN\n>a first\nAC\n", /*truncate_name=*/false);
+  ASSERT_EQ(sequences.size(), 1);
+  EXPECT_EQ(sequences[0]->name, "a first");
+  EXPECT_EQ(sequences[0]->sequence, "NNAC");
+}
+
+TEST(ParallelFastaParser, Empty) {
+  std::unique_ptr<ParallelFastaParser> parser =
+      ParallelFastaParser::NewOrDie("bio/fasta/testdata/empty.fasta");
+  EXPECT_FALSE(parser->Next().has_value());
+  EXPECT_FALSE(parser->Next().has_value());
+}
+
+TEST(ParallelFastaParser, OrderedMatchesFastaParser) {
+  const std::string path = WriteManyRecords();
+  for (bool truncate_name : {false, true}) {
+    const std::vector<NamedSequence> expected =
+        ParseWithFastaParser(path, truncate_name);
+    ASSERT_EQ(expected.size(), 500);
+    for (size_t chunk_size : {1, 17, 1000, 1 << 20}) {
+      EXPECT_EQ(ParseInParallel(path, {.num_threads = 3,
+                                       .chunk_size = chunk_size,
+                                       .truncate_name = truncate_name}),
+                expected)
+          << "chunk size " << chunk_size;
+    }
+  }
+}
+
+TEST(ParallelFastaParser, Unordered) {
+  const std::string path = WriteManyRecords();
+  std::vector<NamedSequence> expected =
+      ParseWithFastaParser(path, /*truncate_name=*/true);
+  std::vector<NamedSequence> actual =
+      ParseInParallel(path, {.num_threads = 4,
+                             .chunk_size = 100,
+                             .ordered = false,
+                             .truncate_name = true});
+  std::sort(expected.begin(), expected.end());
+  std::sort(actual.begin(), actual.end());
+  EXPECT_EQ(actual, expected);
+}
+
+TEST(ParallelFastaParser, TestData) {
+  for (const char* path : {"bio/fasta/testdata/single-sequence.fasta",
+                           "bio/fasta/testdata/multi-sequence.fasta",
+                           "bio/fasta/testdata/soft-masked.fasta"}) {
+    EXPECT_EQ(ParseInParallel(path, {.num_threads = 2, .chunk_size = 64}),
+              ParseWithFastaParser(path, /*truncate_name=*/false))
+        << path;
+  }
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,102 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/reference-cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/fasta/fasta-index.h"
+#include "bio/fasta/indexed-fasta-reader.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+
+ReferenceCache::ReferenceCache(absl::Nonnull<const IndexedFastaReader*> reader,
+                               const ReferenceCacheOptions& options)
+    : reader_(reader), tile_size_(std::max<size_t>(options.tile_size, 1)) {
+  const size_t num_shards = std::max<size_t>(options.num_shards, 1);
+  tiles_per_shard_ =
+      std::max<size_t>(options.max_bytes / num_shards / tile_size_, 1);
+  shards_.reserve(num_shards);
+  for (size_t i = 0; i < num_shards; ++i) {
+    shards_.push_back(std::make_unique<Shard>(tiles_per_shard_));
+  }
+}
+
+auto ReferenceCache::Fetch(absl::string_view name, uint64_t start,
+                           uint64_t end) -> absl::StatusOr<std::string> {
+  const FastaIndexEntry* entry = reader_->index().Find(name);
+  if (entry == nullptr) {
+    return absl::NotFoundError(absl::StrFormat("Unknown sequence: %s", name));
+  }
+  if (start > end || end > entry->length) {
+    return absl::OutOfRangeError(
+        absl::StrFormat("Region %s:%d-%d is outside of the sequence of length "
+                        "%d",
+                        name, start, end, entry->length));
+  }
+
+  std::string bases;
+  bases.reserve(end - start);
+  for (uint64_t position = start; position < end;) {
+    const uint64_t tile_number = position / tile_size_;
+    ASSIGN_OR_RETURN(std::shared_ptr<const std::string> tile,
+                     GetTile(*entry, tile_number));
+    const uint64_t offset = position - tile_number * tile_size_;
+    const uint64_t size = std::min<uint64_t>(end - position,
+                                             tile->size() - offset);
+    bases.append(*tile, offset, size);
+    position += size;
+  }
+  return bases;
+}
+
+auto ReferenceCache::GetTile(const FastaIndexEntry& entry, uint64_t tile)
+    -> absl::StatusOr<std::shared_ptr<const std::string>> {
+  const TileKey key = {&entry - reader_->index().entries().data(), tile};
+  Shard& shard = *shards_[absl::Hash<TileKey>()(key) % shards_.size()];
+  {
+    absl::MutexLock lock(&shard.mutex);
+    if (std::shared_ptr<const std::string>* cached = shard.tiles.Get(key);
+        cached != nullptr) {
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return *cached;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+
+  // Read without holding the lock so that other tiles of the shard can be
+  // served meanwhile.
+  const uint64_t start = tile * tile_size_;
+  const uint64_t end = std::min<uint64_t>(start + tile_size_, entry.length);
+  ASSIGN_OR_RETURN(std::string bases, reader_->Fetch(entry.name, start, end));
+  auto shared = std::make_shared<const std::string>(std::move(bases));
+
+  absl::MutexLock lock(&shard.mutex);
+  shard.tiles.Put(key, shared);
+  return shared;
+}
+
+}  // namespace bio
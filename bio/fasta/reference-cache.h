@@ -0,0 +1,125 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_REFERENCE_CACHE_H_
+#define BIO_FASTA_REFERENCE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/lru-cache.h"
+#include "bio/fasta/indexed-fasta-reader.h"
+
+namespace bio {
+
+// Options for ReferenceCache.
+struct ReferenceCacheOptions {
+  // The number of bases in each cached tile. Tiles start at multiples of the
+  // tile size, so that overlapping fetches share tiles.
+  size_t tile_size = 4096;
+
+  // The maximum number of bytes of sequence held by the cache.
+  size_t max_bytes = 64 << 20;
+
+  // The number of independently locked shards. More shards reduce contention
+  // between threads.
+  size_t num_shards = 16;
+};
+
+// A thread-safe cache of reference sequence regions in front of an
+// IndexedFastaReader.
+//
+// Sequences are cached as fixed-size tiles, each held by one of several shards
+// chosen by hashing the tile, so threads fetching different tiles rarely
+// contend for the same lock. Each shard evicts its least recently used tiles to
+// stay within its share of the byte budget. Because the final tile of a
+// sequence may be short but is budgeted as a full tile, the budget is an upper
+// bound.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<IndexedFastaReader> reader,
+//                  IndexedFastaReader::New("path/to/genome.fasta"));
+// ReferenceCache cache(reader.get(), {.max_bytes = 256 << 20});
+// ASSIGN_OR_RETURN(std::string bases, cache.Fetch("chr1", 10000, 10100));
+// ```
+class ReferenceCache {
+ public:
+  // Constructs a cache over `reader`, which must outlive the cache.
+  ReferenceCache(absl::Nonnull<const IndexedFastaReader*> reader,
+                 const ReferenceCacheOptions& options = {});
+
+  ReferenceCache(const ReferenceCache&) = delete;
+  auto operator=(const ReferenceCache&) -> ReferenceCache& = delete;
+
+  // Returns the bases of sequence `name` in the 0-based, half-open range
+  // [`start`, `end`). Returns the same errors as IndexedFastaReader::Fetch().
+  auto Fetch(absl::string_view name, uint64_t start, uint64_t end)
+      -> absl::StatusOr<std::string>;
+
+  // Returns the number of tile lookups that were served from the cache.
+  auto hits() const -> uint64_t {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the number of tile lookups that read from the file.
+  auto misses() const -> uint64_t {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the maximum number of tiles the cache holds. At least one tile per
+  // shard is always held, even if that exceeds the byte budget.
+  auto capacity() const -> size_t { return shards_.size() * tiles_per_shard_; }
+
+ private:
+  // Identifies a tile by the index of its sequence in the .fai index and the
+  // tile number within the sequence.
+  using TileKey = std::pair<size_t, uint64_t>;
+
+  // A part of the cache with its own lock.
+  struct Shard {
+    explicit Shard(size_t capacity) : tiles(capacity) {}
+
+    absl::Mutex mutex;
+    LruCache<TileKey, std::shared_ptr<const std::string>> tiles
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  // Returns the tile `tile` of the sequence described by `entry`, reading it
+  // from the file on a miss.
+  auto GetTile(const FastaIndexEntry& entry, uint64_t tile)
+      -> absl::StatusOr<std::shared_ptr<const std::string>>;
+
+  const IndexedFastaReader* reader_;
+  size_t tile_size_;
+  size_t tiles_per_shard_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<uint64_t> hits_ = 0;
+  std::atomic<uint64_t> misses_ = 0;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_REFERENCE_CACHE_H_
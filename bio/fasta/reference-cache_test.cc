@@ -0,0 +1,132 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/reference-cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/fasta/fasta-index.h"
+#include "bio/fasta/indexed-fasta-reader.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+
+static constexpr char kFastaPath[] = "bio/fasta/testdata/indexed.fasta";
+
+TEST(ReferenceCache, FetchMatchesReader) {
+  std::unique_ptr<IndexedFastaReader> reader =
+      *IndexedFastaReader::New(kFastaPath);
+  ReferenceCache cache(reader.get(), {.tile_size = 7, .num_shards = 3});
+  for (const FastaIndexEntry& entry : reader->index().entries()) {
+    for (uint64_t start = 0; start <= entry.length; ++start) {
+      for (uint64_t end = start; end <= entry.length; ++end) {
+        absl::StatusOr<std::string> expected =
+            reader->Fetch(entry.name, start, end);
+        ASSERT_THAT(expected, IsOk());
+        EXPECT_THAT(cache.Fetch(entry.name, start, end),
+                    IsOkAndHolds(*expected))
+            << entry.name << ":" << start << "-" << end;
+      }
+    }
+  }
+}
+
+TEST(ReferenceCache, HitsAndMisses) {
+  std::unique_ptr<IndexedFastaReader> reader =
+      *IndexedFastaReader::New(kFastaPath);
+  ReferenceCache cache(reader.get(), {.tile_size = 10});
+
+  // Spans tiles 1 and 2.
+  EXPECT_THAT(cache.Fetch("chr1", 15, 25), IsOk());
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.misses(), 2);
+
+  // Tile 2 is cached; tile 3 is not.
+  EXPECT_THAT(cache.Fetch("chr1", 22, 31), IsOk());
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 3);
+
+  EXPECT_THAT(cache.Fetch("chr1", 10, 30), IsOk());
+  EXPECT_EQ(cache.hits(), 3);
+  EXPECT_EQ(cache.misses(), 3);
+}
+
+TEST(ReferenceCache, ByteBudget) {
+  std::unique_ptr<IndexedFastaReader> reader =
+      *IndexedFastaReader::New(kFastaPath);
+  ReferenceCache cache(reader.get(),
+                       {.tile_size = 10, .max_bytes = 20, .num_shards = 1});
+  EXPECT_EQ(cache.capacity(), 2);
+
+  EXPECT_THAT(cache.Fetch("chr1", 0, 30), IsOk());
+  EXPECT_EQ(cache.misses(), 3);
+  // Tile 0 was evicted to make room for tile 2.
+  EXPECT_THAT(cache.Fetch("chr1", 0, 1), IsOk());
+  EXPECT_EQ(cache.hits(), 0);
+  EXPECT_EQ(cache.misses(), 4);
+  EXPECT_THAT(cache.Fetch("chr1", 29, 30), IsOk());
+  EXPECT_EQ(cache.hits(), 1);
+}
+
+TEST(ReferenceCache, Errors) {
+  std::unique_ptr<IndexedFastaReader> reader =
+      *IndexedFastaReader::New(kFastaPath);
+  ReferenceCache cache(reader.get());
+  EXPECT_THAT(cache.Fetch("chr3", 0, 1),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(cache.Fetch("chr2", 0, 17),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(ReferenceCache, ConcurrentFetches) {
+  std::unique_ptr<IndexedFastaReader> reader =
+      *IndexedFastaReader::New(kFastaPath);
+  const std::string expected = *reader->Fetch("chr1");
+  ReferenceCache cache(reader.get(),
+                       {.tile_size = 4, .max_bytes = 32, .num_shards = 4});
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, &expected, t]() {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 500; ++i) {
+        const uint64_t start = rng() % expected.size();
+        const uint64_t end = start + rng() % (expected.size() - start + 1);
+        absl::StatusOr<std::string> bases = cache.Fetch("chr1", start, end);
+        ASSERT_THAT(bases, IsOk());
+        ASSERT_EQ(*bases, expected.substr(start, end - start));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_GT(cache.hits(), 0);
+}
+
+}  // namespace
+}  // namespace bio
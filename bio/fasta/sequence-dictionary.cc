@@ -0,0 +1,221 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/sequence-dictionary.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/mapped-file.h"
+#include "bio/common/minimal-perfect-hash.h"
+#include "bio/fasta/fasta-index.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+static constexpr char kMagic[8] = {'B', 'I', 'O', 'S', 'D', 'X', '\0', '\1'};
+static constexpr char kFaiExtension[] = ".fai";
+
+// The header words of a dictionary file.
+enum HeaderWord : size_t {
+  kMagicWord = 0,
+  kNumRecords,
+  kHashOffset,
+  kHashSize,
+  kRecordsOffset,
+  kNamesOffset,
+  kNamesSize,
+  kNumHeaderWords = 8,
+};
+
+auto PadToWord(std::string* data) -> void {
+  data->resize((data->size() + 7) / 8 * 8, '\0');
+}
+
+}  // namespace
+
+struct SequenceDictionary::Record {
+  uint64_t length;
+  uint64_t offset;
+  uint64_t name_offset;
+  uint32_t name_length;
+  uint32_t line_bases;
+  uint32_t line_width;
+  uint32_t reserved;
+};
+
+auto SequenceDictionary::Build(const FastaIndex& index)
+    -> absl::StatusOr<std::string> {
+  static_assert(sizeof(Record) == 40);
+  const std::vector<FastaIndexEntry>& entries = index.entries();
+  std::vector<uint64_t> keys;
+  keys.reserve(entries.size());
+  for (const FastaIndexEntry& entry : entries) {
+    if (entry.line_width > std::numeric_limits<uint32_t>::max() ||
+        entry.name.size() > std::numeric_limits<uint32_t>::max()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Sequence %s is too large for a sequence dictionary", entry.name));
+    }
+    keys.push_back(StableHash64(entry.name));
+  }
+  absl::StatusOr<std::string> hash_data = MinimalPerfectHash::Build(keys);
+  if (!hash_data.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Failed to hash sequence names: ", hash_data.status().message()));
+  }
+  // Copy to 8-byte aligned storage to look up the slots.
+  std::vector<uint64_t> hash_words(hash_data->size() / sizeof(uint64_t));
+  std::memcpy(hash_words.data(), hash_data->data(), hash_data->size());
+  ASSIGN_OR_RETURN(const MinimalPerfectHash hash,
+                   MinimalPerfectHash::View(absl::string_view(
+                       reinterpret_cast<const char*>(hash_words.data()),
+                       hash_data->size())));
+
+  std::vector<const FastaIndexEntry*> by_slot(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    by_slot[*hash.Lookup(keys[i])] = &entries[i];
+  }
+  std::vector<Record> records;
+  records.reserve(entries.size());
+  std::string names;
+  for (const FastaIndexEntry* entry : by_slot) {
+    records.push_back({
+        .length = entry->length,
+        .offset = entry->offset,
+        .name_offset = names.size(),
+        .name_length = static_cast<uint32_t>(entry->name.size()),
+        .line_bases = static_cast<uint32_t>(entry->line_bases),
+        .line_width = static_cast<uint32_t>(entry->line_width),
+        .reserved = 0,
+    });
+    names.append(entry->name);
+  }
+
+  uint64_t header[kNumHeaderWords] = {};
+  std::memcpy(&header[kMagicWord], kMagic, sizeof(kMagic));
+  header[kNumRecords] = records.size();
+  header[kHashOffset] = sizeof(header);
+  header[kHashSize] = hash_data->size();
+  header[kRecordsOffset] = header[kHashOffset] + header[kHashSize];
+  header[kNamesOffset] =
+      header[kRecordsOffset] + records.size() * sizeof(Record);
+  header[kNamesSize] = names.size();
+
+  std::string data(reinterpret_cast<const char*>(header), sizeof(header));
+  data.append(*hash_data);
+  data.append(reinterpret_cast<const char*>(records.data()),
+              records.size() * sizeof(Record));
+  data.append(names);
+  PadToWord(&data);
+  return data;
+}
+
+auto SequenceDictionary::BuildForFasta(absl::string_view fasta_path)
+    -> absl::Status {
+  absl::StatusOr<FastaIndex> index =
+      FastaIndex::Read(absl::StrCat(fasta_path, kFaiExtension));
+  if (absl::IsNotFound(index.status())) {
+    index = FastaIndex::Build(fasta_path);
+  }
+  if (!index.ok()) {
+    return index.status();
+  }
+  ASSIGN_OR_RETURN(const std::string data, Build(*index));
+  return gxl::SetContents(absl::StrCat(fasta_path, kExtension), data,
+                          gxl::file::Defaults());
+}
+
+auto SequenceDictionary::Open(absl::string_view path)
+    -> absl::StatusOr<std::unique_ptr<SequenceDictionary>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<MappedFile> file, MappedFile::New(path));
+  const absl::string_view data = file->data();
+  uint64_t header[kNumHeaderWords];
+  if (data.size() < sizeof(header)) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Truncated sequence dictionary header", path));
+  }
+  std::memcpy(header, data.data(), sizeof(header));
+  if (std::memcmp(&header[kMagicWord], kMagic, sizeof(kMagic)) != 0) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Not a sequence dictionary", path));
+  }
+  const uint64_t num_records = header[kNumRecords];
+  const uint64_t hash_offset = header[kHashOffset];
+  const uint64_t hash_size = header[kHashSize];
+  const uint64_t records_offset = header[kRecordsOffset];
+  const uint64_t names_offset = header[kNamesOffset];
+  const uint64_t names_size = header[kNamesSize];
+  // Returns whether `size` bytes at `offset` end by `end`, without adding
+  // them, since corrupt headers can make the sum overflow.
+  const auto ends_by = [](uint64_t offset, uint64_t size, uint64_t end) {
+    return offset <= end && size <= end - offset;
+  };
+  if (hash_offset % 8 != 0 || records_offset % 8 != 0 ||
+      records_offset > data.size() ||
+      !ends_by(hash_offset, hash_size, records_offset) ||
+      num_records > (data.size() - records_offset) / sizeof(Record) ||
+      records_offset + num_records * sizeof(Record) > names_offset ||
+      !ends_by(names_offset, names_size, data.size())) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Invalid sequence dictionary layout", path));
+  }
+  absl::StatusOr<MinimalPerfectHash> hash =
+      MinimalPerfectHash::View(data.substr(hash_offset, hash_size));
+  if (!hash.ok() || hash->size() != num_records) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Invalid sequence dictionary hash", path));
+  }
+  const auto* records =
+      reinterpret_cast<const Record*>(data.data() + records_offset);
+  const absl::string_view names = data.substr(names_offset, names_size);
+  return std::unique_ptr<SequenceDictionary>(
+      new SequenceDictionary(std::move(file), *hash, records, names));
+}
+
+auto SequenceDictionary::Find(absl::string_view name) const
+    -> std::optional<SequenceRecord> {
+  const std::optional<uint64_t> slot = hash_.Lookup(StableHash64(name));
+  if (!slot.has_value() || *slot >= size()) {
+    return std::nullopt;
+  }
+  const Record& record = records_[*slot];
+  if (record.name_offset > names_.size() ||
+      record.name_length > names_.size() - record.name_offset ||
+      names_.substr(record.name_offset, record.name_length) != name) {
+    return std::nullopt;
+  }
+  return SequenceRecord{
+      .name = names_.substr(record.name_offset, record.name_length),
+      .length = record.length,
+      .offset = record.offset,
+      .line_bases = record.line_bases,
+      .line_width = record.line_width,
+  };
+}
+
+}  // namespace bio
@@ -0,0 +1,120 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTA_SEQUENCE_DICTIONARY_H_
+#define BIO_FASTA_SEQUENCE_DICTIONARY_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/mapped-file.h"
+#include "bio/common/minimal-perfect-hash.h"
+#include "bio/fasta/fasta-index.h"
+
+namespace bio {
+
+// The location of a sequence in a FASTA file, as stored in a
+// SequenceDictionary. The fields mirror FastaIndexEntry.
+struct SequenceRecord {
+  // The sequence name. It points into the dictionary.
+  absl::string_view name;
+
+  // The number of bases in the sequence.
+  uint64_t length;
+
+  // The byte offset of the first base of the sequence.
+  uint64_t offset;
+
+  // The number of bases on each line.
+  uint64_t line_bases;
+
+  // The number of bytes on each line, including the line terminator.
+  uint64_t line_width;
+};
+
+// A read-only map from sequence names to their locations in a FASTA file,
+// built once and stored next to the FASTA file with the extension ".sdx".
+//
+// Names are mapped to records by a minimal perfect hash, and the names are
+// stored back to back, so the dictionary takes about 40 bytes plus the name
+// length per sequence. Opening a dictionary maps the file into memory and
+// checks its header without reading the records, so it takes the same time for
+// any number of sequences.
+//
+// The file holds, in little-endian 64-bit words: a header, the serialized
+// MinimalPerfectHash of the names, one record per sequence in hash slot order,
+// and the names.
+//
+// Example usage:
+//
+// ```
+// RETURN_IF_ERROR(SequenceDictionary::BuildForFasta("path/to/rna.fasta"));
+// ASSIGN_OR_RETURN(std::unique_ptr<SequenceDictionary> dictionary,
+//                  SequenceDictionary::Open("path/to/rna.fasta.sdx"));
+// std::optional<SequenceRecord> record = dictionary->Find("NM_000546.6");
+// ```
+class SequenceDictionary {
+ public:
+  // The file extension of sequence dictionaries.
+  static constexpr char kExtension[] = ".sdx";
+
+  // Serializes a dictionary of the sequences in `index`.
+  static auto Build(const FastaIndex& index) -> absl::StatusOr<std::string>;
+
+  // Builds the dictionary of the FASTA file at `fasta_path` and writes it to
+  // `fasta_path`.sdx. The sequences are read from the file's .fai index if it
+  // exists and from the file itself otherwise.
+  static auto BuildForFasta(absl::string_view fasta_path) -> absl::Status;
+
+  // Opens the dictionary file at `path`.
+  static auto Open(absl::string_view path)
+      -> absl::StatusOr<std::unique_ptr<SequenceDictionary>>;
+
+  SequenceDictionary(const SequenceDictionary&) = delete;
+  auto operator=(const SequenceDictionary&) -> SequenceDictionary& = delete;
+
+  // Returns the record of the sequence named `name`, or std::nullopt if there
+  // is no such sequence.
+  auto Find(absl::string_view name) const -> std::optional<SequenceRecord>;
+
+  // Returns the number of sequences.
+  auto size() const -> uint64_t { return hash_.size(); }
+
+ private:
+  // The record layout in the file.
+  struct Record;
+
+  SequenceDictionary(std::unique_ptr<MappedFile> file, MinimalPerfectHash hash,
+                     const Record* records, absl::string_view names)
+      : file_(std::move(file)),
+        hash_(hash),
+        records_(records),
+        names_(names) {}
+
+  std::unique_ptr<MappedFile> file_;
+  MinimalPerfectHash hash_;
+  const Record* records_;
+  absl::string_view names_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTA_SEQUENCE_DICTIONARY_H_
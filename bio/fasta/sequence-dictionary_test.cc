@@ -0,0 +1,150 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fasta/sequence-dictionary.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "bio/common/test-files.h"
+#include "bio/fasta/fasta-index.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+// Copies the test FASTA file to a writable directory and returns its path.
+auto CopyTestFasta() -> std::string {
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents("bio/fasta/testdata/indexed.fasta", &contents,
+                               gxl::file::Defaults()),
+              IsOk());
+  return WriteTempFile("dictionary.fasta", contents);
+}
+
+TEST(SequenceDictionary, BuildForFasta) {
+  const std::string fasta_path = CopyTestFasta();
+  ASSERT_THAT(SequenceDictionary::BuildForFasta(fasta_path), IsOk());
+  absl::StatusOr<std::unique_ptr<SequenceDictionary>> dictionary =
+      SequenceDictionary::Open(absl::StrCat(fasta_path, ".sdx"));
+  ASSERT_THAT(dictionary, IsOk());
+  EXPECT_EQ((*dictionary)->size(), 3);
+
+  const FastaIndex index = *FastaIndex::Build(fasta_path);
+  for (const FastaIndexEntry& entry : index.entries()) {
+    std::optional<SequenceRecord> record = (*dictionary)->Find(entry.name);
+    ASSERT_TRUE(record.has_value()) << entry.name;
+    EXPECT_EQ(record->name, entry.name);
+    EXPECT_EQ(record->length, entry.length);
+    EXPECT_EQ(record->offset, entry.offset);
+    EXPECT_EQ(record->line_bases, entry.line_bases);
+    EXPECT_EQ(record->line_width, entry.line_width);
+  }
+  EXPECT_EQ((*dictionary)->Find("chr3"), std::nullopt);
+  EXPECT_EQ((*dictionary)->Find(""), std::nullopt);
+}
+
+TEST(SequenceDictionary, ManySequences) {
+  std::string fai;
+  for (int i = 0; i < 20000; ++i) {
+    absl::StrAppend(&fai, "ENST", 1000000 + i, ".", i % 7, "\t", i + 1, "\t",
+                    100 * i, "\t60\t61\n");
+  }
+  const FastaIndex index = *FastaIndex::Parse(fai);
+  absl::StatusOr<std::string> data = SequenceDictionary::Build(index);
+  ASSERT_THAT(data, IsOk());
+  std::unique_ptr<SequenceDictionary> dictionary =
+      *SequenceDictionary::Open(WriteTempFile("many.sdx", *data));
+  ASSERT_EQ(dictionary->size(), index.entries().size());
+  for (const FastaIndexEntry& entry : index.entries()) {
+    std::optional<SequenceRecord> record = dictionary->Find(entry.name);
+    ASSERT_TRUE(record.has_value()) << entry.name;
+    EXPECT_EQ(record->offset, entry.offset);
+    EXPECT_EQ(record->length, entry.length);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(dictionary->Find(absl::StrCat("ENSG", i)), std::nullopt);
+  }
+}
+
+TEST(SequenceDictionary, Empty) {
+  absl::StatusOr<std::string> data = SequenceDictionary::Build(FastaIndex());
+  ASSERT_THAT(data, IsOk());
+  std::unique_ptr<SequenceDictionary> dictionary =
+      *SequenceDictionary::Open(WriteTempFile("empty.sdx", *data));
+  EXPECT_EQ(dictionary->size(), 0);
+  EXPECT_EQ(dictionary->Find("chr1"), std::nullopt);
+}
+
+TEST(SequenceDictionary, Invalid) {
+  EXPECT_THAT(SequenceDictionary::Open(
+                  WriteTempFile("invalid.sdx", "not a dictionary")),
+              StatusIs(absl::StatusCode::kDataLoss));
+
+  const FastaIndex index = *FastaIndex::Parse("chr1\t10\t6\t10\t11\n");
+  std::string data = *SequenceDictionary::Build(index);
+  EXPECT_THAT(SequenceDictionary::Open(WriteTempFile(
+                  "truncated.sdx", data.substr(0, data.size() - 16))),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(SequenceDictionary, Corrupt) {
+  std::string fai;
+  for (int i = 0; i < 100; ++i) {
+    absl::StrAppend(&fai, "chr", i, "\t", i + 1, "\t", 100 * i, "\t60\t61\n");
+  }
+  const std::string data =
+      *SequenceDictionary::Build(*FastaIndex::Parse(fai));
+  // Returns the 64-bit word of `data` at byte `offset`.
+  const auto word = [&](size_t offset) {
+    uint64_t value;
+    std::memcpy(&value, &data[offset], sizeof(value));
+    return value;
+  };
+  // Returns `data` with the 64-bit word at byte `offset` set to `value`.
+  const auto with_word = [&](size_t offset, uint64_t value) {
+    std::string corrupt = data;
+    std::memcpy(&corrupt[offset], &value, sizeof(value));
+    return corrupt;
+  };
+  static constexpr uint64_t kMax = std::numeric_limits<uint64_t>::max();
+  const uint64_t hash_offset = word(16);
+  for (const std::string& corrupt : {
+           // The hash, names offset and names size overflow when added.
+           with_word(24, kMax - 7),
+           with_word(40, kMax - 7),
+           with_word(48, kMax - 7),
+           // The first level of the hash is empty, or ends past its bits.
+           with_word(hash_offset + 24, 0),
+           with_word(hash_offset + 24, uint64_t{1} << 40),
+       }) {
+    EXPECT_THAT(SequenceDictionary::Open(WriteTempFile("corrupt.sdx", corrupt)),
+                StatusIs(absl::StatusCode::kDataLoss));
+  }
+}
+
+}  // namespace
+}  // namespace bio
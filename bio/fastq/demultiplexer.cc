@@ -0,0 +1,373 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/demultiplexer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "gxl/file/path.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The bases substituted into barcodes.
+static constexpr absl::string_view kBases = "ACGTN";
+
+// The separator of the two barcodes of dual-index reads, which is never
+// substituted.
+static constexpr char kBarcodeSeparator = '+';
+
+// The size of a buffered read, including the FASTQ line overhead.
+auto ReadBytes(const FastqSequence& read) -> size_t {
+  return read.name.size() + read.sequence.size() + read.quality.size() + 6;
+}
+
+// Opens the FASTQ file at `path`, truncating it unless `append` is set.
+auto OpenWriter(absl::string_view path, bool append)
+    -> absl::StatusOr<std::unique_ptr<FastqWriter>> {
+  gxl::File* file;
+  RETURN_IF_ERROR(
+      gxl::Open(path, append ? "a" : "w", &file, gxl::file::Defaults()));
+  return std::make_unique<FastqWriter>(file);
+}
+
+}  // namespace
+
+auto BarcodeMatcher::New(const std::vector<std::string>& barcodes,
+                         int max_mismatches)
+    -> absl::StatusOr<BarcodeMatcher> {
+  if (max_mismatches < 0 || max_mismatches > kMaxMismatches) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("The mismatch limit must be between 0 and %d but is %d",
+                        kMaxMismatches, max_mismatches));
+  }
+  absl::flat_hash_set<absl::string_view> seen;
+  for (const std::string& barcode : barcodes) {
+    if (barcode.empty()) {
+      return absl::InvalidArgumentError("Empty barcode");
+    }
+    if (!seen.insert(barcode).second) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Duplicate barcode %s", barcode));
+    }
+  }
+  BarcodeMatcher matcher;
+  for (size_t i = 0; i < barcodes.size(); ++i) {
+    std::string neighbor = barcodes[i];
+    matcher.AddNeighbors(static_cast<int32_t>(i), 0, 0, max_mismatches,
+                         &neighbor);
+  }
+  return matcher;
+}
+
+auto BarcodeMatcher::AddNeighbors(int32_t sample, int mismatches,
+                                  size_t position, int remaining,
+                                  std::string* neighbor) -> void {
+  auto [it, inserted] = entries_.try_emplace(
+      *neighbor, Entry{.sample = sample, .mismatches = mismatches});
+  if (!inserted) {
+    Entry& entry = it->second;
+    if (mismatches < entry.mismatches) {
+      entry = {.sample = sample, .mismatches = mismatches};
+    } else if (mismatches == entry.mismatches && entry.sample != sample) {
+      entry.sample = kAmbiguous;
+    }
+  }
+  if (remaining == 0) {
+    return;
+  }
+  for (size_t i = position; i < neighbor->size(); ++i) {
+    const char original = (*neighbor)[i];
+    if (original == kBarcodeSeparator) {
+      continue;
+    }
+    for (char base : kBases) {
+      if (base == original) {
+        continue;
+      }
+      (*neighbor)[i] = base;
+      AddNeighbors(sample, mismatches + 1, i + 1, remaining - 1, neighbor);
+    }
+    (*neighbor)[i] = original;
+  }
+}
+
+auto BarcodeMatcher::Match(absl::string_view barcode) const -> BarcodeMatch {
+  const auto it = entries_.find(barcode);
+  if (it == entries_.end()) {
+    return {};
+  }
+  const Entry& entry = it->second;
+  if (entry.sample == kAmbiguous) {
+    return {.mismatches = entry.mismatches, .ambiguous = true};
+  }
+  return {.sample = static_cast<size_t>(entry.sample),
+          .mismatches = entry.mismatches};
+}
+
+auto ExtractBarcode(absl::string_view name) -> absl::string_view {
+  const size_t space = name.find_first_of(" \t");
+  if (space == absl::string_view::npos) {
+    return "";
+  }
+  const absl::string_view comment = name.substr(space + 1);
+  const size_t colon = comment.rfind(':');
+  return colon == absl::string_view::npos ? comment
+                                          : comment.substr(colon + 1);
+}
+
+auto Demultiplexer::New(const std::vector<SampleBarcode>& samples,
+                        const DemultiplexOptions& options)
+    -> absl::StatusOr<std::unique_ptr<Demultiplexer>> {
+  std::vector<std::string> barcodes;
+  std::vector<std::string> names;
+  absl::flat_hash_set<absl::string_view> seen;
+  for (const SampleBarcode& sample : samples) {
+    if (sample.sample.empty() || sample.sample == kUndetermined ||
+        sample.sample.find('/') != std::string::npos ||
+        !seen.insert(sample.sample).second) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid sample name '%s'", sample.sample));
+    }
+    barcodes.push_back(sample.barcode);
+    names.push_back(sample.sample);
+  }
+  ASSIGN_OR_RETURN(BarcodeMatcher matcher,
+                   BarcodeMatcher::New(barcodes, options.max_mismatches));
+  names.push_back(std::string(kUndetermined));
+  return std::unique_ptr<Demultiplexer>(
+      new Demultiplexer(std::move(matcher), std::move(names), options));
+}
+
+Demultiplexer::Demultiplexer(BarcodeMatcher matcher,
+                             std::vector<std::string> samples,
+                             const DemultiplexOptions& options)
+    : matcher_(std::move(matcher)),
+      samples_(std::move(samples)),
+      options_(options),
+      outputs_(samples_.size() * kNumOutputKinds) {
+  stats_.sample_reads.resize(samples_.size() - 1, 0);
+  static constexpr absl::string_view kSuffixes[kNumOutputKinds] = {
+      ".fastq", "_R1.fastq", "_R2.fastq"};
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    outputs_[i].path = gxl::JoinPath(
+        options_.output_dir, absl::StrCat(samples_[i / kNumOutputKinds],
+                                          kSuffixes[i % kNumOutputKinds]));
+  }
+  for (size_t i = 0; i < std::max<size_t>(options_.num_writer_threads, 1);
+       ++i) {
+    writers_.push_back(std::make_unique<ThreadPool>(1));
+  }
+}
+
+auto Demultiplexer::Route(absl::string_view barcode) -> size_t {
+  const BarcodeMatch match = matcher_.Match(barcode);
+  if (!match.sample.has_value()) {
+    ++stats_.undetermined;
+    if (match.ambiguous) {
+      ++stats_.ambiguous;
+    }
+    return samples_.size() - 1;
+  }
+  ++stats_.sample_reads[*match.sample];
+  if (match.mismatches > 0) {
+    ++stats_.corrected;
+  }
+  return *match.sample;
+}
+
+auto Demultiplexer::Add(const FastqSequence& read) -> absl::Status {
+  return Add(read, ExtractBarcode(read.name));
+}
+
+auto Demultiplexer::Add(const FastqSequence& read, absl::string_view barcode)
+    -> absl::Status {
+  return Buffer(Route(barcode), kSingle, read);
+}
+
+auto Demultiplexer::Add(const FastqPair& pair) -> absl::Status {
+  return Add(pair, ExtractBarcode(pair.first.name));
+}
+
+auto Demultiplexer::Add(const FastqPair& pair, absl::string_view barcode)
+    -> absl::Status {
+  const size_t sample = Route(barcode);
+  RETURN_IF_ERROR(Buffer(sample, kFirst, pair.first));
+  return Buffer(sample, kSecond, pair.second);
+}
+
+auto Demultiplexer::Buffer(size_t sample, OutputKind kind,
+                           const FastqSequence& read) -> absl::Status {
+  const size_t index = sample * kNumOutputKinds + kind;
+  Output& output = outputs_[index];
+  output.buffer.push_back(read);
+  output.buffered_bytes += ReadBytes(read);
+  if (output.buffered_bytes >= options_.buffer_size) {
+    return Flush(index);
+  }
+  return absl::OkStatus();
+}
+
+auto Demultiplexer::CanSubmit() const -> bool {
+  return pending_bytes_ <= options_.max_pending_bytes || !status_.ok();
+}
+
+auto Demultiplexer::Flush(size_t index) -> absl::Status {
+  Output& output = outputs_[index];
+  if (output.buffer.empty()) {
+    return absl::OkStatus();
+  }
+  const size_t bytes = std::exchange(output.buffered_bytes, 0);
+  {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(this, &Demultiplexer::CanSubmit));
+    RETURN_IF_ERROR(status_);
+    pending_bytes_ += bytes;
+  }
+  // Whether the writer thread opens the file, and in which mode, is decided
+  // here, in the order of the flushes.
+  const bool open = !output.open;
+  const bool append = output.created;
+  if (open) {
+    if (num_open_ >= std::max<size_t>(options_.max_open_files, 1)) {
+      Evict();
+    }
+    output.open = true;
+    output.created = true;
+    ++num_open_;
+  }
+  output.last_flush = ++num_flushes_;
+  auto reads = std::make_shared<std::vector<FastqSequence>>(
+      std::exchange(output.buffer, std::vector<FastqSequence>()));
+  writers_[index % writers_.size()]->Schedule(
+      [this, &output, reads, bytes, open, append]() {
+        absl::Status status;
+        if (open) {
+          absl::StatusOr<std::unique_ptr<FastqWriter>> writer =
+              OpenWriter(output.path, append);
+          status = writer.status();
+          if (writer.ok()) {
+            output.writer = *std::move(writer);
+          }
+        }
+        // The writer is null if opening the file failed, which has already
+        // been reported.
+        if (status.ok() && output.writer != nullptr) {
+          status = output.writer->Write(*reads);
+        }
+        absl::MutexLock lock(&mutex_);
+        status_.Update(status);
+        pending_bytes_ -= bytes;
+      });
+  return absl::OkStatus();
+}
+
+auto Demultiplexer::Evict() -> void {
+  // Evictions are rare next to buffered reads, so a scan of the outputs is
+  // cheap enough.
+  size_t index = 0;
+  uint64_t last_flush = UINT64_MAX;
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    if (outputs_[i].open && outputs_[i].last_flush < last_flush) {
+      index = i;
+      last_flush = outputs_[i].last_flush;
+    }
+  }
+  Output& output = outputs_[index];
+  output.open = false;
+  --num_open_;
+  writers_[index % writers_.size()]->Schedule([this, &output]() {
+    if (output.writer == nullptr) {
+      return;
+    }
+    absl::Status status = output.writer->Close();
+    output.writer = nullptr;
+    absl::MutexLock lock(&mutex_);
+    status_.Update(status);
+  });
+}
+
+auto Demultiplexer::Close() -> absl::StatusOr<DemultiplexStats> {
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    RETURN_IF_ERROR(Flush(i));
+  }
+  for (const std::unique_ptr<ThreadPool>& writer : writers_) {
+    writer->Wait();
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    RETURN_IF_ERROR(status_);
+  }
+  for (Output& output : outputs_) {
+    if (output.writer != nullptr) {
+      RETURN_IF_ERROR(output.writer->Close());
+    }
+  }
+  return stats_;
+}
+
+auto DemultiplexFastq(absl::Nonnull<FastqParser*> parser,
+                      const std::vector<SampleBarcode>& samples,
+                      const DemultiplexOptions& options)
+    -> absl::StatusOr<DemultiplexStats> {
+  ASSIGN_OR_RETURN(std::unique_ptr<Demultiplexer> demultiplexer,
+                   Demultiplexer::New(samples, options));
+  while (!parser->eof()) {
+    ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+    if (read == nullptr) {
+      break;
+    }
+    RETURN_IF_ERROR(demultiplexer->Add(*read));
+  }
+  return demultiplexer->Close();
+}
+
+auto DemultiplexFastq(absl::Nonnull<PairedFastqReader*> reader,
+                      const std::vector<SampleBarcode>& samples,
+                      const DemultiplexOptions& options)
+    -> absl::StatusOr<DemultiplexStats> {
+  ASSIGN_OR_RETURN(std::unique_ptr<Demultiplexer> demultiplexer,
+                   Demultiplexer::New(samples, options));
+  while (true) {
+    ASSIGN_OR_RETURN(std::optional<FastqPair> pair, reader->Next());
+    if (!pair.has_value()) {
+      break;
+    }
+    RETURN_IF_ERROR(demultiplexer->Add(*pair));
+  }
+  return demultiplexer->Close();
+}
+
+}  // namespace bio
@@ -0,0 +1,288 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_DEMULTIPLEXER_H_
+#define BIO_FASTQ_DEMULTIPLEXER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+
+namespace bio {
+
+// A sample and its barcode. Dual-index barcodes are written as in Illumina
+// read names, e.g. "ACGTACGT+TTGGCCAA".
+struct SampleBarcode {
+  std::string sample;
+  std::string barcode;
+};
+
+// The result of matching an observed barcode.
+struct BarcodeMatch {
+  // The index of the matching sample, or nullopt if no sample matches or the
+  // barcode is as close to two samples.
+  std::optional<size_t> sample;
+
+  // The number of mismatches with the sample's barcode.
+  int mismatches = 0;
+
+  // Whether the barcode is within the mismatch limit of two samples at the
+  // same distance.
+  bool ambiguous = false;
+};
+
+// Matches observed barcodes against a set of sample barcodes, allowing up to
+// a fixed number of mismatches.
+//
+// Every sequence within the mismatch limit of a sample barcode, substituting
+// A, C, G, T or N at each base, is precomputed in a hash table, so that
+// matching is a single lookup. For 8-base barcodes and one mismatch this is
+// 33 entries per sample.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(BarcodeMatcher matcher,
+//                  BarcodeMatcher::New({"ACGTACGT", "TTGGCCAA"},
+//                                      /*max_mismatches=*/1));
+// BarcodeMatch match = matcher.Match("ACGTACGA");  // Sample 0.
+// ```
+class BarcodeMatcher {
+ public:
+  // The largest supported mismatch limit.
+  static constexpr int kMaxMismatches = 3;
+
+  // Builds a matcher for `barcodes`, which must be distinct and non-empty.
+  static auto New(const std::vector<std::string>& barcodes, int max_mismatches)
+      -> absl::StatusOr<BarcodeMatcher>;
+
+  // Matches `barcode` against the sample barcodes.
+  auto Match(absl::string_view barcode) const -> BarcodeMatch;
+
+ private:
+  // A precomputed sequence: the closest sample, or kAmbiguous.
+  struct Entry {
+    int32_t sample;
+    int32_t mismatches;
+  };
+  static constexpr int32_t kAmbiguous = -1;
+
+  BarcodeMatcher() = default;
+
+  // Adds `neighbor`, which differs from the barcode of `sample` at
+  // `mismatches` positions, and the sequences that differ from it at up to
+  // `remaining` more positions at or after `position`.
+  auto AddNeighbors(int32_t sample, int mismatches, size_t position,
+                    int remaining, std::string* neighbor) -> void;
+
+  absl::flat_hash_map<std::string, Entry> entries_;
+};
+
+// Returns the barcode of an Illumina read name: the last colon-separated field
+// of the comment, as in "A00123:8:H7KLMDSXX:1:1101:10004:1000 1:N:0:ACGTACGT".
+// Returns an empty string if the name has no comment.
+auto ExtractBarcode(absl::string_view name) -> absl::string_view;
+
+// Options for demultiplexing.
+struct DemultiplexOptions {
+  // The maximum number of mismatches between a read's barcode and a sample's
+  // barcode. At most BarcodeMatcher::kMaxMismatches.
+  int max_mismatches = 1;
+
+  // The directory of the output files. Reads of each sample are written to
+  // "<sample>.fastq", or "<sample>_R1.fastq" and "<sample>_R2.fastq" for
+  // pairs. Reads that match no sample go to the "undetermined" sample.
+  std::string output_dir;
+
+  // The number of bytes of reads buffered per output before they are handed
+  // to a writer thread.
+  size_t buffer_size = 256 << 10;
+
+  // The number of bytes handed to writer threads but not yet written, above
+  // which adding reads blocks.
+  size_t max_pending_bytes = 256 << 20;
+
+  // The number of writer threads. Each output is written by one of them, in
+  // order.
+  size_t num_writer_threads = 2;
+
+  // The maximum number of output files kept open. When an output is written
+  // while this many are open, the least recently written one is closed and
+  // reopened for appending when it is next written. Keep it well below the
+  // open file limit of the process (`ulimit -n`).
+  size_t max_open_files = 256;
+};
+
+// Counts of demultiplexed reads, or pairs.
+struct DemultiplexStats {
+  // The number of reads of each sample, in sample sheet order.
+  std::vector<uint64_t> sample_reads;
+
+  // The number of reads that matched no sample.
+  uint64_t undetermined = 0;
+
+  // The number of undetermined reads whose barcode was as close to two
+  // samples.
+  uint64_t ambiguous = 0;
+
+  // The number of reads that matched a sample with at least one mismatch.
+  uint64_t corrected = 0;
+};
+
+// Routes reads to per-sample FASTQ files by barcode.
+//
+// Reads are buffered per output and written by a few writer threads, so the
+// calling thread only looks up barcodes and copies reads, and writes to each
+// file are large and sequential even with thousands of outputs. Output files
+// are created when their first buffer is written, and at most
+// DemultiplexOptions::max_open_files of them are open at a time, plus one per
+// writer thread while evicted files are being closed.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(
+//     std::unique_ptr<Demultiplexer> demultiplexer,
+//     Demultiplexer::New({{"sample1", "ACGTACGT"}, {"sample2", "TTGGCCAA"}},
+//                        {.output_dir = "path/to/output"}));
+// while (...) {
+//   // The barcode is the sequence of the index read.
+//   RETURN_IF_ERROR(demultiplexer->Add(read, index_read.sequence));
+// }
+// ASSIGN_OR_RETURN(DemultiplexStats stats, demultiplexer->Close());
+// ```
+class Demultiplexer {
+ public:
+  // The name of the output of reads that match no sample.
+  static constexpr absl::string_view kUndetermined = "undetermined";
+
+  // Creates a demultiplexer for `samples`. Sample names must be distinct
+  // file names other than kUndetermined.
+  static auto New(const std::vector<SampleBarcode>& samples,
+                  const DemultiplexOptions& options)
+      -> absl::StatusOr<std::unique_ptr<Demultiplexer>>;
+
+  // Waits for pending writes.
+  ~Demultiplexer() = default;
+
+  Demultiplexer(const Demultiplexer&) = delete;
+  auto operator=(const Demultiplexer&) -> Demultiplexer& = delete;
+
+  // Routes `read` by the barcode in its name.
+  auto Add(const FastqSequence& read) -> absl::Status;
+
+  // Routes `read` by `barcode`.
+  auto Add(const FastqSequence& read, absl::string_view barcode)
+      -> absl::Status;
+
+  // Routes `pair` by the barcode in the name of its first mate.
+  auto Add(const FastqPair& pair) -> absl::Status;
+
+  // Routes `pair` by `barcode`.
+  auto Add(const FastqPair& pair, absl::string_view barcode) -> absl::Status;
+
+  // Writes the buffered reads, closes the outputs and returns the counts.
+  auto Close() -> absl::StatusOr<DemultiplexStats>;
+
+ private:
+  // The outputs of each sample.
+  enum OutputKind { kSingle = 0, kFirst = 1, kSecond = 2, kNumOutputKinds = 3 };
+
+  struct Output {
+    std::string path;
+
+    // The open file, which is only used by the writer thread of the output.
+    std::unique_ptr<FastqWriter> writer;
+
+    std::vector<FastqSequence> buffer;
+    size_t buffered_bytes = 0;
+
+    // Whether the file is open, or will be by the time the writer thread gets
+    // to the next write, and whether it has been created.
+    bool open = false;
+    bool created = false;
+
+    // The value of num_flushes_ when the output was last flushed.
+    uint64_t last_flush = 0;
+  };
+
+  Demultiplexer(BarcodeMatcher matcher, std::vector<std::string> samples,
+                const DemultiplexOptions& options);
+
+  // Returns the sample of `barcode`, or the undetermined sample, and counts
+  // the read.
+  auto Route(absl::string_view barcode) -> size_t;
+
+  // Buffers `read` for an output of `sample`.
+  auto Buffer(size_t sample, OutputKind kind, const FastqSequence& read)
+      -> absl::Status;
+
+  // Hands the buffered reads of `output` to its writer thread.
+  auto Flush(size_t output) -> absl::Status;
+
+  // Closes the least recently flushed open output.
+  auto Evict() -> void;
+
+  // Checks whether the pending bytes are below the limit.
+  auto CanSubmit() const -> bool ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  BarcodeMatcher matcher_;
+  std::vector<std::string> samples_;
+  DemultiplexOptions options_;
+  DemultiplexStats stats_;
+  std::vector<Output> outputs_;
+  size_t num_open_ = 0;
+  uint64_t num_flushes_ = 0;
+
+  absl::Mutex mutex_;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  size_t pending_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  // Single-threaded pools, so that the writes of each output are in order.
+  // They are destroyed first, which waits for pending writes.
+  std::vector<std::unique_ptr<ThreadPool>> writers_;
+};
+
+// Demultiplexes the reads of `parser` by the barcodes in their names.
+auto DemultiplexFastq(absl::Nonnull<FastqParser*> parser,
+                      const std::vector<SampleBarcode>& samples,
+                      const DemultiplexOptions& options)
+    -> absl::StatusOr<DemultiplexStats>;
+
+// Demultiplexes the pairs of `reader` by the barcodes in the names of their
+// first mates.
+auto DemultiplexFastq(absl::Nonnull<PairedFastqReader*> reader,
+                      const std::vector<SampleBarcode>& samples,
+                      const DemultiplexOptions& options)
+    -> absl::StatusOr<DemultiplexStats>;
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_DEMULTIPLEXER_H_
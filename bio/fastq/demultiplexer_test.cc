@@ -0,0 +1,246 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/demultiplexer.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::Optional;
+using ::testing::TempDir;
+
+auto ReadFile(absl::string_view name) -> std::string {
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents(gxl::JoinPath(TempDir(), name), &contents,
+                               gxl::file::Defaults()),
+              IsOk());
+  return contents;
+}
+
+auto Record(absl::string_view name, absl::string_view sequence)
+    -> std::string {
+  return absl::StrCat("@", name, "\n", sequence, "\n+\n",
+                      std::string(sequence.size(), 'I'), "\n");
+}
+
+TEST(BarcodeMatcher, MatchesWithMismatches) {
+  absl::StatusOr<BarcodeMatcher> matcher =
+      BarcodeMatcher::New({"ACGTACGT", "TTGGCCAA"}, 1);
+  ASSERT_THAT(matcher, IsOk());
+
+  BarcodeMatch match = matcher->Match("ACGTACGT");
+  EXPECT_THAT(match.sample, Optional(0));
+  EXPECT_EQ(match.mismatches, 0);
+
+  match = matcher->Match("TTGGCNAA");
+  EXPECT_THAT(match.sample, Optional(1));
+  EXPECT_EQ(match.mismatches, 1);
+
+  EXPECT_EQ(matcher->Match("TTGGCCTT").sample, std::nullopt);
+  EXPECT_EQ(matcher->Match("ACGTACG").sample, std::nullopt);
+  EXPECT_EQ(matcher->Match("").sample, std::nullopt);
+}
+
+TEST(BarcodeMatcher, MatchesWithTwoMismatches) {
+  absl::StatusOr<BarcodeMatcher> matcher =
+      BarcodeMatcher::New({"ACGTACGT"}, 2);
+  ASSERT_THAT(matcher, IsOk());
+  const BarcodeMatch match = matcher->Match("ACCTACGA");
+  EXPECT_THAT(match.sample, Optional(0));
+  EXPECT_EQ(match.mismatches, 2);
+  EXPECT_EQ(matcher->Match("ACCTANGA").sample, std::nullopt);
+}
+
+TEST(BarcodeMatcher, PrefersCloserSamples) {
+  absl::StatusOr<BarcodeMatcher> matcher =
+      BarcodeMatcher::New({"AAAA", "AATT", "AAAC"}, 1);
+  ASSERT_THAT(matcher, IsOk());
+
+  // Exact matches win over one-mismatch neighbors.
+  EXPECT_THAT(matcher->Match("AAAC").sample, Optional(2));
+
+  // One mismatch from both AAAA and AATT.
+  const BarcodeMatch match = matcher->Match("AAAT");
+  EXPECT_EQ(match.sample, std::nullopt);
+  EXPECT_TRUE(match.ambiguous);
+}
+
+TEST(BarcodeMatcher, KeepsDualIndexSeparator) {
+  absl::StatusOr<BarcodeMatcher> matcher =
+      BarcodeMatcher::New({"ACGT+TTGG"}, 1);
+  ASSERT_THAT(matcher, IsOk());
+  EXPECT_THAT(matcher->Match("ACGT+TTGA").sample, Optional(0));
+  EXPECT_EQ(matcher->Match("ACGTATTGG").sample, std::nullopt);
+}
+
+TEST(BarcodeMatcher, RejectsInvalidBarcodes) {
+  EXPECT_THAT(BarcodeMatcher::New({"ACGT", "ACGT"}, 1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BarcodeMatcher::New({""}, 1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BarcodeMatcher::New({"ACGT"}, 4),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(BarcodeMatcher::New({"ACGT"}, -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ExtractBarcode, ReturnsLastCommentField) {
+  EXPECT_EQ(ExtractBarcode("A00123:8:H7KLMDSXX:1:1101:10004:1000 "
+                           "1:N:0:ACGTACGT+TTGGCCAA"),
+            "ACGTACGT+TTGGCCAA");
+  EXPECT_EQ(ExtractBarcode("read\tACGT"), "ACGT");
+  EXPECT_EQ(ExtractBarcode("A00123:8:H7KLMDSXX:1:1101:10004:1000"), "");
+}
+
+TEST(Demultiplexer, RoutesReadsToSamples) {
+  std::string input;
+  std::string expected_a;
+  std::string expected_b;
+  std::string expected_undetermined;
+  for (int i = 0; i < 300; ++i) {
+    const absl::string_view barcodes[] = {"ACGTACGT", "TTGGCCAA", "ACGTACGA",
+                                          "GGGGGGGG"};
+    const std::string record = Record(
+        absl::StrCat("read", i, " 1:N:0:", barcodes[i % 4]), "ACGTTGCA");
+    absl::StrAppend(&input, record);
+    absl::StrAppend(i % 4 == 1   ? &expected_b
+                    : i % 4 == 3 ? &expected_undetermined
+                                 : &expected_a,
+                    record);
+  }
+  absl::StatusOr<std::unique_ptr<FastqParser>> parser =
+      FastqParser::New(WriteTempFile("demultiplex.fastq", input));
+  ASSERT_THAT(parser, IsOk());
+
+  absl::StatusOr<DemultiplexStats> stats = DemultiplexFastq(
+      parser->get(),
+      {{"single_a", "ACGTACGT"}, {"single_b", "TTGGCCAA"}},
+      {.output_dir = TempDir(), .buffer_size = 100, .num_writer_threads = 3});
+  ASSERT_THAT(stats, IsOk());
+  EXPECT_THAT(stats->sample_reads, ElementsAre(150, 75));
+  EXPECT_EQ(stats->undetermined, 75);
+  EXPECT_EQ(stats->corrected, 75);
+  EXPECT_EQ(stats->ambiguous, 0);
+
+  EXPECT_EQ(ReadFile("single_a.fastq"), expected_a);
+  EXPECT_EQ(ReadFile("single_b.fastq"), expected_b);
+  EXPECT_EQ(ReadFile("undetermined.fastq"), expected_undetermined);
+}
+
+TEST(Demultiplexer, LimitsOpenFiles) {
+  std::vector<SampleBarcode> samples;
+  for (int i = 0; i < 16; ++i) {
+    std::string barcode;
+    for (int j = 0; j < 4; ++j) {
+      barcode.push_back("ACGT"[(i >> (2 * j)) & 3]);
+    }
+    samples.push_back(
+        {.sample = absl::StrCat("limited", i), .barcode = barcode});
+  }
+  absl::StatusOr<std::unique_ptr<Demultiplexer>> demultiplexer =
+      Demultiplexer::New(samples, {.max_mismatches = 0,
+                                   .output_dir = TempDir(),
+                                   .buffer_size = 1,
+                                   .num_writer_threads = 3,
+                                   .max_open_files = 3});
+  ASSERT_THAT(demultiplexer, IsOk());
+  std::vector<std::string> expected(samples.size());
+  for (int i = 0; i < 1000; ++i) {
+    // Cycle through the samples in a varying order, so that every write
+    // evicts an output that is reopened later.
+    const size_t sample = (i * 7 + i / 16) % samples.size();
+    const FastqSequence read = {.name = absl::StrCat("read", i),
+                                .sequence = "ACGT",
+                                .quality = "IIII"};
+    ASSERT_THAT((*demultiplexer)->Add(read, samples[sample].barcode), IsOk());
+    absl::StrAppend(&expected[sample], read.string(), "\n");
+  }
+  ASSERT_THAT((*demultiplexer)->Close(), IsOk());
+  for (size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_EQ(ReadFile(absl::StrCat(samples[i].sample, ".fastq")), expected[i])
+        << samples[i].sample;
+  }
+}
+
+TEST(Demultiplexer, RoutesPairs) {
+  absl::StatusOr<std::unique_ptr<PairedFastqReader>> reader =
+      PairedFastqReader::New("bio/fastq/testdata/demultiplex-pairs-1.fastq",
+                             "bio/fastq/testdata/demultiplex-pairs-2.fastq");
+  ASSERT_THAT(reader, IsOk());
+  absl::StatusOr<DemultiplexStats> stats =
+      DemultiplexFastq(reader->get(), {{"paired_a", "AAAA"}},
+                       {.max_mismatches = 1, .output_dir = TempDir()});
+  ASSERT_THAT(stats, IsOk());
+  EXPECT_THAT(stats->sample_reads, ElementsAre(2));
+  EXPECT_EQ(stats->undetermined, 1);
+
+  EXPECT_EQ(ReadFile("paired_a_R1.fastq"),
+            absl::StrCat(Record("p1/1 1:N:0:AAAA", "ACGT"),
+                         Record("p3/1 1:N:0:AAAT", "TTTT")));
+  EXPECT_EQ(ReadFile("paired_a_R2.fastq"),
+            absl::StrCat(Record("p1/2 2:N:0:AAAA", "TGCA"),
+                         Record("p3/2 2:N:0:AAAT", "AAAA")));
+  EXPECT_EQ(ReadFile("undetermined_R2.fastq"),
+            Record("p2/2 2:N:0:CCCC", "CCCC"));
+}
+
+TEST(Demultiplexer, RoutesByIndexReads) {
+  absl::StatusOr<std::unique_ptr<Demultiplexer>> demultiplexer =
+      Demultiplexer::New({{"index_a", "ACGT"}}, {.output_dir = TempDir()});
+  ASSERT_THAT(demultiplexer, IsOk());
+  const FastqSequence read = {
+      .name = "read", .sequence = "GATTACA", .quality = "IIIIIII"};
+  ASSERT_THAT((*demultiplexer)->Add(read, "ACGA"), IsOk());
+  absl::StatusOr<DemultiplexStats> stats = (*demultiplexer)->Close();
+  ASSERT_THAT(stats, IsOk());
+  EXPECT_THAT(stats->sample_reads, ElementsAre(1));
+  EXPECT_EQ(ReadFile("index_a.fastq"), Record("read", "GATTACA"));
+}
+
+TEST(Demultiplexer, RejectsInvalidSamples) {
+  const DemultiplexOptions options = {.output_dir = TempDir()};
+  EXPECT_THAT(Demultiplexer::New({{"a", "ACGT"}, {"a", "TTTT"}}, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Demultiplexer::New({{"undetermined", "ACGT"}}, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Demultiplexer::New({{"a/b", "ACGT"}}, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Demultiplexer::New({{"a", "ACGT"}, {"b", "ACGT"}}, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,542 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/duplicate-finder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/hash.h"
+#include "bio/common/temp-file.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The key space is split into 2^kPartitionBits partitions by the top bits of
+// the hash. A spilled partition that is too large to resolve within the memory
+// budget is split again on the next kPartitionBits bits, down to kMaxLevel.
+static constexpr int kPartitionBits = 6;
+static constexpr size_t kNumPartitions = size_t{1} << kPartitionBits;
+static constexpr int kMaxLevel = 64 / kPartitionBits - 1;
+
+// The initial number of table slots.
+static constexpr size_t kInitialSlots = 1024;
+
+// The maximum load factor of the table, in tenths.
+static constexpr size_t kMaxLoadTenths = 7;
+
+// A spill record is a 128-bit key and a 64-bit value. The value is either the
+// index of a read or, with kClusterFlag set, the size of a cluster that was in
+// the table when the partition was spilled.
+static constexpr size_t kRecordSize = 24;
+static constexpr uint64_t kClusterFlag = uint64_t{1} << 63;
+
+// The maximum number of bytes of records buffered per spilled partition, and
+// read at a time when resolving one. Smaller budgets get smaller buffers.
+static constexpr size_t kMaxSpillBufferSize = kRecordSize * (1 << 16);
+
+// The suffix that DuplicateAction::kMark appends to read names.
+static constexpr absl::string_view kDuplicateMark = " duplicate";
+
+// Hashes `sequence` into two independent 64-bit lanes.
+auto HashSequence(absl::string_view sequence, uint64_t* h1, uint64_t* h2)
+    -> void {
+  *h1 = Mix64(*h1 ^ sequence.size());
+  *h2 = Mix64(*h2 + sequence.size() + 0x9e3779b97f4a7c15ULL);
+  while (!sequence.empty()) {
+    uint64_t word = 0;
+    const size_t size = std::min<size_t>(sequence.size(), 8);
+    std::memcpy(&word, sequence.data(), size);
+    *h1 = Mix64(*h1 ^ word);
+    *h2 =
+        Mix64(*h2 + ((word << 32) | (word >> 32))) ^ 0x243f6a8885a308d3ULL;
+    sequence.remove_prefix(size);
+  }
+}
+
+// Returns the 128-bit key of a read or pair, which is never zero.
+auto HashRead(absl::string_view first, absl::string_view second,
+              size_t prefix_length) -> absl::uint128 {
+  if (prefix_length > 0) {
+    first = first.substr(0, prefix_length);
+    second = second.substr(0, prefix_length);
+  }
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  HashSequence(first, &h1, &h2);
+  HashSequence(second, &h1, &h2);
+  const absl::uint128 key =
+      absl::MakeUint128(Mix64(h1 ^ h2), Mix64(h2) ^ h1);
+  return key == 0 ? 1 : key;
+}
+
+// Returns the partition of `key` at `level`, where partitions at level 0 split
+// the whole key space and those at level n + 1 split a partition at level n.
+auto PartitionOf(absl::uint128 key, int level = 0) -> size_t {
+  return (absl::Uint128High64(key) >> (64 - (level + 1) * kPartitionBits)) &
+         (kNumPartitions - 1);
+}
+
+// Returns the slot of `key` in the open-addressing table `slots`, whose size is
+// a power of 2, and whether it was empty. The table must not be full.
+template <typename Slot>
+auto FindOrInsert(std::vector<Slot>* slots, absl::uint128 key)
+    -> std::pair<Slot*, bool> {
+  const size_t mask = slots->size() - 1;
+  size_t i = absl::Uint128Low64(key) & mask;
+  while (true) {
+    Slot& slot = (*slots)[i];
+    if (slot.key == key) {
+      return {&slot, false};
+    }
+    if (slot.key == 0) {
+      slot.key = key;
+      return {&slot, true};
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+// Moves the entries of `slots` to a table of `size` slots.
+template <typename Slot>
+auto Rehash(std::vector<Slot>* slots, size_t size) -> void {
+  std::vector<Slot> rehashed(size);
+  for (const Slot& slot : *slots) {
+    if (slot.key != 0) {
+      *FindOrInsert(&rehashed, slot.key).first = slot;
+    }
+  }
+  *slots = std::move(rehashed);
+}
+
+// Returns the number of slots for a table of `size` keys.
+auto SlotsFor(size_t size) -> size_t {
+  size_t slots = kInitialSlots;
+  while (size * 10 > slots * kMaxLoadTenths) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+auto MarkDuplicate(FastqSequence* read) -> void {
+  absl::StrAppend(&read->name, kDuplicateMark);
+}
+
+// Calls `fn(key, value)` on each record of the spill file at `path`, reading
+// `buffer_size` bytes at a time.
+template <typename Fn>
+auto ForEachRecord(const std::string& path, size_t buffer_size, Fn fn)
+    -> absl::Status {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
+  std::string buffer(buffer_size, '\0');
+  size_t buffered = 0;
+  absl::Status status;
+  while (status.ok()) {
+    const size_t size =
+        file->Read(buffer.data() + buffered, buffer.size() - buffered);
+    if (size == 0) {
+      break;
+    }
+    buffered += size;
+    const size_t end = buffered - buffered % kRecordSize;
+    for (size_t offset = 0; offset < end && status.ok();
+         offset += kRecordSize) {
+      uint64_t words[3];
+      std::memcpy(words, buffer.data() + offset, kRecordSize);
+      status = fn(absl::MakeUint128(words[0], words[1]), words[2]);
+    }
+    buffered -= end;
+    std::memmove(buffer.data(), buffer.data() + end, buffered);
+  }
+  const absl::Status close_status = file->Close(gxl::file::Defaults());
+  RETURN_IF_ERROR(status);
+  RETURN_IF_ERROR(close_status);
+  if (buffered != 0) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Truncated spill file", path));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+auto EstimateLibrarySize(uint64_t reads, uint64_t distinct)
+    -> std::optional<double> {
+  if (distinct == 0 || distinct >= reads) {
+    return std::nullopt;
+  }
+  const double c = distinct;
+  const double n = reads;
+  // The expected number of distinct reads when sampling n reads from a library
+  // of x molecules is x * (1 - exp(-n / x)). Solve for x = c * m by bisection.
+  const auto f = [c, n](double m) {
+    return 1.0 / m - 1.0 + std::exp(-n / (c * m));
+  };
+  double low = 1.0;
+  double high = 100.0;
+  while (f(high) > 0) {
+    high *= 10.0;
+  }
+  for (int i = 0; i < 64; ++i) {
+    const double middle = (low + high) / 2;
+    const double value = f(middle);
+    if (value == 0) {
+      low = high = middle;
+      break;
+    }
+    if (value > 0) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return c * (low + high) / 2;
+}
+
+auto DuplicateSet::Insert(uint64_t read) -> void {
+  if (read / 64 >= words_.size()) {
+    words_.resize(std::max<size_t>(read / 64 + 1, words_.size() * 2), 0);
+  }
+  const uint64_t bit = uint64_t{1} << (read % 64);
+  if ((words_[read / 64] & bit) == 0) {
+    words_[read / 64] |= bit;
+    ++size_;
+  }
+}
+
+DuplicateFinder::DuplicateFinder(const DuplicateFinderOptions& options)
+    : options_(options), slots_(kInitialSlots), partitions_(kNumPartitions) {
+  // The buffers of the spilled partitions take up to half of the budget, and
+  // the table the rest.
+  spill_buffer_size_ = std::clamp(
+      options_.max_memory / (2 * kNumPartitions) / kRecordSize * kRecordSize,
+      kRecordSize, kMaxSpillBufferSize);
+  const size_t buffers_size = kNumPartitions * spill_buffer_size_;
+  table_memory_ = std::max(
+      options_.max_memory - std::min(options_.max_memory, buffers_size),
+      kInitialSlots * sizeof(Slot));
+}
+
+DuplicateFinder::~DuplicateFinder() {
+  for (Partition& partition : partitions_) {
+    Remove(&partition);
+  }
+}
+
+auto DuplicateFinder::Add(const FastqSequence& read) -> absl::Status {
+  return AddKey(HashRead(read.sequence, "", options_.prefix_length));
+}
+
+auto DuplicateFinder::Add(const FastqPair& pair) -> absl::Status {
+  return AddKey(HashRead(pair.first.sequence, pair.second.sequence,
+                         options_.prefix_length));
+}
+
+auto DuplicateFinder::AddKey(absl::uint128 key) -> absl::Status {
+  const uint64_t read = result_.stats.reads++;
+  RETURN_IF_ERROR(Reserve());
+  Partition& partition = partitions_[PartitionOf(key)];
+  if (!partition.path.empty()) {
+    return AppendRecord(&partition, key, read);
+  }
+  auto [slot, inserted] = FindOrInsert(&slots_, key);
+  if (inserted) {
+    slot->count = 1;
+    ++size_;
+  } else {
+    ++slot->count;
+    ++result_.stats.duplicates;
+    result_.duplicates.Insert(read);
+  }
+  return absl::OkStatus();
+}
+
+auto DuplicateFinder::Reserve() -> absl::Status {
+  while ((size_ + 1) * 10 > slots_.size() * kMaxLoadTenths) {
+    if (2 * slots_.size() * sizeof(Slot) <= table_memory_) {
+      Rehash(&slots_, 2 * slots_.size());
+    } else {
+      // Spill the partitions from the top of the key space down.
+      RETURN_IF_ERROR(Spill(kNumPartitions - 1 - num_spilled_));
+    }
+  }
+  return absl::OkStatus();
+}
+
+auto DuplicateFinder::Spill(size_t partition) -> absl::Status {
+  Partition& spilled = partitions_[partition];
+  RETURN_IF_ERROR(Create(&spilled));
+  ++num_spilled_;
+
+  std::vector<Slot> slots(slots_.size());
+  size_ = 0;
+  for (const Slot& slot : slots_) {
+    if (slot.key == 0) {
+      continue;
+    }
+    if (PartitionOf(slot.key) == partition) {
+      RETURN_IF_ERROR(
+          AppendRecord(&spilled, slot.key, slot.count | kClusterFlag));
+    } else {
+      *FindOrInsert(&slots, slot.key).first = slot;
+      ++size_;
+    }
+  }
+  slots_ = std::move(slots);
+  return absl::OkStatus();
+}
+
+auto DuplicateFinder::Create(Partition* partition) -> absl::Status {
+  partition->path = TempFilePath(options_.temp_dir, "bio-duplicates");
+  partition->buffer.reserve(spill_buffer_size_);
+  return gxl::Open(partition->path, "w", &partition->file,
+                   gxl::file::Defaults());
+}
+
+auto DuplicateFinder::AppendRecord(Partition* partition, absl::uint128 key,
+                                   uint64_t value) -> absl::Status {
+  const uint64_t words[3] = {absl::Uint128High64(key), absl::Uint128Low64(key),
+                             value};
+  partition->buffer.append(reinterpret_cast<const char*>(words), kRecordSize);
+  ++partition->num_records;
+  if (partition->buffer.size() >= spill_buffer_size_) {
+    return FlushPartition(partition);
+  }
+  return absl::OkStatus();
+}
+
+auto DuplicateFinder::FlushPartition(Partition* partition) -> absl::Status {
+  const size_t size = partition->file->WriteString(partition->buffer);
+  if (size != partition->buffer.size()) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Expected to write %d bytes but wrote %d",
+                        partition->path, partition->buffer.size(), size));
+  }
+  partition->buffer.clear();
+  return absl::OkStatus();
+}
+
+auto DuplicateFinder::Close(Partition* partition) -> absl::Status {
+  RETURN_IF_ERROR(FlushPartition(partition));
+  partition->buffer = std::string();
+  return std::exchange(partition->file, nullptr)
+      ->Close(gxl::file::Defaults());
+}
+
+auto DuplicateFinder::Remove(Partition* partition) -> void {
+  if (partition->file != nullptr) {
+    std::exchange(partition->file, nullptr)
+        ->Close(gxl::file::Defaults())
+        .IgnoreError();
+  }
+  if (!partition->path.empty()) {
+    std::remove(partition->path.c_str());
+    partition->path.clear();
+  }
+  partition->buffer = std::string();
+  partition->num_records = 0;
+}
+
+auto DuplicateFinder::ResolvePartition(Partition* partition, int level,
+                                       DuplicateResult* result)
+    -> absl::Status {
+  // Records are counted in a table of at most one slot per record, so a
+  // partition whose table would not fit in the budget is split again on the
+  // next bits of the hash. Splitting cannot separate copies of one read, so
+  // if every record lands in the same part, it is mostly duplicates and is
+  // resolved in memory.
+  if (SlotsFor(partition->num_records) * sizeof(Slot) <= table_memory_ ||
+      level >= kMaxLevel) {
+    return CountPartition(partition, result);
+  }
+  std::vector<Partition> parts(kNumPartitions);
+  absl::Status status = ForEachRecord(
+      partition->path, spill_buffer_size_,
+      [&](absl::uint128 key, uint64_t value) -> absl::Status {
+        Partition& part = parts[PartitionOf(key, level + 1)];
+        if (part.path.empty()) {
+          RETURN_IF_ERROR(Create(&part));
+        }
+        return AppendRecord(&part, key, value);
+      });
+  const uint64_t num_records = partition->num_records;
+  Remove(partition);
+  // Close every part first, so that only one holds memory at a time.
+  for (Partition& part : parts) {
+    if (status.ok() && part.file != nullptr) {
+      status = Close(&part);
+    }
+  }
+  for (Partition& part : parts) {
+    if (status.ok() && !part.path.empty()) {
+      status = part.num_records < num_records
+                   ? ResolvePartition(&part, level + 1, result)
+                   : CountPartition(&part, result);
+    }
+    Remove(&part);
+  }
+  return status;
+}
+
+auto DuplicateFinder::CountPartition(Partition* partition,
+                                     DuplicateResult* result) -> absl::Status {
+  // Records are in read order, and the clusters that were in the table when
+  // the partition was spilled come first.
+  std::vector<Slot> slots(kInitialSlots);
+  size_t size = 0;
+  RETURN_IF_ERROR(ForEachRecord(
+      partition->path, spill_buffer_size_,
+      [&](absl::uint128 key, uint64_t value) {
+        if ((size + 1) * 10 > slots.size() * kMaxLoadTenths) {
+          Rehash(&slots, 2 * slots.size());
+        }
+        auto [slot, inserted] = FindOrInsert(&slots, key);
+        size += inserted;
+        if ((value & kClusterFlag) != 0) {
+          slot->count = value & ~kClusterFlag;
+        } else if (inserted) {
+          slot->count = 1;
+        } else {
+          ++slot->count;
+          ++result->stats.duplicates;
+          result->duplicates.Insert(value);
+        }
+        return absl::OkStatus();
+      }));
+  Remove(partition);
+  for (const Slot& slot : slots) {
+    if (slot.key != 0) {
+      ++result->stats.cluster_sizes[slot.count];
+    }
+  }
+  return absl::OkStatus();
+}
+
+auto DuplicateFinder::Finish() -> absl::StatusOr<DuplicateResult> {
+  for (const Slot& slot : slots_) {
+    if (slot.key != 0) {
+      ++result_.stats.cluster_sizes[slot.count];
+    }
+  }
+  slots_ = std::vector<Slot>();
+  size_ = 0;
+  for (Partition& partition : partitions_) {
+    if (partition.file != nullptr) {
+      RETURN_IF_ERROR(Close(&partition));
+    }
+  }
+  for (Partition& partition : partitions_) {
+    if (!partition.path.empty()) {
+      RETURN_IF_ERROR(ResolvePartition(&partition, /*level=*/0, &result_));
+    }
+  }
+  return std::move(result_);
+}
+
+auto FindDuplicates(absl::Nonnull<FastqParser*> parser,
+                    const DuplicateFinderOptions& options)
+    -> absl::StatusOr<DuplicateResult> {
+  DuplicateFinder finder(options);
+  while (!parser->eof()) {
+    ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+    if (read == nullptr) {
+      break;
+    }
+    RETURN_IF_ERROR(finder.Add(*read));
+  }
+  return finder.Finish();
+}
+
+auto FindDuplicates(absl::Nonnull<PairedFastqReader*> reader,
+                    const DuplicateFinderOptions& options)
+    -> absl::StatusOr<DuplicateResult> {
+  DuplicateFinder finder(options);
+  while (true) {
+    ASSIGN_OR_RETURN(std::optional<FastqPair> pair, reader->Next());
+    if (!pair.has_value()) {
+      break;
+    }
+    RETURN_IF_ERROR(finder.Add(*pair));
+  }
+  return finder.Finish();
+}
+
+auto WriteDeduplicated(absl::Nonnull<FastqParser*> parser,
+                       const DuplicateSet& duplicates, DuplicateAction action,
+                       absl::Nonnull<FastqWriter*> writer) -> absl::Status {
+  uint64_t index = 0;
+  while (!parser->eof()) {
+    ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+    if (read == nullptr) {
+      break;
+    }
+    if (duplicates.contains(index++)) {
+      if (action == DuplicateAction::kDrop) {
+        continue;
+      }
+      MarkDuplicate(read.get());
+    }
+    RETURN_IF_ERROR(writer->Write(*read));
+  }
+  return absl::OkStatus();
+}
+
+auto WriteDeduplicated(absl::Nonnull<PairedFastqReader*> reader,
+                       const DuplicateSet& duplicates, DuplicateAction action,
+                       absl::Nonnull<FastqWriter*> first_writer,
+                       absl::Nonnull<FastqWriter*> second_writer)
+    -> absl::Status {
+  uint64_t index = 0;
+  while (true) {
+    ASSIGN_OR_RETURN(std::optional<FastqPair> pair, reader->Next());
+    if (!pair.has_value()) {
+      break;
+    }
+    if (duplicates.contains(index++)) {
+      if (action == DuplicateAction::kDrop) {
+        continue;
+      }
+      MarkDuplicate(&pair->first);
+      MarkDuplicate(&pair->second);
+    }
+    RETURN_IF_ERROR(first_writer->Write(pair->first));
+    RETURN_IF_ERROR(second_writer->Write(pair->second));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace bio
@@ -0,0 +1,265 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_DUPLICATE_FINDER_H_
+#define BIO_FASTQ_DUPLICATE_FINDER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+
+// Options for finding duplicate reads.
+struct DuplicateFinderOptions {
+  // The number of leading bases of each mate that are compared. If 0, whole
+  // sequences are compared. Comparing a prefix also groups near-duplicates
+  // that differ only past it, such as copies trimmed to different lengths.
+  size_t prefix_length = 0;
+
+  // The memory budget of the hash table and of the spill buffers, in bytes.
+  // When the table would outgrow its share, parts of the key space are spilled
+  // to temporary files and resolved by DuplicateFinder::Finish.
+  size_t max_memory = size_t{1} << 30;
+
+  // The directory of the spill files. If empty, the system temporary
+  // directory is used.
+  std::string temp_dir;
+};
+
+// Duplication statistics of a set of reads, or of read pairs.
+struct DuplicateStats {
+  // The number of reads.
+  uint64_t reads = 0;
+
+  // The number of reads that repeat an earlier read.
+  uint64_t duplicates = 0;
+
+  // The number of clusters of identical reads of each size.
+  std::map<uint64_t, uint64_t> cluster_sizes;
+
+  // Returns the number of distinct reads.
+  auto distinct() const -> uint64_t { return reads - duplicates; }
+
+  // Returns the fraction of reads that are duplicates, or 0 if there are no
+  // reads.
+  auto duplicate_fraction() const -> double {
+    return reads == 0 ? 0.0 : static_cast<double>(duplicates) / reads;
+  }
+};
+
+// Estimates the number of distinct molecules in a library from which `reads`
+// reads with `distinct` distinct sequences were drawn, with the Lander-Waterman
+// model used by Picard's EstimateLibraryComplexity. Returns nullopt if there
+// are no duplicates, so that the library size is unbounded.
+auto EstimateLibrarySize(uint64_t reads, uint64_t distinct)
+    -> std::optional<double>;
+
+// A set of read indices, stored as a bitmap.
+class DuplicateSet {
+ public:
+  // Adds `read` to the set.
+  auto Insert(uint64_t read) -> void;
+
+  // Checks whether `read` is in the set.
+  auto contains(uint64_t read) const -> bool {
+    return read / 64 < words_.size() && (words_[read / 64] >> (read % 64)) & 1;
+  }
+
+  // Returns the number of reads in the set.
+  auto size() const -> uint64_t { return size_; }
+
+ private:
+  std::vector<uint64_t> words_;
+  uint64_t size_ = 0;
+};
+
+// The duplicates found in a set of reads.
+struct DuplicateResult {
+  DuplicateStats stats;
+
+  // The 0-based indices of the duplicate reads. The first read of each
+  // cluster is not a duplicate.
+  DuplicateSet duplicates;
+};
+
+// Finds reads, or read pairs, with identical sequences.
+//
+// Each read is reduced to a 128-bit hash of its sequences, and hashes are
+// counted in an open-addressing table. The key space is split into partitions
+// by the top bits of the hash. When the table reaches its share of
+// DuplicateFinderOptions::max_memory, partitions are spilled to temporary files
+// one at a time; their later reads are buffered, appended to the files and
+// resolved partition by partition by Finish. The spill buffers take up to half
+// of the budget. Spilled partitions that are still too large for the budget are
+// split again on more bits of the hash before they are resolved.
+//
+// Example usage:
+//
+// ```
+// DuplicateFinder finder;
+// while (...) {
+//   RETURN_IF_ERROR(finder.Add(read));
+// }
+// ASSIGN_OR_RETURN(DuplicateResult result, finder.Finish());
+// ```
+class DuplicateFinder {
+ public:
+  explicit DuplicateFinder(const DuplicateFinderOptions& options = {});
+
+  // Removes any spill files.
+  ~DuplicateFinder();
+
+  DuplicateFinder(const DuplicateFinder&) = delete;
+  auto operator=(const DuplicateFinder&) -> DuplicateFinder& = delete;
+
+  // Adds the next read.
+  auto Add(const FastqSequence& read) -> absl::Status;
+
+  // Adds the next read pair. Pairs are duplicates if both mates are.
+  auto Add(const FastqPair& pair) -> absl::Status;
+
+  // Resolves the spilled partitions and returns the duplicates. The finder
+  // must not be used afterwards.
+  auto Finish() -> absl::StatusOr<DuplicateResult>;
+
+ private:
+  // A hash table slot. Empty slots have a zero key; keys are never zero.
+  struct Slot {
+    absl::uint128 key = 0;
+    uint64_t count = 0;
+  };
+
+  // A spilled partition.
+  struct Partition {
+    std::string path;
+    absl::Nullable<gxl::File*> file = nullptr;
+    std::string buffer;
+    uint64_t num_records = 0;
+  };
+
+  // Adds the read with hash `key`.
+  auto AddKey(absl::uint128 key) -> absl::Status;
+
+  // Grows the table, or spills partitions if it is at its memory budget.
+  auto Reserve() -> absl::Status;
+
+  // Moves the entries of `partition` from the table to its spill file.
+  auto Spill(size_t partition) -> absl::Status;
+
+  // Creates the spill file of `partition`.
+  auto Create(Partition* partition) -> absl::Status;
+
+  // Appends a record to the spill file of `partition`.
+  auto AppendRecord(Partition* partition, absl::uint128 key, uint64_t value)
+      -> absl::Status;
+
+  // Flushes the buffered records of `partition`.
+  auto FlushPartition(Partition* partition) -> absl::Status;
+
+  // Flushes and closes the spill file of `partition`, and frees its buffer.
+  auto Close(Partition* partition) -> absl::Status;
+
+  // Closes and deletes the spill file of `partition`, if any.
+  auto Remove(Partition* partition) -> void;
+
+  // Counts the records of a closed spilled partition at split `level`,
+  // splitting it further if it does not fit in the memory budget.
+  auto ResolvePartition(Partition* partition, int level,
+                        DuplicateResult* result) -> absl::Status;
+
+  // Counts the records of a closed spill file in memory.
+  auto CountPartition(Partition* partition, DuplicateResult* result)
+      -> absl::Status;
+
+  DuplicateFinderOptions options_;
+  // The size of the record buffer of each spilled partition.
+  size_t spill_buffer_size_;
+  // The memory budget of the table, which is what the spill buffers leave of
+  // options_.max_memory.
+  size_t table_memory_;
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+  std::vector<Partition> partitions_;
+  size_t num_spilled_ = 0;
+  DuplicateResult result_;
+};
+
+// Finds the duplicate reads of `parser`.
+auto FindDuplicates(absl::Nonnull<FastqParser*> parser,
+                    const DuplicateFinderOptions& options = {})
+    -> absl::StatusOr<DuplicateResult>;
+
+// Finds the duplicate pairs of `reader`.
+auto FindDuplicates(absl::Nonnull<PairedFastqReader*> reader,
+                    const DuplicateFinderOptions& options = {})
+    -> absl::StatusOr<DuplicateResult>;
+
+// What to do with duplicate reads when writing them.
+enum class DuplicateAction {
+  // Append " duplicate" to the names of duplicates.
+  kMark,
+  // Leave duplicates out.
+  kDrop,
+};
+
+// Writes the reads of `parser` to `writer`, marking or dropping those in
+// `duplicates`. `parser` must return the reads that the duplicates were found
+// in, in the same order.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser,
+//                  FastqParser::New("path/to/reads.fastq"));
+// ASSIGN_OR_RETURN(DuplicateResult result, FindDuplicates(parser.get()));
+// std::optional<double> library_size =
+//     EstimateLibrarySize(result.stats.reads, result.stats.distinct());
+//
+// ASSIGN_OR_RETURN(parser, FastqParser::New("path/to/reads.fastq"));
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqWriter> writer,
+//                  FastqWriter::New("path/to/deduplicated.fastq"));
+// RETURN_IF_ERROR(WriteDeduplicated(parser.get(), result.duplicates,
+//                                   DuplicateAction::kDrop, writer.get()));
+// RETURN_IF_ERROR(writer->Close());
+// ```
+auto WriteDeduplicated(absl::Nonnull<FastqParser*> parser,
+                       const DuplicateSet& duplicates, DuplicateAction action,
+                       absl::Nonnull<FastqWriter*> writer) -> absl::Status;
+
+// Writes the pairs of `reader` to `first_writer` and `second_writer`, marking
+// or dropping those in `duplicates`.
+auto WriteDeduplicated(absl::Nonnull<PairedFastqReader*> reader,
+                       const DuplicateSet& duplicates, DuplicateAction action,
+                       absl::Nonnull<FastqWriter*> first_writer,
+                       absl::Nonnull<FastqWriter*> second_writer)
+    -> absl::Status;
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_DUPLICATE_FINDER_H_
@@ -0,0 +1,255 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/duplicate-finder.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::testing::DoubleNear;
+using ::testing::ElementsAre;
+using ::testing::Gt;
+using ::testing::Optional;
+using ::testing::Pair;
+using ::testing::TempDir;
+
+auto ReadFile(absl::string_view path) -> std::string {
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents(path, &contents, gxl::file::Defaults()),
+              IsOk());
+  return contents;
+}
+
+// Returns a distinct 40-base sequence for each value of `i`.
+auto MakeSequence(uint64_t i) -> std::string {
+  std::string sequence;
+  for (int j = 0; j < 40; ++j) {
+    sequence.push_back("ACGT"[(i >> (2 * (j % 20))) & 3]);
+  }
+  return sequence;
+}
+
+auto MakeRead(absl::string_view name, absl::string_view sequence)
+    -> FastqSequence {
+  return {
+      .name = std::string(name),
+      .sequence = std::string(sequence),
+      .quality = std::string(sequence.size(), 'I'),
+  };
+}
+
+// Adds 20000 reads in 5000 clusters of 4 and checks the result.
+auto ExpectClusters(const DuplicateFinderOptions& options) -> void {
+  DuplicateFinder finder(options);
+  for (uint64_t i = 0; i < 20000; ++i) {
+    ASSERT_THAT(finder.Add(MakeRead("read", MakeSequence(i % 5000))), IsOk());
+  }
+  absl::StatusOr<DuplicateResult> result = finder.Finish();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->stats.reads, 20000);
+  EXPECT_EQ(result->stats.duplicates, 15000);
+  EXPECT_EQ(result->stats.distinct(), 5000);
+  EXPECT_DOUBLE_EQ(result->stats.duplicate_fraction(), 0.75);
+  EXPECT_THAT(result->stats.cluster_sizes, ElementsAre(Pair(4, 5000)));
+  EXPECT_EQ(result->duplicates.size(), 15000);
+  for (uint64_t i = 0; i < 20000; ++i) {
+    ASSERT_EQ(result->duplicates.contains(i), i >= 5000) << i;
+  }
+}
+
+TEST(EstimateLibrarySize, SolvesTheLanderWatermanEquation) {
+  // Sampling n reads from a library of x molecules gives
+  // x * (1 - exp(-n / x)) distinct reads on average.
+  EXPECT_THAT(EstimateLibrarySize(10000, 6321),
+              Optional(DoubleNear(10000, 10)));
+  EXPECT_THAT(EstimateLibrarySize(1000000, 99995),
+              Optional(DoubleNear(100000, 100)));
+  EXPECT_EQ(EstimateLibrarySize(1000, 1000), std::nullopt);
+  EXPECT_EQ(EstimateLibrarySize(0, 0), std::nullopt);
+}
+
+TEST(DuplicateFinder, FindsDuplicatesInMemory) { ExpectClusters({}); }
+
+TEST(DuplicateFinder, SpillsPartitionsOverTheMemoryBudget) {
+  // The budget only fits the initial table, so most partitions are spilled
+  // while reads are being added.
+  ExpectClusters({.max_memory = 1});
+}
+
+TEST(DuplicateFinder, SplitsPartitionsOverTheMemoryBudget) {
+  // Half of the reads are copies of one sequence and the others are distinct,
+  // so spilled partitions are too large to resolve within the budget and are
+  // split again, down to the one that only holds the copies.
+  const std::string temp_dir = gxl::JoinPath(TempDir(), "split-partitions");
+  std::filesystem::create_directories(temp_dir);
+  DuplicateFinder finder({.max_memory = 1, .temp_dir = temp_dir});
+  for (uint64_t i = 0; i < 200000; ++i) {
+    ASSERT_THAT(finder.Add(MakeRead("read", MakeSequence(
+                                                i % 2 == 0 ? 0 : i / 2 + 1))),
+                IsOk());
+  }
+  absl::StatusOr<DuplicateResult> result = finder.Finish();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->stats.reads, 200000);
+  EXPECT_EQ(result->stats.duplicates, 99999);
+  EXPECT_THAT(result->stats.cluster_sizes,
+              ElementsAre(Pair(1, 100000), Pair(100000, 1)));
+  for (uint64_t i = 0; i < 200000; ++i) {
+    ASSERT_EQ(result->duplicates.contains(i), i % 2 == 0 && i > 0) << i;
+  }
+  EXPECT_TRUE(std::filesystem::is_empty(temp_dir));
+}
+
+TEST(DuplicateFinder, CountsClusterSizes) {
+  DuplicateFinder finder({.max_memory = 1});
+  for (int size = 1; size <= 3; ++size) {
+    for (int i = 0; i < size; ++i) {
+      ASSERT_THAT(finder.Add(MakeRead("read", MakeSequence(size))), IsOk());
+    }
+  }
+  ASSERT_THAT(finder.Add(MakeRead("read", MakeSequence(100))), IsOk());
+  absl::StatusOr<DuplicateResult> result = finder.Finish();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_THAT(result->stats.cluster_sizes,
+              ElementsAre(Pair(1, 2), Pair(2, 1), Pair(3, 1)));
+}
+
+TEST(DuplicateFinder, ComparesPrefixes) {
+  DuplicateFinder exact;
+  DuplicateFinder prefix({.prefix_length = 8});
+  for (absl::string_view sequence : {"ACGTACGTAA", "ACGTACGTCC", "ACGTACGA"}) {
+    ASSERT_THAT(exact.Add(MakeRead("read", sequence)), IsOk());
+    ASSERT_THAT(prefix.Add(MakeRead("read", sequence)), IsOk());
+  }
+  absl::StatusOr<DuplicateResult> exact_result = exact.Finish();
+  ASSERT_THAT(exact_result, IsOk());
+  EXPECT_EQ(exact_result->stats.duplicates, 0);
+  absl::StatusOr<DuplicateResult> prefix_result = prefix.Finish();
+  ASSERT_THAT(prefix_result, IsOk());
+  EXPECT_EQ(prefix_result->stats.duplicates, 1);
+  EXPECT_TRUE(prefix_result->duplicates.contains(1));
+}
+
+TEST(DuplicateFinder, ComparesBothMates) {
+  DuplicateFinder finder;
+  const FastqPair pairs[] = {
+      {MakeRead("a", "AAAA"), MakeRead("a", "CCCC")},
+      {MakeRead("b", "AAAA"), MakeRead("b", "GGGG")},
+      {MakeRead("c", "AAAA"), MakeRead("c", "CCCC")},
+      // The mates are swapped, so this is a different fragment orientation.
+      {MakeRead("d", "CCCC"), MakeRead("d", "AAAA")},
+      {MakeRead("e", "AAAAC"), MakeRead("e", "CCC")},
+  };
+  for (const FastqPair& pair : pairs) {
+    ASSERT_THAT(finder.Add(pair), IsOk());
+  }
+  absl::StatusOr<DuplicateResult> result = finder.Finish();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->stats.duplicates, 1);
+  EXPECT_TRUE(result->duplicates.contains(2));
+}
+
+TEST(WriteDeduplicated, MarksOrDropsDuplicates) {
+  const std::string input = "bio/fastq/testdata/duplicates.fastq";
+  absl::StatusOr<std::unique_ptr<FastqParser>> parser =
+      FastqParser::New(input);
+  ASSERT_THAT(parser, IsOk());
+  absl::StatusOr<DuplicateResult> result = FindDuplicates(parser->get());
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->stats.duplicates, 1);
+  EXPECT_THAT(EstimateLibrarySize(result->stats.reads,
+                                  result->stats.distinct()),
+              Optional(Gt(2)));
+
+  const std::pair<DuplicateAction, absl::string_view> cases[] = {
+      {DuplicateAction::kDrop, "@r1\nACGT\n+\nIIII\n@r2\nTTTT\n+\nIIII\n"},
+      {DuplicateAction::kMark,
+       "@r1\nACGT\n+\nIIII\n@r2\nTTTT\n+\nIIII\n@r3 duplicate\nACGT\n+\n####"
+       "\n"},
+  };
+  for (const auto& [action, expected] : cases) {
+    parser = FastqParser::New(input);
+    ASSERT_THAT(parser, IsOk());
+    const std::string output = gxl::JoinPath(TempDir(), "deduplicated.fastq");
+    absl::StatusOr<std::unique_ptr<FastqWriter>> writer =
+        FastqWriter::New(output);
+    ASSERT_THAT(writer, IsOk());
+    ASSERT_THAT(WriteDeduplicated(parser->get(), result->duplicates, action,
+                                  writer->get()),
+                IsOk());
+    ASSERT_THAT((*writer)->Close(), IsOk());
+    EXPECT_EQ(ReadFile(output), expected);
+  }
+}
+
+TEST(WriteDeduplicated, DropsDuplicatePairs) {
+  const std::string first = "bio/fastq/testdata/duplicate-pairs-1.fastq";
+  const std::string second = "bio/fastq/testdata/duplicate-pairs-2.fastq";
+  absl::StatusOr<std::unique_ptr<PairedFastqReader>> reader =
+      PairedFastqReader::New(first, second);
+  ASSERT_THAT(reader, IsOk());
+  absl::StatusOr<DuplicateResult> result = FindDuplicates(reader->get());
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->stats.reads, 3);
+  EXPECT_EQ(result->stats.duplicates, 1);
+
+  reader = PairedFastqReader::New(first, second);
+  ASSERT_THAT(reader, IsOk());
+  const std::string first_output =
+      gxl::JoinPath(TempDir(), "deduplicated_1.fastq");
+  const std::string second_output =
+      gxl::JoinPath(TempDir(), "deduplicated_2.fastq");
+  absl::StatusOr<std::unique_ptr<FastqWriter>> first_writer =
+      FastqWriter::New(first_output);
+  ASSERT_THAT(first_writer, IsOk());
+  absl::StatusOr<std::unique_ptr<FastqWriter>> second_writer =
+      FastqWriter::New(second_output);
+  ASSERT_THAT(second_writer, IsOk());
+  ASSERT_THAT(WriteDeduplicated(reader->get(), result->duplicates,
+                                DuplicateAction::kDrop, first_writer->get(),
+                                second_writer->get()),
+              IsOk());
+  ASSERT_THAT((*first_writer)->Close(), IsOk());
+  ASSERT_THAT((*second_writer)->Close(), IsOk());
+  EXPECT_EQ(ReadFile(first_output),
+            "@p1/1\nACGT\n+\nIIII\n@p2/1\nACGT\n+\nIIII\n");
+  EXPECT_EQ(ReadFile(second_output),
+            "@p1/2\nGGGG\n+\nIIII\n@p2/2\nGGGA\n+\nIIII\n");
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,519 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-archive.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/random-access-file.h"
+#include "bio/common/varint.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/read-name-codec.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// Identifies a FASTQ archive and its format version. It is at the start of the
+// file and at the end of the trailer. Version 2 added the name codec to the
+// index entries.
+static constexpr absl::string_view kMagic("BIOFQA\0\2", 8);
+
+// The trailer holds the offset of the index, followed by the magic.
+static constexpr size_t kTrailerSize = 8 + kMagic.size();
+
+// The 2-bit code of each base, or kException for characters stored as
+// exceptions.
+static constexpr uint8_t kException = 4;
+
+constexpr auto MakePackTable() -> std::array<uint8_t, 256> {
+  std::array<uint8_t, 256> table = {};
+  for (auto& code : table) {
+    code = kException;
+  }
+  table['A'] = 0;
+  table['C'] = 1;
+  table['G'] = 2;
+  table['T'] = 3;
+  return table;
+}
+
+static constexpr std::array<uint8_t, 256> kPackTable = MakePackTable();
+
+// The four bases packed in each byte value.
+constexpr auto MakeUnpackTable() -> std::array<std::array<char, 4>, 256> {
+  std::array<std::array<char, 4>, 256> table = {};
+  for (size_t byte = 0; byte < table.size(); ++byte) {
+    for (size_t i = 0; i < 4; ++i) {
+      table[byte][i] = "ACGT"[(byte >> (2 * i)) & 3];
+    }
+  }
+  return table;
+}
+
+static constexpr std::array<std::array<char, 4>, 256> kUnpackTable =
+    MakeUnpackTable();
+
+auto LoadLittleEndian64(const char* data) -> uint64_t {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; --i) {
+    value = (value << 8) | static_cast<uint8_t>(data[i]);
+  }
+  return value;
+}
+
+auto AppendLittleEndian64(uint64_t value, std::string* out) -> void {
+  for (int i = 0; i < 8; ++i) {
+    out->push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+auto Compress(absl::string_view data, int level)
+    -> absl::StatusOr<std::string> {
+  uLongf size = compressBound(data.size());
+  std::string compressed(size, '\0');
+  const int result =
+      compress2(reinterpret_cast<Bytef*>(compressed.data()), &size,
+                reinterpret_cast<const Bytef*>(data.data()), data.size(),
+                level);
+  if (result != Z_OK) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to compress stream: zlib error %d", result));
+  }
+  compressed.resize(size);
+  return compressed;
+}
+
+auto Uncompress(absl::string_view data, size_t uncompressed_size)
+    -> absl::StatusOr<std::string> {
+  std::string uncompressed(uncompressed_size, '\0');
+  uLongf size = uncompressed_size;
+  const int result =
+      uncompress(reinterpret_cast<Bytef*>(uncompressed.data()), &size,
+                 reinterpret_cast<const Bytef*>(data.data()), data.size());
+  if (result != Z_OK || size != uncompressed_size) {
+    return absl::DataLossError(
+        absl::StrFormat("Failed to uncompress stream: zlib error %d", result));
+  }
+  return uncompressed;
+}
+
+// Encodes `bases` as a sequence stream: the number of exception runs, the runs
+// as (distance from the end of the previous run, length, character), and the
+// bases packed at 2 bits per base, four to a byte. Exceptions are packed as A.
+auto PackSequences(absl::string_view bases) -> std::string {
+  std::string exceptions;
+  std::string packed((bases.size() + 3) / 4, '\0');
+  uint64_t num_runs = 0;
+  size_t previous_run_end = 0;
+  size_t i = 0;
+  while (i < bases.size()) {
+    const uint8_t code = kPackTable[static_cast<uint8_t>(bases[i])];
+    if (code != kException) {
+      packed[i / 4] |= static_cast<char>(code << (2 * (i % 4)));
+      ++i;
+      continue;
+    }
+    const size_t start = i;
+    while (i < bases.size() && bases[i] == bases[start]) {
+      ++i;
+    }
+    AppendVarint(start - previous_run_end, &exceptions);
+    AppendVarint(i - start, &exceptions);
+    exceptions.push_back(bases[start]);
+    previous_run_end = i;
+    ++num_runs;
+  }
+  std::string stream;
+  AppendVarint(num_runs, &stream);
+  stream += exceptions;
+  stream += packed;
+  return stream;
+}
+
+// Decodes a sequence stream holding `size` bases.
+auto UnpackSequences(absl::string_view stream, uint64_t size)
+    -> absl::StatusOr<std::string> {
+  std::optional<uint64_t> num_runs = ConsumeVarint(&stream);
+  if (!num_runs.has_value()) {
+    return absl::DataLossError("Truncated sequence stream");
+  }
+  struct Run {
+    uint64_t start;
+    uint64_t length;
+    char base;
+  };
+  std::vector<Run> runs;
+  uint64_t end = 0;
+  for (uint64_t i = 0; i < *num_runs; ++i) {
+    std::optional<uint64_t> gap = ConsumeVarint(&stream);
+    std::optional<uint64_t> length = ConsumeVarint(&stream);
+    if (!gap.has_value() || !length.has_value() || stream.empty() ||
+        *gap > size - end || *length > size - end - *gap) {
+      return absl::DataLossError("Invalid sequence exception");
+    }
+    runs.push_back({.start = end + *gap, .length = *length, .base = stream[0]});
+    stream.remove_prefix(1);
+    end += *gap + *length;
+  }
+  if (stream.size() != (size + 3) / 4) {
+    return absl::DataLossError(absl::StrFormat(
+        "Expected %d packed bytes but got %d", (size + 3) / 4, stream.size()));
+  }
+
+  std::string sequences(stream.size() * 4, '\0');
+  for (size_t i = 0; i < stream.size(); ++i) {
+    std::memcpy(&sequences[4 * i],
+                kUnpackTable[static_cast<uint8_t>(stream[i])].data(), 4);
+  }
+  sequences.resize(size);
+  for (const Run& run : runs) {
+    std::fill_n(sequences.begin() + run.start, run.length, run.base);
+  }
+  return sequences;
+}
+
+}  // namespace
+
+auto FastqArchiveWriter::New(absl::string_view path,
+                             const FastqArchiveWriterOptions& options)
+    -> absl::StatusOr<std::unique_ptr<FastqArchiveWriter>> {
+  gxl::File* file;
+  RETURN_IF_ERROR(gxl::Open(path, "w", &file, gxl::file::Defaults()));
+  auto writer = std::unique_ptr<FastqArchiveWriter>(
+      new FastqArchiveWriter(file, options));
+  writer->options_.block_size = std::max<size_t>(options.block_size, 1);
+  RETURN_IF_ERROR(writer->Append(kMagic));
+  return writer;
+}
+
+auto FastqArchiveWriter::Write(const FastqSequence& read) -> absl::Status {
+  if (read.quality.size() != read.sequence.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Read %s: Sequence length %d does not match quality length %d",
+        read.name, read.sequence.size(), read.quality.size()));
+  }
+  if (read.name.find('\n') != std::string::npos) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Read name contains a newline: '%s'", read.name));
+  }
+  if (options_.name_codec == FastqArchiveNameCodec::kTokenized) {
+    name_encoder_.Encode(read.name, &names_);
+  } else {
+    names_ += read.name;
+    names_.push_back('\n');
+  }
+  AppendVarint(read.sequence.size(), &lengths_);
+  bases_ += read.sequence;
+  qualities_ += read.quality;
+  if (++block_reads_ == options_.block_size ||
+      buffered_bytes() >= options_.max_block_bytes) {
+    RETURN_IF_ERROR(Flush());
+  }
+  return absl::OkStatus();
+}
+
+auto FastqArchiveWriter::Write(const std::vector<FastqSequence>& reads)
+    -> absl::Status {
+  for (const FastqSequence& read : reads) {
+    RETURN_IF_ERROR(Write(read));
+  }
+  return absl::OkStatus();
+}
+
+auto FastqArchiveWriter::buffered_bytes() const -> size_t {
+  return std::max({names_.size(), lengths_.size(), bases_.size(),
+                   qualities_.size()});
+}
+
+auto FastqArchiveWriter::Flush() -> absl::Status {
+  if (block_reads_ == 0) {
+    return absl::OkStatus();
+  }
+  FastqArchiveBlock block = {.first_read = num_reads_,
+                             .num_reads = block_reads_,
+                             .name_codec = options_.name_codec};
+  name_encoder_.Reset();
+  std::array<std::string, kNumFastqArchiveStreams> streams;
+  streams[static_cast<size_t>(FastqArchiveStream::kNames)] =
+      std::exchange(names_, std::string());
+  streams[static_cast<size_t>(FastqArchiveStream::kLengths)] =
+      std::exchange(lengths_, std::string());
+  streams[static_cast<size_t>(FastqArchiveStream::kSequences)] =
+      PackSequences(std::exchange(bases_, std::string()));
+  streams[static_cast<size_t>(FastqArchiveStream::kQualities)] =
+      std::exchange(qualities_, std::string());
+  for (size_t i = 0; i < kNumFastqArchiveStreams; ++i) {
+    ASSIGN_OR_RETURN(const std::string compressed,
+                     Compress(streams[i], options_.compression_level));
+    if (compressed.size() > UINT32_MAX || streams[i].size() > UINT32_MAX) {
+      return absl::OutOfRangeError(absl::StrFormat(
+          "Block %d: Stream %d of %d bytes does not fit in a block",
+          blocks_.size(), i, std::max(compressed.size(), streams[i].size())));
+    }
+    block.streams[i] = {
+        .offset = offset_,
+        .compressed_size = static_cast<uint32_t>(compressed.size()),
+        .uncompressed_size = static_cast<uint32_t>(streams[i].size()),
+    };
+    RETURN_IF_ERROR(Append(compressed));
+  }
+  blocks_.push_back(block);
+  num_reads_ += block_reads_;
+  block_reads_ = 0;
+  return absl::OkStatus();
+}
+
+auto FastqArchiveWriter::Append(absl::string_view data) -> absl::Status {
+  const size_t size = file_->WriteString(data);
+  if (size != data.size()) {
+    return absl::DataLossError(absl::StrFormat(
+        "Expected to write %d bytes but wrote %d", data.size(), size));
+  }
+  offset_ += size;
+  return absl::OkStatus();
+}
+
+auto FastqArchiveWriter::Close() -> absl::Status {
+  RETURN_IF_ERROR(Flush());
+  const uint64_t index_offset = offset_;
+  std::string index;
+  AppendVarint(blocks_.size(), &index);
+  for (const FastqArchiveBlock& block : blocks_) {
+    AppendVarint(block.num_reads, &index);
+    AppendVarint(static_cast<uint64_t>(block.name_codec), &index);
+    for (const FastqArchiveStreamInfo& stream : block.streams) {
+      AppendVarint(stream.compressed_size, &index);
+      AppendVarint(stream.uncompressed_size, &index);
+    }
+  }
+  AppendLittleEndian64(index_offset, &index);
+  index += kMagic;
+  RETURN_IF_ERROR(Append(index));
+  return file_->Close(gxl::file::Defaults());
+}
+
+auto FastqArchiveReader::New(absl::string_view path)
+    -> absl::StatusOr<std::unique_ptr<FastqArchiveReader>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<RandomAccessFile> file,
+                   RandomAccessFile::New(path));
+  if (file->size() < kMagic.size() + kTrailerSize) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Too small to be a FASTQ archive", path));
+  }
+  std::string header;
+  RETURN_IF_ERROR(file->Read(0, kMagic.size(), &header));
+  std::string trailer;
+  RETURN_IF_ERROR(
+      file->Read(file->size() - kTrailerSize, kTrailerSize, &trailer));
+  if (header != kMagic || absl::string_view(trailer).substr(8) != kMagic) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Not a FASTQ archive", path));
+  }
+  const uint64_t index_offset = LoadLittleEndian64(trailer.data());
+  const uint64_t index_end = file->size() - kTrailerSize;
+  if (index_offset < kMagic.size() || index_offset > index_end) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Invalid index offset %d", path, index_offset));
+  }
+  std::string index;
+  RETURN_IF_ERROR(file->Read(index_offset, index_end - index_offset, &index));
+
+  absl::string_view data = index;
+  const auto invalid_index = [path]() {
+    return absl::DataLossError(absl::StrFormat("%s: Invalid index", path));
+  };
+  std::optional<uint64_t> num_blocks = ConsumeVarint(&data);
+  if (!num_blocks.has_value() || *num_blocks > data.size()) {
+    return invalid_index();
+  }
+  std::vector<FastqArchiveBlock> blocks(*num_blocks);
+  uint64_t num_reads = 0;
+  uint64_t offset = kMagic.size();
+  for (FastqArchiveBlock& block : blocks) {
+    std::optional<uint64_t> block_reads = ConsumeVarint(&data);
+    std::optional<uint64_t> name_codec = ConsumeVarint(&data);
+    if (!block_reads.has_value() || *block_reads > UINT32_MAX ||
+        !name_codec.has_value() ||
+        *name_codec >
+            static_cast<uint64_t>(FastqArchiveNameCodec::kTokenized)) {
+      return invalid_index();
+    }
+    block.first_read = num_reads;
+    block.num_reads = *block_reads;
+    block.name_codec = static_cast<FastqArchiveNameCodec>(*name_codec);
+    num_reads += *block_reads;
+    for (FastqArchiveStreamInfo& stream : block.streams) {
+      std::optional<uint64_t> compressed_size = ConsumeVarint(&data);
+      std::optional<uint64_t> uncompressed_size = ConsumeVarint(&data);
+      if (!compressed_size.has_value() || !uncompressed_size.has_value() ||
+          *compressed_size > UINT32_MAX || *uncompressed_size > UINT32_MAX) {
+        return invalid_index();
+      }
+      stream = {
+          .offset = offset,
+          .compressed_size = static_cast<uint32_t>(*compressed_size),
+          .uncompressed_size = static_cast<uint32_t>(*uncompressed_size),
+      };
+      offset += *compressed_size;
+    }
+  }
+  if (!data.empty() || offset != index_offset) {
+    return invalid_index();
+  }
+  return std::unique_ptr<FastqArchiveReader>(
+      new FastqArchiveReader(std::move(file), std::move(blocks), num_reads));
+}
+
+auto FastqArchiveReader::ReadStream(const FastqArchiveBlock& block,
+                                    FastqArchiveStream stream) const
+    -> absl::StatusOr<std::string> {
+  const FastqArchiveStreamInfo& info =
+      block.streams[static_cast<size_t>(stream)];
+  std::string compressed;
+  RETURN_IF_ERROR(file_->Read(info.offset, info.compressed_size, &compressed));
+  return Uncompress(compressed, info.uncompressed_size);
+}
+
+auto FastqArchiveReader::ReadBlock(size_t block_index,
+                                   const FastqArchiveFields& fields) const
+    -> absl::StatusOr<std::vector<FastqSequence>> {
+  if (block_index >= blocks_.size()) {
+    return absl::OutOfRangeError(absl::StrFormat(
+        "Block %d is past the last block %d", block_index, blocks_.size()));
+  }
+  const FastqArchiveBlock& block = blocks_[block_index];
+  std::vector<FastqSequence> reads(block.num_reads);
+  const auto corrupt = [block_index](absl::string_view stream) {
+    return absl::DataLossError(
+        absl::StrFormat("Block %d: Invalid %s stream", block_index, stream));
+  };
+
+  if (fields.names) {
+    ASSIGN_OR_RETURN(const std::string names,
+                     ReadStream(block, FastqArchiveStream::kNames));
+    absl::string_view remaining = names;
+    ReadNameDecoder decoder;
+    for (FastqSequence& read : reads) {
+      if (block.name_codec == FastqArchiveNameCodec::kTokenized) {
+        absl::StatusOr<std::string> name = decoder.Decode(&remaining);
+        if (!name.ok()) {
+          return corrupt("name");
+        }
+        read.name = *std::move(name);
+        continue;
+      }
+      const size_t newline = remaining.find('\n');
+      if (newline == absl::string_view::npos) {
+        return corrupt("name");
+      }
+      read.name = std::string(remaining.substr(0, newline));
+      remaining.remove_prefix(newline + 1);
+    }
+    if (!remaining.empty()) {
+      return corrupt("name");
+    }
+  }
+  if (!fields.sequences && !fields.qualities) {
+    return reads;
+  }
+
+  ASSIGN_OR_RETURN(const std::string lengths_stream,
+                   ReadStream(block, FastqArchiveStream::kLengths));
+  absl::string_view remaining = lengths_stream;
+  std::vector<uint64_t> lengths;
+  lengths.reserve(reads.size());
+  uint64_t total = 0;
+  for (size_t i = 0; i < reads.size(); ++i) {
+    std::optional<uint64_t> length = ConsumeVarint(&remaining);
+    if (!length.has_value()) {
+      return corrupt("length");
+    }
+    lengths.push_back(*length);
+    total += *length;
+  }
+  if (!remaining.empty() ||
+      total > block.streams[static_cast<size_t>(FastqArchiveStream::kQualities)]
+                  .uncompressed_size) {
+    return corrupt("length");
+  }
+
+  if (fields.sequences) {
+    ASSIGN_OR_RETURN(const std::string stream,
+                     ReadStream(block, FastqArchiveStream::kSequences));
+    ASSIGN_OR_RETURN(const std::string sequences,
+                     UnpackSequences(stream, total));
+    uint64_t offset = 0;
+    for (size_t i = 0; i < reads.size(); ++i) {
+      reads[i].sequence = sequences.substr(offset, lengths[i]);
+      offset += lengths[i];
+    }
+  }
+  if (fields.qualities) {
+    ASSIGN_OR_RETURN(const std::string qualities,
+                     ReadStream(block, FastqArchiveStream::kQualities));
+    if (qualities.size() != total) {
+      return corrupt("quality");
+    }
+    uint64_t offset = 0;
+    for (size_t i = 0; i < reads.size(); ++i) {
+      reads[i].quality = qualities.substr(offset, lengths[i]);
+      offset += lengths[i];
+    }
+  }
+  return reads;
+}
+
+auto FastqArchiveReader::Read(uint64_t first_read, uint64_t num_reads,
+                              const FastqArchiveFields& fields) const
+    -> absl::StatusOr<std::vector<FastqSequence>> {
+  std::vector<FastqSequence> reads;
+  const uint64_t end =
+      first_read + std::min(num_reads, num_reads_ - std::min(first_read,
+                                                             num_reads_));
+  // The first block whose reads end after `first_read`.
+  auto block = std::upper_bound(
+      blocks_.begin(), blocks_.end(), first_read,
+      [](uint64_t read, const FastqArchiveBlock& block) {
+        return read < block.first_read + block.num_reads;
+      });
+  for (; block != blocks_.end() && block->first_read < end; ++block) {
+    ASSIGN_OR_RETURN(std::vector<FastqSequence> block_reads,
+                     ReadBlock(block - blocks_.begin(), fields));
+    const uint64_t begin = std::max(first_read, block->first_read);
+    const uint64_t stop = std::min(end, block->first_read + block->num_reads);
+    for (uint64_t i = begin; i < stop; ++i) {
+      reads.push_back(std::move(block_reads[i - block->first_read]));
+    }
+  }
+  return reads;
+}
+
+}  // namespace bio
@@ -0,0 +1,243 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_FASTQ_ARCHIVE_H_
+#define BIO_FASTQ_FASTQ_ARCHIVE_H_
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/random-access-file.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/read-name-codec.h"
+#include "gxl/file/file.h"
+
+namespace bio {
+
+// The streams of a FASTQ archive block.
+enum class FastqArchiveStream : uint8_t {
+  // Read names.
+  kNames = 0,
+  // Read lengths, as varints.
+  kLengths = 1,
+  // Bases packed at 2 bits per base, with runs of other characters stored as
+  // exceptions.
+  kSequences = 2,
+  // Quality strings.
+  kQualities = 3,
+};
+
+// How the names stream of a FASTQ archive block is encoded.
+enum class FastqArchiveNameCodec : uint8_t {
+  // Names separated by newlines.
+  kPlain = 0,
+  // Names encoded with ReadNameEncoder, starting afresh in each block.
+  kTokenized = 1,
+};
+
+// The number of streams in a FASTQ archive block.
+static constexpr size_t kNumFastqArchiveStreams = 4;
+
+// The location of one compressed stream of a block.
+struct FastqArchiveStreamInfo {
+  uint64_t offset = 0;
+  uint32_t compressed_size = 0;
+  uint32_t uncompressed_size = 0;
+};
+
+// An entry of the block index of a FASTQ archive.
+struct FastqArchiveBlock {
+  // The index of the first read of the block in the archive.
+  uint64_t first_read = 0;
+
+  // The number of reads in the block.
+  uint32_t num_reads = 0;
+
+  // The encoding of the names stream.
+  FastqArchiveNameCodec name_codec = FastqArchiveNameCodec::kPlain;
+
+  // The streams, indexed by FastqArchiveStream.
+  std::array<FastqArchiveStreamInfo, kNumFastqArchiveStreams> streams;
+};
+
+// Options for FastqArchiveWriter.
+struct FastqArchiveWriterOptions {
+  // The number of reads per block.
+  size_t block_size = 100000;
+
+  // The uncompressed size in bytes at which a stream ends the current block,
+  // whatever its number of reads. Blocks record stream sizes as 32 bits, so
+  // this must be well below 4 GiB.
+  size_t max_block_bytes = 64 << 20;
+
+  // The zlib compression level of the streams.
+  int compression_level = 6;
+
+  // The encoding of read names.
+  FastqArchiveNameCodec name_codec = FastqArchiveNameCodec::kTokenized;
+};
+
+// The fields of FastqSequence to read from a FASTQ archive.
+struct FastqArchiveFields {
+  bool names = true;
+  bool sequences = true;
+  bool qualities = true;
+};
+
+// Writes FASTQ reads to a columnar archive.
+//
+// Reads are grouped in blocks. Each block stores the names, lengths, bases and
+// quality strings of its reads in separate zlib-compressed streams, so that
+// similar data is compressed together and readers can decode only the fields
+// they need. The file ends with an index of the blocks.
+//
+// By default, names are tokenized and encoded against the previous name of the
+// block (see ReadNameEncoder), which more than halves the compressed size of
+// structured names such as Illumina's.
+//
+// Bases are packed at 2 bits per base. Runs of any character other than A, C,
+// G and T (such as N, IUPAC codes or lowercase bases) are stored separately,
+// so archives are lossless.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqArchiveWriter> writer,
+//                  FastqArchiveWriter::New("path/to/reads.bfqa"));
+// while (!parser->eof()) {
+//   ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+//   if (read == nullptr) {
+//     break;
+//   }
+//   RETURN_IF_ERROR(writer->Write(*read));
+// }
+// RETURN_IF_ERROR(writer->Close());
+// ```
+class FastqArchiveWriter {
+ public:
+  // Creates the archive at `path`.
+  static auto New(absl::string_view path,
+                  const FastqArchiveWriterOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<FastqArchiveWriter>>;
+
+  ~FastqArchiveWriter() = default;
+
+  FastqArchiveWriter(const FastqArchiveWriter&) = delete;
+  auto operator=(const FastqArchiveWriter&) -> FastqArchiveWriter& = delete;
+
+  // Adds `read` to the archive. The quality string must be as long as the
+  // sequence.
+  auto Write(const FastqSequence& read) -> absl::Status;
+
+  // Adds `reads` to the archive.
+  auto Write(const std::vector<FastqSequence>& reads) -> absl::Status;
+
+  // Writes the last block and the index, and closes the file.
+  auto Close() -> absl::Status;
+
+ private:
+  FastqArchiveWriter(gxl::File* file, const FastqArchiveWriterOptions& options)
+      : file_(file), options_(options) {}
+
+  // Returns the size of the largest buffered stream.
+  auto buffered_bytes() const -> size_t;
+
+  // Compresses and writes the buffered reads as a block.
+  auto Flush() -> absl::Status;
+
+  // Writes `data` at the end of the file.
+  auto Append(absl::string_view data) -> absl::Status;
+
+  gxl::File* file_;
+  FastqArchiveWriterOptions options_;
+  uint64_t offset_ = 0;
+  uint64_t num_reads_ = 0;
+  std::vector<FastqArchiveBlock> blocks_;
+
+  // The uncompressed streams of the current block.
+  uint32_t block_reads_ = 0;
+  std::string names_;
+  ReadNameEncoder name_encoder_;
+  std::string lengths_;
+  std::string bases_;
+  std::string qualities_;
+};
+
+// Reads FASTQ reads from an archive written by FastqArchiveWriter.
+//
+// Only the index is read when the archive is opened. Reading a range of reads
+// decodes just the blocks that overlap it, and only the streams of the
+// requested fields. Reads are thread-safe.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqArchiveReader> reader,
+//                  FastqArchiveReader::New("path/to/reads.bfqa"));
+// ASSIGN_OR_RETURN(std::vector<FastqSequence> reads,
+//                  reader->Read(/*first_read=*/1000, /*num_reads=*/10,
+//                               {.names = false, .qualities = false}));
+// ```
+class FastqArchiveReader {
+ public:
+  // Opens the archive at `path` and reads its index.
+  static auto New(absl::string_view path)
+      -> absl::StatusOr<std::unique_ptr<FastqArchiveReader>>;
+
+  // Returns the reads of block `block`, with only the requested fields set.
+  auto ReadBlock(size_t block, const FastqArchiveFields& fields = {}) const
+      -> absl::StatusOr<std::vector<FastqSequence>>;
+
+  // Returns `num_reads` reads starting at read `first_read`, with only the
+  // requested fields set. The range is clamped to the end of the archive.
+  auto Read(uint64_t first_read, uint64_t num_reads,
+            const FastqArchiveFields& fields = {}) const
+      -> absl::StatusOr<std::vector<FastqSequence>>;
+
+  // Returns the number of reads in the archive.
+  auto num_reads() const -> uint64_t { return num_reads_; }
+
+  // Returns the block index.
+  auto blocks() const -> const std::vector<FastqArchiveBlock>& {
+    return blocks_;
+  }
+
+ private:
+  FastqArchiveReader(std::unique_ptr<RandomAccessFile> file,
+                     std::vector<FastqArchiveBlock> blocks, uint64_t num_reads)
+      : file_(std::move(file)),
+        blocks_(std::move(blocks)),
+        num_reads_(num_reads) {}
+
+  // Reads and decompresses one stream of a block.
+  auto ReadStream(const FastqArchiveBlock& block,
+                  FastqArchiveStream stream) const
+      -> absl::StatusOr<std::string>;
+
+  std::unique_ptr<RandomAccessFile> file_;
+  std::vector<FastqArchiveBlock> blocks_;
+  uint64_t num_reads_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_FASTQ_ARCHIVE_H_
@@ -0,0 +1,277 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-archive.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::SizeIs;
+using ::testing::TempDir;
+
+// Returns `num_reads` reads of varying lengths. The sequences contain Ns,
+// IUPAC codes and lowercase bases as well as A, C, G and T.
+auto MakeReads(int num_reads) -> std::vector<FastqSequence> {
+  std::mt19937 rng(7);
+  static constexpr absl::string_view kBases = "ACGTACGTACGTACGTNNRYacgt";
+  std::vector<FastqSequence> reads;
+  for (int i = 0; i < num_reads; ++i) {
+    FastqSequence read = {.name = absl::StrCat("read", i, " BC:ACGT")};
+    const size_t size = i % 11 == 0 ? 0 : 20 + rng() % 130;
+    for (size_t j = 0; j < size; ++j) {
+      read.sequence.push_back(kBases[rng() % kBases.size()]);
+      read.quality.push_back(static_cast<char>('!' + rng() % 42));
+    }
+    reads.push_back(read);
+  }
+  return reads;
+}
+
+auto WriteArchive(absl::string_view name,
+                  const std::vector<FastqSequence>& reads,
+                  const FastqArchiveWriterOptions& options) -> std::string {
+  const std::string path = gxl::JoinPath(TempDir(), name);
+  absl::StatusOr<std::unique_ptr<FastqArchiveWriter>> writer =
+      FastqArchiveWriter::New(path, options);
+  EXPECT_THAT(writer, IsOk());
+  EXPECT_THAT((*writer)->Write(reads), IsOk());
+  EXPECT_THAT((*writer)->Close(), IsOk());
+  return path;
+}
+
+auto ExpectReads(const std::vector<FastqSequence>& actual,
+                 const std::vector<FastqSequence>& expected) -> void {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_EQ(actual[i].string(), expected[i].string()) << "read " << i;
+  }
+}
+
+TEST(FastqArchive, RoundTrip) {
+  const std::vector<FastqSequence> reads = MakeReads(100);
+  const std::string path =
+      WriteArchive("round-trip.bfqa", reads, {.block_size = 7});
+
+  absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+      FastqArchiveReader::New(path);
+  ASSERT_THAT(reader, IsOk());
+  EXPECT_EQ((*reader)->num_reads(), 100);
+  ASSERT_THAT((*reader)->blocks(), SizeIs(15));
+  EXPECT_EQ((*reader)->blocks()[14].first_read, 98);
+  EXPECT_EQ((*reader)->blocks()[14].num_reads, 2);
+
+  absl::StatusOr<std::vector<FastqSequence>> actual =
+      (*reader)->Read(0, 100);
+  ASSERT_THAT(actual, IsOk());
+  ExpectReads(*actual, reads);
+}
+
+TEST(FastqArchive, CutsBlocksAtByteLimit) {
+  const std::vector<FastqSequence> reads = MakeReads(100);
+  const std::string path = WriteArchive(
+      "byte-limit.bfqa", reads, {.block_size = 1000, .max_block_bytes = 500});
+
+  absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+      FastqArchiveReader::New(path);
+  ASSERT_THAT(reader, IsOk());
+  ASSERT_GT((*reader)->blocks().size(), 10);
+  for (const FastqArchiveBlock& block : (*reader)->blocks()) {
+    // A block ends with the read that takes a stream past the limit, and
+    // reads are at most 149 bases long.
+    EXPECT_LT(
+        block.streams[static_cast<size_t>(FastqArchiveStream::kQualities)]
+            .uncompressed_size,
+        500 + 150);
+  }
+  absl::StatusOr<std::vector<FastqSequence>> actual =
+      (*reader)->Read(0, 100);
+  ASSERT_THAT(actual, IsOk());
+  ExpectReads(*actual, reads);
+}
+
+TEST(FastqArchive, ReadsSelectedFields) {
+  const std::vector<FastqSequence> reads = MakeReads(20);
+  const std::string path =
+      WriteArchive("fields.bfqa", reads, {.block_size = 8});
+  absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+      FastqArchiveReader::New(path);
+  ASSERT_THAT(reader, IsOk());
+
+  absl::StatusOr<std::vector<FastqSequence>> block = (*reader)->ReadBlock(
+      1, {.names = false, .sequences = true, .qualities = false});
+  ASSERT_THAT(block, IsOk());
+  ASSERT_THAT(*block, SizeIs(8));
+  for (size_t i = 0; i < block->size(); ++i) {
+    EXPECT_EQ((*block)[i].name, "");
+    EXPECT_EQ((*block)[i].sequence, reads[8 + i].sequence);
+    EXPECT_EQ((*block)[i].quality, "");
+  }
+
+  block = (*reader)->ReadBlock(
+      2, {.names = true, .sequences = false, .qualities = false});
+  ASSERT_THAT(block, IsOk());
+  ASSERT_THAT(*block, SizeIs(4));
+  EXPECT_EQ((*block)[3].name, reads[19].name);
+  EXPECT_EQ((*block)[3].sequence, "");
+
+  EXPECT_THAT((*reader)->ReadBlock(3), StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(FastqArchive, ReadsRangesAcrossBlocks) {
+  const std::vector<FastqSequence> reads = MakeReads(50);
+  const std::string path =
+      WriteArchive("ranges.bfqa", reads, {.block_size = 6});
+  absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+      FastqArchiveReader::New(path);
+  ASSERT_THAT(reader, IsOk());
+
+  absl::StatusOr<std::vector<FastqSequence>> range = (*reader)->Read(5, 14);
+  ASSERT_THAT(range, IsOk());
+  ExpectReads(*range, std::vector<FastqSequence>(reads.begin() + 5,
+                                                 reads.begin() + 19));
+
+  range = (*reader)->Read(45, 100);
+  ASSERT_THAT(range, IsOk());
+  ExpectReads(*range,
+              std::vector<FastqSequence>(reads.begin() + 45, reads.end()));
+
+  range = (*reader)->Read(50, 10);
+  ASSERT_THAT(range, IsOk());
+  EXPECT_THAT(*range, SizeIs(0));
+}
+
+TEST(FastqArchive, EmptyArchive) {
+  const std::string path = WriteArchive("empty.bfqa", {}, {.block_size = 10});
+  absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+      FastqArchiveReader::New(path);
+  ASSERT_THAT(reader, IsOk());
+  EXPECT_EQ((*reader)->num_reads(), 0);
+  EXPECT_THAT((*reader)->blocks(), SizeIs(0));
+  absl::StatusOr<std::vector<FastqSequence>> reads = (*reader)->Read(0, 10);
+  ASSERT_THAT(reads, IsOk());
+  EXPECT_THAT(*reads, SizeIs(0));
+}
+
+TEST(FastqArchive, CompressesBetterThanText) {
+  std::vector<FastqSequence> reads;
+  for (int i = 0; i < 1000; ++i) {
+    reads.push_back({
+        .name = absl::StrCat("instrument:run:flowcell:1:1101:", 1000 + i, ":1"),
+        .sequence = std::string(150, "ACGT"[i % 4]),
+        .quality = std::string(150, 'F'),
+    });
+  }
+  const std::string path =
+      WriteArchive("compression.bfqa", reads, {.block_size = 1000});
+  std::string contents;
+  ASSERT_THAT(gxl::GetContents(path, &contents, gxl::file::Defaults()),
+              IsOk());
+  EXPECT_LT(contents.size(), 1000 * 150 / 10);
+}
+
+TEST(FastqArchive, TokenizesNames) {
+  std::vector<FastqSequence> reads;
+  for (int i = 0; i < 1000; ++i) {
+    reads.push_back({
+        .name = absl::StrCat("A00123:8:H7KLMDSXX:1:", 1101 + i / 250, ":",
+                             1000 + (i * 7919) % 30000, ":", 1000 + i * 17,
+                             " 1:N:0:ACGTACGT"),
+        .sequence = "ACGT",
+        .quality = "IIII",
+    });
+  }
+  const std::string plain_path = WriteArchive(
+      "plain-names.bfqa", reads,
+      {.block_size = 300, .name_codec = FastqArchiveNameCodec::kPlain});
+  const std::string tokenized_path =
+      WriteArchive("tokenized-names.bfqa", reads, {.block_size = 300});
+
+  uint64_t name_sizes[2] = {0, 0};
+  int i = 0;
+  for (const std::string& path : {plain_path, tokenized_path}) {
+    absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+        FastqArchiveReader::New(path);
+    ASSERT_THAT(reader, IsOk());
+    for (const FastqArchiveBlock& block : (*reader)->blocks()) {
+      name_sizes[i] +=
+          block.streams[static_cast<size_t>(FastqArchiveStream::kNames)]
+              .compressed_size;
+    }
+    absl::StatusOr<std::vector<FastqSequence>> actual =
+        (*reader)->Read(0, reads.size());
+    ASSERT_THAT(actual, IsOk());
+    ExpectReads(*actual, reads);
+    ++i;
+  }
+  EXPECT_LT(name_sizes[1] * 2, name_sizes[0]);
+}
+
+TEST(FastqArchive, RejectsInvalidReads) {
+  absl::StatusOr<std::unique_ptr<FastqArchiveWriter>> writer =
+      FastqArchiveWriter::New(gxl::JoinPath(TempDir(), "invalid.bfqa"));
+  ASSERT_THAT(writer, IsOk());
+  EXPECT_THAT((*writer)->Write(FastqSequence{
+                  .name = "read", .sequence = "ACGT", .quality = "III"}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT((*writer)->Write(FastqSequence{
+                  .name = "re\nad", .sequence = "ACGT", .quality = "IIII"}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT((*writer)->Close(), IsOk());
+}
+
+TEST(FastqArchive, DetectsCorruption) {
+  const std::string path =
+      WriteArchive("corrupt.bfqa", MakeReads(30), {.block_size = 10});
+  std::string contents;
+  ASSERT_THAT(gxl::GetContents(path, &contents, gxl::file::Defaults()),
+              IsOk());
+
+  EXPECT_THAT(FastqArchiveReader::New(
+                  WriteTempFile("truncated.bfqa", contents.substr(0, 100))),
+              StatusIs(absl::StatusCode::kDataLoss));
+
+  // Damage the first stream of the first block, which holds the names.
+  std::string damaged_contents = contents;
+  for (size_t i = 10; i < 20; ++i) {
+    damaged_contents[i] = static_cast<char>(~damaged_contents[i]);
+  }
+  absl::StatusOr<std::unique_ptr<FastqArchiveReader>> reader =
+      FastqArchiveReader::New(WriteTempFile("damaged.bfqa", damaged_contents));
+  ASSERT_THAT(reader, IsOk());
+  EXPECT_THAT((*reader)->ReadBlock(0), StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT((*reader)->ReadBlock(1), IsOk());
+}
+
+}  // namespace
+}  // namespace bio
@@ -14,6 +14,7 @@
 
 #include "bio/fastq/fastq-parser.h"
 
+#include <cstdlib>
 #include <memory>
 #include <optional>
 #include <string>
@@ -27,7 +28,9 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
+#include "bio/common/sampler.h"
 #include "bio/common/strings.h"
+#include "bio/fastq/fastq-validator.h"
 #include "bio/fastq/fastq.h"
 #include "gxl/file/file.h"
 #include "gxl/status/status_macros.h"
@@ -40,16 +43,18 @@ static constexpr char kQualityIdPrefix[] = "+";
 
 }  // namespace
 
-auto FastqParser::New(absl::string_view path)
+auto FastqParser::New(absl::string_view path,
+                      const FastqParserOptions& options)
     -> absl::StatusOr<std::unique_ptr<FastqParser>> {
   gxl::File* file;
   RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
-  return std::make_unique<FastqParser>(file);
+  return std::make_unique<FastqParser>(file, options);
 }
 
-auto FastqParser::NewOrDie(absl::string_view path)
+auto FastqParser::NewOrDie(absl::string_view path,
+                           const FastqParserOptions& options)
     -> std::unique_ptr<FastqParser> {
-  absl::StatusOr<std::unique_ptr<FastqParser>> parser = New(path);
+  absl::StatusOr<std::unique_ptr<FastqParser>> parser = New(path, options);
   CHECK_OK(parser.status());
   return std::move(parser.value());
 }
@@ -107,10 +112,77 @@ auto FastqParser::Next(bool truncate_name)
           "%d",
           line_number(), sequence->sequence.size(), sequence->quality.size()));
     }
+    if (validator_.has_value()) {
+      if (absl::Status status = validator_->Validate(*sequence); !status.ok()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Line %d: %s", line_number(), status.message()));
+      }
+    }
+
+    return sequence;
+  }
+  // Only blank or stray lines were left.
+  return nullptr;
+}
+
+auto FastqParser::NextIdentifierLine() -> std::optional<std::string> {
+  for (std::optional<std::string> line = NextLine(); line.has_value();
+       line = NextLine()) {
+    if (absl::StartsWith(*line, kIdentifierPrefix)) {
+      return line;
+    }
+  }
+  return std::nullopt;
+}
+
+auto FastqParser::SkipEntryBody() -> absl::Status {
+  static constexpr absl::string_view kEntryLines[] = {"sequence", "quality ID",
+                                                      "quality"};
+  for (absl::string_view entry_line : kEntryLines) {
+    if (!NextLine().has_value()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Line %d: Expected %s line but got EOF",
+                          line_number(), entry_line));
+    }
+  }
+  return absl::OkStatus();
+}
+
+auto FastqParser::NextSampled(const FractionalSampler& sampler,
+                              bool truncate_name)
+    -> absl::StatusOr<std::unique_ptr<FastqSequence>> {
+  for (std::optional<std::string> line = NextIdentifierLine();
+       line.has_value(); line = NextIdentifierLine()) {
+    if (sampler.Keep(
+            MateName(absl::StripPrefix(*line, kIdentifierPrefix)))) {
+      PutBack(*std::move(line));
+      return Next(truncate_name);
+    }
+    RETURN_IF_ERROR(SkipEntryBody());
+  }
+  return nullptr;
+}
+
+auto FastqParser::Skip() -> absl::Status {
+  if (!NextIdentifierLine().has_value()) {
+    return absl::OkStatus();
+  }
+  return SkipEntryBody();
+}
 
-    break;
+auto DetectPhredOffset(absl::string_view path, size_t max_entries)
+    -> absl::StatusOr<PhredOffset> {
+  ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser,
+                   FastqParser::New(path));
+  PhredOffsetDetector detector;
+  for (size_t i = 0; i < max_entries && !parser->eof(); ++i) {
+    ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> sequence, parser->Next());
+    if (sequence == nullptr) {
+      break;
+    }
+    detector.Add(sequence->quality);
   }
-  return sequence;
+  return detector.offset().value_or(PhredOffset::kPhred33);
 }
 
 }  // namespace bio
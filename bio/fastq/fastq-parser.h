@@ -15,18 +15,38 @@
 #ifndef BIO_FASTQ_FASTQ_PARSER_H_
 #define BIO_FASTQ_FASTQ_PARSER_H_
 
+#include <cstdlib>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "bio/common/line-parser-base.h"
+#include "bio/common/sampler.h"
+#include "bio/fastq/fastq-validator.h"
 #include "bio/fastq/fastq.h"
 #include "gxl/file/file.h"
 
 namespace bio {
 
+// Options for FastqParser.
+struct FastqParserOptions {
+  // Whether every entry is checked with a FastqValidator for non-IUPAC bases
+  // and qualities outside the range of `phred_offset` and `max_quality`.
+  bool strict = false;
+
+  // The encoding of the quality scores, for strict validation.
+  PhredOffset phred_offset = PhredOffset::kPhred33;
+
+  // The highest accepted quality score, for strict validation. If not set,
+  // any quality up to '~' is accepted.
+  std::optional<int> max_quality;
+};
+
 // Parser for FASTQ files.
 //
 // See https://maq.sourceforge.net/fastq.shtml
@@ -62,25 +82,75 @@ namespace bio {
 //   // Do stuff with sequence.
 // }
 // ```
+//
+// With FastqParserOptions::strict, entries with invalid bases or qualities
+// are reported as errors instead of being returned:
+//
+// ```cpp
+// ASSIGN_OR_RETURN(PhredOffset offset,
+//                  DetectPhredOffset("path/to/file.fastq"));
+// ASSIGN_OR_RETURN(
+//     std::unique_ptr<FastqParser> parser,
+//     FastqParser::New("path/to/file.fastq",
+//                      {.strict = true, .phred_offset = offset}));
+// ```
 class FastqParser : public LineParserBase {
  public:
-  explicit FastqParser(absl::Nonnull<gxl::File*> file) : LineParserBase(file) {}
+  explicit FastqParser(absl::Nonnull<gxl::File*> file,
+                       const FastqParserOptions& options = {})
+      : LineParserBase(file) {
+    if (options.strict) {
+      validator_.emplace(options.phred_offset, options.max_quality);
+    }
+  }
 
   ~FastqParser() = default;
 
   // Constructs a new FastqParser from the specified file path.
-  static auto New(absl::string_view path)
+  static auto New(absl::string_view path,
+                  const FastqParserOptions& options = {})
       -> absl::StatusOr<std::unique_ptr<FastqParser>>;
 
   // Constructs a new FastqParser from the specified file path or terminates the
   // program if constructing the parser fails.
-  static auto NewOrDie(absl::string_view path) -> std::unique_ptr<FastqParser>;
+  static auto NewOrDie(absl::string_view path,
+                       const FastqParserOptions& options = {})
+      -> std::unique_ptr<FastqParser>;
 
-  // Returns the next FASTQ entry from the file.
+  // Returns the next FASTQ entry from the file, or nullptr if only blank lines
+  // are left.
   auto Next(bool truncate_name = false)
       -> absl::StatusOr<std::unique_ptr<FastqSequence>>;
+
+  // Returns the next FASTQ entry that `sampler` keeps, or nullptr at the end
+  // of the file. Entries are sampled by MateName(), so the mates of paired
+  // files are kept together. Rejected entries are skipped without being
+  // parsed or validated.
+  auto NextSampled(const FractionalSampler& sampler,
+                   bool truncate_name = false)
+      -> absl::StatusOr<std::unique_ptr<FastqSequence>>;
+
+  // Skips the next FASTQ entry without parsing it.
+  auto Skip() -> absl::Status;
+
+ private:
+  // Returns the next sequence identifier line, skipping any other lines, or
+  // std::nullopt at the end of the file.
+  auto NextIdentifierLine() -> std::optional<std::string>;
+
+  // Skips the sequence, quality ID and quality lines of an entry.
+  auto SkipEntryBody() -> absl::Status;
+
+  // Set if entries are validated.
+  std::optional<FastqValidator> validator_;
 };
 
+// Detects the Phred offset of the FASTQ file at `path` from the qualities of
+// its first `max_entries` entries. Files without any qualities are reported
+// as Phred+33.
+auto DetectPhredOffset(absl::string_view path, size_t max_entries = 10000)
+    -> absl::StatusOr<PhredOffset>;
+
 }  // namespace bio
 
 #endif  // BIO_FASTQ_FASTQ_PARSER_H_
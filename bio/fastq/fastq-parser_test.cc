@@ -21,6 +21,8 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "bio/common/sampler.h"
+#include "bio/fastq/fastq-validator.h"
 #include "bio/fastq/fastq.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -29,6 +31,7 @@ namespace bio {
 namespace {
 
 using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::testing::HasSubstr;
 
@@ -105,6 +108,74 @@ TEST(FastqParser, NextInvalidQualityLineLength) {
                        HasSubstr("does not match quality line length")));
 }
 
+TEST(FastqParser, NextTrailingBlankLines) {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/trailing-blank-lines.fastq");
+  absl::StatusOr<std::unique_ptr<FastqSequence>> sequence = parser->Next();
+  ASSERT_THAT(sequence, IsOk());
+  ASSERT_NE(*sequence, nullptr);
+  EXPECT_EQ((*sequence)->name, "read1");
+
+  sequence = parser->Next();
+  ASSERT_THAT(sequence, IsOk());
+  EXPECT_EQ(*sequence, nullptr);
+  EXPECT_TRUE(parser->eof());
+}
+
+TEST(FastqParser, NextStrictInvalidBase) {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/invalid-base.fastq", {.strict = true});
+  EXPECT_THAT(parser->Next(), IsOk());
+  EXPECT_THAT(parser->Next(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Line 8: Invalid base 'J' at position 25")));
+
+  parser = FastqParser::NewOrDie("bio/fastq/testdata/invalid-base.fastq");
+  EXPECT_THAT(parser->Next(), IsOk());
+  EXPECT_THAT(parser->Next(), IsOk());
+}
+
+TEST(FastqParser, NextStrictInvalidQuality) {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/invalid-quality.fastq", {.strict = true});
+  EXPECT_THAT(parser->Next(), IsOk());
+  EXPECT_THAT(parser->Next(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Quality ' ' at position 20")));
+}
+
+TEST(FastqParser, NextStrictPhredOffset) {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/multiple-sequence.fastq",
+      {.strict = true, .phred_offset = PhredOffset::kPhred64});
+  EXPECT_THAT(parser->Next(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("outside the Phred+64 range")));
+
+  parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/phred64.fastq",
+      {.strict = true, .phred_offset = PhredOffset::kPhred64});
+  EXPECT_THAT(parser->Next(), IsOk());
+
+  parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/multiple-sequence.fastq",
+      {.strict = true, .max_quality = 30});
+  EXPECT_THAT(parser->Next(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Quality 'I' at position 0")));
+}
+
+TEST(FastqParser, DetectPhredOffset) {
+  EXPECT_THAT(DetectPhredOffset("bio/fastq/testdata/multiple-sequence.fastq"),
+              IsOkAndHolds(PhredOffset::kPhred33));
+  EXPECT_THAT(DetectPhredOffset("bio/fastq/testdata/phred64.fastq"),
+              IsOkAndHolds(PhredOffset::kPhred64));
+  EXPECT_THAT(DetectPhredOffset("bio/fastq/testdata/empty.fastq"),
+              IsOkAndHolds(PhredOffset::kPhred33));
+  EXPECT_THAT(DetectPhredOffset("bio/fastq/testdata/absent.fastq"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 TEST(FastqParser, NextSingleSequenceWithoutQualityId) {
   std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
       "bio/fastq/testdata/single-sequence-without-quality-id.fastq");
@@ -181,5 +252,54 @@ TEST(FastqParser, NextMultiSequnce) {
   }
 }
 
+TEST(FastqParser, NextSampled) {
+  for (double fraction : {0.0, 0.5, 1.0}) {
+    const FractionalSampler sampler = *FractionalSampler::New(fraction, 7);
+    std::unique_ptr<FastqParser> parser =
+        FastqParser::NewOrDie("bio/fastq/testdata/multiple-sequence.fastq");
+    std::unique_ptr<FastqParser> sampled_parser =
+        FastqParser::NewOrDie("bio/fastq/testdata/multiple-sequence.fastq");
+    while (true) {
+      absl::StatusOr<std::unique_ptr<FastqSequence>> expected = parser->Next();
+      ASSERT_THAT(expected, IsOk());
+      if (*expected == nullptr) {
+        break;
+      }
+      if (!sampler.Keep(MateName((*expected)->name))) {
+        continue;
+      }
+      absl::StatusOr<std::unique_ptr<FastqSequence>> actual =
+          sampled_parser->NextSampled(sampler);
+      ASSERT_THAT(actual, IsOk());
+      ASSERT_NE(*actual, nullptr);
+      CheckSequenceEquals(**expected, actual->get());
+    }
+    absl::StatusOr<std::unique_ptr<FastqSequence>> actual =
+        sampled_parser->NextSampled(sampler);
+    ASSERT_THAT(actual, IsOk());
+    EXPECT_EQ(*actual, nullptr) << fraction;
+  }
+}
+
+TEST(FastqParser, NextSampledSkipsInvalidEntries) {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
+      "bio/fastq/testdata/invalid-quality-line-length.fastq");
+  absl::StatusOr<std::unique_ptr<FastqSequence>> actual =
+      parser->NextSampled(*FractionalSampler::New(0.0));
+  ASSERT_THAT(actual, IsOk());
+  EXPECT_EQ(*actual, nullptr);
+}
+
+TEST(FastqParser, Skip) {
+  std::unique_ptr<FastqParser> parser =
+      FastqParser::NewOrDie("bio/fastq/testdata/multiple-sequence.fastq");
+  ASSERT_THAT(parser->Skip(), IsOk());
+  absl::StatusOr<std::unique_ptr<FastqSequence>> actual =
+      parser->Next(/*truncate_name=*/true);
+  ASSERT_THAT(actual, IsOk());
+  ASSERT_NE(*actual, nullptr);
+  EXPECT_EQ((*actual)->name, "SRR001666.2");
+}
+
 }  // namespace
 }  // namespace bio
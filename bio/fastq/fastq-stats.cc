@@ -0,0 +1,315 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-stats.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "bio/common/base-counts.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+#include "gxl/status/status_macros.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+// The number of reads processed per task.
+static constexpr size_t kBatchSize = 8192;
+
+// The maximum number of batches in flight per thread.
+static constexpr size_t kPendingBatchesPerThread = 2;
+
+static constexpr uint8_t kMaxPhred = FastqStats::kNumQualities - 1;
+
+constexpr auto MakeBaseClassTable() -> std::array<uint8_t, 256> {
+  // Matches the order of FastqStats::BaseClass.
+  std::array<uint8_t, 256> table = {};
+  for (auto& base_class : table) {
+    base_class = 5;
+  }
+  table['A'] = table['a'] = 0;
+  table['C'] = table['c'] = 1;
+  table['G'] = table['g'] = 2;
+  table['T'] = table['t'] = 3;
+  table['N'] = table['n'] = 4;
+  return table;
+}
+
+static constexpr std::array<uint8_t, 256> kBaseClassTable =
+    MakeBaseClassTable();
+
+// Converts `quality` to Phred scores in `phred`, clamped to [0, kMaxPhred],
+// and returns their sum.
+auto ConvertQuality(absl::string_view quality, uint8_t offset, uint8_t* phred)
+    -> uint64_t {
+  uint64_t sum = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i offsets = _mm_set1_epi8(static_cast<char>(offset));
+  const __m128i max_phred = _mm_set1_epi8(static_cast<char>(kMaxPhred));
+  __m128i sums = _mm_setzero_si128();
+  for (; i + 16 <= quality.size(); i += 16) {
+    const __m128i bytes = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(quality.data() + i));
+    const __m128i scores =
+        _mm_min_epu8(_mm_subs_epu8(bytes, offsets), max_phred);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(phred + i), scores);
+    // Sums each group of 8 scores into a 64-bit lane.
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(scores, _mm_setzero_si128()));
+  }
+  const __m128i high = _mm_unpackhi_epi64(sums, sums);
+  sum = static_cast<uint64_t>(_mm_cvtsi128_si64(sums)) +
+        static_cast<uint64_t>(_mm_cvtsi128_si64(high));
+#endif
+  for (; i < quality.size(); ++i) {
+    const uint8_t byte = static_cast<uint8_t>(quality[i]);
+    const uint8_t score =
+        byte < offset ? 0 : std::min<uint8_t>(byte - offset, kMaxPhred);
+    phred[i] = score;
+    sum += score;
+  }
+  return sum;
+}
+
+// Hands out FastqStats accumulators to tasks, so that each running task
+// accumulates into its own FastqStats without locking.
+class AccumulatorPool {
+ public:
+  explicit AccumulatorPool(const FastqStatsOptions& options)
+      : options_(options) {}
+
+  // Takes an accumulator that no other task is using.
+  auto Acquire() -> std::unique_ptr<FastqStats> {
+    absl::MutexLock lock(&mutex_);
+    if (free_.empty()) {
+      return std::make_unique<FastqStats>(options_);
+    }
+    std::unique_ptr<FastqStats> stats = std::move(free_.back());
+    free_.pop_back();
+    return stats;
+  }
+
+  // Returns an accumulator taken with Acquire().
+  auto Release(std::unique_ptr<FastqStats> stats) -> void {
+    absl::MutexLock lock(&mutex_);
+    free_.push_back(std::move(stats));
+  }
+
+  // Merges all accumulators. No task may be running.
+  auto Merge() -> FastqStats {
+    absl::MutexLock lock(&mutex_);
+    FastqStats merged(options_);
+    for (const std::unique_ptr<FastqStats>& stats : free_) {
+      merged.Merge(*stats);
+    }
+    return merged;
+  }
+
+ private:
+  const FastqStatsOptions options_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<FastqStats>> free_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+FastqStats::FastqStats(const FastqStatsOptions& options)
+    : options_(options),
+      length_counts_(1, 0),
+      sample_threshold_(std::numeric_limits<uint64_t>::max()) {}
+
+auto FastqStats::Reserve(size_t length) -> void {
+  if (length < length_counts_.size()) {
+    return;
+  }
+  length_counts_.resize(length + 1, 0);
+  quality_counts_.resize(length * kNumQualities, 0);
+  base_counts_.resize(length * kNumBaseClasses, 0);
+  phred_.resize(length);
+}
+
+auto FastqStats::Add(const FastqSequence& read) -> void {
+  const size_t length = read.sequence.size();
+  Reserve(length);
+  ++num_reads_;
+  num_bases_ += length;
+  ++length_counts_[length];
+
+  for (size_t i = 0; i < length; ++i) {
+    ++base_counts_[i * kNumBaseClasses +
+                   kBaseClassTable[static_cast<uint8_t>(read.sequence[i])]];
+  }
+
+  const absl::string_view quality =
+      absl::string_view(read.quality).substr(0, length);
+  const uint64_t quality_sum =
+      ConvertQuality(quality, options_.quality_offset, phred_.data());
+  uint64_t* counts = quality_counts_.data();
+  for (size_t i = 0; i < quality.size(); ++i) {
+    ++counts[phred_[i]];
+    counts += kNumQualities;
+  }
+  if (!quality.empty()) {
+    ++read_quality_counts_[(quality_sum + quality.size() / 2) /
+                           quality.size()];
+  }
+
+  const uint64_t hash = absl::Hash<absl::string_view>()(read.sequence);
+  if (hash < sample_threshold_) {
+    ++sample_[hash];
+    if (sample_.size() > options_.duplication_sample_size) {
+      sample_threshold_ /= 2;
+      TrimSample();
+    }
+  }
+}
+
+auto FastqStats::Merge(const FastqStats& other) -> void {
+  Reserve(other.max_length());
+  num_reads_ += other.num_reads_;
+  num_bases_ += other.num_bases_;
+  for (size_t i = 0; i < other.quality_counts_.size(); ++i) {
+    quality_counts_[i] += other.quality_counts_[i];
+  }
+  for (size_t i = 0; i < other.base_counts_.size(); ++i) {
+    base_counts_[i] += other.base_counts_[i];
+  }
+  for (size_t i = 0; i < kNumQualities; ++i) {
+    read_quality_counts_[i] += other.read_quality_counts_[i];
+  }
+  for (size_t i = 0; i < other.length_counts_.size(); ++i) {
+    length_counts_[i] += other.length_counts_[i];
+  }
+
+  // Both samples hold every sequence whose hash is below the lower of the two
+  // thresholds, so their union is a sample at that threshold.
+  sample_threshold_ = std::min(sample_threshold_, other.sample_threshold_);
+  for (const auto& [hash, count] : other.sample_) {
+    if (hash < sample_threshold_) {
+      sample_[hash] += count;
+    }
+  }
+  TrimSample();
+  while (sample_.size() > options_.duplication_sample_size) {
+    sample_threshold_ /= 2;
+    TrimSample();
+  }
+}
+
+auto FastqStats::TrimSample() -> void {
+  absl::erase_if(sample_, [this](const auto& entry) {
+    return entry.first >= sample_threshold_;
+  });
+}
+
+auto FastqStats::mean_quality(size_t position) const -> double {
+  const absl::Span<const uint64_t> histogram = quality_histogram(position);
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  for (size_t score = 0; score < histogram.size(); ++score) {
+    count += histogram[score];
+    sum += score * histogram[score];
+  }
+  return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+}
+
+auto FastqStats::base_counts(size_t position) const -> BaseCounts {
+  const uint64_t* counts = &base_counts_[position * kNumBaseClasses];
+  return {
+      .a = counts[kA],
+      .c = counts[kC],
+      .g = counts[kG],
+      .t = counts[kT],
+      .n = counts[kN],
+      .other = counts[kOther],
+  };
+}
+
+auto FastqStats::duplication() const -> DuplicationEstimate {
+  DuplicationEstimate estimate;
+  estimate.distinct_sequences = sample_.size();
+  for (const auto& [hash, count] : sample_) {
+    estimate.sampled_reads += count;
+    ++estimate.levels[count];
+  }
+  return estimate;
+}
+
+auto ComputeFastqStats(absl::Nonnull<FastqParser*> parser,
+                       const FastqStatsOptions& options)
+    -> absl::StatusOr<FastqStats> {
+  if (options.num_threads <= 1) {
+    FastqStats stats(options);
+    while (!parser->eof()) {
+      ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+      if (read == nullptr) {
+        break;
+      }
+      stats.Add(*read);
+    }
+    return stats;
+  }
+
+  AccumulatorPool accumulators(options);
+  ThreadPool pool(options.num_threads);
+  TaskQueue<size_t> queue(&pool, /*ordered=*/false);
+  const size_t max_pending = kPendingBatchesPerThread * options.num_threads;
+  while (!parser->eof()) {
+    auto batch = std::make_shared<std::vector<FastqSequence>>();
+    batch->reserve(kBatchSize);
+    while (batch->size() < kBatchSize && !parser->eof()) {
+      ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+      if (read == nullptr) {
+        break;
+      }
+      batch->push_back(std::move(*read));
+    }
+    if (queue.pending() >= max_pending) {
+      queue.Next();
+    }
+    queue.Submit([batch, &accumulators]() {
+      std::unique_ptr<FastqStats> stats = accumulators.Acquire();
+      for (const FastqSequence& read : *batch) {
+        stats->Add(read);
+      }
+      accumulators.Release(std::move(stats));
+      return batch->size();
+    });
+  }
+  while (queue.pending() > 0) {
+    queue.Next();
+  }
+  return accumulators.Merge();
+}
+
+}  // namespace bio
@@ -0,0 +1,194 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_FASTQ_STATS_H_
+#define BIO_FASTQ_FASTQ_STATS_H_
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "bio/common/base-counts.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+
+namespace bio {
+
+// Options for computing FASTQ statistics.
+struct FastqStatsOptions {
+  // The ASCII value of Phred quality 0: 33 for Sanger and Illumina 1.8+, 64
+  // for older Illumina files.
+  int quality_offset = 33;
+
+  // The maximum number of distinct read sequences sampled to estimate
+  // duplication. Sequences are sampled by hash, so the estimate does not
+  // depend on the order in which reads are added.
+  size_t duplication_sample_size = 1 << 17;
+
+  // The number of threads to spread reads across. If 1 or less, the reads are
+  // processed on the calling thread.
+  size_t num_threads = 1;
+};
+
+// Duplication of the sampled read sequences.
+struct DuplicationEstimate {
+  // The number of reads whose sequence was sampled.
+  uint64_t sampled_reads = 0;
+
+  // The number of distinct sequences among the sampled reads.
+  uint64_t distinct_sequences = 0;
+
+  // The number of distinct sequences by the number of times they were seen.
+  std::map<uint64_t, uint64_t> levels;
+
+  // Returns the fraction of reads that would remain after deduplication, or 1
+  // if no reads were sampled.
+  auto distinct_fraction() const -> double {
+    return sampled_reads == 0
+               ? 1.0
+               : static_cast<double>(distinct_sequences) / sampled_reads;
+  }
+};
+
+// Accumulates FastQC-style quality control statistics over FASTQ reads:
+// per-position quality distributions and base composition, per-read mean
+// quality, the length distribution and an estimate of duplication.
+//
+// On x86-64, quality strings are converted to Phred scores and summed 16 bytes
+// at a time with SSE2. Counters are stored position-major in flat arrays, so
+// accumulating a read touches contiguous memory.
+//
+// Example usage:
+//
+// ```
+// FastqStats stats;
+// while (!parser->eof()) {
+//   ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+//   if (read == nullptr) {
+//     break;
+//   }
+//   stats.Add(*read);
+// }
+// const double q30 = stats.mean_quality(/*position=*/30);
+// ```
+class FastqStats {
+ public:
+  // The number of distinct Phred scores, 0 to 93. Higher scores are counted
+  // as 93.
+  static constexpr size_t kNumQualities = 94;
+
+  explicit FastqStats(const FastqStatsOptions& options = {});
+
+  // Adds the statistics of `read`.
+  auto Add(const FastqSequence& read) -> void;
+
+  // Adds the statistics accumulated in `other`, which must have been
+  // constructed with the same options.
+  auto Merge(const FastqStats& other) -> void;
+
+  // Returns the number of reads.
+  auto num_reads() const -> uint64_t { return num_reads_; }
+
+  // Returns the total number of bases.
+  auto num_bases() const -> uint64_t { return num_bases_; }
+
+  // Returns the length of the longest read.
+  auto max_length() const -> size_t { return length_counts_.size() - 1; }
+
+  // Returns the number of reads with each Phred score at `position`, indexed
+  // by Phred score. `position` must be less than max_length().
+  auto quality_histogram(size_t position) const -> absl::Span<const uint64_t> {
+    return absl::MakeConstSpan(quality_counts_)
+        .subspan(position * kNumQualities, kNumQualities);
+  }
+
+  // Returns the mean Phred score at `position`.
+  auto mean_quality(size_t position) const -> double;
+
+  // Returns the base composition at `position`. Soft-masking is not tracked.
+  auto base_counts(size_t position) const -> BaseCounts;
+
+  // Returns the number of reads by mean Phred score, rounded to the nearest
+  // integer.
+  auto read_quality_histogram() const
+      -> const std::array<uint64_t, kNumQualities>& {
+    return read_quality_counts_;
+  }
+
+  // Returns the number of reads of each length, indexed by length.
+  auto length_histogram() const -> const std::vector<uint64_t>& {
+    return length_counts_;
+  }
+
+  // Returns the duplication estimate.
+  auto duplication() const -> DuplicationEstimate;
+
+ private:
+  // Base classes counted per position, as indexes into base_counts_.
+  enum BaseClass : uint8_t { kA, kC, kG, kT, kN, kOther, kNumBaseClasses };
+
+  // Extends the per-position counters to cover `length` positions.
+  auto Reserve(size_t length) -> void;
+
+  // Drops sampled sequences whose hash is at or above the threshold.
+  auto TrimSample() -> void;
+
+  FastqStatsOptions options_;
+  uint64_t num_reads_ = 0;
+  uint64_t num_bases_ = 0;
+
+  // Indexed by position * kNumQualities + Phred score.
+  std::vector<uint64_t> quality_counts_;
+
+  // Indexed by position * kNumBaseClasses + BaseClass.
+  std::vector<uint64_t> base_counts_;
+
+  std::array<uint64_t, kNumQualities> read_quality_counts_ = {};
+  std::vector<uint64_t> length_counts_;
+
+  // Occurrences of the sampled sequences, by hash. A sequence is sampled if
+  // its hash is below the threshold, which is halved whenever the sample
+  // grows beyond FastqStatsOptions::duplication_sample_size.
+  absl::flat_hash_map<uint64_t, uint64_t> sample_;
+  uint64_t sample_threshold_;
+
+  // Scratch space for the Phred scores of a read.
+  std::vector<uint8_t> phred_;
+};
+
+// Computes the statistics of every read from `parser`. Batches of reads are
+// processed across FastqStatsOptions::num_threads threads, each accumulating
+// into its own FastqStats, which are merged at the end.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser,
+//                  FastqParser::New("path/to/reads.fastq"));
+// ASSIGN_OR_RETURN(FastqStats stats,
+//                  ComputeFastqStats(parser.get(), {.num_threads = 4}));
+// ```
+auto ComputeFastqStats(absl::Nonnull<FastqParser*> parser,
+                       const FastqStatsOptions& options)
+    -> absl::StatusOr<FastqStats>;
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_FASTQ_STATS_H_
@@ -0,0 +1,200 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-stats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "bio/common/base-counts.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::testing::DoubleNear;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::Pair;
+
+auto RandomRead(std::mt19937* rng, int index) -> FastqSequence {
+  static constexpr char kBases[] = "ACGTN";
+  FastqSequence read = {.name = absl::StrCat("read", index)};
+  const size_t length = 1 + (*rng)() % 120;
+  for (size_t i = 0; i < length; ++i) {
+    read.sequence.push_back(kBases[(*rng)() % 5]);
+    read.quality.push_back(static_cast<char>('!' + (*rng)() % 42));
+  }
+  return read;
+}
+
+auto ExpectSameStats(const FastqStats& actual, const FastqStats& expected)
+    -> void {
+  ASSERT_EQ(actual.num_reads(), expected.num_reads());
+  EXPECT_EQ(actual.num_bases(), expected.num_bases());
+  ASSERT_EQ(actual.max_length(), expected.max_length());
+  EXPECT_EQ(actual.length_histogram(), expected.length_histogram());
+  EXPECT_EQ(actual.read_quality_histogram(),
+            expected.read_quality_histogram());
+  for (size_t i = 0; i < expected.max_length(); ++i) {
+    EXPECT_THAT(actual.quality_histogram(i),
+                ElementsAreArray(expected.quality_histogram(i)));
+    EXPECT_EQ(actual.base_counts(i), expected.base_counts(i));
+  }
+  EXPECT_EQ(actual.duplication().levels, expected.duplication().levels);
+}
+
+TEST(FastqStats, Empty) {
+  const FastqStats stats;
+  EXPECT_EQ(stats.num_reads(), 0);
+  EXPECT_EQ(stats.max_length(), 0);
+  EXPECT_EQ(stats.duplication().distinct_fraction(), 1.0);
+}
+
+TEST(FastqStats, PerPosition) {
+  FastqStats stats;
+  stats.Add({.name = "a", .sequence = "ACGN", .quality = "!+5?"});
+  stats.Add({.name = "b", .sequence = "AAR", .quality = "+++"});
+
+  EXPECT_EQ(stats.num_reads(), 2);
+  EXPECT_EQ(stats.num_bases(), 7);
+  EXPECT_EQ(stats.max_length(), 4);
+  EXPECT_THAT(stats.length_histogram(), ElementsAre(0, 0, 0, 1, 1));
+
+  EXPECT_EQ(stats.quality_histogram(0)[0], 1);
+  EXPECT_EQ(stats.quality_histogram(0)[10], 1);
+  EXPECT_EQ(stats.mean_quality(0), 5.0);
+  EXPECT_EQ(stats.mean_quality(1), 10.0);
+  EXPECT_EQ(stats.mean_quality(2), 15.0);
+  EXPECT_EQ(stats.mean_quality(3), 30.0);
+
+  EXPECT_EQ(stats.base_counts(0), (BaseCounts{.a = 2}));
+  EXPECT_EQ(stats.base_counts(1), (BaseCounts{.a = 1, .c = 1}));
+  EXPECT_EQ(stats.base_counts(2), (BaseCounts{.g = 1, .other = 1}));
+  EXPECT_EQ(stats.base_counts(3), (BaseCounts{.n = 1}));
+
+  // Read means are 15 and 10.
+  EXPECT_EQ(stats.read_quality_histogram()[15], 1);
+  EXPECT_EQ(stats.read_quality_histogram()[10], 1);
+}
+
+TEST(FastqStats, LongReads) {
+  // Long enough to cover both the vector and scalar paths.
+  FastqSequence read = {.name = "long"};
+  for (int i = 0; i < 37; ++i) {
+    read.sequence.push_back("ACGT"[i % 4]);
+    read.quality.push_back(static_cast<char>('!' + i));
+  }
+  FastqStats stats;
+  stats.Add(read);
+  for (int i = 0; i < 37; ++i) {
+    EXPECT_EQ(stats.quality_histogram(i)[i], 1) << i;
+  }
+  EXPECT_EQ(stats.read_quality_histogram()[18], 1);
+}
+
+TEST(FastqStats, QualityOffset) {
+  FastqStats stats({.quality_offset = 64});
+  stats.Add({.name = "a", .sequence = "ACG", .quality = "@h!"});
+  EXPECT_EQ(stats.quality_histogram(0)[0], 1);
+  EXPECT_EQ(stats.quality_histogram(1)[40], 1);
+  // Below the offset.
+  EXPECT_EQ(stats.quality_histogram(2)[0], 1);
+
+  FastqStats clamped;
+  clamped.Add({.name = "a", .sequence = "A", .quality = "~"});
+  EXPECT_EQ(clamped.quality_histogram(0)[FastqStats::kNumQualities - 1], 1);
+}
+
+TEST(FastqStats, Duplication) {
+  FastqStats stats;
+  for (int copy = 0; copy < 3; ++copy) {
+    for (int i = 0; i < 100; ++i) {
+      stats.Add({.name = "dup", .sequence = absl::StrCat("ACGT", i),
+                 .quality = "IIIIII"});
+    }
+  }
+  for (int i = 0; i < 50; ++i) {
+    stats.Add({.name = "unique", .sequence = absl::StrCat("TTTT", i),
+               .quality = "IIIIII"});
+  }
+  const DuplicationEstimate duplication = stats.duplication();
+  EXPECT_EQ(duplication.sampled_reads, 350);
+  EXPECT_EQ(duplication.distinct_sequences, 150);
+  EXPECT_THAT(duplication.levels, ElementsAre(Pair(1, 50), Pair(3, 100)));
+  EXPECT_THAT(duplication.distinct_fraction(), DoubleNear(150.0 / 350, 1e-9));
+}
+
+TEST(FastqStats, DuplicationSample) {
+  FastqStats stats({.duplication_sample_size = 64});
+  for (int i = 0; i < 10000; ++i) {
+    const std::string sequence = absl::StrCat("ACGT", i % 5000);
+    stats.Add({.name = "read", .sequence = sequence, .quality = sequence});
+  }
+  const DuplicationEstimate duplication = stats.duplication();
+  EXPECT_LE(duplication.distinct_sequences, 64);
+  EXPECT_GT(duplication.distinct_sequences, 8);
+  EXPECT_EQ(duplication.distinct_fraction(), 0.5);
+}
+
+TEST(FastqStats, Merge) {
+  std::mt19937 rng(1);
+  FastqStats all({.duplication_sample_size = 100});
+  FastqStats first({.duplication_sample_size = 100});
+  FastqStats second({.duplication_sample_size = 100});
+  for (int i = 0; i < 2000; ++i) {
+    FastqSequence read = RandomRead(&rng, i);
+    read.sequence.resize(std::min<size_t>(read.sequence.size(), 3));
+    read.quality.resize(read.sequence.size());
+    all.Add(read);
+    (i % 3 == 0 ? first : second).Add(read);
+  }
+  first.Merge(second);
+  ExpectSameStats(first, all);
+}
+
+TEST(ComputeFastqStats, MatchesSequential) {
+  std::mt19937 rng(2);
+  std::string contents;
+  FastqStats expected;
+  for (int i = 0; i < 30000; ++i) {
+    const FastqSequence read = RandomRead(&rng, i);
+    absl::StrAppend(&contents, read.string(), "\n");
+    expected.Add(read);
+  }
+  const std::string path = WriteTempFile("stats.fastq", contents);
+
+  for (size_t num_threads : {1, 4}) {
+    std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(path);
+    absl::StatusOr<FastqStats> stats =
+        ComputeFastqStats(parser.get(), {.num_threads = num_threads});
+    ASSERT_THAT(stats, IsOk());
+    ExpectSameStats(*stats, expected);
+  }
+}
+
+}  // namespace
+}  // namespace bio
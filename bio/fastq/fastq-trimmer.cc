@@ -0,0 +1,252 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-trimmer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "gxl/status/status_macros.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+// The number of reads trimmed per task.
+static constexpr size_t kBatchSize = 8192;
+
+// The maximum number of batches in flight per thread.
+static constexpr size_t kPendingBatchesPerThread = 2;
+
+// Returns the number of positions at which the first `size` bytes of `lhs` and
+// `rhs` differ. Counting may stop early once the count exceeds `limit`.
+auto CountMismatches(const char* lhs, const char* rhs, size_t size,
+                     size_t limit) -> size_t {
+  size_t mismatches = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= size && mismatches <= limit; i += 16) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+    const uint32_t equal =
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+    mismatches += 16 - std::popcount(equal);
+  }
+#endif
+  for (; i < size && mismatches <= limit; ++i) {
+    mismatches += lhs[i] != rhs[i];
+  }
+  return mismatches;
+}
+
+// Returns the Phred score of a quality character, or 0 if it is below
+// `offset`.
+auto Phred(char quality, int offset) -> int {
+  return std::max(static_cast<uint8_t>(quality) - offset, 0);
+}
+
+// The reads of a batch that were kept, and the counts for the whole batch.
+struct TrimmedBatch {
+  std::vector<FastqSequence> reads;
+  FastqTrimStats stats;
+};
+
+auto TrimBatch(std::vector<FastqSequence> reads,
+               const FastqTrimOptions& options) -> TrimmedBatch {
+  TrimmedBatch batch;
+  batch.reads.reserve(reads.size());
+  for (FastqSequence& read : reads) {
+    ++batch.stats.reads_in;
+    batch.stats.bases_in += read.size();
+    if (TrimRead(&read, options)) {
+      ++batch.stats.adapters_removed;
+    }
+    if (read.size() < options.min_length) {
+      continue;
+    }
+    ++batch.stats.reads_out;
+    batch.stats.bases_out += read.size();
+    batch.reads.push_back(std::move(read));
+  }
+  return batch;
+}
+
+}  // namespace
+
+auto FindAdapter(absl::string_view sequence, absl::string_view adapter,
+                 double max_error_rate, size_t min_overlap) -> size_t {
+  if (adapter.empty()) {
+    return sequence.size();
+  }
+  const size_t min_size = std::min(std::max<size_t>(min_overlap, 1),
+                                   adapter.size());
+  for (size_t start = 0; start + min_size <= sequence.size(); ++start) {
+    const size_t overlap = std::min(adapter.size(), sequence.size() - start);
+    const size_t max_mismatches =
+        static_cast<size_t>(overlap * std::max(max_error_rate, 0.0));
+    if (CountMismatches(sequence.data() + start, adapter.data(), overlap,
+                        max_mismatches) <= max_mismatches) {
+      return start;
+    }
+  }
+  return sequence.size();
+}
+
+auto TruncateRead(absl::Nonnull<FastqSequence*> read, size_t length) -> void {
+  if (length < read->sequence.size()) {
+    read->sequence.resize(length);
+  }
+  if (length < read->quality.size()) {
+    read->quality.resize(length);
+  }
+}
+
+auto TrimAdapter(absl::Nonnull<FastqSequence*> read,
+                 const FastqTrimOptions& options) -> bool {
+  const size_t start =
+      FindAdapter(read->sequence, options.adapter,
+                  options.max_adapter_error_rate, options.min_adapter_overlap);
+  if (start == read->sequence.size()) {
+    return false;
+  }
+  TruncateRead(read, start);
+  return true;
+}
+
+auto TrimSlidingWindow(absl::Nonnull<FastqSequence*> read,
+                       const FastqTrimOptions& options) -> size_t {
+  const std::string& quality = read->quality;
+  const size_t size = quality.size();
+  if (options.window_size == 0 || size == 0) {
+    return 0;
+  }
+  const size_t window = std::min(options.window_size, size);
+  const int64_t min_sum = static_cast<int64_t>(options.window_quality) * window;
+  int64_t sum = 0;
+  for (size_t i = 0; i < window; ++i) {
+    sum += Phred(quality[i], options.quality_offset);
+  }
+  for (size_t start = 0;; ++start) {
+    if (sum < min_sum) {
+      TruncateRead(read, start);
+      return size - start;
+    }
+    if (start + window == size) {
+      return 0;
+    }
+    sum += Phred(quality[start + window], options.quality_offset) -
+           Phred(quality[start], options.quality_offset);
+  }
+}
+
+auto TrimQualityBwa(absl::Nonnull<FastqSequence*> read,
+                    const FastqTrimOptions& options) -> size_t {
+  const std::string& quality = read->quality;
+  const size_t size = quality.size();
+  if (options.quality_threshold <= 0) {
+    return 0;
+  }
+  int64_t sum = 0;
+  int64_t max_sum = 0;
+  size_t cut = size;
+  for (size_t i = size; i > 0; --i) {
+    sum += options.quality_threshold -
+           Phred(quality[i - 1], options.quality_offset);
+    if (sum < 0) {
+      break;
+    }
+    if (sum > max_sum) {
+      max_sum = sum;
+      cut = i - 1;
+    }
+  }
+  TruncateRead(read, cut);
+  return size - cut;
+}
+
+auto TrimRead(absl::Nonnull<FastqSequence*> read,
+              const FastqTrimOptions& options) -> bool {
+  const bool adapter_removed = TrimAdapter(read, options);
+  TrimSlidingWindow(read, options);
+  TrimQualityBwa(read, options);
+  return adapter_removed;
+}
+
+auto TrimFastq(absl::Nonnull<FastqParser*> parser,
+               absl::Nonnull<FastqWriter*> writer,
+               const FastqTrimOptions& options)
+    -> absl::StatusOr<FastqTrimStats> {
+  FastqTrimStats stats;
+  auto consume = [&stats, writer](TrimmedBatch batch) -> absl::Status {
+    RETURN_IF_ERROR(writer->Write(batch.reads));
+    stats += batch.stats;
+    return absl::OkStatus();
+  };
+
+  std::optional<ThreadPool> pool;
+  std::optional<TaskQueue<TrimmedBatch>> queue;
+  if (options.num_threads > 1) {
+    pool.emplace(options.num_threads);
+    queue.emplace(&*pool);
+  }
+  const size_t max_pending = kPendingBatchesPerThread * options.num_threads;
+  while (!parser->eof()) {
+    std::vector<FastqSequence> reads;
+    reads.reserve(kBatchSize);
+    while (reads.size() < kBatchSize && !parser->eof()) {
+      ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+      if (read == nullptr) {
+        break;
+      }
+      reads.push_back(std::move(*read));
+    }
+    if (!queue.has_value()) {
+      RETURN_IF_ERROR(consume(TrimBatch(std::move(reads), options)));
+      continue;
+    }
+    if (queue->pending() >= max_pending) {
+      RETURN_IF_ERROR(consume(*queue->Next()));
+    }
+    auto shared = std::make_shared<std::vector<FastqSequence>>(
+        std::move(reads));
+    queue->Submit([shared, &options]() {
+      return TrimBatch(std::move(*shared), options);
+    });
+  }
+  while (queue.has_value() && queue->pending() > 0) {
+    RETURN_IF_ERROR(consume(*queue->Next()));
+  }
+  return stats;
+}
+
+}  // namespace bio
@@ -0,0 +1,151 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_FASTQ_TRIMMER_H_
+#define BIO_FASTQ_FASTQ_TRIMMER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+
+namespace bio {
+
+// Options for trimming FASTQ reads. The steps run in the order of the fields:
+// adapter removal, then sliding-window trimming, then BWA-style trimming.
+struct FastqTrimOptions {
+  // The ASCII value of Phred quality 0.
+  int quality_offset = 33;
+
+  // The 3' adapter to remove. If empty, adapters are not removed.
+  std::string adapter;
+
+  // The maximum fraction of mismatches in the overlap between a read and the
+  // adapter.
+  double max_adapter_error_rate = 0.1;
+
+  // The minimum overlap between the end of a read and the start of the
+  // adapter for it to be removed.
+  size_t min_adapter_overlap = 3;
+
+  // The size of the sliding window. If 0, sliding-window trimming is
+  // disabled.
+  size_t window_size = 0;
+
+  // The minimum mean Phred score of a sliding window.
+  int window_quality = 20;
+
+  // The quality threshold of BWA-style trimming. If 0, BWA-style trimming is
+  // disabled.
+  int quality_threshold = 0;
+
+  // Reads shorter than this after trimming are discarded by TrimFastq().
+  size_t min_length = 0;
+
+  // The number of threads that trim reads in TrimFastq(). If 1 or less, the
+  // reads are trimmed on the calling thread.
+  size_t num_threads = 1;
+};
+
+// Counts of the reads and bases processed by TrimFastq().
+struct FastqTrimStats {
+  uint64_t reads_in = 0;
+  uint64_t reads_out = 0;
+  uint64_t bases_in = 0;
+  uint64_t bases_out = 0;
+
+  // The number of reads from which an adapter was removed.
+  uint64_t adapters_removed = 0;
+
+  // Adds the counts in `rhs` to these counts.
+  auto operator+=(const FastqTrimStats& rhs) -> FastqTrimStats& {
+    reads_in += rhs.reads_in;
+    reads_out += rhs.reads_out;
+    bases_in += rhs.bases_in;
+    bases_out += rhs.bases_out;
+    adapters_removed += rhs.adapters_removed;
+    return *this;
+  }
+};
+
+// Returns the position in `sequence` where `adapter` starts, or
+// sequence.size() if it is not found. The adapter may run past the 3' end of
+// the sequence, and matches if the overlap has at least `min_overlap` bases
+// and at most `max_error_rate` mismatches per base. The leftmost match is
+// returned.
+//
+// On x86-64, mismatches are counted 16 bases at a time with SSE2 compares.
+auto FindAdapter(absl::string_view sequence, absl::string_view adapter,
+                 double max_error_rate, size_t min_overlap) -> size_t;
+
+// Truncates `read` to `length` bases.
+auto TruncateRead(absl::Nonnull<FastqSequence*> read, size_t length) -> void;
+
+// Removes the adapter in `options` and everything after it from `read`.
+// Returns true if an adapter was found.
+auto TrimAdapter(absl::Nonnull<FastqSequence*> read,
+                 const FastqTrimOptions& options) -> bool;
+
+// Truncates `read` at the start of the first window of
+// FastqTrimOptions::window_size bases whose mean Phred score is below
+// FastqTrimOptions::window_quality, as Trimmomatic's SLIDINGWINDOW does.
+// Reads shorter than the window are treated as a single window. Returns the
+// number of bases removed.
+auto TrimSlidingWindow(absl::Nonnull<FastqSequence*> read,
+                       const FastqTrimOptions& options) -> size_t;
+
+// Trims the 3' end of `read` with the algorithm of BWA's -q option: the read
+// is cut at the position that maximizes the sum of
+// (FastqTrimOptions::quality_threshold - Phred score) over the removed
+// bases. Returns the number of bases removed.
+auto TrimQualityBwa(absl::Nonnull<FastqSequence*> read,
+                    const FastqTrimOptions& options) -> size_t;
+
+// Applies all trimming steps enabled in `options` to `read`. Returns true if
+// an adapter was removed.
+auto TrimRead(absl::Nonnull<FastqSequence*> read,
+              const FastqTrimOptions& options) -> bool;
+
+// Trims every read from `parser` and writes the reads that are at least
+// FastqTrimOptions::min_length bases long to `writer`, in input order.
+// Batches of reads are trimmed across FastqTrimOptions::num_threads threads.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser,
+//                  FastqParser::New("path/to/reads.fastq"));
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqWriter> writer,
+//                  FastqWriter::New("path/to/trimmed.fastq"));
+// ASSIGN_OR_RETURN(
+//     FastqTrimStats stats,
+//     TrimFastq(parser.get(), writer.get(),
+//               {.adapter = "AGATCGGAAGAGC", .quality_threshold = 20,
+//                .min_length = 30, .num_threads = 8}));
+// RETURN_IF_ERROR(writer->Close());
+// ```
+auto TrimFastq(absl::Nonnull<FastqParser*> parser,
+               absl::Nonnull<FastqWriter*> writer,
+               const FastqTrimOptions& options)
+    -> absl::StatusOr<FastqTrimStats>;
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_FASTQ_TRIMMER_H_
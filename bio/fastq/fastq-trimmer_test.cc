@@ -0,0 +1,220 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-trimmer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::testing::TempDir;
+
+static constexpr absl::string_view kAdapter = "AGATCGGAAGAGCACACGTCT";
+
+auto MakeRead(absl::string_view sequence, absl::string_view quality)
+    -> FastqSequence {
+  return {.name = "read", .sequence = std::string(sequence),
+          .quality = std::string(quality)};
+}
+
+// Returns the quality string of Phred scores `scores`.
+auto Quality(const std::vector<int>& scores) -> std::string {
+  std::string quality;
+  for (int score : scores) {
+    quality.push_back(static_cast<char>('!' + score));
+  }
+  return quality;
+}
+
+TEST(FindAdapter, FullAdapter) {
+  const std::string sequence = absl::StrCat("ACGTTGCAACGT", kAdapter, "ACGT");
+  EXPECT_EQ(FindAdapter(sequence, kAdapter, 0.0, 3), 12);
+}
+
+TEST(FindAdapter, PartialAdapterAtEnd) {
+  EXPECT_EQ(FindAdapter("TTTTTTTTTTAGATC", kAdapter, 0.1, 3), 10);
+  EXPECT_EQ(FindAdapter("TTTTTTTTTTAGA", kAdapter, 0.1, 3), 10);
+  // Shorter than the minimum overlap.
+  EXPECT_EQ(FindAdapter("TTTTTTTTTTAG", kAdapter, 0.1, 3), 12);
+}
+
+TEST(FindAdapter, Mismatches) {
+  std::string adapter(kAdapter);
+  adapter[5] = 'T';
+  adapter[17] = 'A';
+  const std::string sequence = absl::StrCat("CCCCCCCCCCCCCCCCCCCC", adapter);
+  // Two mismatches in 21 bases.
+  EXPECT_EQ(FindAdapter(sequence, kAdapter, 0.1, 3), 20);
+  EXPECT_EQ(FindAdapter(sequence, kAdapter, 0.05, 3), sequence.size());
+}
+
+TEST(FindAdapter, MatchesNaiveSearch) {
+  std::mt19937 rng(1);
+  for (int trial = 0; trial < 2000; ++trial) {
+    std::string sequence(rng() % 80, 'A');
+    for (char& base : sequence) {
+      base = "ACGT"[rng() % 4];
+    }
+    std::string adapter(1 + rng() % 40, 'A');
+    for (char& base : adapter) {
+      base = "ACGT"[rng() % 4];
+    }
+    if (!sequence.empty() && rng() % 2 == 0) {
+      const size_t start = rng() % sequence.size();
+      sequence.replace(start, sequence.size() - start,
+                       adapter.substr(0, sequence.size() - start));
+      sequence[start] = 'G';
+    }
+    const double rate = 0.15;
+    const size_t min_overlap = 3;
+
+    size_t expected = sequence.size();
+    for (size_t start = 0; start < sequence.size(); ++start) {
+      const size_t overlap = std::min(adapter.size(), sequence.size() - start);
+      if (overlap < std::min(min_overlap, adapter.size())) {
+        break;
+      }
+      size_t mismatches = 0;
+      for (size_t i = 0; i < overlap; ++i) {
+        mismatches += sequence[start + i] != adapter[i];
+      }
+      if (mismatches <= static_cast<size_t>(overlap * rate)) {
+        expected = start;
+        break;
+      }
+    }
+    ASSERT_EQ(FindAdapter(sequence, adapter, rate, min_overlap), expected)
+        << sequence << " " << adapter;
+  }
+}
+
+TEST(FastqTrimmer, TrimAdapter) {
+  FastqSequence read = MakeRead(absl::StrCat("ACGTACGT", kAdapter.substr(0, 8)),
+                                std::string(16, 'I'));
+  EXPECT_TRUE(TrimAdapter(&read, {.adapter = std::string(kAdapter)}));
+  EXPECT_EQ(read.sequence, "ACGTACGT");
+  EXPECT_EQ(read.quality, "IIIIIIII");
+
+  EXPECT_FALSE(TrimAdapter(&read, {.adapter = std::string(kAdapter)}));
+  EXPECT_FALSE(TrimAdapter(&read, {}));
+  EXPECT_EQ(read.sequence, "ACGTACGT");
+}
+
+TEST(FastqTrimmer, TrimSlidingWindow) {
+  FastqSequence read = MakeRead(
+      "ACGTACGTAC", Quality({30, 30, 30, 30, 30, 30, 10, 10, 10, 30}));
+  EXPECT_EQ(TrimSlidingWindow(&read, {.window_size = 4, .window_quality = 20}),
+            5);
+  // The window starting at 5 has mean (30 + 10 + 10 + 10) / 4 = 15.
+  EXPECT_EQ(read.sequence, "ACGTA");
+  EXPECT_EQ(read.quality.size(), 5);
+
+  FastqSequence good = MakeRead("ACGT", Quality({30, 30, 30, 30}));
+  EXPECT_EQ(TrimSlidingWindow(&good, {.window_size = 4}), 0);
+  EXPECT_EQ(TrimSlidingWindow(&good, {}), 0);
+  EXPECT_EQ(good.sequence, "ACGT");
+
+  FastqSequence short_read = MakeRead("AC", Quality({10, 20}));
+  EXPECT_EQ(TrimSlidingWindow(&short_read, {.window_size = 4}), 2);
+  EXPECT_EQ(short_read.sequence, "");
+}
+
+TEST(FastqTrimmer, TrimQualityBwa) {
+  // Cutadapt's documented example: qualities 42 40 26 27 8 7 11 4 2 3 with
+  // threshold 10 cut the last six bases.
+  FastqSequence read =
+      MakeRead("ACGTACGTAC", Quality({42, 40, 26, 27, 8, 7, 11, 4, 2, 3}));
+  EXPECT_EQ(TrimQualityBwa(&read, {.quality_threshold = 10}), 6);
+  EXPECT_EQ(read.sequence, "ACGT");
+
+  FastqSequence good = MakeRead("ACGT", Quality({30, 30, 30, 30}));
+  EXPECT_EQ(TrimQualityBwa(&good, {.quality_threshold = 10}), 0);
+
+  FastqSequence offset = MakeRead("ACG", "hhB");
+  EXPECT_EQ(
+      TrimQualityBwa(&offset, {.quality_offset = 64, .quality_threshold = 10}),
+      1);
+  EXPECT_EQ(offset.sequence, "AC");
+}
+
+TEST(TrimFastq, TrimsFile) {
+  std::string contents;
+  std::string expected;
+  uint64_t bases = 0;
+  for (int i = 0; i < 20000; ++i) {
+    FastqSequence read = {.name = absl::StrCat("read", i)};
+    const size_t insert = 10 + i % 50;
+    for (size_t j = 0; j < insert; ++j) {
+      read.sequence.push_back("ACGT"[(i + j * 7) % 4] == 'A' ? 'C' : 'G');
+    }
+    read.sequence += kAdapter.substr(0, 60 - insert);
+    read.quality = std::string(read.sequence.size(), 'I');
+    bases += read.size();
+    absl::StrAppend(&contents, read.string(), "\n");
+    if (insert >= 20) {
+      // Adapter overlaps shorter than 3 bases are kept.
+      const size_t length = 60 - insert >= 3 ? insert : read.size();
+      FastqSequence trimmed = read;
+      trimmed.sequence.resize(length);
+      trimmed.quality.resize(length);
+      absl::StrAppend(&expected, trimmed.string(), "\n");
+    }
+  }
+  const std::string input = WriteTempFile("untrimmed.fastq", contents);
+
+  for (size_t num_threads : {1, 4}) {
+    const std::string output = gxl::JoinPath(
+        TempDir(), absl::StrCat("trimmed", num_threads, ".fastq"));
+    std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(input);
+    std::unique_ptr<FastqWriter> writer = FastqWriter::NewOrDie(output);
+    absl::StatusOr<FastqTrimStats> stats = TrimFastq(
+        parser.get(), writer.get(),
+        {.adapter = std::string(kAdapter), .min_length = 20,
+         .num_threads = num_threads});
+    ASSERT_THAT(stats, IsOk());
+    ASSERT_THAT(writer->Close(), IsOk());
+
+    EXPECT_EQ(stats->reads_in, 20000);
+    EXPECT_EQ(stats->bases_in, bases);
+    EXPECT_EQ(stats->adapters_removed, 20000 * 48 / 50);
+    EXPECT_EQ(stats->reads_out, 20000 * 40 / 50);
+
+    std::string actual;
+    ASSERT_THAT(gxl::GetContents(output, &actual, gxl::file::Defaults()),
+                IsOk());
+    EXPECT_EQ(actual, expected) << num_threads << " threads";
+  }
+}
+
+}  // namespace
+}  // namespace bio
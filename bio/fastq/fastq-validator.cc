@@ -0,0 +1,194 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-validator.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+// The highest printable quality character.
+static constexpr char kMaxPrintableQuality = '~';
+
+// The number of bytes compared per SIMD step.
+static constexpr size_t kBlockSize = 16;
+
+constexpr auto MakeIupacTable() -> std::array<bool, 256> {
+  std::array<bool, 256> table = {};
+  for (char base : absl::string_view("ACGTUNRYSWKMBDHV")) {
+    table[static_cast<uint8_t>(base)] = true;
+    table[static_cast<uint8_t>(base - 'A' + 'a')] = true;
+  }
+  return table;
+}
+
+static constexpr std::array<bool, 256> kIupacTable = MakeIupacTable();
+
+// Returns the position of the first base of `sequence` that is not an IUPAC
+// code, starting at `start`, using the lookup table.
+auto FindInvalidBaseScalar(absl::string_view sequence, size_t start)
+    -> size_t {
+  for (size_t i = start; i < sequence.size(); ++i) {
+    if (!kIupacTable[static_cast<uint8_t>(sequence[i])]) {
+      return i;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+auto Escape(char c) -> std::string {
+  return absl::CHexEscape(absl::string_view(&c, 1));
+}
+
+}  // namespace
+
+FastqValidator::FastqValidator(PhredOffset offset,
+                               std::optional<int> max_quality)
+    : offset_(offset), min_char_(static_cast<char>(offset)) {
+  const int max_char =
+      max_quality.has_value()
+          ? std::clamp(static_cast<int>(offset) + *max_quality,
+                       static_cast<int>(offset),
+                       static_cast<int>(kMaxPrintableQuality))
+          : kMaxPrintableQuality;
+  max_char_ = static_cast<char>(max_char);
+}
+
+auto FastqValidator::FindInvalidBase(absl::string_view sequence) -> size_t {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i a = _mm_set1_epi8('A');
+  const __m128i c = _mm_set1_epi8('C');
+  const __m128i g = _mm_set1_epi8('G');
+  const __m128i t = _mm_set1_epi8('T');
+  const __m128i n = _mm_set1_epi8('N');
+  for (; i + kBlockSize <= sequence.size(); i += kBlockSize) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(sequence.data() + i));
+    const __m128i acgtn = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, a), _mm_cmpeq_epi8(bytes, c)),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, g),
+                                  _mm_cmpeq_epi8(bytes, t)),
+                     _mm_cmpeq_epi8(bytes, n)));
+    if (_mm_movemask_epi8(acgtn) == 0xffff) {
+      continue;
+    }
+    // Lowercase and ambiguity codes are rare, so check the rest of the block
+    // with the table.
+    const size_t invalid =
+        FindInvalidBaseScalar(sequence.substr(0, i + kBlockSize), i);
+    if (invalid != absl::string_view::npos) {
+      return invalid;
+    }
+  }
+#endif  // defined(__SSE2__)
+  return FindInvalidBaseScalar(sequence, i);
+}
+
+auto FastqValidator::FindInvalidQuality(absl::string_view quality) const
+    -> size_t {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Both bounds are below 0x80, so signed comparisons also reject bytes with
+  // the high bit set, which compare as negative.
+  const __m128i below = _mm_set1_epi8(min_char_);
+  const __m128i above = _mm_set1_epi8(max_char_);
+  for (; i + kBlockSize <= quality.size(); i += kBlockSize) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(quality.data() + i));
+    const __m128i outside = _mm_or_si128(_mm_cmplt_epi8(bytes, below),
+                                         _mm_cmpgt_epi8(bytes, above));
+    const int mask = _mm_movemask_epi8(outside);
+    if (mask != 0) {
+      return i + std::countr_zero(static_cast<uint32_t>(mask));
+    }
+  }
+#endif  // defined(__SSE2__)
+  for (; i < quality.size(); ++i) {
+    if (quality[i] < min_char_ || quality[i] > max_char_) {
+      return i;
+    }
+  }
+  return absl::string_view::npos;
+}
+
+auto FastqValidator::Validate(const FastqSequence& sequence) const
+    -> absl::Status {
+  const size_t base = FindInvalidBase(sequence.sequence);
+  if (base != absl::string_view::npos) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid base '%s' at position %d",
+                        Escape(sequence.sequence[base]), base));
+  }
+  const size_t quality = FindInvalidQuality(sequence.quality);
+  if (quality != absl::string_view::npos) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Quality '%s' at position %d is outside the Phred+%d range '%c' to "
+        "'%c'",
+        Escape(sequence.quality[quality]), quality, static_cast<int>(offset_),
+        min_char_, max_char_));
+  }
+  return absl::OkStatus();
+}
+
+auto PhredOffsetDetector::Add(absl::string_view quality) -> void {
+  if (quality.empty()) {
+    return;
+  }
+  empty_ = false;
+  uint8_t min_char = min_char_;
+  size_t i = 0;
+#if defined(__SSE2__)
+  __m128i mins = _mm_set1_epi8(static_cast<char>(min_char));
+  for (; i + kBlockSize <= quality.size(); i += kBlockSize) {
+    mins = _mm_min_epu8(mins, _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                                  quality.data() + i)));
+  }
+  alignas(16) uint8_t lanes[kBlockSize];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), mins);
+  min_char = *std::min_element(lanes, lanes + kBlockSize);
+#endif  // defined(__SSE2__)
+  for (; i < quality.size(); ++i) {
+    min_char = std::min(min_char, static_cast<uint8_t>(quality[i]));
+  }
+  min_char_ = min_char;
+}
+
+auto PhredOffsetDetector::offset() const -> std::optional<PhredOffset> {
+  if (empty_) {
+    return std::nullopt;
+  }
+  return min_char_ < static_cast<uint8_t>(PhredOffset::kPhred64)
+             ? PhredOffset::kPhred33
+             : PhredOffset::kPhred64;
+}
+
+}  // namespace bio
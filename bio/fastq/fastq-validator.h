@@ -0,0 +1,117 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_FASTQ_VALIDATOR_H_
+#define BIO_FASTQ_FASTQ_VALIDATOR_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq.h"
+
+namespace bio {
+
+// The ASCII offset of the quality scores in a FASTQ file.
+enum class PhredOffset : uint8_t {
+  // Sanger and Illumina 1.8+, where '!' is Q0.
+  kPhred33 = 33,
+
+  // Illumina 1.3 to 1.7, where '@' is Q0.
+  kPhred64 = 64,
+};
+
+// Checks that FASTQ records contain only IUPAC bases and quality scores in
+// the range of their Phred encoding.
+//
+// Bases are checked against the IUPAC nucleotide codes in either case,
+// including U; gaps and '.' no-calls are rejected. Qualities must lie between
+// Q0 and `max_quality`, capped at '~'. Both checks compare 16 bytes at a
+// time with SSE2 where available: sequences that contain only uppercase ACGTN
+// take a few comparisons per block, and other blocks fall back to a lookup
+// table.
+//
+// Example usage:
+//
+// ```
+// const FastqValidator validator(PhredOffset::kPhred33);
+// RETURN_IF_ERROR(validator.Validate(*sequence));
+// ```
+class FastqValidator {
+ public:
+  // Constructs a validator for qualities encoded with `offset` and scores of
+  // at most `max_quality`. If `max_quality` is not set, any printable
+  // character from Q0 up to '~' is accepted.
+  explicit FastqValidator(PhredOffset offset = PhredOffset::kPhred33,
+                          std::optional<int> max_quality = std::nullopt);
+
+  // Returns an InvalidArgument error describing the first invalid base or
+  // quality of `sequence`.
+  auto Validate(const FastqSequence& sequence) const -> absl::Status;
+
+  // Returns the position of the first base of `sequence` that is not an IUPAC
+  // code, or absl::string_view::npos if there is none.
+  static auto FindInvalidBase(absl::string_view sequence) -> size_t;
+
+  // Returns the position of the first quality outside the accepted range, or
+  // absl::string_view::npos if there is none.
+  auto FindInvalidQuality(absl::string_view quality) const -> size_t;
+
+  // Returns the lowest and highest accepted quality characters.
+  auto min_quality_char() const -> char { return min_char_; }
+  auto max_quality_char() const -> char { return max_char_; }
+
+ private:
+  PhredOffset offset_;
+  char min_char_;
+  char max_char_;
+};
+
+// Guesses the Phred offset of a file from a sample of its quality strings.
+//
+// The lowest quality character decides: Phred+64 files have no qualities
+// below '@', while Phred+33 files almost always do, since '@' is only Q31.
+//
+// Example usage:
+//
+// ```
+// PhredOffsetDetector detector;
+// for (const FastqSequence& read : first_reads) {
+//   detector.Add(read.quality);
+// }
+// const PhredOffset offset =
+//     detector.offset().value_or(PhredOffset::kPhred33);
+// ```
+class PhredOffsetDetector {
+ public:
+  // Adds the qualities of one record to the sample.
+  auto Add(absl::string_view quality) -> void;
+
+  // Returns the detected offset, or std::nullopt if no qualities have been
+  // added.
+  auto offset() const -> std::optional<PhredOffset>;
+
+  // Returns the lowest quality character added so far.
+  auto min_quality_char() const -> uint8_t { return min_char_; }
+
+ private:
+  uint8_t min_char_ = 0xff;
+  bool empty_ = true;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_FASTQ_VALIDATOR_H_
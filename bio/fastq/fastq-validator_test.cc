@@ -0,0 +1,113 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/fastq-validator.h"
+
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(FastqValidator, FindInvalidBase) {
+  EXPECT_EQ(FastqValidator::FindInvalidBase(""), absl::string_view::npos);
+  EXPECT_EQ(FastqValidator::FindInvalidBase("ACGTNacgtnRYSWKMBDHVUu"),
+            absl::string_view::npos);
+  for (char c : absl::string_view("-.*XZ0 \xff")) {
+    EXPECT_EQ(FastqValidator::FindInvalidBase(std::string(1, c)), 0) << c;
+  }
+}
+
+TEST(FastqValidator, FindInvalidBaseAtEveryPosition) {
+  // Covers the SIMD blocks, the table fallback within a block and the tail.
+  for (size_t size : {1, 15, 16, 17, 40, 64}) {
+    for (size_t i = 0; i < size; ++i) {
+      std::string sequence(size, 'A');
+      sequence[(i + 3) % size] = 'y';
+      sequence[i] = 'E';
+      EXPECT_EQ(FastqValidator::FindInvalidBase(sequence), i) << size;
+    }
+  }
+}
+
+TEST(FastqValidator, FindInvalidQuality) {
+  const FastqValidator validator(PhredOffset::kPhred33, /*max_quality=*/41);
+  EXPECT_EQ(validator.min_quality_char(), '!');
+  EXPECT_EQ(validator.max_quality_char(), 'J');
+  EXPECT_EQ(validator.FindInvalidQuality("!#5?IJ"), absl::string_view::npos);
+  for (size_t size : {1, 15, 16, 17, 40}) {
+    for (size_t i = 0; i < size; ++i) {
+      for (char c : absl::string_view(" K~\x80\xff")) {
+        std::string quality(size, 'I');
+        quality[i] = c;
+        EXPECT_EQ(validator.FindInvalidQuality(quality), i) << size;
+      }
+    }
+  }
+}
+
+TEST(FastqValidator, QualityRange) {
+  EXPECT_EQ(FastqValidator(PhredOffset::kPhred64).min_quality_char(), '@');
+  EXPECT_EQ(FastqValidator(PhredOffset::kPhred64).max_quality_char(), '~');
+  EXPECT_EQ(FastqValidator(PhredOffset::kPhred64, 41).max_quality_char(),
+            'i');
+  EXPECT_EQ(FastqValidator(PhredOffset::kPhred33, 200).max_quality_char(),
+            '~');
+}
+
+TEST(FastqValidator, Validate) {
+  const FastqValidator validator;
+  EXPECT_THAT(validator.Validate({.name = "r",
+                                  .sequence = "ACGTN",
+                                  .quality = "!!II~"}),
+              IsOk());
+  EXPECT_THAT(validator.Validate({.name = "r",
+                                  .sequence = "AC\tTN",
+                                  .quality = "IIIII"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid base '\\t' at position 2")));
+  EXPECT_THAT(
+      validator.Validate(
+          {.name = "r", .sequence = "ACGTN", .quality = "III\x7fI"}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Quality '\\x7f' at position 3 is outside the "
+                         "Phred+33 range '!' to '~'")));
+}
+
+TEST(PhredOffsetDetector, Detect) {
+  PhredOffsetDetector detector;
+  EXPECT_EQ(detector.offset(), std::nullopt);
+  detector.Add("");
+  EXPECT_EQ(detector.offset(), std::nullopt);
+  detector.Add("hhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhBBBB");
+  EXPECT_EQ(detector.offset(), PhredOffset::kPhred64);
+  EXPECT_EQ(detector.min_quality_char(), 'B');
+  detector.Add("IIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIIII?");
+  EXPECT_EQ(detector.offset(), PhredOffset::kPhred33);
+  EXPECT_EQ(detector.min_quality_char(), '?');
+}
+
+}  // namespace
+}  // namespace bio
@@ -19,6 +19,8 @@
 #include <string>
 
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
 
 namespace bio {
 
@@ -42,6 +44,16 @@ struct FastqSequence {
   }
 };
 
+// Returns the part of a read name that identifies the pair: the first word,
+// without a trailing "/1" or "/2".
+inline auto MateName(absl::string_view name) -> absl::string_view {
+  name = name.substr(0, name.find_first_of(" \t"));
+  if (!absl::ConsumeSuffix(&name, "/1")) {
+    absl::ConsumeSuffix(&name, "/2");
+  }
+  return name;
+}
+
 }  // namespace bio
 
 #endif  // BIO_FASTQ_FASTQ_H_
@@ -43,5 +43,14 @@ GGGTGATGGCCGCTGCCGATGGCGTCAAATCCCACC
 IIIIIIIIIIIIIIIIIIIIIIIIIIIIII9IG9IC)");
 }
 
+TEST(MateName, StripsSuffixAndComment) {
+  EXPECT_EQ(MateName("read1/1"), "read1");
+  EXPECT_EQ(MateName("read1/2 1:N:0:ACGT"), "read1");
+  EXPECT_EQ(MateName("read1\tcomment"), "read1");
+  EXPECT_EQ(MateName("read1/3"), "read1/3");
+  EXPECT_EQ(MateName("read1"), "read1");
+  EXPECT_EQ(MateName(""), "");
+}
+
 }  // namespace
 }  // namespace bio
@@ -0,0 +1,161 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/paired-fastq-reader.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+
+PairedFastqReader::Stream::Stream(std::unique_ptr<FastqParser> parser,
+                                  const PairedFastqReaderOptions& options)
+    : parser_(std::move(parser)),
+      options_(options),
+      pool_(/*num_threads=*/1),
+      queue_(&pool_) {
+  options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+  options_.prefetch_batches = std::max<size_t>(options_.prefetch_batches, 1);
+}
+
+auto PairedFastqReader::Stream::Next()
+    -> absl::StatusOr<std::optional<FastqSequence>> {
+  while (batch_index_ == batch_.size()) {
+    if (!status_.ok()) {
+      return status_;
+    }
+    if (done_ && queue_.pending() == 0) {
+      return std::nullopt;
+    }
+    while (!done_ && queue_.pending() < options_.prefetch_batches) {
+      queue_.Submit([this]() { return ReadBatch(); });
+    }
+    Batch batch = *queue_.Next();
+    // Records read before an error are returned before the error.
+    if (!batch.status.ok()) {
+      status_ = std::move(batch.status);
+      done_ = true;
+    }
+    if (batch.eof) {
+      done_ = true;
+    }
+    batch_ = std::move(batch.records);
+    batch_index_ = 0;
+  }
+  return std::move(batch_[batch_index_++]);
+}
+
+auto PairedFastqReader::Stream::ReadBatch() -> Batch {
+  Batch batch;
+  if (io_done_) {
+    batch.eof = true;
+    return batch;
+  }
+  batch.records.reserve(options_.batch_size);
+  while (batch.records.size() < options_.batch_size) {
+    if (parser_->eof()) {
+      batch.eof = true;
+      break;
+    }
+    absl::StatusOr<std::unique_ptr<FastqSequence>> record =
+        parser_->Next(options_.truncate_name);
+    if (!record.ok()) {
+      batch.status = record.status();
+      break;
+    }
+    if (*record == nullptr) {
+      batch.eof = true;
+      break;
+    }
+    batch.records.push_back(std::move(**record));
+  }
+  io_done_ = batch.eof || !batch.status.ok();
+  return batch;
+}
+
+auto PairedFastqReader::New(absl::string_view first_path,
+                            absl::string_view second_path,
+                            const PairedFastqReaderOptions& options)
+    -> absl::StatusOr<std::unique_ptr<PairedFastqReader>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> first,
+                   FastqParser::New(first_path));
+  ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> second,
+                   FastqParser::New(second_path));
+  return std::unique_ptr<PairedFastqReader>(new PairedFastqReader(
+      std::make_unique<Stream>(std::move(first), options),
+      std::make_unique<Stream>(std::move(second), options)));
+}
+
+auto PairedFastqReader::NewInterleaved(absl::string_view path,
+                                       const PairedFastqReaderOptions& options)
+    -> absl::StatusOr<std::unique_ptr<PairedFastqReader>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser, FastqParser::New(path));
+  // Read whole pairs per batch.
+  PairedFastqReaderOptions interleaved = options;
+  interleaved.batch_size = 2 * std::max<size_t>(options.batch_size, 1);
+  return std::unique_ptr<PairedFastqReader>(new PairedFastqReader(
+      std::make_unique<Stream>(std::move(parser), interleaved), nullptr));
+}
+
+auto PairedFastqReader::Next() -> absl::StatusOr<std::optional<FastqPair>> {
+  ASSIGN_OR_RETURN(std::optional<FastqSequence> first, first_->Next());
+  Stream* mates = second_ != nullptr ? second_.get() : first_.get();
+  ASSIGN_OR_RETURN(std::optional<FastqSequence> second, mates->Next());
+  if (!first.has_value() && !second.has_value()) {
+    return std::nullopt;
+  }
+  if (!first.has_value() || !second.has_value()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Pair %d: Read %s has no mate", pairs_read_ + 1,
+        first.has_value() ? first->name : second->name));
+  }
+  if (MateName(first->name) != MateName(second->name)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Pair %d: Mate names do not match: '%s' and '%s'",
+                        pairs_read_ + 1, first->name, second->name));
+  }
+  ++pairs_read_;
+  return FastqPair{
+      .first = *std::move(first),
+      .second = *std::move(second),
+  };
+}
+
+auto PairedFastqReader::NextBatch(size_t max_pairs)
+    -> absl::StatusOr<std::vector<FastqPair>> {
+  std::vector<FastqPair> pairs;
+  pairs.reserve(max_pairs);
+  while (pairs.size() < max_pairs) {
+    ASSIGN_OR_RETURN(std::optional<FastqPair> pair, Next());
+    if (!pair.has_value()) {
+      break;
+    }
+    pairs.push_back(*std::move(pair));
+  }
+  return pairs;
+}
+
+}  // namespace bio
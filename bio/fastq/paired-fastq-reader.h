@@ -0,0 +1,159 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_PAIRED_FASTQ_READER_H_
+#define BIO_FASTQ_PAIRED_FASTQ_READER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+
+namespace bio {
+
+// Options for PairedFastqReader.
+struct PairedFastqReaderOptions {
+  // Whether read names are truncated to their first word, as with
+  // FastqParser::Next(/*truncate_name=*/true).
+  bool truncate_name = false;
+
+  // The number of records each I/O thread reads at a time.
+  size_t batch_size = 1024;
+
+  // The number of batches each I/O thread reads ahead of the caller.
+  size_t prefetch_batches = 4;
+};
+
+// The two mates of a read pair.
+struct FastqPair {
+  FastqSequence first;
+  FastqSequence second;
+};
+
+// Reads paired-end FASTQ from a pair of R1/R2 files or from a single
+// interleaved file, in which the mates of each pair are consecutive records.
+//
+// Each file is parsed on its own I/O thread that reads batches of records
+// ahead of the caller. Mate names are checked to agree, ignoring comments and
+// "/1" and "/2" suffixes, and files with different numbers of records are
+// reported as errors.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<PairedFastqReader> reader,
+//                  PairedFastqReader::New("path/to/sample_R1.fastq",
+//                                         "path/to/sample_R2.fastq"));
+// while (true) {
+//   ASSIGN_OR_RETURN(std::optional<FastqPair> pair, reader->Next());
+//   if (!pair.has_value()) {
+//     break;
+//   }
+//   // Do stuff with `pair->first` and `pair->second`.
+// }
+// ```
+class PairedFastqReader {
+ public:
+  ~PairedFastqReader() = default;
+
+  PairedFastqReader(const PairedFastqReader&) = delete;
+  auto operator=(const PairedFastqReader&) -> PairedFastqReader& = delete;
+
+  // Constructs a reader for the mates in `first_path` and `second_path`.
+  static auto New(absl::string_view first_path, absl::string_view second_path,
+                  const PairedFastqReaderOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<PairedFastqReader>>;
+
+  // Constructs a reader for the interleaved mates in `path`.
+  static auto NewInterleaved(absl::string_view path,
+                             const PairedFastqReaderOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<PairedFastqReader>>;
+
+  // Returns the next pair, or std::nullopt once all pairs have been read.
+  auto Next() -> absl::StatusOr<std::optional<FastqPair>>;
+
+  // Returns up to `max_pairs` pairs. Fewer pairs are returned only at the end
+  // of the input, and none once all pairs have been read.
+  auto NextBatch(size_t max_pairs) -> absl::StatusOr<std::vector<FastqPair>>;
+
+  // Returns the number of pairs read so far.
+  auto pairs_read() const -> uint64_t { return pairs_read_; }
+
+ private:
+  // Records parsed from one file on its own I/O thread.
+  class Stream {
+   public:
+    Stream(std::unique_ptr<FastqParser> parser,
+           const PairedFastqReaderOptions& options);
+
+    // Returns the next record, or std::nullopt at the end of the file.
+    auto Next() -> absl::StatusOr<std::optional<FastqSequence>>;
+
+   private:
+    // A batch of records read by the I/O thread, and the error that stopped
+    // reading, if any.
+    struct Batch {
+      std::vector<FastqSequence> records;
+      absl::Status status;
+      bool eof = false;
+    };
+
+    // Reads the next batch on the I/O thread.
+    auto ReadBatch() -> Batch;
+
+    std::unique_ptr<FastqParser> parser_;
+    PairedFastqReaderOptions options_;
+
+    // A single thread runs the reads, so they happen in order. The pool must
+    // outlive the queue, whose destructor waits for its tasks.
+    ThreadPool pool_;
+    TaskQueue<Batch> queue_;
+
+    // Whether the I/O thread has stopped reading. Only used on the I/O thread.
+    bool io_done_ = false;
+
+    // Whether a batch that ended the file or failed has been received.
+    bool done_ = false;
+    absl::Status status_;
+
+    // The batch being returned by Next() and the index of its next record.
+    std::vector<FastqSequence> batch_;
+    size_t batch_index_ = 0;
+  };
+
+  PairedFastqReader(std::unique_ptr<Stream> first,
+                    std::unique_ptr<Stream> second)
+      : first_(std::move(first)), second_(std::move(second)) {}
+
+  std::unique_ptr<Stream> first_;
+
+  // Null if the input is interleaved.
+  std::unique_ptr<Stream> second_;
+
+  uint64_t pairs_read_ = 0;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_PAIRED_FASTQ_READER_H_
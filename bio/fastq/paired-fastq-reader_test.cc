@@ -0,0 +1,190 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/paired-fastq-reader.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+auto Record(absl::string_view name, absl::string_view sequence)
+    -> std::string {
+  return absl::StrCat("@", name, "\n", sequence, "\n+\n",
+                      std::string(sequence.size(), 'I'), "\n");
+}
+
+// Returns the first and second mates of `num_pairs` pairs in FASTQ format.
+auto MakePairs(int num_pairs) -> std::pair<std::string, std::string> {
+  std::string first;
+  std::string second;
+  for (int i = 0; i < num_pairs; ++i) {
+    absl::StrAppend(&first, Record(absl::StrCat("read", i, "/1 BC:ACGT"),
+                                   i % 2 == 0 ? "ACGT" : "GGCCA"));
+    absl::StrAppend(&second, Record(absl::StrCat("read", i, "/2 BC:ACGT"),
+                                    i % 2 == 0 ? "TTGA" : "CAT"));
+  }
+  return {first, second};
+}
+
+auto ReadAll(PairedFastqReader* reader)
+    -> absl::StatusOr<std::vector<FastqPair>> {
+  std::vector<FastqPair> pairs;
+  while (true) {
+    absl::StatusOr<std::optional<FastqPair>> pair = reader->Next();
+    if (!pair.ok()) {
+      return pair.status();
+    }
+    if (!pair->has_value()) {
+      return pairs;
+    }
+    pairs.push_back(**std::move(pair));
+  }
+}
+
+TEST(PairedFastqReader, TwoFiles) {
+  const auto [first, second] = MakePairs(1000);
+  const std::string first_path = WriteTempFile("two_R1.fastq", first);
+  const std::string second_path = WriteTempFile("two_R2.fastq", second);
+
+  absl::StatusOr<std::unique_ptr<PairedFastqReader>> reader =
+      PairedFastqReader::New(first_path, second_path,
+                             {.batch_size = 7, .prefetch_batches = 3});
+  ASSERT_THAT(reader, IsOk());
+  absl::StatusOr<std::vector<FastqPair>> pairs = ReadAll(reader->get());
+  ASSERT_THAT(pairs, IsOk());
+  ASSERT_EQ(pairs->size(), 1000);
+  EXPECT_EQ((*reader)->pairs_read(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    const FastqPair& pair = (*pairs)[i];
+    EXPECT_EQ(pair.first.name, absl::StrCat("read", i, "/1 BC:ACGT"));
+    EXPECT_EQ(pair.second.name, absl::StrCat("read", i, "/2 BC:ACGT"));
+    EXPECT_EQ(pair.first.sequence, i % 2 == 0 ? "ACGT" : "GGCCA");
+    EXPECT_EQ(pair.second.sequence, i % 2 == 0 ? "TTGA" : "CAT");
+    EXPECT_EQ(pair.second.quality.size(), pair.second.sequence.size());
+  }
+  EXPECT_EQ(*(*reader)->Next(), std::nullopt);
+}
+
+TEST(PairedFastqReader, TruncateName) {
+  const auto [first, second] = MakePairs(3);
+  std::unique_ptr<PairedFastqReader> reader =
+      *PairedFastqReader::New(WriteTempFile("truncate_R1.fastq", first),
+                              WriteTempFile("truncate_R2.fastq", second),
+                              {.truncate_name = true});
+  std::optional<FastqPair> pair = *reader->Next();
+  ASSERT_TRUE(pair.has_value());
+  EXPECT_EQ(pair->first.name, "read0/1");
+  EXPECT_EQ(pair->second.name, "read0/2");
+}
+
+TEST(PairedFastqReader, Interleaved) {
+  std::string contents;
+  for (int i = 0; i < 500; ++i) {
+    absl::StrAppend(&contents, Record(absl::StrCat("read", i, "/1"), "ACGT"),
+                    Record(absl::StrCat("read", i, "/2"), "TTGCA"));
+  }
+  std::unique_ptr<PairedFastqReader> reader =
+      *PairedFastqReader::NewInterleaved(
+          WriteTempFile("interleaved.fastq", contents), {.batch_size = 16});
+
+  absl::StatusOr<std::vector<FastqPair>> batch = reader->NextBatch(300);
+  ASSERT_THAT(batch, IsOk());
+  ASSERT_EQ(batch->size(), 300);
+  EXPECT_EQ((*batch)[299].first.name, "read299/1");
+  EXPECT_EQ((*batch)[299].second.name, "read299/2");
+  EXPECT_EQ((*batch)[299].second.sequence, "TTGCA");
+
+  batch = reader->NextBatch(300);
+  ASSERT_THAT(batch, IsOk());
+  ASSERT_EQ(batch->size(), 200);
+  EXPECT_EQ((*batch)[0].first.name, "read300/1");
+
+  batch = reader->NextBatch(300);
+  ASSERT_THAT(batch, IsOk());
+  EXPECT_TRUE(batch->empty());
+}
+
+TEST(PairedFastqReader, Empty) {
+  std::unique_ptr<PairedFastqReader> reader =
+      *PairedFastqReader::New("bio/fastq/testdata/empty.fastq",
+                              "bio/fastq/testdata/empty.fastq");
+  EXPECT_EQ(*reader->Next(), std::nullopt);
+}
+
+TEST(PairedFastqReader, MismatchedNames) {
+  std::unique_ptr<PairedFastqReader> reader = *PairedFastqReader::New(
+      "bio/fastq/testdata/paired-mismatched-names-1.fastq",
+      "bio/fastq/testdata/paired-mismatched-names-2.fastq");
+  ASSERT_THAT(reader->Next(), IsOk());
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PairedFastqReader, MissingMate) {
+  const std::string first = MakePairs(10).first;
+  const std::string short_second = MakePairs(9).second;
+  std::unique_ptr<PairedFastqReader> reader =
+      *PairedFastqReader::New(WriteTempFile("missing_R1.fastq", first),
+                              WriteTempFile("missing_R2.fastq", short_second),
+                              {.batch_size = 4});
+  EXPECT_THAT(ReadAll(reader.get()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  reader = *PairedFastqReader::NewInterleaved(
+      "bio/fastq/testdata/interleaved-missing-mate.fastq");
+  ASSERT_THAT(reader->Next(), IsOk());
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PairedFastqReader, ParseError) {
+  const auto [first, second] = MakePairs(20);
+  const std::string truncated = absl::StrCat(second, "@read20/2\nACGT\n");
+  std::unique_ptr<PairedFastqReader> reader =
+      *PairedFastqReader::New(WriteTempFile("error_R1.fastq", first),
+                              WriteTempFile("error_R2.fastq", truncated),
+                              {.batch_size = 8});
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_THAT(reader->Next(), IsOk()) << i;
+  }
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PairedFastqReader, MissingFile) {
+  EXPECT_THAT(
+      PairedFastqReader::New("bio/fastq/testdata/empty.fastq",
+                             gxl::JoinPath(TempDir(), "absent_R2.fastq")),
+      StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
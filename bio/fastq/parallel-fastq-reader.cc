@@ -0,0 +1,366 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/parallel-fastq-reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/random-access-file.h"
+#include "bio/common/strings.h"
+#include "bio/fastq/fastq.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+static constexpr char kIdentifierPrefix = '@';
+static constexpr char kQualityIdPrefix = '+';
+
+// The number of bytes read past the end of a chunk up front, so that the last
+// record of most chunks is available without another read.
+static constexpr size_t kReadAhead = 64 << 10;
+
+// A line of the file, as byte offsets.
+struct Line {
+  // The offsets of the first byte and just past the last byte of the line,
+  // excluding the line terminator.
+  uint64_t begin;
+  uint64_t end;
+
+  // The offset of the next line.
+  uint64_t next;
+
+  auto empty() const -> bool { return begin == end; }
+  auto size() const -> uint64_t { return end - begin; }
+};
+
+// A window onto the file that is extended as lines past its end are
+// requested.
+class FileWindow {
+ public:
+  FileWindow(const RandomAccessFile* file, uint64_t offset, size_t size)
+      : file_(file), offset_(offset) {
+    status_ = Extend(size);
+  }
+
+  // Returns the line that starts at `offset`, or std::nullopt at the end of
+  // the file or if reading failed.
+  auto LineAt(uint64_t offset) -> std::optional<Line> {
+    if (!status_.ok() || offset >= file_->size()) {
+      return std::nullopt;
+    }
+    size_t search_from = offset - offset_;
+    while (true) {
+      const size_t newline = data_.find('\n', search_from);
+      if (newline != std::string::npos) {
+        return MakeLine(offset, offset_ + newline, offset_ + newline + 1);
+      }
+      if (offset_ + data_.size() == file_->size()) {
+        return MakeLine(offset, file_->size(), file_->size());
+      }
+      search_from = data_.size();
+      status_ = Extend(std::max(data_.size(), kReadAhead));
+      if (!status_.ok()) {
+        return std::nullopt;
+      }
+    }
+  }
+
+  // Returns the text of `line`, which must have been returned by LineAt().
+  auto text(const Line& line) const -> absl::string_view {
+    return absl::string_view(data_).substr(line.begin - offset_, line.size());
+  }
+
+  // Returns the error from reading the file, if any.
+  auto status() const -> const absl::Status& { return status_; }
+
+ private:
+  // Returns the line from `begin` to the newline at `newline`, excluding a
+  // carriage return before it.
+  auto MakeLine(uint64_t begin, uint64_t newline, uint64_t next) const
+      -> Line {
+    uint64_t end = newline;
+    if (end > begin && data_[end - 1 - offset_] == '\r') {
+      --end;
+    }
+    return {.begin = begin, .end = end, .next = next};
+  }
+
+  // Appends up to `size` more bytes of the file to the window.
+  auto Extend(size_t size) -> absl::Status {
+    const uint64_t end = offset_ + data_.size();
+    std::string more;
+    RETURN_IF_ERROR(file_->Read(
+        end, std::min<uint64_t>(size, file_->size() - end), &more));
+    data_.append(more);
+    return absl::OkStatus();
+  }
+
+  const RandomAccessFile* file_;
+  uint64_t offset_;
+  std::string data_;
+  absl::Status status_;
+};
+
+auto StartsWith(absl::string_view text, char c) -> bool {
+  return !text.empty() && text.front() == c;
+}
+
+// Returns the offset of the first non-empty line at or after `offset`, or the
+// size of the file if there is none.
+auto SkipEmptyLines(FileWindow* window, uint64_t offset) -> uint64_t {
+  for (std::optional<Line> line = window->LineAt(offset);
+       line.has_value() && line->empty(); line = window->LineAt(offset)) {
+    offset = line->next;
+  }
+  return offset;
+}
+
+// Returns whether a record starts at the line at `offset`.
+auto IsRecordStart(FileWindow* window, uint64_t offset) -> bool {
+  std::optional<Line> lines[4];
+  for (std::optional<Line>& line : lines) {
+    line = window->LineAt(offset);
+    if (!line.has_value()) {
+      return false;
+    }
+    offset = line->next;
+  }
+  if (!StartsWith(window->text(*lines[0]), kIdentifierPrefix) ||
+      !StartsWith(window->text(*lines[2]), kQualityIdPrefix) ||
+      lines[1]->size() != lines[3]->size()) {
+    return false;
+  }
+  const std::optional<Line> following =
+      window->LineAt(SkipEmptyLines(window, offset));
+  return !following.has_value() ||
+         StartsWith(window->text(*following), kIdentifierPrefix);
+}
+
+// Returns the error for a missing sequence identifier line at `offset`.
+auto MissingRecordError(uint64_t offset) -> absl::Status {
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "Offset %d: Expected sequence identifier line starting with '%c'",
+      offset, kIdentifierPrefix));
+}
+
+// Parses the record at `offset` into `record` and sets `offset` to the
+// offset of the line after it.
+auto ParseRecord(FileWindow* window, bool truncate_name,
+                 FastqSequence* record, uint64_t* offset) -> absl::Status {
+  const std::optional<Line> identifier_line = window->LineAt(*offset);
+  RETURN_IF_ERROR(window->status());
+  if (!identifier_line.has_value() ||
+      !StartsWith(window->text(*identifier_line), kIdentifierPrefix)) {
+    return MissingRecordError(*offset);
+  }
+  const absl::string_view name = window->text(*identifier_line).substr(1);
+  record->name = truncate_name ? FirstWord(name) : std::string(name);
+
+  const std::optional<Line> sequence_line =
+      window->LineAt(identifier_line->next);
+  RETURN_IF_ERROR(window->status());
+  if (!sequence_line.has_value()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Offset %d: Expected sequence line but got EOF",
+                        identifier_line->next));
+  }
+  record->sequence = window->text(*sequence_line);
+
+  const std::optional<Line> quality_id_line =
+      window->LineAt(sequence_line->next);
+  RETURN_IF_ERROR(window->status());
+  if (!quality_id_line.has_value()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Offset %d: Expected quality ID line but got EOF",
+                        sequence_line->next));
+  }
+  if (!StartsWith(window->text(*quality_id_line), kQualityIdPrefix)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Offset %d: Expected quality ID: '%c' or '%c%s'",
+        quality_id_line->begin, kQualityIdPrefix, kQualityIdPrefix,
+        record->name));
+  }
+
+  const std::optional<Line> quality_line =
+      window->LineAt(quality_id_line->next);
+  RETURN_IF_ERROR(window->status());
+  if (!quality_line.has_value()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Offset %d: Expected quality line but got EOF",
+                        quality_id_line->next));
+  }
+  record->quality = window->text(*quality_line);
+  if (record->quality.size() != record->sequence.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Offset %d: Sequence line length %d does not match quality line "
+        "length %d",
+        quality_line->begin, record->sequence.size(), record->quality.size()));
+  }
+  *offset = quality_line->next;
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+ParallelFastqReader::ParallelFastqReader(
+    std::unique_ptr<RandomAccessFile> file,
+    const ParallelFastqReaderOptions& options)
+    : file_(std::move(file)),
+      options_(options),
+      pool_(std::max<size_t>(options.num_threads, 1)),
+      queue_(&pool_) {
+  options_.num_threads = pool_.num_threads();
+  options_.chunk_size = std::max<size_t>(options_.chunk_size, 1);
+  options_.prefetch_chunks = std::max<size_t>(options_.prefetch_chunks, 1);
+  num_chunks_ =
+      (file_->size() + options_.chunk_size - 1) / options_.chunk_size;
+}
+
+auto ParallelFastqReader::New(absl::string_view path,
+                              const ParallelFastqReaderOptions& options)
+    -> absl::StatusOr<std::unique_ptr<ParallelFastqReader>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<RandomAccessFile> file,
+                   RandomAccessFile::New(path));
+  return std::unique_ptr<ParallelFastqReader>(
+      new ParallelFastqReader(std::move(file), options));
+}
+
+auto ParallelFastqReader::ParseChunk(uint64_t index) const -> Chunk {
+  const uint64_t begin = index * options_.chunk_size;
+  const uint64_t end =
+      std::min<uint64_t>(begin + options_.chunk_size, file_->size());
+  Chunk chunk;
+
+  // Read from the byte before the chunk, to tell whether the chunk starts at
+  // the beginning of a line.
+  const uint64_t window_begin = index == 0 ? 0 : begin - 1;
+  FileWindow window(file_.get(), window_begin,
+                    end - window_begin + kReadAhead);
+  uint64_t offset = 0;
+  if (index > 0) {
+    // Resynchronize to the first record that starts in the chunk.
+    std::optional<Line> line = window.LineAt(window_begin);
+    offset = line.has_value() ? line->next : file_->size();
+    while (offset < end && !IsRecordStart(&window, offset)) {
+      line = window.LineAt(offset);
+      if (!line.has_value()) {
+        break;
+      }
+      offset = line->next;
+    }
+    if (!window.status().ok()) {
+      chunk.status = window.status();
+      return chunk;
+    }
+    if (offset >= end) {
+      return chunk;
+    }
+  }
+
+  chunk.begin = offset;
+  while (true) {
+    offset = SkipEmptyLines(&window, offset);
+    if (!window.status().ok()) {
+      chunk.status = window.status();
+      return chunk;
+    }
+    if (offset >= end) {
+      break;
+    }
+    FastqSequence record;
+    chunk.status =
+        ParseRecord(&window, options_.truncate_name, &record, &offset);
+    if (!chunk.status.ok()) {
+      return chunk;
+    }
+    chunk.records.push_back(std::move(record));
+  }
+  chunk.end = offset;
+  return chunk;
+}
+
+auto ParallelFastqReader::CheckContiguous(const Chunk& chunk)
+    -> absl::Status {
+  if (!chunk.begin.has_value()) {
+    return absl::OkStatus();
+  }
+  // The chunks disagree about the record boundary only if the file is
+  // malformed between them, so report it the way parsing would.
+  if (*chunk.begin != expected_offset_) {
+    return MissingRecordError(expected_offset_);
+  }
+  expected_offset_ = chunk.end;
+  return absl::OkStatus();
+}
+
+auto ParallelFastqReader::Next()
+    -> absl::StatusOr<std::optional<FastqSequence>> {
+  const size_t max_pending = options_.num_threads * options_.prefetch_chunks;
+  while (batch_index_ == batch_.size()) {
+    if (!status_.ok()) {
+      return status_;
+    }
+    if (next_chunk_ == num_chunks_ && queue_.pending() == 0) {
+      // Lines after the last record boundary were not part of any record.
+      if (expected_offset_ != file_->size()) {
+        status_ = MissingRecordError(expected_offset_);
+        continue;
+      }
+      return std::nullopt;
+    }
+    while (next_chunk_ < num_chunks_ && queue_.pending() < max_pending) {
+      queue_.Submit(
+          [this, index = next_chunk_]() { return ParseChunk(index); });
+      ++next_chunk_;
+    }
+    Chunk chunk = *queue_.Next();
+    // Records parsed before an error are returned before the error.
+    status_ = CheckContiguous(chunk);
+    if (status_.ok()) {
+      status_ = std::move(chunk.status);
+      batch_ = std::move(chunk.records);
+      batch_index_ = 0;
+    }
+  }
+  ++records_read_;
+  return std::move(batch_[batch_index_++]);
+}
+
+auto ParallelFastqReader::NextBatch(size_t max_records)
+    -> absl::StatusOr<std::vector<FastqSequence>> {
+  std::vector<FastqSequence> records;
+  records.reserve(max_records);
+  while (records.size() < max_records) {
+    ASSIGN_OR_RETURN(std::optional<FastqSequence> record, Next());
+    if (!record.has_value()) {
+      break;
+    }
+    records.push_back(*std::move(record));
+  }
+  return records;
+}
+
+}  // namespace bio
@@ -0,0 +1,153 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_PARALLEL_FASTQ_READER_H_
+#define BIO_FASTQ_PARALLEL_FASTQ_READER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/random-access-file.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/fastq/fastq.h"
+
+namespace bio {
+
+// Options for ParallelFastqReader.
+struct ParallelFastqReaderOptions {
+  // Whether read names are truncated to their first word, as with
+  // FastqParser::Next(/*truncate_name=*/true).
+  bool truncate_name = false;
+
+  // The number of threads that parse chunks.
+  size_t num_threads = 4;
+
+  // The number of bytes of the file each chunk covers. Records are assigned to
+  // the chunk in which their identifier line starts.
+  size_t chunk_size = 4 << 20;
+
+  // The number of chunks each thread parses ahead of the caller.
+  size_t prefetch_chunks = 2;
+};
+
+// Reads a single FASTQ file by splitting it into fixed-size chunks that are
+// parsed in parallel, and returns the records in file order.
+//
+// A chunk generally starts in the middle of a record. Each chunk is
+// resynchronized to the first record boundary at or after its start: a line
+// starting with '@', followed by a sequence line, a line starting with '+' and
+// a quality line of the same length as the sequence, followed by the end of
+// the file or another line starting with '@'. A quality line may start with
+// '@', but is then followed by a sequence identifier line rather than a '+'
+// line, so the boundary is found unambiguously in well-formed files. The
+// boundaries found by consecutive chunks are checked to agree, so records are
+// never duplicated or dropped.
+//
+// Unlike FastqParser, records must consist of exactly four lines, and lines
+// other than empty lines between records are reported as errors rather than
+// skipped. Errors report byte offsets into the file instead of line numbers.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<ParallelFastqReader> reader,
+//                  ParallelFastqReader::New("path/to/reads.fastq",
+//                                           {.num_threads = 8}));
+// while (true) {
+//   ASSIGN_OR_RETURN(std::optional<FastqSequence> read, reader->Next());
+//   if (!read.has_value()) {
+//     break;
+//   }
+//   // Do stuff with `read`.
+// }
+// ```
+class ParallelFastqReader {
+ public:
+  ~ParallelFastqReader() = default;
+
+  ParallelFastqReader(const ParallelFastqReader&) = delete;
+  auto operator=(const ParallelFastqReader&) -> ParallelFastqReader& = delete;
+
+  // Constructs a reader for the records in `path`.
+  static auto New(absl::string_view path,
+                  const ParallelFastqReaderOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<ParallelFastqReader>>;
+
+  // Returns the next record, or std::nullopt once all records have been read.
+  auto Next() -> absl::StatusOr<std::optional<FastqSequence>>;
+
+  // Returns up to `max_records` records. Fewer records are returned only at
+  // the end of the file, and none once all records have been read.
+  auto NextBatch(size_t max_records)
+      -> absl::StatusOr<std::vector<FastqSequence>>;
+
+  // Returns the number of records read so far.
+  auto records_read() const -> uint64_t { return records_read_; }
+
+ private:
+  // The records parsed from one chunk.
+  struct Chunk {
+    std::vector<FastqSequence> records;
+    absl::Status status;
+
+    // The offset of the first record and the offset just past the last
+    // record, including any empty lines that follow it. Unset if no record
+    // starts in the chunk.
+    std::optional<uint64_t> begin;
+    uint64_t end = 0;
+  };
+
+  ParallelFastqReader(std::unique_ptr<RandomAccessFile> file,
+                      const ParallelFastqReaderOptions& options);
+
+  // Parses the chunk at index `index` on a worker thread.
+  auto ParseChunk(uint64_t index) const -> Chunk;
+
+  // Checks that `chunk` starts where the previous chunk ended.
+  auto CheckContiguous(const Chunk& chunk) -> absl::Status;
+
+  std::unique_ptr<RandomAccessFile> file_;
+  ParallelFastqReaderOptions options_;
+  uint64_t num_chunks_;
+
+  // The pool must outlive the queue, whose destructor waits for its tasks.
+  ThreadPool pool_;
+  TaskQueue<Chunk> queue_;
+
+  // The index of the next chunk to submit.
+  uint64_t next_chunk_ = 0;
+
+  // The offset at which the next record is expected to start.
+  uint64_t expected_offset_ = 0;
+
+  absl::Status status_;
+
+  // The chunk being returned by Next() and the index of its next record.
+  std::vector<FastqSequence> batch_;
+  size_t batch_index_ = 0;
+
+  uint64_t records_read_ = 0;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_PARALLEL_FASTQ_READER_H_
@@ -0,0 +1,206 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/parallel-fastq-reader.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::TempDir;
+
+// Returns `num_records` records whose quality lines often start with '@' or
+// '+', so that they look like identifier or quality ID lines.
+auto MakeRecords(int num_records) -> std::vector<FastqSequence> {
+  static constexpr absl::string_view kBases = "ACGTN";
+  static constexpr absl::string_view kQualities = "@+I#5";
+  std::vector<FastqSequence> records;
+  for (int i = 0; i < num_records; ++i) {
+    FastqSequence record = {
+        .name = absl::StrCat("read", i, " length=", i % 37),
+    };
+    for (int j = 0; j < i % 37; ++j) {
+      record.sequence.push_back(kBases[(i + j) % kBases.size()]);
+      record.quality.push_back(kQualities[(i * j) % kQualities.size()]);
+    }
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+auto Format(const std::vector<FastqSequence>& records) -> std::string {
+  std::string contents;
+  for (const FastqSequence& record : records) {
+    absl::StrAppend(&contents, record.string(), "\n");
+  }
+  return contents;
+}
+
+auto ReadAll(ParallelFastqReader* reader)
+    -> absl::StatusOr<std::vector<FastqSequence>> {
+  std::vector<FastqSequence> records;
+  while (true) {
+    absl::StatusOr<std::optional<FastqSequence>> record = reader->Next();
+    if (!record.ok()) {
+      return record.status();
+    }
+    if (!record->has_value()) {
+      return records;
+    }
+    records.push_back(**std::move(record));
+  }
+}
+
+auto ExpectRecordsEqual(const std::vector<FastqSequence>& actual,
+                        const std::vector<FastqSequence>& expected) -> void {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_EQ(actual[i].name, expected[i].name) << i;
+    EXPECT_EQ(actual[i].sequence, expected[i].sequence) << i;
+    EXPECT_EQ(actual[i].quality, expected[i].quality) << i;
+  }
+}
+
+TEST(ParallelFastqReader, ResynchronizesAtAnyChunkSize) {
+  const std::vector<FastqSequence> records = MakeRecords(500);
+  const std::string path = WriteTempFile("resync.fastq", Format(records));
+  for (size_t chunk_size : {1, 2, 7, 33, 100, 1000, 1 << 20}) {
+    for (size_t num_threads : {1, 3}) {
+      absl::StatusOr<std::unique_ptr<ParallelFastqReader>> reader =
+          ParallelFastqReader::New(path, {.num_threads = num_threads,
+                                          .chunk_size = chunk_size});
+      ASSERT_THAT(reader, IsOk());
+      absl::StatusOr<std::vector<FastqSequence>> actual =
+          ReadAll(reader->get());
+      ASSERT_THAT(actual, IsOk()) << chunk_size;
+      ExpectRecordsEqual(*actual, records);
+      EXPECT_EQ((*reader)->records_read(), records.size());
+    }
+  }
+}
+
+TEST(ParallelFastqReader, EmptyLinesAndCarriageReturns) {
+  const std::vector<FastqSequence> records = MakeRecords(50);
+  std::string contents = "\n\n";
+  for (const FastqSequence& record : records) {
+    absl::StrAppend(&contents, "@", record.name, "\r\n", record.sequence,
+                    "\r\n+\r\n", record.quality, "\r\n\n");
+  }
+  const std::string path = WriteTempFile("empty_lines.fastq", contents);
+  for (size_t chunk_size : {3, 64, 4096}) {
+    std::unique_ptr<ParallelFastqReader> reader = *ParallelFastqReader::New(
+        path, {.num_threads = 2, .chunk_size = chunk_size});
+    absl::StatusOr<std::vector<FastqSequence>> actual =
+        ReadAll(reader.get());
+    ASSERT_THAT(actual, IsOk()) << chunk_size;
+    ExpectRecordsEqual(*actual, records);
+  }
+}
+
+TEST(ParallelFastqReader, TruncateName) {
+  std::unique_ptr<ParallelFastqReader> reader = *ParallelFastqReader::New(
+      WriteTempFile("truncate.fastq", Format(MakeRecords(3))),
+      {.truncate_name = true});
+  absl::StatusOr<std::vector<FastqSequence>> batch = reader->NextBatch(2);
+  ASSERT_THAT(batch, IsOk());
+  ASSERT_EQ(batch->size(), 2);
+  EXPECT_EQ((*batch)[1].name, "read1");
+  batch = reader->NextBatch(2);
+  ASSERT_THAT(batch, IsOk());
+  EXPECT_EQ(batch->size(), 1);
+  batch = reader->NextBatch(2);
+  ASSERT_THAT(batch, IsOk());
+  EXPECT_TRUE(batch->empty());
+}
+
+TEST(ParallelFastqReader, Empty) {
+  std::unique_ptr<ParallelFastqReader> reader =
+      *ParallelFastqReader::New("bio/fastq/testdata/empty.fastq");
+  EXPECT_THAT(reader->Next(), IsOk());
+  EXPECT_EQ(*reader->Next(), std::nullopt);
+}
+
+TEST(ParallelFastqReader, MalformedRecord) {
+  const std::vector<FastqSequence> records = MakeRecords(100);
+  const std::string contents =
+      absl::StrCat(Format(std::vector<FastqSequence>(records.begin(),
+                                                     records.begin() + 60)),
+                   "@broken\nACGT\nIIII\n",
+                   Format(std::vector<FastqSequence>(records.begin() + 60,
+                                                     records.end())));
+  const std::string path = WriteTempFile("malformed.fastq", contents);
+  for (size_t chunk_size : {5, 256, 1 << 20}) {
+    std::unique_ptr<ParallelFastqReader> reader = *ParallelFastqReader::New(
+        path, {.num_threads = 2, .chunk_size = chunk_size});
+    for (int i = 0; i < 60; ++i) {
+      ASSERT_THAT(reader->Next(), IsOk()) << chunk_size << " " << i;
+    }
+    EXPECT_THAT(reader->Next(),
+                StatusIs(absl::StatusCode::kInvalidArgument))
+        << chunk_size;
+    EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kInvalidArgument));
+  }
+}
+
+TEST(ParallelFastqReader, MismatchedQualityLength) {
+  std::unique_ptr<ParallelFastqReader> reader = *ParallelFastqReader::New(
+      "bio/fastq/testdata/invalid-quality-line-length.fastq");
+  EXPECT_THAT(
+      reader->Next(),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("Sequence line length 36 does not match quality "
+                         "line length 3")));
+}
+
+TEST(ParallelFastqReader, TrailingGarbage) {
+  const std::string contents =
+      absl::StrCat(Format(MakeRecords(20)), "not a record\n");
+  const std::string path = WriteTempFile("trailing.fastq", contents);
+  for (size_t chunk_size : {4, 1 << 20}) {
+    std::unique_ptr<ParallelFastqReader> reader =
+        *ParallelFastqReader::New(path, {.chunk_size = chunk_size});
+    EXPECT_THAT(ReadAll(reader.get()),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Expected sequence identifier line")))
+        << chunk_size;
+  }
+}
+
+TEST(ParallelFastqReader, MissingFile) {
+  EXPECT_THAT(
+      ParallelFastqReader::New(gxl::JoinPath(TempDir(), "absent.fastq")),
+      StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
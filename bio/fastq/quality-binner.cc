@@ -0,0 +1,111 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/quality-binner.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "bio/common/byte-translator.h"
+
+namespace bio {
+namespace {
+
+// The highest Phred score that can be represented with offset 33.
+static constexpr int kMaxQuality = 93;
+
+}  // namespace
+
+auto QualityBinner::New(const std::vector<QualityBin>& bins,
+                        int quality_offset) -> absl::StatusOr<QualityBinner> {
+  if (quality_offset < 0 || quality_offset + kMaxQuality > 255) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid quality offset: %d", quality_offset));
+  }
+  if (bins.empty() || bins.front().min_quality != 0) {
+    return absl::InvalidArgumentError("The first bin must start at 0");
+  }
+  for (size_t i = 0; i < bins.size(); ++i) {
+    const QualityBin& bin = bins[i];
+    if (bin.min_quality > kMaxQuality || bin.value < 0 ||
+        bin.value > kMaxQuality) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Bin %d: Scores must be between 0 and %d", i, kMaxQuality));
+    }
+    if (i > 0 && bin.min_quality <= bins[i - 1].min_quality) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Bin %d: Bins must be sorted by minimum score", i));
+    }
+  }
+
+  std::array<uint8_t, 256> table;
+  for (size_t i = 0; i < table.size(); ++i) {
+    table[i] = static_cast<uint8_t>(i);
+  }
+  size_t bin = 0;
+  for (int quality = 0; quality <= kMaxQuality; ++quality) {
+    while (bin + 1 < bins.size() && bins[bin + 1].min_quality <= quality) {
+      ++bin;
+    }
+    table[quality_offset + quality] =
+        static_cast<uint8_t>(quality_offset + bins[bin].value);
+  }
+  return QualityBinner(ByteTranslator(table), quality_offset);
+}
+
+auto QualityBinner::Illumina8(int quality_offset) -> QualityBinner {
+  absl::StatusOr<QualityBinner> binner = New(
+      {
+          {.min_quality = 0, .value = 0},
+          {.min_quality = 2, .value = 6},
+          {.min_quality = 10, .value = 15},
+          {.min_quality = 20, .value = 22},
+          {.min_quality = 25, .value = 27},
+          {.min_quality = 30, .value = 33},
+          {.min_quality = 35, .value = 37},
+          {.min_quality = 40, .value = 40},
+      },
+      quality_offset);
+  CHECK_OK(binner.status());
+  return *std::move(binner);
+}
+
+auto QualityBinner::Illumina4(int quality_offset) -> QualityBinner {
+  absl::StatusOr<QualityBinner> binner = New(
+      {
+          {.min_quality = 0, .value = 2},
+          {.min_quality = 3, .value = 12},
+          {.min_quality = 15, .value = 23},
+          {.min_quality = 31, .value = 37},
+      },
+      quality_offset);
+  CHECK_OK(binner.status());
+  return *std::move(binner);
+}
+
+auto QualityBinner::Bin(int quality) const -> int {
+  if (quality < 0 || quality > kMaxQuality) {
+    return quality;
+  }
+  return translator_.table()[quality_offset_ + quality] - quality_offset_;
+}
+
+}  // namespace bio
@@ -0,0 +1,105 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_QUALITY_BINNER_H_
+#define BIO_FASTQ_QUALITY_BINNER_H_
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "bio/common/byte-translator.h"
+#include "bio/fastq/fastq.h"
+
+namespace bio {
+
+// A range of Phred scores that are replaced by a single score.
+struct QualityBin {
+  // The lowest score in the bin. The bin extends up to the next bin's
+  // `min_quality`, or to the highest score for the last bin.
+  int min_quality;
+
+  // The score that replaces every score in the bin.
+  int value;
+};
+
+// Reduces the resolution of FASTQ quality scores by replacing each score with
+// the representative score of its bin. Binned quality strings compress much
+// better, at a small cost in variant calling accuracy.
+//
+// Quality characters are remapped through a lookup table with
+// ByteTranslator. Characters outside the range of Phred scores 0 to 93 are
+// left unchanged.
+//
+// Example usage:
+//
+// ```
+// const QualityBinner binner = QualityBinner::Illumina8();
+// while (!parser->eof()) {
+//   ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+//   if (read == nullptr) {
+//     break;
+//   }
+//   binner.Bin(read.get());
+//   RETURN_IF_ERROR(writer->Write(*read));
+// }
+// ```
+class QualityBinner {
+ public:
+  // Constructs a binner from `bins`, which must be sorted by `min_quality`
+  // with the first bin starting at score 0. Scores must be between 0 and 93.
+  static auto New(const std::vector<QualityBin>& bins, int quality_offset = 33)
+      -> absl::StatusOr<QualityBinner>;
+
+  // Illumina's 8-level binning: 0-1, 2-9, 10-19, 20-24, 25-29, 30-34, 35-39
+  // and 40+ map to 0, 6, 15, 22, 27, 33, 37 and 40.
+  static auto Illumina8(int quality_offset = 33) -> QualityBinner;
+
+  // 4-level binning as produced by NovaSeq instruments: 0-2, 3-14, 15-30 and
+  // 31+ map to 2, 12, 23 and 37.
+  static auto Illumina4(int quality_offset = 33) -> QualityBinner;
+
+  // Returns the binned Phred score of `quality`.
+  auto Bin(int quality) const -> int;
+
+  // Bins the quality characters of `quality` in place.
+  auto Bin(absl::Nonnull<std::string*> quality) const -> void {
+    translator_.Translate(quality);
+  }
+
+  // Bins the quality scores of `read` in place.
+  auto Bin(absl::Nonnull<FastqSequence*> read) const -> void {
+    Bin(&read->quality);
+  }
+
+  // Bins the quality scores of `reads` in place.
+  auto Bin(absl::Nonnull<std::vector<FastqSequence>*> reads) const -> void {
+    for (FastqSequence& read : *reads) {
+      Bin(&read.quality);
+    }
+  }
+
+ private:
+  QualityBinner(const ByteTranslator& translator, int quality_offset)
+      : translator_(translator), quality_offset_(quality_offset) {}
+
+  ByteTranslator translator_;
+  int quality_offset_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_QUALITY_BINNER_H_
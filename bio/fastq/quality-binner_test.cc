@@ -0,0 +1,110 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/quality-binner.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/fastq/fastq.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+TEST(QualityBinner, Illumina8) {
+  const QualityBinner binner = QualityBinner::Illumina8();
+  EXPECT_EQ(binner.Bin(0), 0);
+  EXPECT_EQ(binner.Bin(1), 0);
+  EXPECT_EQ(binner.Bin(2), 6);
+  EXPECT_EQ(binner.Bin(9), 6);
+  EXPECT_EQ(binner.Bin(10), 15);
+  EXPECT_EQ(binner.Bin(24), 22);
+  EXPECT_EQ(binner.Bin(25), 27);
+  EXPECT_EQ(binner.Bin(34), 33);
+  EXPECT_EQ(binner.Bin(39), 37);
+  EXPECT_EQ(binner.Bin(41), 40);
+  EXPECT_EQ(binner.Bin(93), 40);
+}
+
+TEST(QualityBinner, Illumina4) {
+  const QualityBinner binner = QualityBinner::Illumina4();
+  EXPECT_EQ(binner.Bin(0), 2);
+  EXPECT_EQ(binner.Bin(14), 12);
+  EXPECT_EQ(binner.Bin(15), 23);
+  EXPECT_EQ(binner.Bin(31), 37);
+}
+
+TEST(QualityBinner, BinsRead) {
+  const QualityBinner binner = QualityBinner::Illumina8();
+  FastqSequence read = {
+      .name = "read",
+      .sequence = "ACGTACGTACGTACGTACGTN",
+      .quality = "IIIIIIIIII:::::++++\"#",
+  };
+  binner.Bin(&read);
+  // I = 40, : = 25, + = 10, " = 1, # = 2.
+  EXPECT_EQ(read.quality, "IIIIIIIIII<<<<<0000!'");
+  EXPECT_EQ(read.sequence, "ACGTACGTACGTACGTACGTN");
+}
+
+TEST(QualityBinner, QualityOffset) {
+  const QualityBinner binner = QualityBinner::Illumina8(/*quality_offset=*/64);
+  std::string quality = "@Jhi";
+  binner.Bin(&quality);
+  // 0, 10, 40 and 41.
+  EXPECT_EQ(quality, "@Ohh");
+  // Characters below the offset are left unchanged.
+  quality = "!";
+  binner.Bin(&quality);
+  EXPECT_EQ(quality, "!");
+}
+
+TEST(QualityBinner, Custom) {
+  absl::StatusOr<QualityBinner> binner = QualityBinner::New(
+      {{.min_quality = 0, .value = 5}, {.min_quality = 20, .value = 30}});
+  ASSERT_THAT(binner, IsOk());
+  std::vector<FastqSequence> reads = {
+      {.name = "a", .sequence = "AC", .quality = "!5"},
+      {.name = "b", .sequence = "G", .quality = "~"},
+  };
+  binner->Bin(&reads);
+  EXPECT_EQ(reads[0].quality, "&?");
+  EXPECT_EQ(reads[1].quality, "?");
+}
+
+TEST(QualityBinner, InvalidBins) {
+  EXPECT_THAT(QualityBinner::New({}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(QualityBinner::New({{.min_quality = 1, .value = 1}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(QualityBinner::New({{.min_quality = 0, .value = 0},
+                                  {.min_quality = 10, .value = 10},
+                                  {.min_quality = 5, .value = 5}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(QualityBinner::New({{.min_quality = 0, .value = 94}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(QualityBinner::New({{.min_quality = 0, .value = 0}},
+                                 /*quality_offset=*/200),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace bio
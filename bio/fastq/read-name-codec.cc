@@ -0,0 +1,203 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/read-name-codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/varint.h"
+
+namespace bio {
+namespace {
+
+// The operations of an encoded name, one byte per token. Byte values above
+// kString add `byte - kString` to the integer at the same position of the
+// previous name.
+static constexpr uint8_t kEnd = 0;
+static constexpr uint8_t kMatch = 1;
+static constexpr uint8_t kInteger = 2;
+static constexpr uint8_t kString = 3;
+static constexpr uint64_t kMaxDelta = 255 - kString;
+
+// The maximum number of digits of an integer token, so that it fits in 64
+// bits.
+static constexpr size_t kMaxIntegerDigits = 18;
+
+auto TokenText(absl::string_view name, const ReadNameToken& token)
+    -> absl::string_view {
+  return name.substr(token.start, token.size);
+}
+
+}  // namespace
+
+auto TokenizeReadName(absl::string_view name,
+                      absl::Nonnull<std::vector<ReadNameToken>*> tokens)
+    -> void {
+  tokens->clear();
+  size_t i = 0;
+  while (i < name.size()) {
+    ReadNameToken token = {.start = i};
+    if (!absl::ascii_isalnum(name[i])) {
+      token.size = 1;
+      tokens->push_back(token);
+      ++i;
+      continue;
+    }
+    bool digits = true;
+    while (i < name.size() && absl::ascii_isalnum(name[i])) {
+      digits = digits && absl::ascii_isdigit(name[i]);
+      ++i;
+    }
+    token.size = i - token.start;
+    if (digits && token.size <= kMaxIntegerDigits &&
+        (token.size == 1 || name[token.start] != '0')) {
+      token.is_integer = true;
+      for (char digit : TokenText(name, token)) {
+        token.value = token.value * 10 + (digit - '0');
+      }
+    }
+    tokens->push_back(token);
+  }
+}
+
+auto ReadNameEncoder::Encode(absl::string_view name,
+                             absl::Nonnull<std::string*> out) -> void {
+  TokenizeReadName(name, &tokens_);
+  const auto matches = [&](size_t i) {
+    return i < previous_tokens_.size() &&
+           TokenText(name, tokens_[i]) ==
+               TokenText(previous_, previous_tokens_[i]);
+  };
+  size_t prefix = 0;
+  while (prefix < tokens_.size() && matches(prefix)) {
+    ++prefix;
+  }
+  AppendVarint(prefix, out);
+  for (size_t i = prefix; i < tokens_.size(); ++i) {
+    const ReadNameToken& token = tokens_[i];
+    if (matches(i)) {
+      out->push_back(static_cast<char>(kMatch));
+      continue;
+    }
+    if (token.is_integer) {
+      if (i < previous_tokens_.size() && previous_tokens_[i].is_integer &&
+          token.value > previous_tokens_[i].value &&
+          token.value - previous_tokens_[i].value <= kMaxDelta) {
+        out->push_back(static_cast<char>(
+            kString + (token.value - previous_tokens_[i].value)));
+      } else {
+        out->push_back(static_cast<char>(kInteger));
+        AppendVarint(token.value, out);
+      }
+      continue;
+    }
+    out->push_back(static_cast<char>(kString));
+    AppendVarint(token.size, out);
+    out->append(TokenText(name, token));
+  }
+  out->push_back(static_cast<char>(kEnd));
+  previous_ = std::string(name);
+  std::swap(previous_tokens_, tokens_);
+}
+
+auto ReadNameEncoder::Reset() -> void {
+  previous_.clear();
+  previous_tokens_.clear();
+}
+
+auto ReadNameDecoder::Decode(absl::Nonnull<absl::string_view*> data)
+    -> absl::StatusOr<std::string> {
+  std::optional<uint64_t> prefix = ConsumeVarint(data);
+  if (!prefix.has_value() || *prefix > previous_tokens_.size()) {
+    return absl::DataLossError("Invalid read name prefix");
+  }
+  std::string name;
+  tokens_.assign(previous_tokens_.begin(), previous_tokens_.begin() + *prefix);
+  if (!tokens_.empty()) {
+    name = previous_.substr(0, tokens_.back().start + tokens_.back().size);
+  }
+  const auto add_token = [&name, this](absl::string_view text, bool is_integer,
+                                       uint64_t value) {
+    tokens_.push_back({.start = name.size(),
+                       .size = text.size(),
+                       .is_integer = is_integer,
+                       .value = value});
+    name.append(text);
+  };
+
+  while (true) {
+    if (data->empty()) {
+      return absl::DataLossError("Truncated read name");
+    }
+    const uint8_t op = static_cast<uint8_t>(data->front());
+    data->remove_prefix(1);
+    if (op == kEnd) {
+      break;
+    }
+    const size_t i = tokens_.size();
+    const ReadNameToken* previous =
+        i < previous_tokens_.size() ? &previous_tokens_[i] : nullptr;
+    if (op == kMatch) {
+      if (previous == nullptr) {
+        return absl::DataLossError(
+            absl::StrFormat("Read name token %d has no previous token", i));
+      }
+      add_token(TokenText(previous_, *previous), previous->is_integer,
+                previous->value);
+    } else if (op == kInteger) {
+      std::optional<uint64_t> value = ConsumeVarint(data);
+      if (!value.has_value()) {
+        return absl::DataLossError("Truncated read name integer");
+      }
+      add_token(absl::StrCat(*value), true, *value);
+    } else if (op == kString) {
+      std::optional<uint64_t> size = ConsumeVarint(data);
+      if (!size.has_value() || *size > data->size()) {
+        return absl::DataLossError("Truncated read name string");
+      }
+      add_token(data->substr(0, *size), false, 0);
+      data->remove_prefix(*size);
+    } else {
+      if (previous == nullptr || !previous->is_integer) {
+        return absl::DataLossError(absl::StrFormat(
+            "Read name token %d has no previous integer token", i));
+      }
+      const uint64_t value = previous->value + (op - kString);
+      add_token(absl::StrCat(value), true, value);
+    }
+  }
+  previous_ = name;
+  std::swap(previous_tokens_, tokens_);
+  return name;
+}
+
+auto ReadNameDecoder::Reset() -> void {
+  previous_.clear();
+  previous_tokens_.clear();
+}
+
+}  // namespace bio
@@ -0,0 +1,113 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_READ_NAME_CODEC_H_
+#define BIO_FASTQ_READ_NAME_CODEC_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace bio {
+
+// A token of a read name: a run of letters and digits, or a single other
+// character. Runs of at most 18 digits without a leading zero are integers.
+struct ReadNameToken {
+  // The position of the token in the name.
+  size_t start = 0;
+  size_t size = 0;
+
+  // Whether the token is an integer, and its value if so.
+  bool is_integer = false;
+  uint64_t value = 0;
+};
+
+// Splits `name` into tokens. For example, the name
+// "A00123:8:H7KLMDSXX:1:1101:10004:1000" has the tokens "A00123", ":", 8, ":",
+// "H7KLMDSXX", ":", 1, ":", 1101, ":", 10004, ":" and 1000.
+auto TokenizeReadName(absl::string_view name,
+                      absl::Nonnull<std::vector<ReadNameToken>*> tokens)
+    -> void;
+
+// Encodes read names against the previous name.
+//
+// Each name is encoded as the number of leading tokens that match the previous
+// name, followed by one operation per remaining token: match the token at the
+// same position of the previous name, add a small delta to it, or store a
+// literal integer or string. Names from the same run typically differ only in
+// their last few integers, so most names take a few bytes before any further
+// compression.
+//
+// Example usage:
+//
+// ```
+// ReadNameEncoder encoder;
+// std::string encoded;
+// for (const FastqSequence& read : reads) {
+//   encoder.Encode(read.name, &encoded);
+// }
+// ```
+class ReadNameEncoder {
+ public:
+  // Appends the encoding of `name` to `out`.
+  auto Encode(absl::string_view name, absl::Nonnull<std::string*> out)
+      -> void;
+
+  // Forgets the previous name, so that the next name is encoded on its own.
+  auto Reset() -> void;
+
+ private:
+  std::string previous_;
+  std::vector<ReadNameToken> previous_tokens_;
+  std::vector<ReadNameToken> tokens_;
+};
+
+// Decodes read names encoded by ReadNameEncoder, one at a time. The decoder
+// must see the names in the order they were encoded, starting from the first
+// name after the encoder was created or reset.
+//
+// Example usage:
+//
+// ```
+// ReadNameDecoder decoder;
+// absl::string_view data = encoded;
+// while (!data.empty()) {
+//   ASSIGN_OR_RETURN(std::string name, decoder.Decode(&data));
+//   ...
+// }
+// ```
+class ReadNameDecoder {
+ public:
+  // Decodes the next name from the start of `data` and removes its encoding
+  // from `data`. Returns a DataLoss error if the encoding is invalid.
+  auto Decode(absl::Nonnull<absl::string_view*> data)
+      -> absl::StatusOr<std::string>;
+
+  // Forgets the previous name, to match ReadNameEncoder::Reset.
+  auto Reset() -> void;
+
+ private:
+  std::string previous_;
+  std::vector<ReadNameToken> previous_tokens_;
+  std::vector<ReadNameToken> tokens_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_READ_NAME_CODEC_H_
@@ -0,0 +1,149 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/read-name-codec.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+
+auto Encode(const std::vector<std::string>& names) -> std::string {
+  ReadNameEncoder encoder;
+  std::string encoded;
+  for (const std::string& name : names) {
+    encoder.Encode(name, &encoded);
+  }
+  return encoded;
+}
+
+auto ExpectRoundTrip(const std::vector<std::string>& names) -> void {
+  const std::string encoded = Encode(names);
+  ReadNameDecoder decoder;
+  absl::string_view data = encoded;
+  for (const std::string& name : names) {
+    EXPECT_THAT(decoder.Decode(&data), IsOkAndHolds(name));
+  }
+  EXPECT_TRUE(data.empty());
+}
+
+TEST(TokenizeReadName, SplitsIntegersAndStrings) {
+  const std::string name = "A00123:8:H7KLMDSXX:1:1101:10004:1000 1:N:0:0";
+  std::vector<ReadNameToken> tokens;
+  TokenizeReadName(name, &tokens);
+  std::vector<std::string> texts;
+  std::vector<bool> integers;
+  for (const ReadNameToken& token : tokens) {
+    texts.push_back(name.substr(token.start, token.size));
+    integers.push_back(token.is_integer);
+  }
+  EXPECT_THAT(texts, ElementsAre("A00123", ":", "8", ":", "H7KLMDSXX", ":",
+                                 "1", ":", "1101", ":", "10004", ":", "1000",
+                                 " ", "1", ":", "N", ":", "0", ":", "0"));
+  EXPECT_THAT(integers,
+              ElementsAre(false, false, true, false, false, false, true, false,
+                          true, false, true, false, true, false, true, false,
+                          false, false, true, false, true));
+  EXPECT_EQ(tokens[10].value, 10004);
+}
+
+TEST(TokenizeReadName, KeepsLeadingZerosAndLongNumbersAsStrings) {
+  std::vector<ReadNameToken> tokens;
+  TokenizeReadName("007/1234567890123456789", &tokens);
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_FALSE(tokens[0].is_integer);
+  EXPECT_FALSE(tokens[2].is_integer);
+}
+
+TEST(ReadNameCodec, RoundTripsIlluminaNames) {
+  std::vector<std::string> names;
+  for (int i = 0; i < 1000; ++i) {
+    names.push_back(absl::StrCat("A00123:8:H7KLMDSXX:", 1 + i / 500, ":",
+                                 1101 + i / 100, ":", 10004 + (i * 37) % 3000,
+                                 ":", 1000 + i * 3));
+  }
+  ExpectRoundTrip(names);
+
+  size_t raw_size = 0;
+  for (const std::string& name : names) {
+    raw_size += name.size() + 1;
+  }
+  EXPECT_LT(Encode(names).size(), raw_size / 5);
+}
+
+TEST(ReadNameCodec, RoundTripsIrregularNames) {
+  ExpectRoundTrip({
+      "SRR001666.1 071112_SLXA-EAS1_s_7:5:1:817:345 length=36",
+      "SRR001666.2 071112_SLXA-EAS1_s_7:5:1:801:338 length=36",
+      "SRR001666.10 071112_SLXA-EAS1_s_7:5:1:801:338 length=72",
+      "",
+      "read/1",
+      "read/1",
+      "read_0000/2",
+      "read_0001",
+      "m64011_190830_220126/1/ccs",
+      "18446744073709551615",
+      "999999999999999999:1",
+      "999999999999999999:2:extra",
+      "x",
+  });
+}
+
+TEST(ReadNameCodec, ResetMakesNamesIndependent) {
+  ReadNameEncoder encoder;
+  std::string first;
+  encoder.Encode("instrument:1:100", &first);
+  encoder.Reset();
+  std::string second;
+  encoder.Encode("instrument:1:101", &second);
+
+  ReadNameDecoder decoder;
+  absl::string_view data = second;
+  EXPECT_THAT(decoder.Decode(&data), IsOkAndHolds("instrument:1:101"));
+}
+
+TEST(ReadNameCodec, RejectsInvalidEncodings) {
+  const std::string encoded = Encode({"instrument:1:100", "instrument:1:101"});
+  for (size_t size = 0; size < encoded.size(); ++size) {
+    ReadNameDecoder decoder;
+    absl::string_view data = absl::string_view(encoded).substr(0, size);
+    absl::Status status = decoder.Decode(&data).status();
+    if (status.ok()) {
+      status = decoder.Decode(&data).status();
+    }
+    EXPECT_THAT(status, StatusIs(absl::StatusCode::kDataLoss)) << size;
+  }
+
+  // The second name refers to tokens of a first name that was never decoded.
+  ReadNameDecoder decoder;
+  absl::string_view data = absl::string_view(encoded).substr(
+      Encode({"instrument:1:100"}).size());
+  EXPECT_THAT(decoder.Decode(&data), StatusIs(absl::StatusCode::kDataLoss));
+}
+
+}  // namespace
+}  // namespace bio
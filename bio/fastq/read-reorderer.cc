@@ -0,0 +1,773 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/read-reorderer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/types/span.h"
+#include "bio/common/sequence.h"
+#include "bio/common/temp-file.h"
+#include "bio/common/varint.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "bio/kmer/kmer-iterator.h"
+#include "bio/kmer/kmer.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The number of buckets that reads are distributed into, and that an
+// oversized bucket is split into.
+static constexpr int kNumBucketBits = 8;
+static constexpr size_t kNumBuckets = size_t{1} << kNumBucketBits;
+
+// The magic number at the start of permutation files.
+static constexpr absl::string_view kPermutationMagic("BIOPERM\1", 8);
+
+// The size of the buffers used to read and write permutation files.
+static constexpr size_t kPermutationBufferSize = 1 << 20;
+
+// The size of the chunks in which spill files are streamed.
+static constexpr size_t kSpillReadSize = 1 << 16;
+
+// The sort key of a read.
+struct ReadKey {
+  // The hash of the minimizer.
+  uint64_t hash = std::numeric_limits<uint64_t>::max();
+
+  // The order among reads with the same minimizer.
+  uint64_t order = std::numeric_limits<uint64_t>::max();
+
+  auto operator<(const ReadKey& rhs) const -> bool {
+    return std::tie(hash, order) < std::tie(rhs.hash, rhs.order);
+  }
+
+  auto operator==(const ReadKey& rhs) const -> bool {
+    return std::tie(hash, order) == std::tie(rhs.hash, rhs.order);
+  }
+};
+
+// A record of a bucket, with its key.
+struct BucketEntry {
+  ReadKey key;
+  absl::string_view record;
+};
+
+// Appends `record` and its key to `out`: the hash as 8 bytes, then the order
+// and the size of the record as varints.
+auto AppendEntry(const ReadKey& key, absl::string_view record,
+                 std::string* out) -> void {
+  out->append(reinterpret_cast<const char*>(&key.hash), sizeof(key.hash));
+  AppendVarint(key.order, out);
+  AppendVarint(record.size(), out);
+  out->append(record);
+}
+
+// Removes the next entry appended by AppendEntry() from the front of `data`.
+// Returns std::nullopt, leaving `data` unchanged, if `data` does not hold a
+// whole entry.
+auto ConsumeEntry(absl::string_view* data) -> std::optional<BucketEntry> {
+  BucketEntry entry;
+  absl::string_view rest = *data;
+  if (rest.size() < sizeof(entry.key.hash)) {
+    return std::nullopt;
+  }
+  std::memcpy(&entry.key.hash, rest.data(), sizeof(entry.key.hash));
+  rest.remove_prefix(sizeof(entry.key.hash));
+  const std::optional<uint64_t> order = ConsumeVarint(&rest);
+  if (!order.has_value()) {
+    return std::nullopt;
+  }
+  const std::optional<uint64_t> size = ConsumeVarint(&rest);
+  if (!size.has_value() || *size > rest.size()) {
+    return std::nullopt;
+  }
+  entry.key.order = *order;
+  entry.record = rest.substr(0, *size);
+  rest.remove_prefix(*size);
+  *data = rest;
+  return entry;
+}
+
+// Records grouped into buckets, which are visited in order, each by
+// increasing key and then in the order the records were added. The keys of a
+// bucket must all be above those of the previous buckets.
+//
+// Records are buffered in memory until their total size reaches a budget,
+// and then all buckets are spilled to one temporary file each. A bucket that
+// fits in the budget is sorted in memory when it is visited. A larger one is
+// streamed into kNumBuckets parts on the next bits of its keys below those
+// that all its keys share, and each part is visited in turn the same way.
+// Parts whose records all have the same key, such as reads without any
+// k-mer, are streamed in the order the records were added.
+class BucketStore {
+ public:
+  BucketStore(size_t max_memory, absl::string_view temp_dir)
+      : max_memory_(max_memory), temp_dir_(temp_dir), buckets_(kNumBuckets) {}
+
+  BucketStore(const BucketStore&) = delete;
+  auto operator=(const BucketStore&) -> BucketStore& = delete;
+
+  // Appends `record` with `key` to `bucket`.
+  auto Add(size_t bucket, const ReadKey& key, absl::string_view record)
+      -> absl::Status {
+    buffered_ += Append(&buckets_[bucket], key, record);
+    if (buffered_ >= max_memory_) {
+      return Spill();
+    }
+    return absl::OkStatus();
+  }
+
+  // Calls `fn(key, record)` for every record, in bucket order, and removes
+  // the records from the store. Stops at the first error that `fn` returns.
+  template <typename Fn>
+  auto Visit(Fn fn) -> absl::Status {
+    // Once anything has been spilled, spill the rest as well, so that only
+    // the bucket being visited is held in memory.
+    if (spilled_) {
+      RETURN_IF_ERROR(Spill());
+      for (Partition& bucket : buckets_) {
+        RETURN_IF_ERROR(Close(&bucket));
+      }
+    }
+    for (Partition& bucket : buckets_) {
+      RETURN_IF_ERROR(Resolve(&bucket, fn));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  // A bucket or part of one. Its records are in its spill file, if any,
+  // followed by its buffer.
+  struct Partition {
+    Partition() = default;
+
+    // Removes the spill file.
+    ~Partition() { Remove(); }
+
+    Partition(const Partition&) = delete;
+    auto operator=(const Partition&) -> Partition& = delete;
+
+    // Closes and removes the spill file, and clears the buffer.
+    auto Remove() -> void {
+      if (file != nullptr) {
+        file->Close(gxl::file::Defaults()).IgnoreError();
+        file = nullptr;
+      }
+      if (!path.empty()) {
+        std::remove(path.c_str());
+        path.clear();
+      }
+      std::string().swap(buffer);
+    }
+
+    std::string path;
+    gxl::File* file = nullptr;
+    std::string buffer;
+
+    // The number and total size of the records, spilled or not.
+    uint64_t num_records = 0;
+    size_t size = 0;
+
+    // The smallest and largest keys of the records.
+    ReadKey min_key;
+    ReadKey max_key = {.hash = 0, .order = 0};
+  };
+
+  // Appends `record` with `key` to the buffer of `partition`, and returns the
+  // number of bytes appended.
+  static auto Append(Partition* partition, const ReadKey& key,
+                     absl::string_view record) -> size_t {
+    const size_t size = partition->buffer.size();
+    AppendEntry(key, record, &partition->buffer);
+    const size_t appended = partition->buffer.size() - size;
+    ++partition->num_records;
+    partition->size += appended;
+    partition->min_key = std::min(partition->min_key, key);
+    partition->max_key = std::max(partition->max_key, key);
+    return appended;
+  }
+
+  // Appends the buffer of `partition` to its spill file.
+  auto Write(Partition* partition) -> absl::Status {
+    if (partition->buffer.empty()) {
+      return absl::OkStatus();
+    }
+    if (partition->file == nullptr) {
+      partition->path = TempFilePath(temp_dir_, "bio-reorder");
+      RETURN_IF_ERROR(gxl::Open(partition->path, "w", &partition->file,
+                                gxl::file::Defaults()));
+    }
+    const size_t size = partition->file->WriteString(partition->buffer);
+    if (size != partition->buffer.size()) {
+      return absl::DataLossError(
+          absl::StrFormat("%s: Expected to write %d bytes but wrote %d",
+                          partition->path, partition->buffer.size(), size));
+    }
+    partition->buffer.clear();
+    return absl::OkStatus();
+  }
+
+  // Closes the spill file of `partition` for writing, keeping it on disk.
+  static auto Close(Partition* partition) -> absl::Status {
+    if (partition->file == nullptr) {
+      return absl::OkStatus();
+    }
+    return std::exchange(partition->file, nullptr)
+        ->Close(gxl::file::Defaults());
+  }
+
+  // Appends the buffered records of every bucket to its spill file.
+  auto Spill() -> absl::Status {
+    for (Partition& bucket : buckets_) {
+      RETURN_IF_ERROR(Write(&bucket));
+    }
+    buffered_ = 0;
+    spilled_ = true;
+    return absl::OkStatus();
+  }
+
+  // Calls `fn(entry)` for each entry of `partition` in the order they were
+  // added, streaming its spill file.
+  template <typename Fn>
+  static auto ForEachEntry(Partition* partition, Fn fn) -> absl::Status {
+    RETURN_IF_ERROR(Close(partition));
+    if (!partition->path.empty()) {
+      gxl::File* file;
+      RETURN_IF_ERROR(
+          gxl::Open(partition->path, "r", &file, gxl::file::Defaults()));
+      std::string buffer;
+      size_t offset = 0;
+      bool eof = false;
+      absl::Status status;
+      while (status.ok()) {
+        absl::string_view data = absl::string_view(buffer).substr(offset);
+        if (std::optional<BucketEntry> entry = ConsumeEntry(&data)) {
+          status = fn(*entry);
+          offset = buffer.size() - data.size();
+          continue;
+        }
+        if (eof) {
+          if (!data.empty()) {
+            status = absl::DataLossError(absl::StrFormat(
+                "%s: Truncated record in spill file", partition->path));
+          }
+          break;
+        }
+        buffer.erase(0, offset);
+        offset = 0;
+        const size_t size = buffer.size();
+        buffer.resize(size + kSpillReadSize);
+        const size_t read = file->Read(&buffer[size], kSpillReadSize);
+        buffer.resize(size + read);
+        eof = read < kSpillReadSize;
+      }
+      const absl::Status close_status = file->Close(gxl::file::Defaults());
+      RETURN_IF_ERROR(status);
+      RETURN_IF_ERROR(close_status);
+    }
+    for (absl::string_view data = partition->buffer; !data.empty();) {
+      const std::optional<BucketEntry> entry = ConsumeEntry(&data);
+      if (!entry.has_value()) {
+        return absl::DataLossError("Corrupt record in bucket");
+      }
+      RETURN_IF_ERROR(fn(*entry));
+    }
+    return absl::OkStatus();
+  }
+
+  // Visits the records of `partition` as described for the class, and
+  // removes them.
+  template <typename Fn>
+  auto Resolve(Partition* partition, Fn& fn) -> absl::Status {
+    if (partition->num_records == 0) {
+      return absl::OkStatus();
+    }
+    const ReadKey min_key = partition->min_key;
+    const ReadKey max_key = partition->max_key;
+    if (min_key == max_key) {
+      RETURN_IF_ERROR(ForEachEntry(partition, [&](const BucketEntry& entry) {
+        return fn(entry.key, entry.record);
+      }));
+    } else if (partition->size +
+                   partition->num_records * sizeof(BucketEntry) <=
+               max_memory_) {
+      std::string records;
+      RETURN_IF_ERROR(Close(partition));
+      if (!partition->path.empty()) {
+        RETURN_IF_ERROR(gxl::GetContents(partition->path, &records,
+                                         gxl::file::Defaults()));
+      }
+      records.append(partition->buffer);
+      partition->Remove();
+      std::vector<BucketEntry> entries;
+      entries.reserve(partition->num_records);
+      for (absl::string_view data = records; !data.empty();) {
+        const std::optional<BucketEntry> entry = ConsumeEntry(&data);
+        if (!entry.has_value()) {
+          return absl::DataLossError("Corrupt record in spill file");
+        }
+        entries.push_back(*entry);
+      }
+      std::stable_sort(entries.begin(), entries.end(),
+                       [](const BucketEntry& lhs, const BucketEntry& rhs) {
+                         return lhs.key < rhs.key;
+                       });
+      for (const BucketEntry& entry : entries) {
+        RETURN_IF_ERROR(fn(entry.key, entry.record));
+      }
+    } else {
+      // Split on the highest bits of the hash that differ between the keys,
+      // or of the order if the keys all share their hash.
+      const bool by_hash = min_key.hash != max_key.hash;
+      const uint64_t differing = by_hash ? min_key.hash ^ max_key.hash
+                                         : min_key.order ^ max_key.order;
+      const int shift = std::max(
+          static_cast<int>(std::bit_width(differing)) - kNumBucketBits, 0);
+      // Share half of the budget between the buffers of the parts.
+      const size_t part_buffer_size = max_memory_ / (2 * kNumBuckets);
+      std::vector<Partition> parts(kNumBuckets);
+      RETURN_IF_ERROR(ForEachEntry(
+          partition, [&](const BucketEntry& entry) -> absl::Status {
+            const uint64_t value = by_hash ? entry.key.hash : entry.key.order;
+            Partition* part = &parts[(value >> shift) & (kNumBuckets - 1)];
+            Append(part, entry.key, entry.record);
+            if (part->buffer.size() > part_buffer_size) {
+              return Write(part);
+            }
+            return absl::OkStatus();
+          }));
+      partition->Remove();
+      for (Partition& part : parts) {
+        RETURN_IF_ERROR(Write(&part));
+        RETURN_IF_ERROR(Close(&part));
+      }
+      for (Partition& part : parts) {
+        RETURN_IF_ERROR(Resolve(&part, fn));
+      }
+    }
+    partition->Remove();
+    return absl::OkStatus();
+  }
+
+  size_t max_memory_;
+  std::string temp_dir_;
+  std::vector<Partition> buckets_;
+  size_t buffered_ = 0;
+  bool spilled_ = false;
+};
+
+// Removes the next field appended by AppendMates() from the front of
+// `records`.
+auto ConsumeRecord(absl::string_view* records)
+    -> std::optional<absl::string_view> {
+  const std::optional<uint64_t> size = ConsumeVarint(records);
+  if (!size.has_value() || *size > records->size()) {
+    return std::nullopt;
+  }
+  const absl::string_view record = records->substr(0, *size);
+  records->remove_prefix(*size);
+  return record;
+}
+
+auto AppendMates(absl::Span<const FastqSequence> mates, std::string* out)
+    -> void {
+  for (const FastqSequence& mate : mates) {
+    for (absl::string_view field : {absl::string_view(mate.name),
+                                    absl::string_view(mate.sequence),
+                                    absl::string_view(mate.quality)}) {
+      AppendVarint(field.size(), out);
+      out->append(field);
+    }
+  }
+}
+
+// Decodes the mates appended by AppendMates() into `mates`, which must have
+// the number of mates that were appended.
+auto DecodeMates(absl::string_view data, std::vector<FastqSequence>* mates)
+    -> absl::Status {
+  for (FastqSequence& mate : *mates) {
+    for (std::string* field : {&mate.name, &mate.sequence, &mate.quality}) {
+      const std::optional<absl::string_view> value = ConsumeRecord(&data);
+      if (!value.has_value()) {
+        return absl::DataLossError("Corrupt read in spill file");
+      }
+      field->assign(value->data(), value->size());
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Returns the key of a read whose minimizer is `kmer`. Reads that share a
+// minimizer are ordered by their approximate start on the genome: reads with
+// the minimizer on the sense strand by decreasing position in the read, then
+// reads with it on the antisense strand by increasing position.
+auto MinimizerKey(uint64_t hash, const Kmer& kmer) -> ReadKey {
+  static constexpr uint64_t kAntisense = uint64_t{1} << 62;
+  return {
+      .hash = hash,
+      .order = kmer.strand == Strand::kSense ? kAntisense - 1 - kmer.position
+                                             : kAntisense | kmer.position,
+  };
+}
+
+// Returns the key of the read with the given mates: the key of the smallest
+// minimizer of any mate.
+auto KeyOf(absl::Span<const FastqSequence> mates,
+           const ReadReorderOptions& options) -> ReadKey {
+  ReadKey key;
+  for (const FastqSequence& mate : mates) {
+    KmerIterator kmers(mate.sequence, options.k);
+    for (std::optional<Kmer> kmer = kmers.Next(); kmer.has_value();
+         kmer = kmers.Next()) {
+      const uint64_t hash = HashKmer(kmer->value, options.seed);
+      if (hash <= key.hash) {
+        key = std::min(key, MinimizerKey(hash, *kmer));
+      }
+    }
+  }
+  return key;
+}
+
+// Reads the next read of `parser` into `mates`. Returns false at the end of
+// the file.
+auto NextRead(FastqParser* parser, std::vector<FastqSequence>* mates)
+    -> absl::StatusOr<bool> {
+  if (parser->eof()) {
+    return false;
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> read, parser->Next());
+  if (read == nullptr) {
+    return false;
+  }
+  mates->resize(1);
+  (*mates)[0] = std::move(*read);
+  return true;
+}
+
+// Reads the next pair of `reader` into `mates`. Returns false at the end of
+// the input.
+auto NextRead(PairedFastqReader* reader, std::vector<FastqSequence>* mates)
+    -> absl::StatusOr<bool> {
+  ASSIGN_OR_RETURN(std::optional<FastqPair> pair, reader->Next());
+  if (!pair.has_value()) {
+    return false;
+  }
+  mates->resize(2);
+  (*mates)[0] = std::move(pair->first);
+  (*mates)[1] = std::move(pair->second);
+  return true;
+}
+
+auto WriteMates(absl::Span<const FastqSequence> mates,
+                absl::Span<FastqWriter* const> writers) -> absl::Status {
+  for (size_t i = 0; i < writers.size(); ++i) {
+    RETURN_IF_ERROR(writers[i]->Write(mates[i]));
+  }
+  return absl::OkStatus();
+}
+
+auto WriteString(gxl::File* file, absl::string_view path,
+                 absl::string_view data) -> absl::Status {
+  const size_t size = file->WriteString(data);
+  if (size != data.size()) {
+    return absl::DataLossError(
+        absl::StrFormat("%s: Expected to write %d bytes but wrote %d", path,
+                        data.size(), size));
+  }
+  return absl::OkStatus();
+}
+
+// Reads the indices of a permutation file one at a time.
+class PermutationReader {
+ public:
+  // Opens the permutation file at `path` and reads its header.
+  static auto New(absl::string_view path)
+      -> absl::StatusOr<std::unique_ptr<PermutationReader>> {
+    gxl::File* file;
+    RETURN_IF_ERROR(gxl::Open(path, "r", &file, gxl::file::Defaults()));
+    auto reader =
+        std::unique_ptr<PermutationReader>(new PermutationReader(path, file));
+    reader->Fill();
+    absl::string_view data = reader->data();
+    if (!absl::ConsumePrefix(&data, kPermutationMagic)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("%s: Not a permutation file", path));
+    }
+    const std::optional<uint64_t> size = ConsumeVarint(&data);
+    if (!size.has_value()) {
+      return absl::DataLossError(
+          absl::StrFormat("%s: Truncated permutation header", path));
+    }
+    reader->size_ = *size;
+    reader->offset_ = reader->buffer_.size() - data.size();
+    return reader;
+  }
+
+  ~PermutationReader() { file_->Close(gxl::file::Defaults()).IgnoreError(); }
+
+  PermutationReader(const PermutationReader&) = delete;
+  auto operator=(const PermutationReader&) -> PermutationReader& = delete;
+
+  // Returns the next index.
+  auto Next() -> absl::StatusOr<uint64_t> {
+    Fill();
+    absl::string_view data = this->data();
+    const std::optional<uint64_t> index = ConsumeVarint(&data);
+    if (!index.has_value()) {
+      return absl::DataLossError(
+          absl::StrFormat("%s: Truncated permutation", path_));
+    }
+    offset_ = buffer_.size() - data.size();
+    return *index;
+  }
+
+  // Returns the number of indices in the permutation.
+  auto size() const -> uint64_t { return size_; }
+
+ private:
+  PermutationReader(absl::string_view path, gxl::File* file)
+      : path_(path), file_(file) {}
+
+  // Returns the buffered bytes that have not been consumed.
+  auto data() const -> absl::string_view {
+    return absl::string_view(buffer_).substr(offset_);
+  }
+
+  // Reads more of the file if fewer than a header's worth of bytes are
+  // buffered.
+  auto Fill() -> void {
+    if (eof_ ||
+        buffer_.size() - offset_ >= kPermutationMagic.size() + kMaxVarintSize) {
+      return;
+    }
+    buffer_.erase(0, offset_);
+    offset_ = 0;
+    const size_t size = buffer_.size();
+    buffer_.resize(size + kPermutationBufferSize);
+    const size_t read = file_->Read(&buffer_[size], kPermutationBufferSize);
+    buffer_.resize(size + read);
+    eof_ = read < kPermutationBufferSize;
+  }
+
+  std::string path_;
+  gxl::File* file_;
+  std::string buffer_;
+  size_t offset_ = 0;
+  bool eof_ = false;
+  uint64_t size_ = 0;
+};
+
+// Writes the reads of `store` in key order to `writers` and their indices to
+// `permutation_file`.
+auto WriteSorted(BucketStore* store, gxl::File* permutation_file,
+                 absl::string_view permutation_path, uint64_t num_reads,
+                 absl::Span<FastqWriter* const> writers) -> absl::Status {
+  std::string permutation(kPermutationMagic);
+  AppendVarint(num_reads, &permutation);
+  std::vector<FastqSequence> mates(writers.size());
+  RETURN_IF_ERROR(store->Visit(
+      [&](const ReadKey& key, absl::string_view record) -> absl::Status {
+        const std::optional<uint64_t> index = ConsumeVarint(&record);
+        if (!index.has_value()) {
+          return absl::DataLossError("Corrupt record in spill file");
+        }
+        RETURN_IF_ERROR(DecodeMates(record, &mates));
+        RETURN_IF_ERROR(WriteMates(mates, writers));
+        AppendVarint(*index, &permutation);
+        if (permutation.size() >= kPermutationBufferSize) {
+          RETURN_IF_ERROR(
+              WriteString(permutation_file, permutation_path, permutation));
+          permutation.clear();
+        }
+        return absl::OkStatus();
+      }));
+  return WriteString(permutation_file, permutation_path, permutation);
+}
+
+template <typename Source>
+auto Reorder(Source* source, absl::Span<FastqWriter* const> writers,
+             absl::string_view permutation_path,
+             const ReadReorderOptions& options) -> absl::StatusOr<uint64_t> {
+  if (options.k < 1 || options.k > kMaxKmerLength<uint64_t>) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "k must be between 1 and %d, got %d", kMaxKmerLength<uint64_t>,
+        options.k));
+  }
+
+  // Distribute the reads into buckets by their minimizer.
+  BucketStore store(options.max_memory, options.temp_dir);
+  std::vector<FastqSequence> mates;
+  std::string record;
+  uint64_t num_reads = 0;
+  while (true) {
+    ASSIGN_OR_RETURN(bool more, NextRead(source, &mates));
+    if (!more) {
+      break;
+    }
+    const ReadKey key = KeyOf(mates, options);
+    record.clear();
+    AppendVarint(num_reads++, &record);
+    AppendMates(mates, &record);
+    RETURN_IF_ERROR(
+        store.Add(key.hash >> (64 - kNumBucketBits), key, record));
+  }
+
+  gxl::File* permutation_file;
+  RETURN_IF_ERROR(gxl::Open(permutation_path, "w", &permutation_file,
+                            gxl::file::Defaults()));
+  const absl::Status status =
+      WriteSorted(&store, permutation_file, permutation_path, num_reads,
+                  writers);
+  const absl::Status close_status =
+      permutation_file->Close(gxl::file::Defaults());
+  RETURN_IF_ERROR(status);
+  RETURN_IF_ERROR(close_status);
+  return num_reads;
+}
+
+template <typename Source>
+auto Restore(Source* source, absl::string_view permutation_path,
+             absl::Span<FastqWriter* const> writers,
+             const ReadReorderOptions& options) -> absl::Status {
+  ASSIGN_OR_RETURN(std::unique_ptr<PermutationReader> permutation,
+                   PermutationReader::New(permutation_path));
+  const uint64_t num_reads = permutation->size();
+  const uint64_t reads_per_bucket =
+      std::max<uint64_t>((num_reads + kNumBuckets - 1) / kNumBuckets, 1);
+
+  // Distribute the reads into buckets by their original index.
+  BucketStore store(options.max_memory, options.temp_dir);
+  std::vector<FastqSequence> mates;
+  std::string record;
+  uint64_t position = 0;
+  while (true) {
+    ASSIGN_OR_RETURN(bool more, NextRead(source, &mates));
+    if (!more) {
+      break;
+    }
+    if (position == num_reads) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("%s: Expected %d reads but got more",
+                          permutation_path, num_reads));
+    }
+    ASSIGN_OR_RETURN(uint64_t index, permutation->Next());
+    if (index >= num_reads) {
+      return absl::DataLossError(
+          absl::StrFormat("%s: Index %d is out of range for %d reads",
+                          permutation_path, index, num_reads));
+    }
+    // The reads are keyed by their index alone.
+    record.clear();
+    AppendMates(mates, &record);
+    RETURN_IF_ERROR(store.Add(index / reads_per_bucket,
+                              {.hash = index, .order = 0}, record));
+    ++position;
+  }
+  if (position != num_reads) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("%s: Expected %d reads but got %d", permutation_path,
+                        num_reads, position));
+  }
+
+  // Every read is in range and there are as many reads as indices, so an
+  // index that is not the next one means another index appears twice.
+  uint64_t expected = 0;
+  return store.Visit(
+      [&](const ReadKey& key, absl::string_view record) -> absl::Status {
+        if (key.hash != expected) {
+          return absl::DataLossError(
+              absl::StrFormat("%s: Index %d appears more than once",
+                              permutation_path, key.hash));
+        }
+        ++expected;
+        RETURN_IF_ERROR(DecodeMates(record, &mates));
+        return WriteMates(mates, writers);
+      });
+}
+
+}  // namespace
+
+auto ReorderReads(absl::Nonnull<FastqParser*> parser,
+                  absl::Nonnull<FastqWriter*> writer,
+                  absl::string_view permutation_path,
+                  const ReadReorderOptions& options)
+    -> absl::StatusOr<uint64_t> {
+  FastqWriter* const writers[] = {writer};
+  return Reorder(parser, writers, permutation_path, options);
+}
+
+auto ReorderReads(absl::Nonnull<PairedFastqReader*> reader,
+                  absl::Nonnull<FastqWriter*> first_writer,
+                  absl::Nonnull<FastqWriter*> second_writer,
+                  absl::string_view permutation_path,
+                  const ReadReorderOptions& options)
+    -> absl::StatusOr<uint64_t> {
+  FastqWriter* const writers[] = {first_writer, second_writer};
+  return Reorder(reader, writers, permutation_path, options);
+}
+
+auto RestoreReadOrder(absl::Nonnull<FastqParser*> parser,
+                      absl::string_view permutation_path,
+                      absl::Nonnull<FastqWriter*> writer,
+                      const ReadReorderOptions& options) -> absl::Status {
+  FastqWriter* const writers[] = {writer};
+  return Restore(parser, permutation_path, writers, options);
+}
+
+auto RestoreReadOrder(absl::Nonnull<PairedFastqReader*> reader,
+                      absl::string_view permutation_path,
+                      absl::Nonnull<FastqWriter*> first_writer,
+                      absl::Nonnull<FastqWriter*> second_writer,
+                      const ReadReorderOptions& options) -> absl::Status {
+  FastqWriter* const writers[] = {first_writer, second_writer};
+  return Restore(reader, permutation_path, writers, options);
+}
+
+auto ReadPermutation(absl::string_view path)
+    -> absl::StatusOr<std::vector<uint64_t>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<PermutationReader> reader,
+                   PermutationReader::New(path));
+  std::vector<uint64_t> permutation;
+  permutation.reserve(reader->size());
+  for (uint64_t i = 0; i < reader->size(); ++i) {
+    ASSIGN_OR_RETURN(uint64_t index, reader->Next());
+    permutation.push_back(index);
+  }
+  return permutation;
+}
+
+}  // namespace bio
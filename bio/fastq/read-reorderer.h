@@ -0,0 +1,135 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_FASTQ_READ_REORDERER_H_
+#define BIO_FASTQ_READ_REORDERER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/paired-fastq-reader.h"
+
+namespace bio {
+
+// Options for reordering reads and restoring their order.
+struct ReadReorderOptions {
+  // The k-mer length of the minimizers, between 1 and 32.
+  size_t k = 15;
+
+  // The seed of the k-mer hash.
+  uint64_t seed = 0;
+
+  // The number of bytes of reads held in memory. Beyond it, reads are spilled
+  // to one temporary file per bucket, and buckets that do not fit are split
+  // further on disk before being sorted.
+  size_t max_memory = size_t{1} << 30;
+
+  // The directory of the spill files. If empty, the system temporary
+  // directory is used.
+  std::string temp_dir;
+};
+
+// Reorders the reads of `parser` so that reads that share their minimizer,
+// and so likely overlap, are adjacent, which lets general-purpose compressors
+// find far more redundancy. The reordered reads are written to `writer` and
+// the permutation that restores the original order to `permutation_path`.
+// Returns the number of reads.
+//
+// Each read is keyed by its minimizer: the canonical k-mer with the smallest
+// hash. Reads are ordered by the hash of their minimizer and then by its
+// strand and position, so that reads sharing a minimizer are laid out roughly
+// in the order of their start on the genome. Reads without any k-mer, such as
+// short or all-N reads, come last. Ties keep the input order.
+//
+// The reads are sorted with an external bucket sort: they are distributed into
+// 256 buckets by the top bits of their minimizer hash, and each bucket is then
+// sorted in memory. Buckets larger than `max_memory`, such as those of very
+// frequent minimizers, are split again on the following bits of their keys.
+// Reads that share a key, such as those without any k-mer, need no sorting
+// and are streamed.
+//
+// The permutation file holds, for each output read, the 0-based index of the
+// read in the input, as varints after a magic number and the read count.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser,
+//                  FastqParser::New("path/to/reads.fastq"));
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqWriter> writer,
+//                  FastqWriter::New("path/to/reordered.fastq"));
+// ASSIGN_OR_RETURN(uint64_t num_reads,
+//                  ReorderReads(parser.get(), writer.get(),
+//                               "path/to/reordered.perm"));
+// RETURN_IF_ERROR(writer->Close());
+// ```
+auto ReorderReads(absl::Nonnull<FastqParser*> parser,
+                  absl::Nonnull<FastqWriter*> writer,
+                  absl::string_view permutation_path,
+                  const ReadReorderOptions& options = {})
+    -> absl::StatusOr<uint64_t>;
+
+// Reorders the pairs of `reader`, keeping the mates of each pair together.
+// Pairs are keyed by the smaller minimizer of their two mates.
+auto ReorderReads(absl::Nonnull<PairedFastqReader*> reader,
+                  absl::Nonnull<FastqWriter*> first_writer,
+                  absl::Nonnull<FastqWriter*> second_writer,
+                  absl::string_view permutation_path,
+                  const ReadReorderOptions& options = {})
+    -> absl::StatusOr<uint64_t>;
+
+// Writes the reads of `parser`, which were reordered by ReorderReads(), to
+// `writer` in their original order. Only `max_memory` and `temp_dir` of
+// `options` are used.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqParser> parser,
+//                  FastqParser::New("path/to/reordered.fastq"));
+// ASSIGN_OR_RETURN(std::unique_ptr<FastqWriter> writer,
+//                  FastqWriter::New("path/to/reads.fastq"));
+// RETURN_IF_ERROR(RestoreReadOrder(parser.get(), "path/to/reordered.perm",
+//                                  writer.get()));
+// RETURN_IF_ERROR(writer->Close());
+// ```
+auto RestoreReadOrder(absl::Nonnull<FastqParser*> parser,
+                      absl::string_view permutation_path,
+                      absl::Nonnull<FastqWriter*> writer,
+                      const ReadReorderOptions& options = {}) -> absl::Status;
+
+// Writes the pairs of `reader`, which were reordered by ReorderReads(), to
+// `first_writer` and `second_writer` in their original order.
+auto RestoreReadOrder(absl::Nonnull<PairedFastqReader*> reader,
+                      absl::string_view permutation_path,
+                      absl::Nonnull<FastqWriter*> first_writer,
+                      absl::Nonnull<FastqWriter*> second_writer,
+                      const ReadReorderOptions& options = {}) -> absl::Status;
+
+// Reads the permutation file at `path` written by ReorderReads(). The i-th
+// element is the input index of the i-th output read.
+auto ReadPermutation(absl::string_view path)
+    -> absl::StatusOr<std::vector<uint64_t>>;
+
+}  // namespace bio
+
+#endif  // BIO_FASTQ_READ_REORDERER_H_
@@ -0,0 +1,369 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/fastq/read-reorderer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq-writer.h"
+#include "bio/fastq/fastq.h"
+#include "bio/fastq/paired-fastq-reader.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/file.h"
+#include "gxl/file/path.h"
+#include "zlib.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::TempDir;
+
+auto Path(absl::string_view name) -> std::string {
+  return gxl::JoinPath(TempDir(), name);
+}
+
+auto ReverseComplement(absl::string_view sequence) -> std::string {
+  std::string result(sequence.rbegin(), sequence.rend());
+  for (char& base : result) {
+    switch (base) {
+      case 'A': base = 'T'; break;
+      case 'C': base = 'G'; break;
+      case 'G': base = 'C'; break;
+      case 'T': base = 'A'; break;
+    }
+  }
+  return result;
+}
+
+// Returns `num_reads` reads of `length` bases sampled from both strands of a
+// random genome, followed by reads without any valid k-mer.
+auto SampleReads(size_t num_reads, size_t length, uint64_t seed,
+                 size_t genome_size = 5000) -> std::vector<FastqSequence> {
+  std::mt19937_64 random(seed);
+  std::string genome(genome_size, 'A');
+  for (char& base : genome) {
+    base = "ACGT"[random() % 4];
+  }
+  std::vector<FastqSequence> reads;
+  for (size_t i = 0; i < num_reads; ++i) {
+    std::string sequence =
+        genome.substr(random() % (genome.size() - length), length);
+    if (random() % 2 == 0) {
+      sequence = ReverseComplement(sequence);
+    }
+    reads.push_back({
+        .name = absl::StrCat("read", i),
+        .sequence = sequence,
+        .quality = std::string(length, "#5?I"[i % 4]),
+    });
+  }
+  reads.push_back({.name = "all-n", .sequence = "NNNNNNNNNN",
+                   .quality = "##########"});
+  reads.push_back({.name = "short", .sequence = "ACGT", .quality = "IIII"});
+  return reads;
+}
+
+auto Format(const std::vector<FastqSequence>& reads) -> std::string {
+  std::string contents;
+  for (const FastqSequence& read : reads) {
+    absl::StrAppend(&contents, read.string(), "\n");
+  }
+  return contents;
+}
+
+auto ReadReads(absl::string_view path) -> std::vector<FastqSequence> {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(path);
+  std::vector<FastqSequence> reads;
+  while (!parser->eof()) {
+    absl::StatusOr<std::unique_ptr<FastqSequence>> read = parser->Next();
+    EXPECT_THAT(read, IsOk());
+    if (!read.ok() || *read == nullptr) {
+      break;
+    }
+    reads.push_back(**std::move(read));
+  }
+  return reads;
+}
+
+auto Contents(absl::string_view path) -> std::string {
+  std::string contents;
+  EXPECT_THAT(gxl::GetContents(path, &contents, gxl::file::Defaults()),
+              IsOk());
+  return contents;
+}
+
+auto CompressedSize(absl::string_view data) -> size_t {
+  uLongf size = compressBound(data.size());
+  std::string compressed(size, '\0');
+  EXPECT_EQ(compress2(reinterpret_cast<Bytef*>(compressed.data()), &size,
+                      reinterpret_cast<const Bytef*>(data.data()),
+                      data.size(), 9),
+            Z_OK);
+  return size;
+}
+
+auto Reorder(absl::string_view input, absl::string_view output,
+             absl::string_view permutation,
+             const ReadReorderOptions& options) -> absl::StatusOr<uint64_t> {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(input);
+  std::unique_ptr<FastqWriter> writer = FastqWriter::NewOrDie(output);
+  absl::StatusOr<uint64_t> num_reads =
+      ReorderReads(parser.get(), writer.get(), permutation, options);
+  EXPECT_THAT(writer->Close(), IsOk());
+  return num_reads;
+}
+
+auto Restore(absl::string_view input, absl::string_view permutation,
+             absl::string_view output, const ReadReorderOptions& options)
+    -> absl::Status {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(input);
+  std::unique_ptr<FastqWriter> writer = FastqWriter::NewOrDie(output);
+  absl::Status status =
+      RestoreReadOrder(parser.get(), permutation, writer.get(), options);
+  EXPECT_THAT(writer->Close(), IsOk());
+  return status;
+}
+
+TEST(ReorderReads, RoundTrip) {
+  const std::vector<FastqSequence> reads = SampleReads(2000, 100, 1);
+  const std::string input = WriteTempFile("reorder_in.fastq", Format(reads));
+  // A tiny budget spills every bucket many times.
+  for (size_t max_memory : {size_t{1} << 30, size_t{4096}}) {
+    const ReadReorderOptions options = {.max_memory = max_memory,
+                                        .temp_dir = TempDir()};
+    const std::string reordered = Path("reorder_out.fastq");
+    const std::string permutation_path = Path("reorder_out.perm");
+    ASSERT_THAT(Reorder(input, reordered, permutation_path, options),
+                IsOkAndHolds(reads.size()));
+
+    const std::vector<FastqSequence> output = ReadReads(reordered);
+    absl::StatusOr<std::vector<uint64_t>> permutation =
+        ReadPermutation(permutation_path);
+    ASSERT_THAT(permutation, IsOk());
+    ASSERT_EQ(output.size(), reads.size());
+    ASSERT_EQ(permutation->size(), reads.size());
+    for (size_t i = 0; i < output.size(); ++i) {
+      ASSERT_LT((*permutation)[i], reads.size());
+      EXPECT_EQ(output[i].string(), reads[(*permutation)[i]].string());
+    }
+    std::vector<uint64_t> sorted = *permutation;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+      ASSERT_EQ(sorted[i], i);
+    }
+    // Reads without a minimizer come last, in input order.
+    EXPECT_EQ(output[output.size() - 2].name, "all-n");
+    EXPECT_EQ(output.back().name, "short");
+
+    const std::string restored = Path("reorder_restored.fastq");
+    ASSERT_THAT(Restore(reordered, permutation_path, restored, options),
+                IsOk());
+    EXPECT_EQ(Contents(restored), Contents(input)) << max_memory;
+  }
+}
+
+TEST(ReorderReads, SplitsOversizedBuckets) {
+  // Most reads share one minimizer, at various positions, or have no k-mer
+  // at all, so their buckets are far larger than the budget.
+  static constexpr absl::string_view kCopy = "GATTACAGATTACAGATTACA";
+  std::vector<FastqSequence> reads = SampleReads(500, 60, 7);
+  for (int i = 0; i < 2000; ++i) {
+    reads.push_back({.name = absl::StrCat("copy", i),
+                     .sequence = std::string(kCopy),
+                     .quality = std::string(kCopy.size(), 'I')});
+    const std::string shifted =
+        absl::StrCat(std::string(1 + i % 7, 'N'), kCopy);
+    reads.push_back({.name = absl::StrCat("shifted", i),
+                     .sequence = shifted,
+                     .quality = std::string(shifted.size(), 'I')});
+    reads.push_back(
+        {.name = absl::StrCat("n", i), .sequence = "NNNN", .quality = "####"});
+  }
+  const std::string input = WriteTempFile("split_in.fastq", Format(reads));
+  const std::string temp_dir = Path("split-buckets");
+  std::filesystem::create_directories(temp_dir);
+  const ReadReorderOptions options = {.max_memory = 4096,
+                                      .temp_dir = temp_dir};
+  const std::string reordered = Path("split_out.fastq");
+  const std::string permutation_path = Path("split_out.perm");
+  ASSERT_THAT(Reorder(input, reordered, permutation_path, options),
+              IsOkAndHolds(reads.size()));
+  EXPECT_TRUE(std::filesystem::is_empty(temp_dir));
+
+  // Copies, which share their whole key, are adjacent and in input order,
+  // and reads without a minimizer come last, in input order.
+  const std::vector<FastqSequence> output = ReadReads(reordered);
+  ASSERT_EQ(output.size(), reads.size());
+  const auto first_copy =
+      std::find_if(output.begin(), output.end(), [](const FastqSequence& read) {
+        return read.name == "copy0";
+      });
+  ASSERT_LE(first_copy + 2000, output.end());
+  for (int i = 0; i < 2000; ++i) {
+    EXPECT_EQ(first_copy[i].name, absl::StrCat("copy", i));
+    EXPECT_EQ(output[output.size() - 2000 + i].name, absl::StrCat("n", i));
+  }
+
+  const std::string restored = Path("split_restored.fastq");
+  ASSERT_THAT(Restore(reordered, permutation_path, restored, options),
+              IsOk());
+  EXPECT_EQ(Contents(restored), Contents(input));
+  EXPECT_TRUE(std::filesystem::is_empty(temp_dir));
+}
+
+TEST(ReorderReads, CompressesBetter) {
+  // The genome is much larger than the 32 KiB window of deflate, so reads
+  // from the same region are only matched if they are close together.
+  const std::vector<FastqSequence> reads =
+      SampleReads(10000, 100, 2, /*genome_size=*/100000);
+  const std::string input = WriteTempFile("compress_in.fastq", Format(reads));
+  const std::string reordered = Path("compress_out.fastq");
+  ASSERT_THAT(
+      Reorder(input, reordered, Path("compress_out.perm"), {}), IsOk());
+  std::string original_sequences;
+  for (const FastqSequence& read : reads) {
+    absl::StrAppend(&original_sequences, read.sequence, "\n");
+  }
+  std::string reordered_sequences;
+  for (const FastqSequence& read : ReadReads(reordered)) {
+    absl::StrAppend(&reordered_sequences, read.sequence, "\n");
+  }
+  EXPECT_LT(CompressedSize(reordered_sequences),
+            CompressedSize(original_sequences) * 4 / 5);
+}
+
+TEST(ReorderReads, Pairs) {
+  const std::vector<FastqSequence> first = SampleReads(500, 80, 3);
+  std::vector<FastqSequence> second = SampleReads(500, 80, 4);
+  for (size_t i = 0; i < second.size(); ++i) {
+    second[i].name = absl::StrCat(first[i].name, "/2");
+  }
+  const std::string first_path =
+      WriteTempFile("pairs_R1.fastq", Format(first));
+  const std::string second_path =
+      WriteTempFile("pairs_R2.fastq", Format(second));
+  const ReadReorderOptions options = {.max_memory = 8192,
+                                      .temp_dir = TempDir()};
+
+  const std::string out_first = Path("pairs_out_R1.fastq");
+  const std::string out_second = Path("pairs_out_R2.fastq");
+  const std::string permutation_path = Path("pairs_out.perm");
+  {
+    std::unique_ptr<PairedFastqReader> reader =
+        *PairedFastqReader::New(first_path, second_path);
+    std::unique_ptr<FastqWriter> first_writer =
+        FastqWriter::NewOrDie(out_first);
+    std::unique_ptr<FastqWriter> second_writer =
+        FastqWriter::NewOrDie(out_second);
+    ASSERT_THAT(ReorderReads(reader.get(), first_writer.get(),
+                             second_writer.get(), permutation_path, options),
+                IsOkAndHolds(first.size()));
+    ASSERT_THAT(first_writer->Close(), IsOk());
+    ASSERT_THAT(second_writer->Close(), IsOk());
+  }
+  const std::vector<FastqSequence> reordered_first = ReadReads(out_first);
+  const std::vector<FastqSequence> reordered_second = ReadReads(out_second);
+  ASSERT_EQ(reordered_first.size(), first.size());
+  ASSERT_EQ(reordered_second.size(), first.size());
+  for (size_t i = 0; i < reordered_first.size(); ++i) {
+    EXPECT_EQ(MateName(reordered_first[i].name),
+              MateName(reordered_second[i].name));
+  }
+
+  const std::string restored_first = Path("pairs_restored_R1.fastq");
+  const std::string restored_second = Path("pairs_restored_R2.fastq");
+  {
+    std::unique_ptr<PairedFastqReader> reader =
+        *PairedFastqReader::New(out_first, out_second);
+    std::unique_ptr<FastqWriter> first_writer =
+        FastqWriter::NewOrDie(restored_first);
+    std::unique_ptr<FastqWriter> second_writer =
+        FastqWriter::NewOrDie(restored_second);
+    ASSERT_THAT(RestoreReadOrder(reader.get(), permutation_path,
+                                 first_writer.get(), second_writer.get(),
+                                 options),
+                IsOk());
+    ASSERT_THAT(first_writer->Close(), IsOk());
+    ASSERT_THAT(second_writer->Close(), IsOk());
+  }
+  EXPECT_EQ(Contents(restored_first), Contents(first_path));
+  EXPECT_EQ(Contents(restored_second), Contents(second_path));
+}
+
+TEST(ReorderReads, Empty) {
+  const std::string input = WriteTempFile("empty_in.fastq", "");
+  const std::string permutation_path = Path("empty.perm");
+  ASSERT_THAT(Reorder(input, Path("empty_out.fastq"), permutation_path, {}),
+              IsOkAndHolds(0));
+  EXPECT_THAT(ReadPermutation(permutation_path),
+              IsOkAndHolds(std::vector<uint64_t>()));
+  ASSERT_THAT(Restore(Path("empty_out.fastq"), permutation_path,
+                      Path("empty_restored.fastq"), {}),
+              IsOk());
+  EXPECT_EQ(Contents(Path("empty_restored.fastq")), "");
+}
+
+TEST(ReorderReads, InvalidK) {
+  const std::string input =
+      WriteTempFile("invalid_k.fastq", Format(SampleReads(1, 50, 5)));
+  EXPECT_THAT(Reorder(input, Path("invalid_k_out.fastq"),
+                      Path("invalid_k.perm"), {.k = 33}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(RestoreReadOrder, MismatchedReads) {
+  const std::vector<FastqSequence> reads = SampleReads(20, 50, 6);
+  const std::string input = WriteTempFile("mismatch_in.fastq", Format(reads));
+  const std::string permutation_path = Path("mismatch.perm");
+  ASSERT_THAT(
+      Reorder(input, Path("mismatch_out.fastq"), permutation_path, {}),
+      IsOk());
+
+  const std::string fewer = WriteTempFile(
+      "mismatch_fewer.fastq",
+      Format(std::vector<FastqSequence>(reads.begin(), reads.begin() + 10)));
+  EXPECT_THAT(Restore(fewer, permutation_path, Path("mismatch_restored.fastq"),
+                      {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  std::vector<FastqSequence> more = reads;
+  more.push_back(reads[0]);
+  EXPECT_THAT(Restore(WriteTempFile("mismatch_more.fastq", Format(more)),
+                      permutation_path, Path("mismatch_restored.fastq"), {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  EXPECT_THAT(Restore(input, input, Path("mismatch_restored.fastq"), {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,123 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_KMER_KMER_ITERATOR_H_
+#define BIO_KMER_KMER_ITERATOR_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+#include "absl/log/check.h"
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/sequence.h"
+#include "bio/kmer/kmer.h"
+
+namespace bio {
+
+// Iterates over the canonical k-mers of a sequence, such as
+// FastaSequence::sequence or FastqSequence::sequence.
+//
+// The forward and reverse complement k-mers are updated with a rolling 2-bit
+// encoding, so each base is read exactly once. K-mers overlapping a base that
+// is not A, C, G, T or U (e.g. N) are skipped: the iterator restarts after the
+// offending base without rescanning the bases before it.
+//
+// The iterator does not copy the sequence, which must outlive it.
+//
+// Example usage:
+//
+// ```
+// KmerIterator it(sequence->sequence, /*k=*/21);
+// while (!it.eol()) {
+//   std::optional<Kmer> kmer = it.Next();
+//   if (!kmer.has_value()) {
+//     break;
+//   }
+//   // Do stuff with `kmer`.
+// }
+// ```
+template <typename Word>
+class BasicKmerIterator {
+ public:
+  // Constructs an iterator over the k-mers of `sequence`. `k` must be between
+  // 1 and kMaxKmerLength<Word>, inclusive.
+  BasicKmerIterator(absl::string_view sequence, size_t k)
+      : sequence_(sequence),
+        k_(k),
+        mask_(0),
+        reverse_shift_(0),
+        forward_(0),
+        reverse_(0),
+        run_length_(0),
+        cursor_(0) {
+    CHECK(k >= 1 && k <= kMaxKmerLength<Word>)  // Crash OK
+        << "Invalid k-mer length: " << k;
+    mask_ = KmerMask<Word>(k);
+    reverse_shift_ = 2 * (k - 1);
+  }
+
+  // Returns the next canonical k-mer, or std::nullopt if there are no more
+  // k-mers in the sequence.
+  auto Next() -> std::optional<BasicKmer<Word>> {
+    while (cursor_ < sequence_.size()) {
+      const uint8_t code = EncodeBase(sequence_[cursor_]);
+      ++cursor_;
+      if (code == kInvalidBase) {
+        run_length_ = 0;
+        continue;
+      }
+      forward_ = ((forward_ << 2) | Word(code)) & mask_;
+      reverse_ = (reverse_ >> 2) | (Word(3 - code) << reverse_shift_);
+      if (++run_length_ < k_) {
+        continue;
+      }
+      const size_t position = cursor_ - k_;
+      if (reverse_ < forward_) {
+        return BasicKmer<Word>{reverse_, position, Strand::kAntisense};
+      }
+      return BasicKmer<Word>{forward_, position, Strand::kSense};
+    }
+    return std::nullopt;
+  }
+
+  // Returns true if the end of the sequence has been reached.
+  auto eol() const -> bool { return cursor_ >= sequence_.size(); }
+
+  // Returns the k-mer length.
+  auto k() const -> size_t { return k_; }
+
+ private:
+  absl::string_view sequence_;
+  size_t k_;
+  Word mask_;
+  size_t reverse_shift_;
+  Word forward_;
+  Word reverse_;
+
+  // The number of consecutive valid bases ending at cursor_.
+  size_t run_length_;
+  size_t cursor_;
+};
+
+// Iterator over k-mers of up to 32 bases.
+using KmerIterator = BasicKmerIterator<uint64_t>;
+
+// Iterator over k-mers of up to 64 bases.
+using KmerIterator128 = BasicKmerIterator<absl::uint128>;
+
+}  // namespace bio
+
+#endif  // BIO_KMER_KMER_ITERATOR_H_
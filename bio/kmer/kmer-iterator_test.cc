@@ -0,0 +1,132 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/kmer/kmer-iterator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/sequence.h"
+#include "bio/fasta/fasta.h"
+#include "bio/fastq/fastq.h"
+#include "bio/kmer/kmer.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+template <typename Word>
+auto CollectKmers(absl::string_view sequence, size_t k)
+    -> std::vector<BasicKmer<Word>> {
+  std::vector<BasicKmer<Word>> kmers;
+  BasicKmerIterator<Word> it(sequence, k);
+  while (!it.eol()) {
+    std::optional<BasicKmer<Word>> kmer = it.Next();
+    if (!kmer.has_value()) {
+      break;
+    }
+    kmers.push_back(*kmer);
+  }
+  return kmers;
+}
+
+// Computes the canonical k-mers of `sequence` without a rolling encoding.
+template <typename Word>
+auto NaiveKmers(absl::string_view sequence, size_t k)
+    -> std::vector<BasicKmer<Word>> {
+  std::vector<BasicKmer<Word>> kmers;
+  for (size_t i = 0; i + k <= sequence.size(); ++i) {
+    std::optional<Word> forward = EncodeKmer<Word>(sequence.substr(i, k));
+    if (!forward.has_value()) {
+      continue;
+    }
+    const Word reverse = ReverseComplementKmer<Word>(*forward, k);
+    if (reverse < *forward) {
+      kmers.push_back({reverse, i, Strand::kAntisense});
+    } else {
+      kmers.push_back({*forward, i, Strand::kSense});
+    }
+  }
+  return kmers;
+}
+
+TEST(KmerIterator, Empty) {
+  KmerIterator it("", 3);
+  EXPECT_TRUE(it.eol());
+  EXPECT_EQ(it.Next(), std::nullopt);
+}
+
+TEST(KmerIterator, SequenceShorterThanK) {
+  EXPECT_THAT(CollectKmers<uint64_t>("ACG", 4), IsEmpty());
+}
+
+TEST(KmerIterator, Canonical) {
+  // AAC -> GTT, ACG -> CGT, CGT -> ACG.
+  EXPECT_THAT(
+      CollectKmers<uint64_t>("AACGT", 3),
+      ElementsAre(Kmer{*EncodeKmer<uint64_t>("AAC"), 0, Strand::kSense},
+                  Kmer{*EncodeKmer<uint64_t>("ACG"), 1, Strand::kSense},
+                  Kmer{*EncodeKmer<uint64_t>("ACG"), 2, Strand::kAntisense}));
+}
+
+TEST(KmerIterator, SkipsInvalidBases) {
+  EXPECT_THAT(
+      CollectKmers<uint64_t>("AAANAAAANNAA", 3),
+      ElementsAre(Kmer{*EncodeKmer<uint64_t>("AAA"), 0, Strand::kSense},
+                  Kmer{*EncodeKmer<uint64_t>("AAA"), 4, Strand::kSense},
+                  Kmer{*EncodeKmer<uint64_t>("AAA"), 5, Strand::kSense}));
+}
+
+TEST(KmerIterator, SoftMaskedBases) {
+  EXPECT_EQ(CollectKmers<uint64_t>("acgtTGCAnACGT", 4),
+            CollectKmers<uint64_t>("ACGTTGCANACGT", 4));
+}
+
+TEST(KmerIterator, MatchesNaive) {
+  const std::string sequence =
+      "GATTACAGATTACANNCCGGTTAACGTACGTAGCTAGCTAGGCTAGCGATCGATCGNATCGATCGGCT"
+      "AGCTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTAAAAAAACGTGCACGTGAAACCCGGGTTTA";
+  for (size_t k : {1, 2, 5, 11, 21, 31, 32}) {
+    EXPECT_THAT(CollectKmers<uint64_t>(sequence, k),
+                ElementsAreArray(NaiveKmers<uint64_t>(sequence, k)))
+        << "k = " << k;
+  }
+  for (size_t k : {1, 17, 33, 47, 63, 64}) {
+    EXPECT_THAT(CollectKmers<absl::uint128>(sequence, k),
+                ElementsAreArray(NaiveKmers<absl::uint128>(sequence, k)))
+        << "k = " << k;
+  }
+}
+
+TEST(KmerIterator, FastaAndFastqSequences) {
+  const FastaSequence fasta = {.name = "chr1", .sequence = "ACGTNACGTA"};
+  const FastqSequence fastq = {
+      .name = "read1", .sequence = "ACGTNACGTA", .quality = "IIIIIIIIII"};
+  EXPECT_EQ(CollectKmers<uint64_t>(fasta.sequence, 4),
+            CollectKmers<uint64_t>(fastq.sequence, 4));
+  EXPECT_EQ(CollectKmers<uint64_t>(fasta.sequence, 4).size(), 3);
+}
+
+}  // namespace
+}  // namespace bio
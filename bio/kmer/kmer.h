@@ -0,0 +1,158 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_KMER_KMER_H_
+#define BIO_KMER_KMER_H_
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/sequence.h"
+
+namespace bio {
+
+// The value returned by EncodeBase() for anything other than A, C, G, T or U.
+static constexpr uint8_t kInvalidBase = 4;
+
+// The maximum k-mer length that can be packed into a `Word`, at 2 bits per
+// base.
+template <typename Word>
+static constexpr size_t kMaxKmerLength = 4 * sizeof(Word);
+
+namespace internal {
+
+constexpr auto MakeBaseEncodingTable() -> std::array<uint8_t, 256> {
+  std::array<uint8_t, 256> table = {};
+  for (auto& code : table) {
+    code = kInvalidBase;
+  }
+  table['A'] = table['a'] = 0;
+  table['C'] = table['c'] = 1;
+  table['G'] = table['g'] = 2;
+  table['T'] = table['t'] = 3;
+  table['U'] = table['u'] = 3;
+  return table;
+}
+
+static constexpr std::array<uint8_t, 256> kBaseEncodingTable =
+    MakeBaseEncodingTable();
+
+}  // namespace internal
+
+// Returns the 2-bit encoding of `base` (A = 0, C = 1, G = 2, T/U = 3), or
+// kInvalidBase if `base` is not one of these. Lowercase (soft-masked) bases
+// are encoded the same as uppercase ones.
+inline auto EncodeBase(char base) -> uint8_t {
+  return internal::kBaseEncodingTable[static_cast<uint8_t>(base)];
+}
+
+// Returns the mask that covers the low 2 * k bits of a `Word`.
+template <typename Word>
+inline auto KmerMask(size_t k) -> Word {
+  return ~Word(0) >> (8 * sizeof(Word) - 2 * k);
+}
+
+// A 2-bit encoded k-mer together with its position in the sequence it was
+// extracted from. The first base is stored in the most significant bits, so
+// that comparing encoded k-mers is equivalent to comparing them
+// lexicographically.
+template <typename Word>
+struct BasicKmer {
+  // The canonical k-mer: the smaller of the forward k-mer and its reverse
+  // complement.
+  Word value;
+
+  // The 0-based position of the first base of the k-mer in the sequence.
+  size_t position;
+
+  // kSense if `value` is the forward k-mer, kAntisense if it is the reverse
+  // complement.
+  Strand strand;
+
+  // Checks for equality.
+  auto operator==(const BasicKmer& rhs) const -> bool {
+    return value == rhs.value && position == rhs.position &&
+           strand == rhs.strand;
+  }
+};
+
+// K-mers of up to 32 bases.
+using Kmer = BasicKmer<uint64_t>;
+
+// K-mers of up to 64 bases.
+using Kmer128 = BasicKmer<absl::uint128>;
+
+// Encodes `sequence` as a 2-bit k-mer, or returns std::nullopt if the sequence
+// contains a base that cannot be encoded or is too long to fit in a `Word`.
+template <typename Word>
+auto EncodeKmer(absl::string_view sequence) -> std::optional<Word> {
+  if (sequence.size() > kMaxKmerLength<Word>) {
+    return std::nullopt;
+  }
+  Word value = 0;
+  for (char base : sequence) {
+    const uint8_t code = EncodeBase(base);
+    if (code == kInvalidBase) {
+      return std::nullopt;
+    }
+    value = (value << 2) | Word(code);
+  }
+  return value;
+}
+
+// Decodes the 2-bit encoded k-mer `value` of length `k` into its bases.
+template <typename Word>
+auto DecodeKmer(Word value, size_t k) -> std::string {
+  static constexpr char kBases[] = "ACGT";
+  std::string sequence(k, 'N');
+  for (size_t i = k; i > 0; --i) {
+    sequence[i - 1] = kBases[static_cast<uint8_t>(value & Word(3))];
+    value >>= 2;
+  }
+  return sequence;
+}
+
+// Returns the reverse complement of the 2-bit encoded k-mer `value` of length
+// `k`.
+template <typename Word>
+auto ReverseComplementKmer(Word value, size_t k) -> Word {
+  Word reverse = 0;
+  for (size_t i = 0; i < k; ++i) {
+    reverse = (reverse << 2) | (Word(3) - (value & Word(3)));
+    value >>= 2;
+  }
+  return reverse;
+}
+
+// Hashes an encoded k-mer of up to 32 bases. This is the 64-bit finalizer from
+// MurmurHash3, which is a bijection, so distinct k-mers never collide for a
+// given seed.
+inline auto HashKmer(uint64_t value, uint64_t seed = 0) -> uint64_t {
+  uint64_t hash = value ^ seed;
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+}  // namespace bio
+
+#endif  // BIO_KMER_KMER_H_
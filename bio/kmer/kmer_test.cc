@@ -0,0 +1,89 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/kmer/kmer.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "absl/numeric/int128.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::testing::Optional;
+
+TEST(EncodeBase, Correctness) {
+  EXPECT_EQ(EncodeBase('A'), 0);
+  EXPECT_EQ(EncodeBase('C'), 1);
+  EXPECT_EQ(EncodeBase('G'), 2);
+  EXPECT_EQ(EncodeBase('T'), 3);
+  EXPECT_EQ(EncodeBase('U'), 3);
+  EXPECT_EQ(EncodeBase('a'), 0);
+  EXPECT_EQ(EncodeBase('c'), 1);
+  EXPECT_EQ(EncodeBase('g'), 2);
+  EXPECT_EQ(EncodeBase('t'), 3);
+  EXPECT_EQ(EncodeBase('N'), kInvalidBase);
+  EXPECT_EQ(EncodeBase('n'), kInvalidBase);
+  EXPECT_EQ(EncodeBase('-'), kInvalidBase);
+  EXPECT_EQ(EncodeBase('\xff'), kInvalidBase);
+}
+
+TEST(EncodeKmer, Correctness) {
+  EXPECT_THAT(EncodeKmer<uint64_t>(""), Optional(0));
+  EXPECT_THAT(EncodeKmer<uint64_t>("ACGT"), Optional(0b00011011));
+  EXPECT_THAT(EncodeKmer<uint64_t>("acgt"), Optional(0b00011011));
+  EXPECT_EQ(EncodeKmer<uint64_t>("ACNT"), std::nullopt);
+  EXPECT_THAT(EncodeKmer<uint64_t>(std::string(32, 'T')),
+              Optional(~uint64_t{0}));
+  EXPECT_EQ(EncodeKmer<uint64_t>(std::string(33, 'A')), std::nullopt);
+  EXPECT_THAT(EncodeKmer<absl::uint128>(std::string(64, 'T')),
+              Optional(~absl::uint128(0)));
+  EXPECT_EQ(EncodeKmer<absl::uint128>(std::string(65, 'A')), std::nullopt);
+}
+
+TEST(DecodeKmer, RoundTrip) {
+  EXPECT_EQ(DecodeKmer<uint64_t>(0, 0), "");
+  EXPECT_EQ(DecodeKmer<uint64_t>(0b00011011, 4), "ACGT");
+  EXPECT_EQ(DecodeKmer<uint64_t>(0, 3), "AAA");
+
+  const std::string kmer32 = "ACGTTGCAACGTTGCAGGGGCCCCAAAATTTT";
+  EXPECT_EQ(DecodeKmer<uint64_t>(*EncodeKmer<uint64_t>(kmer32), 32), kmer32);
+
+  const std::string kmer64 = kmer32 + "TTTTAAAACCCCGGGGACGTTGCAACGTTGCA";
+  EXPECT_EQ(
+      DecodeKmer<absl::uint128>(*EncodeKmer<absl::uint128>(kmer64), 64),
+      kmer64);
+}
+
+TEST(ReverseComplementKmer, Correctness) {
+  EXPECT_EQ(ReverseComplementKmer<uint64_t>(*EncodeKmer<uint64_t>("AACG"), 4),
+            *EncodeKmer<uint64_t>("CGTT"));
+  EXPECT_EQ(ReverseComplementKmer<uint64_t>(*EncodeKmer<uint64_t>("ACGT"), 4),
+            *EncodeKmer<uint64_t>("ACGT"));
+  EXPECT_EQ(ReverseComplementKmer<absl::uint128>(
+                *EncodeKmer<absl::uint128>(std::string(40, 'A')), 40),
+            *EncodeKmer<absl::uint128>(std::string(40, 'T')));
+}
+
+TEST(HashKmer, IsDeterministicAndSeeded) {
+  EXPECT_EQ(HashKmer(12345), HashKmer(12345));
+  EXPECT_NE(HashKmer(12345), HashKmer(12346));
+  EXPECT_NE(HashKmer(12345, /*seed=*/1), HashKmer(12345, /*seed=*/2));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,333 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/kmer/minhash.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/strip.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/task-queue.h"
+#include "bio/common/thread-pool.h"
+#include "bio/common/varint.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fasta/fasta.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/fastq/fastq.h"
+#include "bio/kmer/kmer-iterator.h"
+#include "bio/kmer/kmer.h"
+#include "gxl/file/file.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// Identifies a serialized sketch and its format version.
+static constexpr absl::string_view kMagic = "BMH\x01";
+
+// The number of bases of sequence sketched per task.
+static constexpr size_t kBatchBases = 4 << 20;
+
+// The maximum number of batches in flight per thread.
+static constexpr size_t kPendingBatchesPerThread = 2;
+
+auto ValidateOptions(const MinHashOptions& options) -> absl::Status {
+  if (options.k < 1 || options.k > kMaxKmerLength<uint64_t>) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid k-mer length: %d", options.k));
+  }
+  if (options.sketch_size == 0) {
+    return absl::InvalidArgumentError("Sketch size must be positive");
+  }
+  return absl::OkStatus();
+}
+
+auto CheckCompatible(const MinHashSketch& a, const MinHashSketch& b)
+    -> absl::Status {
+  if (a.k() != b.k() || a.seed() != b.seed()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Incompatible sketches: k = %d, seed = %d vs. k = %d, seed = %d",
+        a.k(), a.seed(), b.k(), b.seed()));
+  }
+  return absl::OkStatus();
+}
+
+// Reads the next sequence into `sequence`. Returns false at the end of the
+// input.
+using NextSequenceFn = std::function<absl::StatusOr<bool>(std::string*)>;
+
+auto SketchSequences(const NextSequenceFn& next, const MinHashOptions& options)
+    -> absl::StatusOr<MinHashSketch> {
+  RETURN_IF_ERROR(ValidateOptions(options));
+  MinHashSketcher sketcher(options);
+  if (options.num_threads <= 1) {
+    std::string sequence;
+    while (true) {
+      ASSIGN_OR_RETURN(const bool more, next(&sequence));
+      if (!more) {
+        break;
+      }
+      sketcher.Add(sequence);
+    }
+    return sketcher.Finish();
+  }
+
+  ThreadPool pool(options.num_threads);
+  TaskQueue<MinHashSketch> queue(&pool, /*ordered=*/false);
+  const size_t max_pending = kPendingBatchesPerThread * options.num_threads;
+  bool more = true;
+  while (more) {
+    auto batch = std::make_shared<std::vector<std::string>>();
+    size_t batch_bases = 0;
+    while (batch_bases < kBatchBases) {
+      std::string sequence;
+      ASSIGN_OR_RETURN(more, next(&sequence));
+      if (!more) {
+        break;
+      }
+      batch_bases += sequence.size();
+      batch->push_back(std::move(sequence));
+    }
+    if (batch->empty()) {
+      break;
+    }
+    if (queue.pending() >= max_pending) {
+      RETURN_IF_ERROR(sketcher.Merge(*queue.Next()));
+    }
+    queue.Submit([batch, options]() {
+      MinHashSketcher batch_sketcher(options);
+      for (const std::string& sequence : *batch) {
+        batch_sketcher.Add(sequence);
+      }
+      return batch_sketcher.Finish();
+    });
+  }
+  while (queue.pending() > 0) {
+    RETURN_IF_ERROR(sketcher.Merge(*queue.Next()));
+  }
+  return sketcher.Finish();
+}
+
+}  // namespace
+
+auto MinHashSketch::Serialize() const -> std::string {
+  std::string data(kMagic);
+  AppendVarint(k_, &data);
+  AppendVarint(sketch_size_, &data);
+  AppendVarint(seed_, &data);
+  AppendVarint(hashes_.size(), &data);
+  uint64_t previous = 0;
+  for (uint64_t hash : hashes_) {
+    AppendVarint(hash - previous, &data);
+    previous = hash;
+  }
+  return data;
+}
+
+auto MinHashSketch::Deserialize(absl::string_view data)
+    -> absl::StatusOr<MinHashSketch> {
+  if (!absl::ConsumePrefix(&data, kMagic)) {
+    return absl::DataLossError("Not a MinHash sketch");
+  }
+  std::optional<uint64_t> k = ConsumeVarint(&data);
+  std::optional<uint64_t> sketch_size = ConsumeVarint(&data);
+  std::optional<uint64_t> seed = ConsumeVarint(&data);
+  std::optional<uint64_t> num_hashes = ConsumeVarint(&data);
+  if (!k.has_value() || !sketch_size.has_value() || !seed.has_value() ||
+      !num_hashes.has_value()) {
+    return absl::DataLossError("Truncated MinHash sketch header");
+  }
+  MinHashSketch sketch({.k = *k, .sketch_size = *sketch_size, .seed = *seed});
+  if (!ValidateOptions({.k = sketch.k_, .sketch_size = sketch.sketch_size_})
+           .ok() ||
+      *num_hashes > *sketch_size || *num_hashes > data.size()) {
+    return absl::DataLossError("Invalid MinHash sketch header");
+  }
+  sketch.hashes_.reserve(*num_hashes);
+  uint64_t hash = 0;
+  for (uint64_t i = 0; i < *num_hashes; ++i) {
+    std::optional<uint64_t> delta = ConsumeVarint(&data);
+    if (!delta.has_value()) {
+      return absl::DataLossError("Truncated MinHash sketch");
+    }
+    if ((i > 0 && *delta == 0) ||
+        *delta > std::numeric_limits<uint64_t>::max() - hash) {
+      return absl::DataLossError("MinHash sketch hashes are not sorted");
+    }
+    hash += *delta;
+    sketch.hashes_.push_back(hash);
+  }
+  if (!data.empty()) {
+    return absl::DataLossError("Trailing data after MinHash sketch");
+  }
+  return sketch;
+}
+
+auto MinHashSketch::Read(absl::string_view path)
+    -> absl::StatusOr<MinHashSketch> {
+  std::string data;
+  RETURN_IF_ERROR(gxl::GetContents(path, &data, gxl::file::Defaults()));
+  return Deserialize(data);
+}
+
+auto MinHashSketch::Write(absl::string_view path) const -> absl::Status {
+  return gxl::SetContents(path, Serialize(), gxl::file::Defaults());
+}
+
+MinHashSketcher::MinHashSketcher(const MinHashOptions& options)
+    : sketch_(options),
+      max_buffer_size_(2 * options.sketch_size),
+      threshold_(std::numeric_limits<uint64_t>::max()) {
+  CHECK_OK(ValidateOptions(options));  // Crash OK
+  buffer_.reserve(max_buffer_size_);
+}
+
+auto MinHashSketcher::Add(absl::string_view sequence) -> void {
+  KmerIterator it(sequence, sketch_.k_);
+  for (std::optional<Kmer> kmer = it.Next(); kmer.has_value();
+       kmer = it.Next()) {
+    AddHash(HashKmer(kmer->value, sketch_.seed_));
+  }
+}
+
+auto MinHashSketcher::Merge(const MinHashSketch& sketch) -> absl::Status {
+  RETURN_IF_ERROR(CheckCompatible(sketch_, sketch));
+  for (uint64_t hash : sketch.hashes_) {
+    AddHash(hash);
+  }
+  return absl::OkStatus();
+}
+
+auto MinHashSketcher::Finish() -> MinHashSketch {
+  Compact();
+  MinHashSketch sketch = sketch_;
+  sketch.hashes_ = buffer_;
+  return sketch;
+}
+
+auto MinHashSketcher::Compact() -> void {
+  std::sort(buffer_.begin(), buffer_.end());
+  buffer_.erase(std::unique(buffer_.begin(), buffer_.end()), buffer_.end());
+  if (buffer_.size() >= sketch_.sketch_size_) {
+    buffer_.resize(sketch_.sketch_size_);
+    threshold_ = buffer_.back();
+  }
+}
+
+auto MinHashJaccard(const MinHashSketch& a, const MinHashSketch& b)
+    -> absl::StatusOr<double> {
+  RETURN_IF_ERROR(CheckCompatible(a, b));
+  const std::vector<uint64_t>& lhs = a.hashes();
+  const std::vector<uint64_t>& rhs = b.hashes();
+  const size_t sketch_size = std::min(a.sketch_size(), b.sketch_size());
+
+  // Walk the bottom `sketch_size` hashes of the union, counting the ones in
+  // both sketches.
+  size_t i = 0;
+  size_t j = 0;
+  size_t union_size = 0;
+  size_t shared = 0;
+  while (union_size < sketch_size && (i < lhs.size() || j < rhs.size())) {
+    if (j == rhs.size() || (i < lhs.size() && lhs[i] < rhs[j])) {
+      ++i;
+    } else if (i == lhs.size() || rhs[j] < lhs[i]) {
+      ++j;
+    } else {
+      ++shared;
+      ++i;
+      ++j;
+    }
+    ++union_size;
+  }
+  return union_size == 0 ? 0.0 : static_cast<double>(shared) / union_size;
+}
+
+auto MinHashContainment(const MinHashSketch& query,
+                        const MinHashSketch& reference)
+    -> absl::StatusOr<double> {
+  RETURN_IF_ERROR(CheckCompatible(query, reference));
+  const std::vector<uint64_t>& lhs = query.hashes();
+  const std::vector<uint64_t>& rhs = reference.hashes();
+
+  // Query hashes above the largest reference hash of a full sketch cannot be
+  // tested for membership.
+  const uint64_t max_hash = rhs.size() == reference.sketch_size()
+                                ? rhs.back()
+                                : std::numeric_limits<uint64_t>::max();
+  size_t j = 0;
+  size_t tested = 0;
+  size_t shared = 0;
+  for (size_t i = 0; i < lhs.size() && lhs[i] <= max_hash; ++i) {
+    ++tested;
+    while (j < rhs.size() && rhs[j] < lhs[i]) {
+      ++j;
+    }
+    if (j < rhs.size() && rhs[j] == lhs[i]) {
+      ++shared;
+    }
+  }
+  return tested == 0 ? 0.0 : static_cast<double>(shared) / tested;
+}
+
+auto SketchFasta(absl::Nonnull<FastaParser*> parser,
+                 const MinHashOptions& options)
+    -> absl::StatusOr<MinHashSketch> {
+  return SketchSequences(
+      [parser](std::string* sequence) -> absl::StatusOr<bool> {
+        if (parser->eof()) {
+          return false;
+        }
+        std::optional<std::unique_ptr<FastaSequence>> next = parser->Next();
+        if (!next.has_value()) {
+          return false;
+        }
+        *sequence = std::move((*next)->sequence);
+        return true;
+      },
+      options);
+}
+
+auto SketchFastq(absl::Nonnull<FastqParser*> parser,
+                 const MinHashOptions& options)
+    -> absl::StatusOr<MinHashSketch> {
+  return SketchSequences(
+      [parser](std::string* sequence) -> absl::StatusOr<bool> {
+        while (!parser->eof()) {
+          ASSIGN_OR_RETURN(std::unique_ptr<FastqSequence> next,
+                           parser->Next());
+          if (next == nullptr) {
+            break;
+          }
+          *sequence = std::move(next->sequence);
+          return true;
+        }
+        return false;
+      },
+      options);
+}
+
+}  // namespace bio
@@ -0,0 +1,200 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_KMER_MINHASH_H_
+#define BIO_KMER_MINHASH_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fastq/fastq-parser.h"
+
+namespace bio {
+
+// Options for building MinHash sketches.
+struct MinHashOptions {
+  // The k-mer length, between 1 and 32 inclusive.
+  size_t k = 21;
+
+  // The maximum number of hashes kept in a sketch.
+  size_t sketch_size = 1000;
+
+  // The seed of the k-mer hash. Only sketches with the same seed and k-mer
+  // length can be compared.
+  uint64_t seed = 42;
+
+  // The number of threads used to sketch the sequences of a file. If 1 or
+  // less, the sequences are sketched on the calling thread.
+  size_t num_threads = 1;
+};
+
+// A bottom-k MinHash sketch: the `sketch_size` smallest distinct hashes of the
+// canonical k-mers of a set of sequences.
+//
+// Sketches are used to estimate the Jaccard similarity and containment of
+// large k-mer sets, such as those of genomes or read sets, in time linear in
+// the sketch size. See https://doi.org/10.1186/s13059-016-0997-x.
+class MinHashSketch {
+ public:
+  // Constructs an empty sketch.
+  explicit MinHashSketch(const MinHashOptions& options = {})
+      : k_(options.k), sketch_size_(options.sketch_size), seed_(options.seed) {}
+
+  // Serializes a sketch as a short header followed by the delta-encoded,
+  // varint-packed hashes.
+  auto Serialize() const -> std::string;
+
+  // Parses a sketch serialized with Serialize().
+  static auto Deserialize(absl::string_view data)
+      -> absl::StatusOr<MinHashSketch>;
+
+  // Reads a serialized sketch from a file.
+  static auto Read(absl::string_view path) -> absl::StatusOr<MinHashSketch>;
+
+  // Writes the serialized sketch to a file.
+  auto Write(absl::string_view path) const -> absl::Status;
+
+  // Returns the k-mer length.
+  auto k() const -> size_t { return k_; }
+
+  // Returns the maximum number of hashes in the sketch.
+  auto sketch_size() const -> size_t { return sketch_size_; }
+
+  // Returns the hash seed.
+  auto seed() const -> uint64_t { return seed_; }
+
+  // Returns the hashes in ascending order. There are fewer than
+  // sketch_size() hashes only if the sketched sequences have fewer distinct
+  // k-mers.
+  auto hashes() const -> const std::vector<uint64_t>& { return hashes_; }
+
+  // Checks for equality.
+  auto operator==(const MinHashSketch& rhs) const -> bool {
+    return k_ == rhs.k_ && sketch_size_ == rhs.sketch_size_ &&
+           seed_ == rhs.seed_ && hashes_ == rhs.hashes_;
+  }
+
+ private:
+  friend class MinHashSketcher;
+
+  size_t k_;
+  size_t sketch_size_;
+  uint64_t seed_;
+  std::vector<uint64_t> hashes_;
+};
+
+// Builds a MinHashSketch incrementally.
+//
+// Hashes below the current sketch threshold are appended to a buffer that is
+// compacted to the bottom `sketch_size` hashes whenever it fills up, so each
+// k-mer costs a hash and a compare in the common case.
+//
+// Example usage:
+//
+// ```
+// MinHashSketcher sketcher({.k = 21, .sketch_size = 1000});
+// while (!parser->eof()) {
+//   std::optional<std::unique_ptr<FastaSequence>> sequence = parser->Next();
+//   if (!sequence.has_value()) {
+//     break;
+//   }
+//   sketcher.Add((*sequence)->sequence);
+// }
+// MinHashSketch sketch = sketcher.Finish();
+// ```
+class MinHashSketcher {
+ public:
+  // Constructs a sketcher. `options.k` must be between 1 and 32 inclusive and
+  // `options.sketch_size` must be positive.
+  explicit MinHashSketcher(const MinHashOptions& options);
+
+  // Adds the canonical k-mers of `sequence`.
+  auto Add(absl::string_view sequence) -> void;
+
+  // Adds the hashes of `sketch`, which must have been built with the same
+  // k-mer length and seed. The result is the sketch of the union of both
+  // k-mer sets.
+  auto Merge(const MinHashSketch& sketch) -> absl::Status;
+
+  // Returns the sketch of everything added so far.
+  auto Finish() -> MinHashSketch;
+
+ private:
+  // Adds a single k-mer hash.
+  auto AddHash(uint64_t hash) -> void {
+    if (hash < threshold_) {
+      buffer_.push_back(hash);
+      if (buffer_.size() >= max_buffer_size_) {
+        Compact();
+      }
+    }
+  }
+
+  // Reduces the buffer to the bottom sketch_size distinct hashes and lowers
+  // the threshold accordingly.
+  auto Compact() -> void;
+
+  MinHashSketch sketch_;
+  std::vector<uint64_t> buffer_;
+  size_t max_buffer_size_;
+
+  // Hashes at or above the threshold cannot be in the sketch.
+  uint64_t threshold_;
+};
+
+// Estimates the Jaccard similarity of the k-mer sets of `a` and `b` from the
+// bottom hashes of their union. Returns an error if the sketches were built
+// with different k-mer lengths or seeds.
+auto MinHashJaccard(const MinHashSketch& a, const MinHashSketch& b)
+    -> absl::StatusOr<double>;
+
+// Estimates the fraction of the k-mers of `query` that are also in
+// `reference`. Returns an error if the sketches were built with different
+// k-mer lengths or seeds.
+auto MinHashContainment(const MinHashSketch& query,
+                        const MinHashSketch& reference)
+    -> absl::StatusOr<double>;
+
+// Sketches every sequence read from `parser`. Sequences are sketched in
+// batches across MinHashOptions::num_threads threads and the batch sketches
+// are merged.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<FastaParser> parser,
+//                  FastaParser::New("path/to/genome.fasta"));
+// ASSIGN_OR_RETURN(MinHashSketch sketch,
+//                  SketchFasta(parser.get(), {.num_threads = 8}));
+// RETURN_IF_ERROR(sketch.Write("path/to/genome.msh"));
+// ```
+auto SketchFasta(absl::Nonnull<FastaParser*> parser,
+                 const MinHashOptions& options)
+    -> absl::StatusOr<MinHashSketch>;
+
+// Sketches every read from `parser`, as SketchFasta() does.
+auto SketchFastq(absl::Nonnull<FastqParser*> parser,
+                 const MinHashOptions& options)
+    -> absl::StatusOr<MinHashSketch>;
+
+}  // namespace bio
+
+#endif  // BIO_KMER_MINHASH_H_
@@ -0,0 +1,242 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/kmer/minhash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/test-files.h"
+#include "bio/fasta/fasta-parser.h"
+#include "bio/fastq/fastq-parser.h"
+#include "bio/kmer/kmer-iterator.h"
+#include "bio/kmer/kmer.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::DoubleNear;
+using ::testing::ElementsAreArray;
+using ::testing::TempDir;
+
+auto RandomSequence(size_t length, uint32_t seed) -> std::string {
+  static constexpr char kBases[] = "ACGT";
+  std::mt19937 rng(seed);
+  std::string sequence(length, 'A');
+  for (char& base : sequence) {
+    base = kBases[rng() % 4];
+  }
+  return sequence;
+}
+
+auto ReverseComplement(absl::string_view sequence) -> std::string {
+  std::string reverse(sequence.rbegin(), sequence.rend());
+  for (char& base : reverse) {
+    switch (base) {
+      case 'A':
+        base = 'T';
+        break;
+      case 'C':
+        base = 'G';
+        break;
+      case 'G':
+        base = 'C';
+        break;
+      case 'T':
+        base = 'A';
+        break;
+      default:
+        break;
+    }
+  }
+  return reverse;
+}
+
+auto Sketch(absl::string_view sequence, const MinHashOptions& options)
+    -> MinHashSketch {
+  MinHashSketcher sketcher(options);
+  sketcher.Add(sequence);
+  return sketcher.Finish();
+}
+
+TEST(MinHashSketcher, KeepsBottomHashes) {
+  const std::string sequence = RandomSequence(20000, 1);
+  const MinHashOptions options = {.k = 15, .sketch_size = 100};
+  const MinHashSketch sketch = Sketch(sequence, options);
+
+  absl::flat_hash_set<uint64_t> distinct;
+  KmerIterator it(sequence, options.k);
+  for (std::optional<Kmer> kmer = it.Next(); kmer.has_value();
+       kmer = it.Next()) {
+    distinct.insert(HashKmer(kmer->value, options.seed));
+  }
+  std::vector<uint64_t> expected(distinct.begin(), distinct.end());
+  std::sort(expected.begin(), expected.end());
+  expected.resize(options.sketch_size);
+  EXPECT_THAT(sketch.hashes(), ElementsAreArray(expected));
+}
+
+TEST(MinHashSketcher, FewerKmersThanSketchSize) {
+  const MinHashSketch sketch = Sketch("ACGTNACGTACGT", {.k = 4});
+  // ACGT, CGTA (= TACG) and GTAC.
+  EXPECT_EQ(sketch.hashes().size(), 3);
+  EXPECT_TRUE(std::is_sorted(sketch.hashes().begin(), sketch.hashes().end()));
+  EXPECT_TRUE(Sketch("", {}).hashes().empty());
+}
+
+TEST(MinHashSketcher, Canonical) {
+  const std::string sequence = RandomSequence(5000, 2);
+  EXPECT_EQ(Sketch(sequence, {}), Sketch(ReverseComplement(sequence), {}));
+}
+
+TEST(MinHashSketcher, Merge) {
+  const std::string sequence = RandomSequence(50000, 3);
+  MinHashSketcher sketcher({});
+  ASSERT_THAT(sketcher.Merge(Sketch(sequence.substr(0, 30000), {})), IsOk());
+  ASSERT_THAT(sketcher.Merge(Sketch(sequence.substr(29980), {})), IsOk());
+  EXPECT_EQ(sketcher.Finish(), Sketch(sequence, {}));
+  EXPECT_THAT(sketcher.Merge(Sketch(sequence, {.k = 17})),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MinHash, Jaccard) {
+  const std::string sequence = RandomSequence(90000, 4);
+  const MinHashOptions options = {.sketch_size = 2000};
+  const MinHashSketch a = Sketch(sequence.substr(0, 60000), options);
+  const MinHashSketch b = Sketch(sequence.substr(30000), options);
+  const MinHashSketch c = Sketch(RandomSequence(60000, 5), options);
+
+  EXPECT_EQ(*MinHashJaccard(a, a), 1.0);
+  EXPECT_THAT(*MinHashJaccard(a, b), DoubleNear(1.0 / 3, 0.05));
+  EXPECT_THAT(*MinHashJaccard(a, c), DoubleNear(0.0, 0.01));
+  EXPECT_EQ(*MinHashJaccard(a, b), *MinHashJaccard(b, a));
+  EXPECT_EQ(*MinHashJaccard(Sketch("", {}), Sketch("", {})), 0.0);
+  EXPECT_THAT(MinHashJaccard(a, Sketch(sequence, {.seed = 7})),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MinHash, Containment) {
+  const std::string sequence = RandomSequence(200000, 6);
+  const MinHashOptions options = {.sketch_size = 2000};
+  const MinHashSketch genome = Sketch(sequence, options);
+  const MinHashSketch part = Sketch(sequence.substr(50000, 50000), options);
+  const MinHashSketch other = Sketch(RandomSequence(50000, 7), options);
+
+  EXPECT_THAT(*MinHashContainment(part, genome), DoubleNear(1.0, 0.05));
+  EXPECT_THAT(*MinHashContainment(genome, part), DoubleNear(0.25, 0.05));
+  EXPECT_THAT(*MinHashContainment(other, genome), DoubleNear(0.0, 0.01));
+  EXPECT_THAT(MinHashContainment(part, Sketch(sequence, {.k = 31})),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(MinHashSketch, Serialize) {
+  const MinHashSketch sketch =
+      Sketch(RandomSequence(100000, 8), {.k = 31, .sketch_size = 1000});
+  const std::string data = sketch.Serialize();
+  // Deltas between the bottom 1000 of 2^64 hashes fit in about 7 bytes.
+  EXPECT_LT(data.size(), 7.5 * sketch.hashes().size());
+
+  absl::StatusOr<MinHashSketch> parsed = MinHashSketch::Deserialize(data);
+  ASSERT_THAT(parsed, IsOk());
+  EXPECT_EQ(*parsed, sketch);
+
+  const std::string path = gxl::JoinPath(TempDir(), "sketch.msh");
+  ASSERT_THAT(sketch.Write(path), IsOk());
+  absl::StatusOr<MinHashSketch> read = MinHashSketch::Read(path);
+  ASSERT_THAT(read, IsOk());
+  EXPECT_EQ(*read, sketch);
+
+  const MinHashSketch empty({.k = 5});
+  EXPECT_EQ(*MinHashSketch::Deserialize(empty.Serialize()), empty);
+}
+
+TEST(MinHashSketch, DeserializeInvalid) {
+  const std::string data = Sketch(RandomSequence(1000, 9), {}).Serialize();
+  EXPECT_THAT(MinHashSketch::Deserialize("not a sketch"),
+              StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(MinHashSketch::Deserialize(data.substr(0, data.size() - 1)),
+              StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(MinHashSketch::Deserialize(absl::StrCat(data, "x")),
+              StatusIs(absl::StatusCode::kDataLoss));
+  EXPECT_THAT(MinHashSketch::Deserialize(absl::StrCat(
+                  absl::string_view(data).substr(0, 4), "\x00\x01\x00\x00")),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(SketchFasta, MatchesSequentialSketch) {
+  std::string contents;
+  MinHashSketcher expected({.sketch_size = 500});
+  for (int i = 0; i < 20; ++i) {
+    const std::string sequence = RandomSequence(10000 + 997 * i, 10 + i);
+    absl::StrAppend(&contents, ">seq", i, "\n", sequence, "\n");
+    expected.Add(sequence);
+  }
+  const std::string path = WriteTempFile("minhash.fasta", contents);
+
+  for (size_t num_threads : {1, 4}) {
+    std::unique_ptr<FastaParser> parser = FastaParser::NewOrDie(path);
+    absl::StatusOr<MinHashSketch> sketch = SketchFasta(
+        parser.get(), {.sketch_size = 500, .num_threads = num_threads});
+    ASSERT_THAT(sketch, IsOk());
+    EXPECT_EQ(*sketch, expected.Finish()) << num_threads << " threads";
+  }
+}
+
+TEST(SketchFastq, MatchesSequentialSketch) {
+  std::string contents;
+  MinHashSketcher expected({.k = 25});
+  for (int i = 0; i < 5000; ++i) {
+    const std::string read = RandomSequence(150, 100 + i);
+    absl::StrAppend(&contents, "@read", i, "\n", read, "\n+\n",
+                    std::string(read.size(), 'I'), "\n");
+    expected.Add(read);
+  }
+  const std::string path = WriteTempFile("minhash.fastq", contents);
+
+  for (size_t num_threads : {1, 3}) {
+    std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(path);
+    absl::StatusOr<MinHashSketch> sketch =
+        SketchFastq(parser.get(), {.k = 25, .num_threads = num_threads});
+    ASSERT_THAT(sketch, IsOk());
+    EXPECT_EQ(*sketch, expected.Finish()) << num_threads << " threads";
+  }
+}
+
+TEST(SketchFastq, InvalidOptions) {
+  std::unique_ptr<FastqParser> parser = FastqParser::NewOrDie(
+      WriteTempFile("options.fastq", "@read\nACGT\n+\nIIII\n"));
+  EXPECT_THAT(SketchFastq(parser.get(), {.k = 33}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(SketchFastq(parser.get(), {.sketch_size = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace bio
@@ -0,0 +1,92 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/kmer/minimizer-iterator.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+#include "absl/log/check.h"
+#include "absl/strings/string_view.h"
+#include "bio/kmer/kmer-iterator.h"
+#include "bio/kmer/kmer.h"
+
+namespace bio {
+
+MinimizerIterator::MinimizerIterator(absl::string_view sequence, size_t w,
+                                     size_t k, uint64_t seed)
+    : kmers_(sequence, k),
+      w_(w),
+      seed_(seed),
+      queue_front_(0),
+      queue_size_(0),
+      run_kmers_(0) {
+  CHECK(w >= 1) << "Invalid window size: " << w;  // Crash OK
+  queue_.resize(w);
+}
+
+auto MinimizerIterator::Reset() -> void {
+  queue_front_ = 0;
+  queue_size_ = 0;
+  run_kmers_ = 0;
+}
+
+auto MinimizerIterator::Next() -> std::optional<Minimizer> {
+  for (std::optional<Kmer> kmer = kmers_.Next(); kmer.has_value();
+       kmer = kmers_.Next()) {
+    // A gap in the k-mer positions means that an invalid base was skipped,
+    // which ends the current run of windows.
+    if (last_kmer_position_.has_value() &&
+        kmer->position != *last_kmer_position_ + 1) {
+      Reset();
+    }
+    last_kmer_position_ = kmer->position;
+
+    // Drop the front of the queue once it falls out of the window.
+    if (queue_size_ > 0 &&
+        queue_[queue_front_].position + w_ <= kmer->position) {
+      queue_front_ = (queue_front_ + 1) % w_;
+      --queue_size_;
+    }
+
+    // Drop k-mers from the back that can no longer be the minimum of any
+    // window, then append the new k-mer.
+    const uint64_t hash = HashKmer(kmer->value, seed_);
+    while (queue_size_ > 0 &&
+           queue_[(queue_front_ + queue_size_ - 1) % w_].hash > hash) {
+      --queue_size_;
+    }
+    queue_[(queue_front_ + queue_size_) % w_] = {
+        .hash = hash,
+        .kmer = kmer->value,
+        .position = kmer->position,
+        .strand = kmer->strand,
+    };
+    ++queue_size_;
+
+    ++run_kmers_;
+    if (run_kmers_ < w_) {
+      continue;
+    }
+    const Minimizer& minimizer = queue_[queue_front_];
+    if (last_minimizer_position_ != minimizer.position) {
+      last_minimizer_position_ = minimizer.position;
+      return minimizer;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace bio
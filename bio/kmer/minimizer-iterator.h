@@ -0,0 +1,112 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_KMER_MINIMIZER_ITERATOR_H_
+#define BIO_KMER_MINIMIZER_ITERATOR_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "bio/common/sequence.h"
+#include "bio/kmer/kmer-iterator.h"
+#include "bio/kmer/kmer.h"
+
+namespace bio {
+
+// A (w,k)-minimizer.
+struct Minimizer {
+  // The hash of the canonical k-mer, which determines the minimizer order.
+  uint64_t hash;
+
+  // The canonical k-mer.
+  uint64_t kmer;
+
+  // The 0-based position of the first base of the k-mer in the sequence.
+  size_t position;
+
+  // The strand of the canonical k-mer.
+  Strand strand;
+
+  // Checks for equality.
+  auto operator==(const Minimizer& rhs) const -> bool {
+    return hash == rhs.hash && kmer == rhs.kmer && position == rhs.position &&
+           strand == rhs.strand;
+  }
+};
+
+// Iterates over the (w,k)-minimizers of a sequence: for every window of `w`
+// consecutive k-mers, the k-mer with the smallest hash (HashKmer()) is
+// selected, and each selected k-mer is returned once. Ties are broken in favor
+// of the leftmost k-mer.
+//
+// The minimum of each window is maintained with a monotone queue, so the
+// iterator does a constant amount of amortized work per k-mer. Windows may not
+// span a base that is not A, C, G, T or U; such a base restarts the window.
+//
+// The iterator does not copy the sequence, which must outlive it.
+//
+// Example usage:
+//
+// ```
+// MinimizerIterator it(sequence->sequence, /*w=*/10, /*k=*/15);
+// while (!it.eol()) {
+//   std::optional<Minimizer> minimizer = it.Next();
+//   if (!minimizer.has_value()) {
+//     break;
+//   }
+//   // Do stuff with `minimizer`.
+// }
+// ```
+class MinimizerIterator {
+ public:
+  // Constructs an iterator over the minimizers of `sequence`. `w` must be at
+  // least 1 and `k` must be between 1 and 32, inclusive.
+  MinimizerIterator(absl::string_view sequence, size_t w, size_t k,
+                    uint64_t seed = 0);
+
+  // Returns the next minimizer, or std::nullopt if there are no more
+  // minimizers in the sequence.
+  auto Next() -> std::optional<Minimizer>;
+
+  // Returns true if the end of the sequence has been reached.
+  auto eol() const -> bool { return kmers_.eol(); }
+
+ private:
+  // Discards the contents of the window.
+  auto Reset() -> void;
+
+  KmerIterator kmers_;
+  size_t w_;
+  uint64_t seed_;
+
+  // Ring buffer holding the monotone queue. Hashes never decrease from front
+  // to back.
+  std::vector<Minimizer> queue_;
+  size_t queue_front_;
+  size_t queue_size_;
+
+  // The number of consecutive k-mers in the current run.
+  size_t run_kmers_;
+
+  // The position of the last k-mer and the last minimizer returned, if any.
+  std::optional<size_t> last_kmer_position_;
+  std::optional<size_t> last_minimizer_position_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_KMER_MINIMIZER_ITERATOR_H_
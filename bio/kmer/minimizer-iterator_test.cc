@@ -0,0 +1,114 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/kmer/minimizer-iterator.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "bio/kmer/kmer-iterator.h"
+#include "bio/kmer/kmer.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+auto CollectMinimizers(absl::string_view sequence, size_t w, size_t k)
+    -> std::vector<Minimizer> {
+  std::vector<Minimizer> minimizers;
+  MinimizerIterator it(sequence, w, k);
+  while (!it.eol()) {
+    std::optional<Minimizer> minimizer = it.Next();
+    if (!minimizer.has_value()) {
+      break;
+    }
+    minimizers.push_back(*minimizer);
+  }
+  return minimizers;
+}
+
+// Computes the minimizers of `sequence` by scanning every window.
+auto NaiveMinimizers(absl::string_view sequence, size_t w, size_t k)
+    -> std::vector<Minimizer> {
+  // Split the k-mers into runs of consecutive positions.
+  std::vector<std::vector<Minimizer>> runs;
+  KmerIterator it(sequence, k);
+  for (std::optional<Kmer> kmer = it.Next(); kmer.has_value();
+       kmer = it.Next()) {
+    if (runs.empty() || runs.back().back().position + 1 != kmer->position) {
+      runs.emplace_back();
+    }
+    runs.back().push_back(
+        {HashKmer(kmer->value), kmer->value, kmer->position, kmer->strand});
+  }
+
+  std::vector<Minimizer> minimizers;
+  for (const auto& run : runs) {
+    for (size_t start = 0; start + w <= run.size(); ++start) {
+      const Minimizer* min = &run[start];
+      for (size_t i = start + 1; i < start + w; ++i) {
+        if (run[i].hash < min->hash) {
+          min = &run[i];
+        }
+      }
+      if (minimizers.empty() || minimizers.back().position != min->position) {
+        minimizers.push_back(*min);
+      }
+    }
+  }
+  return minimizers;
+}
+
+TEST(MinimizerIterator, Empty) {
+  MinimizerIterator it("", 5, 3);
+  EXPECT_TRUE(it.eol());
+  EXPECT_EQ(it.Next(), std::nullopt);
+}
+
+TEST(MinimizerIterator, FewerKmersThanWindow) {
+  EXPECT_THAT(CollectMinimizers("ACGTAC", 5, 3), IsEmpty());
+}
+
+TEST(MinimizerIterator, WindowOfOneReturnsEveryKmer) {
+  const std::vector<Minimizer> minimizers =
+      CollectMinimizers("ACGTACGTTT", 1, 4);
+  ASSERT_EQ(minimizers.size(), 7);
+  for (size_t i = 0; i < minimizers.size(); ++i) {
+    EXPECT_EQ(minimizers[i].position, i);
+  }
+}
+
+TEST(MinimizerIterator, MatchesNaive) {
+  const std::string sequence =
+      "GATTACAGATTACANNCCGGTTAACGTACGTAGCTAGCTAGGCTAGCGATCGATCGNATCGATCGGCT"
+      "AGCTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTTAAAAAAACGTGCACGTGAAACCCGGGTTTA"
+      "CGATCGATCGACTGACTAGCTACGACTNNNNNNNNNNACGACGTAGCTAGCTGCTAGTCGATCGATG";
+  for (size_t w : {1, 2, 4, 10, 25}) {
+    for (size_t k : {3, 7, 15, 21, 32}) {
+      EXPECT_THAT(CollectMinimizers(sequence, w, k),
+                  ElementsAreArray(NaiveMinimizers(sequence, w, k)))
+          << "w = " << w << ", k = " << k;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace bio
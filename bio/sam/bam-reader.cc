@@ -0,0 +1,415 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/bam-reader.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-reader.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/sam.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+static constexpr absl::string_view kBamMagic("BAM\1", 4);
+
+// The size of the fixed-length fields of an alignment record, from refID to
+// tlen.
+static constexpr size_t kFixedFieldsSize = 32;
+
+// The bases encoded by the 4-bit codes of the SEQ field.
+static constexpr absl::string_view kBases = "=ACMGRSVTWYHKDBN";
+
+// The first byte of the QUAL field when the qualities are absent.
+static constexpr uint8_t kMissingQuality = 0xff;
+
+// BAM encodes CIGAR operations in the order of CigarType, from M (0) to X (8).
+static_assert(static_cast<int>(CigarType::kSequenceMismatch) == 8);
+static constexpr uint32_t kNumCigarTypes = 9;
+
+auto LoadLittleEndian16(const char* data) -> uint16_t {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  return bytes[0] | (bytes[1] << 8);
+}
+
+auto LoadLittleEndian32(const char* data) -> uint32_t {
+  return LoadLittleEndian16(data) |
+         (static_cast<uint32_t>(LoadLittleEndian16(data + 2)) << 16);
+}
+
+auto TruncatedError() -> absl::Status {
+  return absl::DataLossError("Truncated record");
+}
+
+// Reads exactly `size` bytes from `reader` into `out`.
+auto ReadExactly(BgzfReader* reader, size_t size, std::string* out)
+    -> absl::Status {
+  RETURN_IF_ERROR(reader->Read(size, out));
+  if (out->size() < size) {
+    return absl::DataLossError(absl::StrFormat(
+        "Offset %d: Unexpected end of file", reader->tell()));
+  }
+  return absl::OkStatus();
+}
+
+auto ReadHeader(BgzfReader* reader) -> absl::StatusOr<SamHeader> {
+  SamHeader header;
+  std::string buffer;
+  RETURN_IF_ERROR(ReadExactly(reader, kBamMagic.size() + 4, &buffer));
+  if (absl::string_view(buffer).substr(0, kBamMagic.size()) != kBamMagic) {
+    return absl::InvalidArgumentError("Not a BAM file");
+  }
+  const uint32_t text_size = LoadLittleEndian32(buffer.data() + 4);
+  RETURN_IF_ERROR(ReadExactly(reader, text_size, &header.text));
+  // The text may be padded with NULs.
+  header.text.resize(std::strlen(header.text.c_str()));
+
+  RETURN_IF_ERROR(ReadExactly(reader, 4, &buffer));
+  const uint32_t num_references = LoadLittleEndian32(buffer.data());
+  for (uint32_t i = 0; i < num_references; ++i) {
+    RETURN_IF_ERROR(ReadExactly(reader, 4, &buffer));
+    const uint32_t name_size = LoadLittleEndian32(buffer.data());
+    RETURN_IF_ERROR(ReadExactly(reader, name_size + 4, &buffer));
+    if (name_size == 0 || buffer[name_size - 1] != '\0') {
+      return absl::DataLossError(
+          absl::StrFormat("Reference %d: Invalid name", i));
+    }
+    header.references.push_back({
+        .name = buffer.substr(0, name_size - 1),
+        .length = LoadLittleEndian32(buffer.data() + name_size),
+    });
+  }
+  return header;
+}
+
+// Returns the name of the reference with index `id`, or "*" if `id` is -1.
+auto ReferenceName(int32_t id, const std::vector<SamReference>& references)
+    -> absl::StatusOr<std::string> {
+  if (id == -1) {
+    return "*";
+  }
+  if (id < 0 || static_cast<size_t>(id) >= references.size()) {
+    return absl::DataLossError(
+        absl::StrFormat("Invalid reference index %d", id));
+  }
+  return references[id].name;
+}
+
+auto DecodeCigarOperation(uint32_t value)
+    -> absl::StatusOr<CigarOperation> {
+  const uint32_t type = value & 0xf;
+  if (type >= kNumCigarTypes) {
+    return absl::DataLossError(
+        absl::StrFormat("Invalid CIGAR operation %d", type));
+  }
+  return CigarOperation{
+      .type = static_cast<CigarType>(type),
+      .length = value >> 4,
+  };
+}
+
+// Decodes the 4-bit encoded SEQ field of `length` bases.
+auto DecodeSequence(absl::string_view packed, size_t length) -> std::string {
+  // The pair of bases encoded by each byte.
+  static const std::array<std::array<char, 2>, 256> kBasePairs = [] {
+    std::array<std::array<char, 2>, 256> pairs;
+    for (int i = 0; i < 256; ++i) {
+      pairs[i] = {kBases[i >> 4], kBases[i & 0xf]};
+    }
+    return pairs;
+  }();
+
+  std::string sequence(length, '\0');
+  for (size_t i = 0; i < length / 2; ++i) {
+    std::memcpy(&sequence[2 * i],
+                kBasePairs[static_cast<uint8_t>(packed[i])].data(), 2);
+  }
+  if (length % 2 == 1) {
+    sequence[length - 1] =
+        kBasePairs[static_cast<uint8_t>(packed[length / 2])][0];
+  }
+  return sequence;
+}
+
+// Returns the size of a value of the numeric tag type `type`, or 0 if `type`
+// is not numeric.
+auto NumericSize(char type) -> size_t {
+  switch (type) {
+    case 'c':
+    case 'C':
+      return 1;
+    case 's':
+    case 'S':
+      return 2;
+    case 'i':
+    case 'I':
+    case 'f':
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+// Appends the text of the numeric value of type `type` at `data` to `out`.
+auto AppendNumber(char type, const char* data, std::string* out) -> void {
+  switch (type) {
+    case 'c':
+      absl::StrAppend(out, static_cast<int8_t>(data[0]));
+      break;
+    case 'C':
+      absl::StrAppend(out, static_cast<uint8_t>(data[0]));
+      break;
+    case 's':
+      absl::StrAppend(out, static_cast<int16_t>(LoadLittleEndian16(data)));
+      break;
+    case 'S':
+      absl::StrAppend(out, LoadLittleEndian16(data));
+      break;
+    case 'i':
+      absl::StrAppend(out, static_cast<int32_t>(LoadLittleEndian32(data)));
+      break;
+    case 'I':
+      absl::StrAppend(out, LoadLittleEndian32(data));
+      break;
+    case 'f': {
+      const uint32_t bits = LoadLittleEndian32(data);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      absl::StrAppend(out, value);
+      break;
+    }
+  }
+}
+
+// Decodes the next tag in `tags` into its SAM text, "TAG:TYPE:VALUE", and
+// removes it from `tags`. If `long_cigar` is not null, a CG tag holding a long
+// CIGAR is decoded into it instead and an empty string is returned.
+auto DecodeTag(absl::string_view* tags, Cigar* long_cigar)
+    -> absl::StatusOr<std::string> {
+  if (tags->size() < 3) {
+    return TruncatedError();
+  }
+  const absl::string_view name = tags->substr(0, 2);
+  const char type = (*tags)[2];
+  tags->remove_prefix(3);
+
+  std::string text = absl::StrCat(name, ":");
+  if (const size_t size = NumericSize(type); size > 0) {
+    if (tags->size() < size) {
+      return TruncatedError();
+    }
+    absl::StrAppend(&text, type == 'f' ? "f:" : "i:");
+    AppendNumber(type, tags->data(), &text);
+    tags->remove_prefix(size);
+    return text;
+  }
+  switch (type) {
+    case 'A':
+      if (tags->empty()) {
+        return TruncatedError();
+      }
+      absl::StrAppend(&text, "A:", tags->substr(0, 1));
+      tags->remove_prefix(1);
+      return text;
+    case 'Z':
+    case 'H': {
+      const size_t end = tags->find('\0');
+      if (end == absl::string_view::npos) {
+        return TruncatedError();
+      }
+      absl::StrAppend(&text, absl::string_view(&type, 1), ":",
+                      tags->substr(0, end));
+      tags->remove_prefix(end + 1);
+      return text;
+    }
+    case 'B': {
+      if (tags->size() < 5) {
+        return TruncatedError();
+      }
+      const char subtype = (*tags)[0];
+      const size_t size = NumericSize(subtype);
+      const uint64_t count = LoadLittleEndian32(tags->data() + 1);
+      tags->remove_prefix(5);
+      if (size == 0) {
+        return absl::DataLossError(absl::StrFormat(
+            "Invalid array type '%c' for tag %s", subtype, name));
+      }
+      if (tags->size() < count * size) {
+        return TruncatedError();
+      }
+      if (long_cigar != nullptr && name == "CG" && subtype == 'I') {
+        long_cigar->operations.clear();
+        for (uint64_t i = 0; i < count; ++i) {
+          ASSIGN_OR_RETURN(
+              CigarOperation operation,
+              DecodeCigarOperation(LoadLittleEndian32(tags->data() + 4 * i)));
+          long_cigar->operations.push_back(operation);
+        }
+        tags->remove_prefix(count * size);
+        return std::string();
+      }
+      absl::StrAppend(&text, "B:", absl::string_view(&subtype, 1));
+      for (uint64_t i = 0; i < count; ++i) {
+        text.push_back(',');
+        AppendNumber(subtype, tags->data() + i * size, &text);
+      }
+      tags->remove_prefix(count * size);
+      return text;
+    }
+    default:
+      return absl::DataLossError(
+          absl::StrFormat("Invalid type '%c' for tag %s", type, name));
+  }
+}
+
+// Decodes an alignment record, without its leading block_size field.
+auto DecodeRecord(absl::string_view record,
+                  const std::vector<SamReference>& references)
+    -> absl::StatusOr<std::unique_ptr<SamEntry>> {
+  if (record.size() < kFixedFieldsSize) {
+    return TruncatedError();
+  }
+  const char* fields = record.data();
+  const auto ref_id = static_cast<int32_t>(LoadLittleEndian32(fields));
+  const auto pos = static_cast<int32_t>(LoadLittleEndian32(fields + 4));
+  const uint8_t name_size = fields[8];
+  const uint16_t num_operations = LoadLittleEndian16(fields + 12);
+  const uint32_t length = LoadLittleEndian32(fields + 16);
+  const auto next_ref_id =
+      static_cast<int32_t>(LoadLittleEndian32(fields + 20));
+  const auto next_pos = static_cast<int32_t>(LoadLittleEndian32(fields + 24));
+  record.remove_prefix(kFixedFieldsSize);
+  if (record.size() < name_size + 4 * static_cast<uint64_t>(num_operations) +
+                          (length + uint64_t{1}) / 2 + length) {
+    return TruncatedError();
+  }
+
+  auto entry = std::make_unique<SamEntry>();
+  if (name_size == 0 || record[name_size - 1] != '\0') {
+    return absl::DataLossError("Invalid read name");
+  }
+  entry->qname = std::string(record.substr(0, name_size - 1));
+  record.remove_prefix(name_size);
+  entry->flags = LoadLittleEndian16(fields + 14);
+  ASSIGN_OR_RETURN(entry->rname, ReferenceName(ref_id, references));
+  entry->pos = static_cast<uint32_t>(pos + 1);
+  entry->mapq = fields[9];
+
+  entry->cigar.operations.reserve(num_operations);
+  for (int i = 0; i < num_operations; ++i) {
+    ASSIGN_OR_RETURN(CigarOperation operation,
+                     DecodeCigarOperation(LoadLittleEndian32(record.data())));
+    entry->cigar.operations.push_back(operation);
+    record.remove_prefix(4);
+  }
+
+  if (next_ref_id != -1 && next_ref_id == ref_id) {
+    entry->rnext = "=";
+  } else {
+    ASSIGN_OR_RETURN(entry->rnext, ReferenceName(next_ref_id, references));
+  }
+  entry->pnext = static_cast<uint32_t>(next_pos + 1);
+  entry->tlen = static_cast<int32_t>(LoadLittleEndian32(fields + 28));
+
+  if (length > 0) {
+    entry->seq = DecodeSequence(record, length);
+  }
+  record.remove_prefix((length + 1) / 2);
+  if (length > 0 && static_cast<uint8_t>(record[0]) != kMissingQuality) {
+    std::string& qual = entry->qual.emplace(record.substr(0, length));
+    for (char& c : qual) {
+      c += 33;
+    }
+  }
+  record.remove_prefix(length);
+
+  // A CIGAR with more operations than fit in the record is stored in the CG
+  // tag, and the CIGAR field holds a placeholder of the form <length>S<n>N.
+  const std::vector<CigarOperation>& operations = entry->cigar.operations;
+  const bool long_cigar = operations.size() == 2 &&
+                          operations[0].type == CigarType::kSoftClipping &&
+                          operations[0].length == length &&
+                          operations[1].type == CigarType::kSkippedRegion;
+  while (!record.empty()) {
+    ASSIGN_OR_RETURN(std::string tag,
+                     DecodeTag(&record, long_cigar ? &entry->cigar : nullptr));
+    if (!tag.empty()) {
+      entry->tags.push_back(std::move(tag));
+    }
+  }
+  return entry;
+}
+
+}  // namespace
+
+auto BamReader::New(absl::string_view path, const BamReaderOptions& options)
+    -> absl::StatusOr<std::unique_ptr<BamReader>> {
+  ASSIGN_OR_RETURN(std::unique_ptr<BgzfReader> reader,
+                   BgzfReader::New(path, {.num_threads = options.num_threads}));
+  absl::StatusOr<SamHeader> header = ReadHeader(reader.get());
+  if (!header.ok()) {
+    return absl::Status(header.status().code(),
+                        absl::StrFormat("%s: %s", path,
+                                        header.status().message()));
+  }
+  return std::unique_ptr<BamReader>(
+      new BamReader(std::move(reader), *std::move(header)));
+}
+
+auto BamReader::NewOrDie(absl::string_view path,
+                         const BamReaderOptions& options)
+    -> std::unique_ptr<BamReader> {
+  absl::StatusOr<std::unique_ptr<BamReader>> reader = New(path, options);
+  CHECK_OK(reader.status());
+  return std::move(reader.value());
+}
+
+auto BamReader::Next() -> absl::StatusOr<std::unique_ptr<SamEntry>> {
+  RETURN_IF_ERROR(reader_->Read(4, &record_));
+  if (record_.empty()) {
+    return nullptr;
+  }
+  absl::StatusOr<std::unique_ptr<SamEntry>> entry = TruncatedError();
+  if (record_.size() == 4) {
+    const uint32_t size = LoadLittleEndian32(record_.data());
+    RETURN_IF_ERROR(reader_->Read(size, &record_));
+    if (record_.size() == size) {
+      entry = DecodeRecord(record_, header_.references);
+    }
+  }
+  if (!entry.ok()) {
+    return absl::Status(entry.status().code(),
+                        absl::StrFormat("Record %d: %s", records_read_ + 1,
+                                        entry.status().message()));
+  }
+  ++records_read_;
+  return entry;
+}
+
+}  // namespace bio
@@ -0,0 +1,102 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_SAM_BAM_READER_H_
+#define BIO_SAM_BAM_READER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-reader.h"
+#include "bio/sam/sam.h"
+
+namespace bio {
+
+// Options for BamReader.
+struct BamReaderOptions {
+  // The number of threads that decompress BGZF blocks.
+  size_t num_threads = 4;
+};
+
+// Reader for BAM files, the BGZF-compressed binary form of SAM. Records are
+// decoded directly into SamEntry, with the same field values as SamParser
+// returns for the equivalent SAM text:
+//
+//  * RNAME and RNEXT are looked up in the header's reference list, and RNEXT
+//    is "=" when it is the same reference as RNAME.
+//  * POS and PNEXT are 1-based, and 0 for unmapped records.
+//  * Optional tags are formatted as "TAG:TYPE:VALUE". Integer tags of every
+//    width have type 'i', as in SAM.
+//  * CIGARs too long for the BAM CIGAR field are taken from the CG tag.
+//
+// See section 4.2 of https://samtools.github.io/hts-specs/SAMv1.pdf for the
+// format.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<BamReader> reader,
+//                  BamReader::New("path/to/file.bam", {.num_threads = 8}));
+// while (true) {
+//   ASSIGN_OR_RETURN(std::unique_ptr<SamEntry> entry, reader->Next());
+//   if (entry == nullptr) {
+//     break;
+//   }
+//   // Do stuff with entry.
+// }
+// ```
+class BamReader {
+ public:
+  BamReader(const BamReader&) = delete;
+  auto operator=(const BamReader&) -> BamReader& = delete;
+
+  // Opens the BAM file at `path` and reads its header.
+  static auto New(absl::string_view path, const BamReaderOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<BamReader>>;
+
+  // Opens the BAM file at `path` or terminates the program if opening the file
+  // or reading its header fails.
+  static auto NewOrDie(absl::string_view path,
+                       const BamReaderOptions& options = {})
+      -> std::unique_ptr<BamReader>;
+
+  // Returns the header of the file.
+  auto header() const -> const SamHeader& { return header_; }
+
+  // Returns the next alignment, or nullptr at the end of the file.
+  auto Next() -> absl::StatusOr<std::unique_ptr<SamEntry>>;
+
+  // Returns the number of alignments read so far.
+  auto records_read() const -> uint64_t { return records_read_; }
+
+ private:
+  BamReader(std::unique_ptr<BgzfReader> reader, SamHeader header)
+      : reader_(std::move(reader)), header_(std::move(header)) {}
+
+  std::unique_ptr<BgzfReader> reader_;
+  SamHeader header_;
+  uint64_t records_read_ = 0;
+
+  // The raw bytes of the record being decoded, kept to reuse its allocation.
+  std::string record_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_SAM_BAM_READER_H_
@@ -0,0 +1,339 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/bam-reader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf.h"
+#include "bio/common/test-files.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/sam-parser.h"
+#include "bio/sam/sam.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::TempDir;
+
+static constexpr absl::string_view kHeaderText =
+    "@HD\tVN:1.6\tSO:coordinate\n@SQ\tSN:ref\tLN:45\n";
+
+auto U16(uint16_t value) -> std::string {
+  return std::string({static_cast<char>(value), static_cast<char>(value >> 8)});
+}
+
+auto U32(uint32_t value) -> std::string {
+  return absl::StrCat(U16(value), U16(value >> 16));
+}
+
+// Returns the BAM encoding of the CIGAR operation `length``type`.
+auto Op(uint32_t length, char type) -> uint32_t {
+  return length << 4 | absl::string_view("MIDNSHP=X").find(type);
+}
+
+// The fields of a BAM alignment record.
+struct TestRecord {
+  std::string qname;
+  uint16_t flags = 0;
+  int32_t ref_id = -1;
+  int32_t pos = -1;
+  uint8_t mapq = 0;
+  std::vector<uint32_t> cigar;
+  int32_t next_ref_id = -1;
+  int32_t next_pos = -1;
+  int32_t tlen = 0;
+  std::string seq;
+  // Phred scores without an offset. If empty, the qualities are absent.
+  std::string qual;
+  // Binary encoded tags.
+  std::string tags;
+};
+
+auto Encode(const TestRecord& record) -> std::string {
+  std::string data = absl::StrCat(
+      U32(record.ref_id), U32(record.pos),
+      std::string(1, static_cast<char>(record.qname.size() + 1)),
+      std::string(1, static_cast<char>(record.mapq)), U16(0),
+      U16(record.cigar.size()), U16(record.flags), U32(record.seq.size()),
+      U32(record.next_ref_id), U32(record.next_pos), U32(record.tlen),
+      record.qname, std::string(1, '\0'));
+  for (const uint32_t operation : record.cigar) {
+    data.append(U32(operation));
+  }
+  std::string packed((record.seq.size() + 1) / 2, '\0');
+  for (size_t i = 0; i < record.seq.size(); ++i) {
+    const size_t code = absl::string_view("=ACMGRSVTWYHKDBN").find(
+        record.seq[i]);
+    packed[i / 2] |= i % 2 == 0 ? code << 4 : code;
+  }
+  data.append(packed);
+  data.append(record.qual.empty() ? std::string(record.seq.size(), '\xff')
+                                  : record.qual);
+  data.append(record.tags);
+  return absl::StrCat(U32(data.size()), data);
+}
+
+auto EncodeHeader(absl::string_view text,
+                  const std::vector<SamReference>& references)
+    -> std::string {
+  std::string data = absl::StrCat("BAM\1", U32(text.size()), text,
+                                  U32(references.size()));
+  for (const SamReference& reference : references) {
+    absl::StrAppend(&data, U32(reference.name.size() + 1), reference.name,
+                    std::string(1, '\0'), U32(reference.length));
+  }
+  return data;
+}
+
+// Writes `data` as a BGZF file of `block_size` blocks and returns its path.
+auto WriteBam(absl::string_view name, absl::string_view data,
+              size_t block_size = kBgzfMaxDataSize) -> std::string {
+  std::string contents;
+  for (size_t i = 0; i < data.size(); i += block_size) {
+    EXPECT_THAT(DeflateBgzfBlock(data.substr(i, block_size), 6, &contents),
+                IsOk());
+  }
+  contents.append(BgzfEofBlock());
+  return WriteTempFile(name, contents);
+}
+
+auto WriteBam(absl::string_view name,
+              const std::vector<TestRecord>& records) -> std::string {
+  std::string data = EncodeHeader(kHeaderText, {{.name = "ref", .length = 45}});
+  for (const TestRecord& record : records) {
+    data.append(Encode(record));
+  }
+  return WriteBam(name, data);
+}
+
+auto ExpectSameEntry(const SamEntry& actual, const SamEntry& expected)
+    -> void {
+  EXPECT_EQ(actual.qname, expected.qname);
+  EXPECT_EQ(actual.flags, expected.flags);
+  EXPECT_EQ(actual.rname, expected.rname);
+  EXPECT_EQ(actual.pos, expected.pos);
+  EXPECT_EQ(actual.mapq, expected.mapq);
+  EXPECT_EQ(actual.cigar, expected.cigar);
+  EXPECT_EQ(actual.rnext, expected.rnext);
+  EXPECT_EQ(actual.pnext, expected.pnext);
+  EXPECT_EQ(actual.tlen, expected.tlen);
+  EXPECT_EQ(actual.seq, expected.seq);
+  EXPECT_EQ(actual.qual, expected.qual);
+  EXPECT_EQ(actual.tags, expected.tags);
+}
+
+TEST(BamReader, MatchesSamParser) {
+  const std::string path = WriteBam(
+      "matches.bam",
+      {{
+           .qname = "r001",
+           .flags = 99,
+           .ref_id = 0,
+           .pos = 6,
+           .mapq = 30,
+           .cigar = {Op(8, 'M'), Op(2, 'I'), Op(4, 'M'), Op(1, 'D'),
+                     Op(3, 'M')},
+           .next_ref_id = 0,
+           .next_pos = 36,
+           .tlen = 39,
+           .seq = "TTAGATAAAGGATACTG",
+       },
+       {
+           .qname = "r003",
+           .ref_id = 0,
+           .pos = 8,
+           .mapq = 30,
+           .cigar = {Op(5, 'S'), Op(6, 'M')},
+           .seq = "GCCTAAGCTAA",
+           .tags = absl::StrCat("SAZref,29,-,6H5M,17,0;", std::string(1, 0)),
+       }});
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(path);
+  EXPECT_EQ(reader->header().text, kHeaderText);
+  EXPECT_THAT(reader->header().references,
+              ElementsAre(SamReference{.name = "ref", .length = 45}));
+
+  for (absl::string_view sam_path : {"bio/sam/testdata/minimal-fields.sam",
+                                     "bio/sam/testdata/with-tags.sam"}) {
+    absl::StatusOr<std::unique_ptr<SamEntry>> expected =
+        SamParser::NewOrDie(sam_path)->Next();
+    ASSERT_THAT(expected, IsOk());
+    absl::StatusOr<std::unique_ptr<SamEntry>> entry = reader->Next();
+    ASSERT_THAT(entry, IsOk());
+    ASSERT_NE(*entry, nullptr);
+    ExpectSameEntry(**entry, **expected);
+  }
+  absl::StatusOr<std::unique_ptr<SamEntry>> entry = reader->Next();
+  ASSERT_THAT(entry, IsOk());
+  EXPECT_EQ(*entry, nullptr);
+  EXPECT_EQ(reader->records_read(), 2);
+}
+
+TEST(BamReader, Header) {
+  const std::string text = "@HD\tVN:1.6\n@SQ\tSN:chr1\tLN:1000\n";
+  const std::string path = WriteBam(
+      "header.bam",
+      EncodeHeader(absl::StrCat(text, std::string(5, '\0')),
+                   {{.name = "chr1", .length = 1000},
+                    {.name = "chrM", .length = 16569}}));
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(path);
+  EXPECT_EQ(reader->header().text, text);
+  EXPECT_THAT(reader->header().references,
+              ElementsAre(SamReference{.name = "chr1", .length = 1000},
+                          SamReference{.name = "chrM", .length = 16569}));
+  EXPECT_EQ(*reader->Next(), nullptr);
+}
+
+TEST(BamReader, UnmappedWithQualities) {
+  std::unique_ptr<BamReader> reader =
+      BamReader::NewOrDie(WriteBam("unmapped.bam", {{
+                                       .qname = "u1",
+                                       .flags = 4,
+                                       .seq = "ACGTN",
+                                       .qual = {0, 10, 20, 30, 40},
+                                   }}));
+  std::unique_ptr<SamEntry> entry = *reader->Next();
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->rname, "*");
+  EXPECT_EQ(entry->pos, 0);
+  EXPECT_TRUE(entry->cigar.operations.empty());
+  EXPECT_EQ(entry->rnext, "*");
+  EXPECT_EQ(entry->pnext, 0);
+  EXPECT_EQ(entry->seq, "ACGTN");
+  EXPECT_EQ(entry->qual, "!+5?I");
+}
+
+TEST(BamReader, Tags) {
+  const std::string tags = absl::StrCat(
+      "XAAx", "XBc\xfb", "XCC\xc8", "XDs", U16(-300), "XES", U16(60000),
+      "XFi", U32(-70000), "XGI", U32(4000000000), "XHf", U32(0x3fc00000),
+      "XIZhello", std::string(1, '\0'), "XJH1AE3", std::string(1, '\0'),
+      "XKBc", U32(3), std::string("\xff\x00\x07", 3), "XLBf", U32(2),
+      U32(0x3f000000), U32(0xc0200000));
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(
+      WriteBam("tags.bam", {{.qname = "t", .seq = "A", .tags = tags}}));
+  std::unique_ptr<SamEntry> entry = *reader->Next();
+  ASSERT_NE(entry, nullptr);
+  EXPECT_THAT(entry->tags,
+              ElementsAre("XA:A:x", "XB:i:-5", "XC:i:200", "XD:i:-300",
+                          "XE:i:60000", "XF:i:-70000", "XG:i:4000000000",
+                          "XH:f:1.5", "XI:Z:hello", "XJ:H:1AE3",
+                          "XK:B:c,-1,0,7", "XL:B:f,0.5,-2.5"));
+}
+
+TEST(BamReader, LongCigar) {
+  std::string cigar;
+  for (int i = 0; i < 3; ++i) {
+    absl::StrAppend(&cigar, U32(Op(2, 'M')), U32(Op(1, 'I')));
+  }
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(WriteBam(
+      "long-cigar.bam",
+      {{
+          .qname = "long",
+          .ref_id = 0,
+          .pos = 0,
+          .cigar = {Op(9, 'S'), Op(6, 'N')},
+          .seq = "ACGTACGTA",
+          .tags = absl::StrCat("NMi", U32(3), "CGBI", U32(6), cigar),
+      }}));
+  std::unique_ptr<SamEntry> entry = *reader->Next();
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->cigar.string(), "2M1I2M1I2M1I");
+  EXPECT_THAT(entry->tags, ElementsAre("NM:i:3"));
+}
+
+TEST(BamReader, ManyRecordsAcrossBlocks) {
+  std::string data = EncodeHeader(kHeaderText, {{.name = "ref", .length = 45}});
+  for (int i = 0; i < 5000; ++i) {
+    data.append(Encode({
+        .qname = absl::StrCat("read", i),
+        .ref_id = 0,
+        .pos = i % 40,
+        .cigar = {Op(4, 'M')},
+        .seq = "ACGT",
+        .tags = absl::StrCat("NMC", std::string(1, i % 3)),
+    }));
+  }
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(
+      WriteBam("many.bam", data, /*block_size=*/1000), {.num_threads = 4});
+  for (int i = 0; i < 5000; ++i) {
+    absl::StatusOr<std::unique_ptr<SamEntry>> entry = reader->Next();
+    ASSERT_THAT(entry, IsOk());
+    ASSERT_NE(*entry, nullptr);
+    EXPECT_EQ((*entry)->qname, absl::StrCat("read", i));
+    EXPECT_EQ((*entry)->pos, i % 40 + 1);
+    EXPECT_THAT((*entry)->tags, ElementsAre(absl::StrCat("NM:i:", i % 3)));
+  }
+  EXPECT_EQ(*reader->Next(), nullptr);
+  EXPECT_EQ(reader->records_read(), 5000);
+}
+
+TEST(BamReader, NotBam) {
+  EXPECT_THAT(BamReader::New(
+                  WriteBam("not-bam.bam", absl::StrCat("SAM\1", U32(0)))),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Not a BAM file")));
+}
+
+TEST(BamReader, TruncatedRecord) {
+  std::string record = Encode({.qname = "r", .seq = "ACGT"});
+  record.resize(record.size() - 2);
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(WriteBam(
+      "truncated.bam",
+      absl::StrCat(EncodeHeader(kHeaderText, {}), Encode({.qname = "ok"}),
+                   record)));
+  ASSERT_THAT(reader->Next(), IsOk());
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kDataLoss,
+                                       HasSubstr("Record 2: Truncated")));
+}
+
+TEST(BamReader, InvalidRecord) {
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(
+      WriteBam("invalid-reference.bam", {{.qname = "r", .ref_id = 1}}));
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kDataLoss,
+                                       HasSubstr("Invalid reference index")));
+
+  reader = BamReader::NewOrDie(WriteBam(
+      "invalid-cigar.bam", {{.qname = "r", .ref_id = 0, .cigar = {0x1f}}}));
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kDataLoss,
+                                       HasSubstr("Invalid CIGAR operation")));
+
+  reader = BamReader::NewOrDie(
+      WriteBam("invalid-tag.bam", {{.qname = "r", .tags = "XXq"}}));
+  EXPECT_THAT(reader->Next(), StatusIs(absl::StatusCode::kDataLoss,
+                                       HasSubstr("Invalid type 'q'")));
+}
+
+TEST(BamReader, MissingFile) {
+  EXPECT_THAT(BamReader::New(gxl::JoinPath(TempDir(), "absent.bam")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace bio
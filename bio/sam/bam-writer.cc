@@ -0,0 +1,578 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/bam-writer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-writer.h"
+#include "bio/common/cpu.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/sam.h"
+#include "gxl/status/status_macros.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(BIO_HAVE_TARGET_SSSE3)
+#include <tmmintrin.h>
+#endif
+
+namespace bio {
+namespace {
+
+static constexpr absl::string_view kBamMagic("BAM\1", 4);
+
+// The most CIGAR operations that fit in the CIGAR field of a record.
+static constexpr size_t kMaxCigarOperations = 0xffff;
+
+// The QUAL field of a record is filled with this when the qualities are
+// absent.
+static constexpr char kMissingQuality = '\xff';
+
+// The 4-bit code of N, which is also used for bases that are not IUPAC codes.
+static constexpr uint8_t kCodeN = 15;
+
+constexpr auto MakeBaseCodeTable() -> std::array<uint8_t, 256> {
+  constexpr absl::string_view kBases = "=ACMGRSVTWYHKDBN";
+  std::array<uint8_t, 256> table = {};
+  for (uint8_t& code : table) {
+    code = kCodeN;
+  }
+  for (uint8_t code = 0; code < kBases.size(); ++code) {
+    table[static_cast<uint8_t>(kBases[code])] = code;
+    if (kBases[code] != '=') {
+      table[static_cast<uint8_t>(kBases[code] - 'A' + 'a')] = code;
+    }
+  }
+  return table;
+}
+
+// The 4-bit code of each base.
+static constexpr std::array<uint8_t, 256> kBaseCodes = MakeBaseCodeTable();
+
+auto AppendLittleEndian16(uint16_t value, std::string* out) -> void {
+  out->push_back(static_cast<char>(value));
+  out->push_back(static_cast<char>(value >> 8));
+}
+
+auto AppendLittleEndian32(uint32_t value, std::string* out) -> void {
+  AppendLittleEndian16(value, out);
+  AppendLittleEndian16(value >> 16, out);
+}
+
+auto StoreLittleEndian32(uint32_t value, char* out) -> void {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>(value >> (8 * i));
+  }
+}
+
+// Packs `bases` into 4-bit codes, two per byte, using the lookup table.
+auto PackBasesScalar(absl::string_view bases, char* out) -> void {
+  for (size_t i = 0; i + 1 < bases.size(); i += 2) {
+    out[i / 2] = static_cast<char>(
+        kBaseCodes[static_cast<uint8_t>(bases[i])] << 4 |
+        kBaseCodes[static_cast<uint8_t>(bases[i + 1])]);
+  }
+  if (bases.size() % 2 == 1) {
+    out[bases.size() / 2] = static_cast<char>(
+        kBaseCodes[static_cast<uint8_t>(bases.back())] << 4);
+  }
+}
+
+#if defined(__SSE2__)
+// Sets `codes` to the 4-bit codes of 16 `bases`. Returns false if any base is
+// not one of ACGTN in either case, leaving `codes` unspecified.
+auto EncodeAcgtn(__m128i bases, __m128i* codes) -> bool {
+  const __m128i upper = _mm_andnot_si128(_mm_set1_epi8(0x20), bases);
+  const __m128i a = _mm_cmpeq_epi8(upper, _mm_set1_epi8('A'));
+  const __m128i c = _mm_cmpeq_epi8(upper, _mm_set1_epi8('C'));
+  const __m128i g = _mm_cmpeq_epi8(upper, _mm_set1_epi8('G'));
+  const __m128i t = _mm_cmpeq_epi8(upper, _mm_set1_epi8('T'));
+  const __m128i n = _mm_cmpeq_epi8(upper, _mm_set1_epi8('N'));
+  const __m128i matched =
+      _mm_or_si128(_mm_or_si128(_mm_or_si128(a, c), _mm_or_si128(g, t)), n);
+  if (_mm_movemask_epi8(matched) != 0xffff) {
+    return false;
+  }
+  *codes = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(a, _mm_set1_epi8(kBaseCodes['A'])),
+                   _mm_and_si128(c, _mm_set1_epi8(kBaseCodes['C']))),
+      _mm_or_si128(
+          _mm_or_si128(_mm_and_si128(g, _mm_set1_epi8(kBaseCodes['G'])),
+                       _mm_and_si128(t, _mm_set1_epi8(kBaseCodes['T']))),
+          _mm_and_si128(n, _mm_set1_epi8(kCodeN))));
+  return true;
+}
+
+// Combines the 16 codes in `codes` into 8 bytes, one in the low byte of each
+// 16-bit lane, with the first code of each pair in the high nibble.
+auto PairCodes(__m128i codes) -> __m128i {
+  return _mm_or_si128(
+      _mm_slli_epi16(_mm_and_si128(codes, _mm_set1_epi16(0x00ff)), 4),
+      _mm_srli_epi16(codes, 8));
+}
+#endif
+
+#if defined(BIO_HAVE_TARGET_SSSE3) && defined(__SSE2__)
+// Returns the 4-bit codes of 16 `bases`. Letters are folded to uppercase and
+// looked up with a byte shuffle in the rows of kBaseCodes for 0x40 and 0x50,
+// which hold all the uppercase codes. '=' is the only other byte that is not
+// encoded as N.
+BIO_TARGET_SSSE3 auto EncodeBases(__m128i bases) -> __m128i {
+  const __m128i low_mask = _mm_set1_epi8(0x0f);
+  const __m128i upper = _mm_andnot_si128(_mm_set1_epi8(0x20), bases);
+  const __m128i low = _mm_and_si128(upper, low_mask);
+  const __m128i high = _mm_and_si128(_mm_srli_epi16(upper, 4), low_mask);
+  const __m128i row4 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&kBaseCodes[0x40])),
+      low);
+  const __m128i row5 = _mm_shuffle_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&kBaseCodes[0x50])),
+      low);
+  const __m128i in_row4 = _mm_cmpeq_epi8(high, _mm_set1_epi8(4));
+  const __m128i in_row5 = _mm_cmpeq_epi8(high, _mm_set1_epi8(5));
+  const __m128i letters = _mm_or_si128(_mm_and_si128(in_row4, row4),
+                                       _mm_and_si128(in_row5, row5));
+  const __m128i other = _mm_andnot_si128(_mm_or_si128(in_row4, in_row5),
+                                         _mm_set1_epi8(kCodeN));
+  // The code of '=' is 0, so clearing its lanes encodes it.
+  const __m128i equals = _mm_cmpeq_epi8(bases, _mm_set1_epi8('='));
+  return _mm_andnot_si128(equals, _mm_or_si128(letters, other));
+}
+
+// Packs the whole 32-base chunks of `bases` with EncodeBases, and returns the
+// number of bases packed.
+BIO_TARGET_SSSE3 auto PackBasesSsse3(absl::string_view bases, char* out)
+    -> size_t {
+  size_t i = 0;
+  for (; i + 32 <= bases.size(); i += 32) {
+    const __m128i first = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(bases.data() + i));
+    const __m128i second = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(bases.data() + i + 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm_packus_epi16(PairCodes(EncodeBases(first)),
+                                      PairCodes(EncodeBases(second))));
+  }
+  return i;
+}
+#endif
+
+// Packs `bases` into 4-bit codes, two per byte, 32 at a time with SIMD. On
+// CPUs with SSSE3 every base is encoded by a nibble lookup. Otherwise, runs
+// of the common bases ACGTN are encoded by SSE2 compares, and chunks holding
+// anything else fall back to the lookup table.
+auto PackBases(absl::string_view bases, char* out) -> void {
+  size_t i = 0;
+#if defined(BIO_HAVE_TARGET_SSSE3) && defined(__SSE2__)
+  if (CpuHasSsse3()) {
+    i = PackBasesSsse3(bases, out);
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 32 <= bases.size(); i += 32) {
+    const __m128i first = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(bases.data() + i));
+    const __m128i second = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(bases.data() + i + 16));
+    __m128i first_codes;
+    __m128i second_codes;
+    if (!EncodeAcgtn(first, &first_codes) ||
+        !EncodeAcgtn(second, &second_codes)) {
+      PackBasesScalar(bases.substr(i, 32), out + i / 2);
+      continue;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm_packus_epi16(PairCodes(first_codes),
+                                      PairCodes(second_codes)));
+  }
+#endif
+  PackBasesScalar(bases.substr(i), out + i / 2);
+}
+
+// Returns the number of reference bases covered by `cigar`.
+auto ReferenceLength(const Cigar& cigar) -> int64_t {
+  int64_t length = 0;
+  for (const CigarOperation& operation : cigar.operations) {
+    switch (operation.type) {
+      case CigarType::kAlignmentMatch:
+      case CigarType::kDeletion:
+      case CigarType::kSkippedRegion:
+      case CigarType::kSequenceMatch:
+      case CigarType::kSequenceMismatch:
+        length += operation.length;
+        break;
+      default:
+        break;
+    }
+  }
+  return length;
+}
+
+// Returns the BAI bin of the 0-based, half-open interval [begin, end), as
+// computed by reg2bin() in section 5.3 of the SAM specification.
+auto RegionToBin(int64_t begin, int64_t end) -> uint16_t {
+  --end;
+  // The index of the first bin of each level, from 16 KiB bins upwards.
+  int64_t first_bin = ((1 << 15) - 1) / 7;
+  for (int shift = 14; shift <= 26; shift += 3) {
+    if (begin >> shift == end >> shift) {
+      return first_bin + (begin >> shift);
+    }
+    first_bin = (first_bin - 1) / 8;
+  }
+  return 0;
+}
+
+auto AppendCigarOperation(const CigarOperation& operation, std::string* out)
+    -> absl::Status {
+  if (operation.type == CigarType::kInvalid ||
+      operation.length >= (1 << 28)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Invalid CIGAR operation '%s'", operation.string()));
+  }
+  AppendLittleEndian32(
+      operation.length << 4 | static_cast<uint32_t>(operation.type), out);
+  return absl::OkStatus();
+}
+
+// Returns the range of values of the integer tag type `type`, or std::nullopt
+// if `type` is not an integer type.
+auto IntegerRange(char type) -> std::optional<std::pair<int64_t, int64_t>> {
+  switch (type) {
+    case 'c':
+      return std::pair<int64_t, int64_t>(INT8_MIN, INT8_MAX);
+    case 'C':
+      return std::pair<int64_t, int64_t>(0, UINT8_MAX);
+    case 's':
+      return std::pair<int64_t, int64_t>(INT16_MIN, INT16_MAX);
+    case 'S':
+      return std::pair<int64_t, int64_t>(0, UINT16_MAX);
+    case 'i':
+      return std::pair<int64_t, int64_t>(INT32_MIN, INT32_MAX);
+    case 'I':
+      return std::pair<int64_t, int64_t>(0, UINT32_MAX);
+    default:
+      return std::nullopt;
+  }
+}
+
+// Returns the smallest integer tag type that holds `value`, preferring
+// unsigned types, or std::nullopt if no type holds it.
+auto SmallestIntegerType(int64_t value) -> std::optional<char> {
+  for (char type : absl::string_view(value < 0 ? "csi" : "CSI")) {
+    const auto [min, max] = *IntegerRange(type);
+    if (value >= min && value <= max) {
+      return type;
+    }
+  }
+  return std::nullopt;
+}
+
+// Appends `value` as a little-endian integer of tag type `type`.
+auto AppendInteger(char type, int64_t value, std::string* out) -> void {
+  switch (type) {
+    case 'c':
+    case 'C':
+      out->push_back(static_cast<char>(value));
+      break;
+    case 's':
+    case 'S':
+      AppendLittleEndian16(static_cast<uint16_t>(value), out);
+      break;
+    default:
+      AppendLittleEndian32(static_cast<uint32_t>(value), out);
+      break;
+  }
+}
+
+// Appends the numeric `text` as a value of the numeric tag type `type`.
+auto AppendNumber(char type, absl::string_view text, std::string* out)
+    -> absl::Status {
+  if (type == 'f') {
+    float value;
+    if (!absl::SimpleAtof(text, &value)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid float '%s'", text));
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    AppendLittleEndian32(bits, out);
+    return absl::OkStatus();
+  }
+  const std::optional<std::pair<int64_t, int64_t>> range = IntegerRange(type);
+  if (!range.has_value()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid numeric type '%c'", type));
+  }
+  int64_t value;
+  if (!absl::SimpleAtoi(text, &value) || value < range->first ||
+      value > range->second) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Invalid integer '%s' for type '%c'", text, type));
+  }
+  AppendInteger(type, value, out);
+  return absl::OkStatus();
+}
+
+// Appends the binary encoding of `tag`, in SAM "TAG:TYPE:VALUE" form.
+auto AppendTag(absl::string_view tag, std::string* out) -> absl::Status {
+  if (tag.size() < 5 || tag[2] != ':' || tag[4] != ':') {
+    return absl::InvalidArgumentError(absl::StrFormat("Invalid tag '%s'", tag));
+  }
+  const absl::string_view name = tag.substr(0, 2);
+  const char type = tag[3];
+  const absl::string_view value = tag.substr(5);
+  out->append(name);
+  switch (type) {
+    case 'A':
+      if (value.size() != 1) {
+        break;
+      }
+      out->push_back('A');
+      out->push_back(value[0]);
+      return absl::OkStatus();
+    case 'i': {
+      int64_t number;
+      if (!absl::SimpleAtoi(value, &number)) {
+        break;
+      }
+      const std::optional<char> integer_type = SmallestIntegerType(number);
+      if (!integer_type.has_value()) {
+        break;
+      }
+      out->push_back(*integer_type);
+      AppendInteger(*integer_type, number, out);
+      return absl::OkStatus();
+    }
+    case 'f':
+      out->push_back('f');
+      if (!AppendNumber('f', value, out).ok()) {
+        break;
+      }
+      return absl::OkStatus();
+    case 'Z':
+    case 'H':
+      out->push_back(type);
+      out->append(value);
+      out->push_back('\0');
+      return absl::OkStatus();
+    case 'B': {
+      const std::vector<absl::string_view> values = absl::StrSplit(value, ',');
+      if (values[0].size() != 1) {
+        break;
+      }
+      out->push_back('B');
+      out->push_back(values[0][0]);
+      AppendLittleEndian32(values.size() - 1, out);
+      bool valid = true;
+      for (size_t i = 1; i < values.size() && valid; ++i) {
+        valid = AppendNumber(values[0][0], values[i], out).ok();
+      }
+      if (!valid) {
+        break;
+      }
+      return absl::OkStatus();
+    }
+  }
+  return absl::InvalidArgumentError(absl::StrFormat("Invalid tag '%s'", tag));
+}
+
+}  // namespace
+
+BamWriter::BamWriter(std::unique_ptr<BgzfWriter> writer,
+                     const SamHeader& header)
+    : writer_(std::move(writer)) {
+  for (size_t i = 0; i < header.references.size(); ++i) {
+    reference_indices_.try_emplace(header.references[i].name,
+                                   static_cast<int32_t>(i));
+  }
+}
+
+auto BamWriter::New(absl::string_view path, const SamHeader& header,
+                    const BamWriterOptions& options)
+    -> absl::StatusOr<std::unique_ptr<BamWriter>> {
+  if (header.references.size() >
+      static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Too many references: %d", header.references.size()));
+  }
+  const BgzfWriterOptions bgzf_options = {
+      .num_threads = options.num_threads,
+      .level = options.compression_level,
+  };
+  ASSIGN_OR_RETURN(std::unique_ptr<BgzfWriter> bgzf,
+                   BgzfWriter::New(path, bgzf_options));
+  std::string data(kBamMagic);
+  AppendLittleEndian32(header.text.size(), &data);
+  data.append(header.text);
+  AppendLittleEndian32(header.references.size(), &data);
+  for (const SamReference& reference : header.references) {
+    AppendLittleEndian32(reference.name.size() + 1, &data);
+    data.append(reference.name);
+    data.push_back('\0');
+    AppendLittleEndian32(reference.length, &data);
+  }
+  RETURN_IF_ERROR(bgzf->Write(data));
+  // Start the alignments in a new block, as samtools does.
+  RETURN_IF_ERROR(bgzf->Flush());
+  return std::unique_ptr<BamWriter>(new BamWriter(std::move(bgzf), header));
+}
+
+auto BamWriter::NewOrDie(absl::string_view path, const SamHeader& header,
+                         const BamWriterOptions& options)
+    -> std::unique_ptr<BamWriter> {
+  absl::StatusOr<std::unique_ptr<BamWriter>> writer =
+      New(path, header, options);
+  CHECK_OK(writer.status());
+  return std::move(writer.value());
+}
+
+auto BamWriter::Write(const std::vector<SamEntry>& entries) -> absl::Status {
+  for (const SamEntry& entry : entries) {
+    RETURN_IF_ERROR(Write(entry));
+  }
+  return absl::OkStatus();
+}
+
+auto BamWriter::Write(const SamEntry& entry) -> absl::Status {
+  if (const absl::Status status = EncodeRecord(entry); !status.ok()) {
+    return absl::Status(
+        status.code(), absl::StrFormat("Record %d (%s): %s",
+                                       records_written_ + 1, entry.qname,
+                                       status.message()));
+  }
+  RETURN_IF_ERROR(writer_->Write(record_));
+  ++records_written_;
+  return absl::OkStatus();
+}
+
+auto BamWriter::Close() -> absl::Status { return writer_->Close(); }
+
+auto BamWriter::ReferenceIndex(absl::string_view name) const
+    -> absl::StatusOr<int32_t> {
+  if (name == "*") {
+    return -1;
+  }
+  const auto it = reference_indices_.find(name);
+  if (it == reference_indices_.end()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unknown reference '%s'", name));
+  }
+  return it->second;
+}
+
+auto BamWriter::EncodeRecord(const SamEntry& entry) -> absl::Status {
+  if (entry.qname.empty() || entry.qname.size() > 254) {
+    return absl::InvalidArgumentError("QNAME must have 1 to 254 characters");
+  }
+  const size_t length = entry.seq.has_value() ? entry.seq->size() : 0;
+  if (entry.qual.has_value() && entry.qual->size() != length) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("QUAL has %d characters but SEQ has %d",
+                        entry.qual->size(), length));
+  }
+  ASSIGN_OR_RETURN(const int32_t ref_id, ReferenceIndex(entry.rname));
+  int32_t next_ref_id = ref_id;
+  if (entry.rnext != "=") {
+    ASSIGN_OR_RETURN(next_ref_id, ReferenceIndex(entry.rnext));
+  }
+  const int64_t pos = static_cast<int64_t>(entry.pos) - 1;
+  const int64_t reference_length = (entry.flags & SAM_QUERY_UNMAPPED) != 0
+                                       ? 0
+                                       : ReferenceLength(entry.cigar);
+  const bool long_cigar =
+      entry.cigar.operations.size() > kMaxCigarOperations;
+
+  record_.clear();
+  // block_size is filled in once the record has been encoded.
+  AppendLittleEndian32(0, &record_);
+  AppendLittleEndian32(ref_id, &record_);
+  AppendLittleEndian32(static_cast<uint32_t>(pos), &record_);
+  record_.push_back(static_cast<char>(entry.qname.size() + 1));
+  record_.push_back(static_cast<char>(entry.mapq));
+  AppendLittleEndian16(
+      RegionToBin(pos, pos + std::max<int64_t>(reference_length, 1)),
+      &record_);
+  AppendLittleEndian16(long_cigar ? 2 : entry.cigar.operations.size(),
+                       &record_);
+  AppendLittleEndian16(entry.flags, &record_);
+  AppendLittleEndian32(length, &record_);
+  AppendLittleEndian32(next_ref_id, &record_);
+  AppendLittleEndian32(entry.pnext - 1, &record_);
+  AppendLittleEndian32(entry.tlen, &record_);
+  record_.append(entry.qname);
+  record_.push_back('\0');
+
+  if (long_cigar) {
+    // The real CIGAR goes in the CG tag, behind a placeholder of the form
+    // <length>S<reference length>N.
+    RETURN_IF_ERROR(AppendCigarOperation(
+        {.type = CigarType::kSoftClipping, .length = length}, &record_));
+    RETURN_IF_ERROR(AppendCigarOperation(
+        {.type = CigarType::kSkippedRegion,
+         .length = static_cast<size_t>(reference_length)},
+        &record_));
+  } else {
+    for (const CigarOperation& operation : entry.cigar.operations) {
+      RETURN_IF_ERROR(AppendCigarOperation(operation, &record_));
+    }
+  }
+
+  const size_t seq_start = record_.size();
+  record_.resize(seq_start + (length + 1) / 2);
+  if (length > 0) {
+    PackBases(*entry.seq, record_.data() + seq_start);
+  }
+  if (entry.qual.has_value()) {
+    for (const char c : *entry.qual) {
+      record_.push_back(static_cast<char>(c - 33));
+    }
+  } else {
+    record_.append(length, kMissingQuality);
+  }
+
+  for (const std::string& tag : entry.tags) {
+    RETURN_IF_ERROR(AppendTag(tag, &record_));
+  }
+  if (long_cigar) {
+    record_.append("CGBI");
+    AppendLittleEndian32(entry.cigar.operations.size(), &record_);
+    for (const CigarOperation& operation : entry.cigar.operations) {
+      RETURN_IF_ERROR(AppendCigarOperation(operation, &record_));
+    }
+  }
+  StoreLittleEndian32(record_.size() - 4, record_.data());
+  return absl::OkStatus();
+}
+
+}  // namespace bio
@@ -0,0 +1,111 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_SAM_BAM_WRITER_H_
+#define BIO_SAM_BAM_WRITER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-writer.h"
+#include "bio/sam/sam.h"
+
+namespace bio {
+
+// Options for BamWriter.
+struct BamWriterOptions {
+  // The number of threads that compress BGZF blocks.
+  size_t num_threads = 4;
+
+  // The zlib compression level, from 0 to 9.
+  int compression_level = 6;
+};
+
+// Writer for BAM files. SamEntry records are encoded directly into binary
+// records, which BamReader decodes back into the same entries:
+//
+//  * RNAME and RNEXT must be "*" or the name of a reference in the header,
+//    and RNEXT may be "=".
+//  * SEQ bases other than IUPAC codes and '=' are written as N, and lowercase
+//    bases are written in uppercase.
+//  * Integer tags are stored in the smallest integer type that holds them.
+//  * CIGARs with more than 65535 operations are stored in a CG tag.
+//
+// Example usage:
+//
+// ```
+// ASSIGN_OR_RETURN(std::unique_ptr<BamWriter> writer,
+//                  BamWriter::New("path/to/out.bam", header,
+//                                 {.num_threads = 8}));
+// for (const SamEntry& entry : entries) {
+//   RETURN_IF_ERROR(writer->Write(entry));
+// }
+// RETURN_IF_ERROR(writer->Close());
+// ```
+class BamWriter {
+ public:
+  BamWriter(const BamWriter&) = delete;
+  auto operator=(const BamWriter&) -> BamWriter& = delete;
+
+  // Creates the BAM file at `path` and writes `header` to it.
+  static auto New(absl::string_view path, const SamHeader& header,
+                  const BamWriterOptions& options = {})
+      -> absl::StatusOr<std::unique_ptr<BamWriter>>;
+
+  // Creates the BAM file at `path` and writes `header` to it, or terminates
+  // the program if that fails.
+  static auto NewOrDie(absl::string_view path, const SamHeader& header,
+                       const BamWriterOptions& options = {})
+      -> std::unique_ptr<BamWriter>;
+
+  // Writes the provided entries to the file.
+  auto Write(const std::vector<SamEntry>& entries) -> absl::Status;
+
+  // Writes the provided entry to the file.
+  auto Write(const SamEntry& entry) -> absl::Status;
+
+  // Writes any buffered records and closes the file.
+  auto Close() -> absl::Status;
+
+  // Returns the number of records written so far.
+  auto records_written() const -> uint64_t { return records_written_; }
+
+ private:
+  BamWriter(std::unique_ptr<BgzfWriter> writer, const SamHeader& header);
+
+  // Encodes `entry` into `record_`, including its leading block_size field.
+  auto EncodeRecord(const SamEntry& entry) -> absl::Status;
+
+  // Returns the index of the reference named `name`, or -1 for "*".
+  auto ReferenceIndex(absl::string_view name) const
+      -> absl::StatusOr<int32_t>;
+
+  std::unique_ptr<BgzfWriter> writer_;
+  absl::flat_hash_map<std::string, int32_t> reference_indices_;
+  uint64_t records_written_ = 0;
+
+  // The record being encoded, kept to reuse its allocation.
+  std::string record_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_SAM_BAM_WRITER_H_
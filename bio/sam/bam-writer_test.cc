@@ -0,0 +1,305 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/bam-writer.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "bio/common/bgzf-reader.h"
+#include "bio/sam/bam-reader.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/sam-parser.h"
+#include "bio/sam/sam.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gxl/file/path.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::TempDir;
+
+auto TestHeader() -> SamHeader {
+  return {
+      .text = "@HD\tVN:1.6\tSO:coordinate\n@SQ\tSN:ref\tLN:45\n",
+      .references = {{.name = "ref", .length = 45}},
+  };
+}
+
+auto MakeEntry(absl::string_view qname, absl::string_view seq) -> SamEntry {
+  return {
+      .qname = std::string(qname),
+      .flags = 0,
+      .rname = "ref",
+      .pos = 1,
+      .mapq = 60,
+      .cigar = {{{.type = CigarType::kAlignmentMatch, .length = seq.size()}}},
+      .rnext = "*",
+      .pnext = 0,
+      .tlen = 0,
+      .seq = std::string(seq),
+  };
+}
+
+auto ExpectSameEntry(const SamEntry& actual, const SamEntry& expected)
+    -> void {
+  EXPECT_EQ(actual.qname, expected.qname);
+  EXPECT_EQ(actual.flags, expected.flags);
+  EXPECT_EQ(actual.rname, expected.rname);
+  EXPECT_EQ(actual.pos, expected.pos);
+  EXPECT_EQ(actual.mapq, expected.mapq);
+  EXPECT_EQ(actual.cigar, expected.cigar);
+  EXPECT_EQ(actual.rnext, expected.rnext);
+  EXPECT_EQ(actual.pnext, expected.pnext);
+  EXPECT_EQ(actual.tlen, expected.tlen);
+  EXPECT_EQ(actual.seq, expected.seq);
+  EXPECT_EQ(actual.qual, expected.qual);
+  EXPECT_EQ(actual.tags, expected.tags);
+}
+
+// Writes `entries` to a BAM file and returns the entries read back from it.
+auto RoundTrip(absl::string_view name, const std::vector<SamEntry>& entries,
+               const BamWriterOptions& options = {})
+    -> std::vector<std::unique_ptr<SamEntry>> {
+  const std::string path = gxl::JoinPath(TempDir(), name);
+  std::unique_ptr<BamWriter> writer =
+      BamWriter::NewOrDie(path, TestHeader(), options);
+  EXPECT_THAT(writer->Write(entries), IsOk());
+  EXPECT_EQ(writer->records_written(), entries.size());
+  EXPECT_THAT(writer->Close(), IsOk());
+
+  std::unique_ptr<BamReader> reader = BamReader::NewOrDie(path);
+  EXPECT_EQ(reader->header().text, TestHeader().text);
+  EXPECT_EQ(reader->header().references, TestHeader().references);
+  std::vector<std::unique_ptr<SamEntry>> read;
+  while (true) {
+    absl::StatusOr<std::unique_ptr<SamEntry>> entry = reader->Next();
+    EXPECT_THAT(entry, IsOk());
+    if (!entry.ok() || *entry == nullptr) {
+      return read;
+    }
+    read.push_back(*std::move(entry));
+  }
+}
+
+TEST(BamWriter, RoundTripsSamFiles) {
+  for (absl::string_view sam_path : {"bio/sam/testdata/minimal-fields.sam",
+                                     "bio/sam/testdata/with-tags.sam",
+                                     "bio/sam/testdata/multiple-entries.sam"}) {
+    std::unique_ptr<SamParser> parser = SamParser::NewOrDie(sam_path);
+    std::vector<SamEntry> entries;
+    for (absl::StatusOr<std::unique_ptr<SamEntry>> entry = parser->Next();
+         entry.ok() && *entry != nullptr; entry = parser->Next()) {
+      entries.push_back(**entry);
+    }
+    ASSERT_FALSE(entries.empty()) << sam_path;
+
+    const std::vector<std::unique_ptr<SamEntry>> read =
+        RoundTrip("sam-file.bam", entries);
+    ASSERT_EQ(read.size(), entries.size()) << sam_path;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      ExpectSameEntry(*read[i], entries[i]);
+    }
+  }
+}
+
+TEST(BamWriter, Tags) {
+  SamEntry entry = MakeEntry("tags", "ACGT");
+  entry.qual = "!+5I";
+  entry.tags = {"XA:A:x",
+                "XB:i:-5",
+                "XC:i:200",
+                "XD:i:-300",
+                "XE:i:60000",
+                "XF:i:-70000",
+                "XG:i:4000000000",
+                "XH:f:1.5",
+                "XI:Z:hello world",
+                "XJ:H:1AE3",
+                "XK:B:c,-1,0,7",
+                "XL:B:f,0.5,-2.5",
+                "XM:B:I,1,4000000000"};
+  const std::vector<std::unique_ptr<SamEntry>> read =
+      RoundTrip("tags.bam", {entry});
+  ASSERT_EQ(read.size(), 1);
+  ExpectSameEntry(*read[0], entry);
+}
+
+TEST(BamWriter, Sequences) {
+  static constexpr absl::string_view kBases = "ACGTNacgtnRYKMrySWBDHVbdhv=X.*";
+  std::mt19937 rng(42);
+  std::vector<SamEntry> entries;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 500; ++i) {
+    // Mostly ACGTN, with the occasional other character.
+    const bool acgtn_only = i % 3 != 0;
+    std::string seq(i % 130, ' ');
+    for (char& base : seq) {
+      base = kBases[rng() % (acgtn_only ? 10 : kBases.size())];
+    }
+    std::string upper = absl::AsciiStrToUpper(seq);
+    for (char& base : upper) {
+      if (absl::string_view("=ACMGRSVTWYHKDBN").find(base) ==
+          absl::string_view::npos) {
+        base = 'N';
+      }
+    }
+    entries.push_back(MakeEntry(absl::StrCat("seq", i), seq));
+    expected.push_back(upper);
+  }
+  const std::vector<std::unique_ptr<SamEntry>> read =
+      RoundTrip("sequences.bam", entries);
+  ASSERT_EQ(read.size(), entries.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    if (expected[i].empty()) {
+      EXPECT_EQ(read[i]->seq, std::nullopt);
+    } else {
+      EXPECT_EQ(read[i]->seq, expected[i]) << entries[i].seq.value();
+    }
+  }
+}
+
+TEST(BamWriter, EveryByteValue) {
+  // Covers every byte in every lane of the vectorized packing.
+  std::string seq;
+  for (int i = 0; i < 3 * 256; ++i) {
+    seq.push_back(static_cast<char>(i * 7 % 256));
+  }
+  std::string expected = absl::AsciiStrToUpper(seq);
+  for (char& base : expected) {
+    if (absl::string_view("=ACMGRSVTWYHKDBN").find(base) ==
+        absl::string_view::npos) {
+      base = 'N';
+    }
+  }
+  const std::vector<std::unique_ptr<SamEntry>> read =
+      RoundTrip("every-byte.bam", {MakeEntry("every-byte", seq)});
+  ASSERT_EQ(read.size(), 1);
+  EXPECT_EQ(read[0]->seq, expected);
+}
+
+TEST(BamWriter, LongCigar) {
+  SamEntry entry = MakeEntry("long", std::string(70000, 'A'));
+  entry.cigar.operations.clear();
+  for (int i = 0; i < 35000; ++i) {
+    entry.cigar.operations.push_back(
+        {.type = CigarType::kAlignmentMatch, .length = 1});
+    entry.cigar.operations.push_back(
+        {.type = CigarType::kInsertion, .length = 1});
+  }
+  entry.tags = {"NM:i:35000"};
+  const std::vector<std::unique_ptr<SamEntry>> read =
+      RoundTrip("long-cigar.bam", {entry});
+  ASSERT_EQ(read.size(), 1);
+  ExpectSameEntry(*read[0], entry);
+}
+
+TEST(BamWriter, ManyRecords) {
+  std::vector<SamEntry> entries;
+  for (int i = 0; i < 20000; ++i) {
+    SamEntry entry = MakeEntry(absl::StrCat("read", i), "ACGTACGTACGTACGT");
+    entry.pos = i % 30 + 1;
+    entry.tags = {absl::StrCat("NM:i:", i % 5)};
+    entries.push_back(entry);
+  }
+  const std::vector<std::unique_ptr<SamEntry>> read =
+      RoundTrip("many.bam", entries, {.num_threads = 4});
+  ASSERT_EQ(read.size(), entries.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    ExpectSameEntry(*read[i], entries[i]);
+  }
+}
+
+TEST(BamWriter, Bin) {
+  SamEntry mapped = MakeEntry("mapped", "ACGT");
+  mapped.rname = "chr";
+  mapped.pos = 20000;
+  SamEntry unmapped = MakeEntry("unmapped", "ACGT");
+  unmapped.flags = SAM_QUERY_UNMAPPED;
+  unmapped.rname = "*";
+  unmapped.pos = 0;
+  unmapped.cigar.operations.clear();
+
+  const std::string path = gxl::JoinPath(TempDir(), "bin.bam");
+  std::unique_ptr<BamWriter> writer =
+      BamWriter::NewOrDie(path, {.text = "", .references = {{"chr", 100000}}});
+  ASSERT_THAT(writer->Write(mapped), IsOk());
+  ASSERT_THAT(writer->Write(unmapped), IsOk());
+  ASSERT_THAT(writer->Close(), IsOk());
+
+  // Skip the header: magic, l_text, n_ref, then l_name, "chr\0" and l_ref.
+  std::unique_ptr<BgzfReader> reader = *BgzfReader::New(path);
+  std::string data;
+  ASSERT_THAT(reader->Read(4 + 4 + 4 + 4 + 4 + 4, &data), IsOk());
+  for (const int expected_bin : {4681 + 19999 / 16384, 4680}) {
+    ASSERT_THAT(reader->Read(4, &data), IsOk());
+    const int size = static_cast<uint8_t>(data[0]) |
+                     static_cast<uint8_t>(data[1]) << 8;
+    ASSERT_THAT(reader->Read(size, &data), IsOk());
+    EXPECT_EQ(static_cast<uint8_t>(data[10]) |
+                  static_cast<uint8_t>(data[11]) << 8,
+              expected_bin);
+  }
+}
+
+TEST(BamWriter, InvalidEntries) {
+  const std::string path = gxl::JoinPath(TempDir(), "invalid.bam");
+  std::unique_ptr<BamWriter> writer = BamWriter::NewOrDie(path, TestHeader());
+
+  SamEntry entry = MakeEntry("r1", "ACGT");
+  entry.rname = "chr1";
+  EXPECT_THAT(writer->Write(entry),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Record 1 (r1): Unknown reference 'chr1'")));
+
+  entry = MakeEntry("r1", "ACGT");
+  entry.qual = "III";
+  EXPECT_THAT(writer->Write(entry),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("QUAL has 3 characters but SEQ has 4")));
+
+  for (absl::string_view tag :
+       {"XA", "XA:i:one", "XA:i:5000000000", "XA:q:1", "XA:B:c,300",
+        "XA:B:q,1", "XA:A:xy"}) {
+    entry = MakeEntry("r1", "ACGT");
+    entry.tags = {std::string(tag)};
+    EXPECT_THAT(writer->Write(entry),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("Invalid tag")))
+        << tag;
+  }
+
+  // Invalid entries do not affect later writes.
+  ASSERT_THAT(writer->Write(MakeEntry("r1", "ACGT")), IsOk());
+  EXPECT_EQ(writer->records_written(), 1);
+  ASSERT_THAT(writer->Close(), IsOk());
+}
+
+}  // namespace
+}  // namespace bio
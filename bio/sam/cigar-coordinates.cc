@@ -0,0 +1,212 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/cigar-coordinates.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+#include "absl/types/span.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/packed-cigar.h"
+
+namespace bio {
+namespace {
+
+// Whether the operation type consumes reference bases.
+auto ConsumesReference(CigarType type) -> bool {
+  switch (type) {
+    case CigarType::kAlignmentMatch:
+    case CigarType::kDeletion:
+    case CigarType::kSkippedRegion:
+    case CigarType::kSequenceMatch:
+    case CigarType::kSequenceMismatch:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Whether the operation type consumes query bases.
+auto ConsumesQuery(CigarType type) -> bool {
+  switch (type) {
+    case CigarType::kAlignmentMatch:
+    case CigarType::kInsertion:
+    case CigarType::kSoftClipping:
+    case CigarType::kSequenceMatch:
+    case CigarType::kSequenceMismatch:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto IsAligned(CigarType type) -> bool {
+  return type == CigarType::kAlignmentMatch ||
+         type == CigarType::kSequenceMatch ||
+         type == CigarType::kSequenceMismatch;
+}
+
+// Accumulates the summary of a CIGAR one operation at a time.
+class Summarizer {
+ public:
+  auto Add(const CigarOperation& operation) -> void {
+    const uint64_t length = operation.length;
+    if (ConsumesReference(operation.type)) {
+      summary_.reference_length += length;
+    }
+    if (ConsumesQuery(operation.type)) {
+      summary_.query_length += length;
+    }
+    if (IsAligned(operation.type)) {
+      summary_.aligned_length += length;
+    }
+    switch (operation.type) {
+      case CigarType::kSoftClipping:
+        (seen_body_ ? trailing_soft_clip_ : summary_.leading_soft_clip) +=
+            length;
+        break;
+      case CigarType::kHardClipping:
+        (seen_body_ ? trailing_hard_clip_ : summary_.leading_hard_clip) +=
+            length;
+        break;
+      default:
+        // Clipping before this operation is not at the end of the query.
+        seen_body_ = true;
+        trailing_soft_clip_ = 0;
+        trailing_hard_clip_ = 0;
+        break;
+    }
+  }
+
+  auto summary() -> CigarSummary {
+    summary_.trailing_soft_clip = trailing_soft_clip_;
+    summary_.trailing_hard_clip = trailing_hard_clip_;
+    return summary_;
+  }
+
+ private:
+  CigarSummary summary_;
+  bool seen_body_ = false;
+  uint64_t trailing_soft_clip_ = 0;
+  uint64_t trailing_hard_clip_ = 0;
+};
+
+template <typename Operations>
+auto Summarize(const Operations& operations) -> CigarSummary {
+  Summarizer summarizer;
+  for (const CigarOperation operation : operations) {
+    summarizer.Add(operation);
+  }
+  return summarizer.summary();
+}
+
+}  // namespace
+
+auto SummarizeCigar(const Cigar& cigar) -> CigarSummary {
+  return Summarize(cigar.operations);
+}
+
+auto SummarizeCigar(const PackedCigar& cigar) -> CigarSummary {
+  return Summarize(cigar);
+}
+
+CigarCoordinates::CigarCoordinates(const Cigar& cigar,
+                                   uint64_t reference_start)
+    : reference_start_(reference_start) {
+  Build(cigar.operations);
+}
+
+CigarCoordinates::CigarCoordinates(const PackedCigar& cigar,
+                                   uint64_t reference_start)
+    : reference_start_(reference_start) {
+  Build(cigar);
+}
+
+template <typename Operations>
+auto CigarCoordinates::Build(const Operations& operations) -> void {
+  Summarizer summarizer;
+  uint64_t reference_position = reference_start_;
+  uint64_t query_position = 0;
+  // Whether the previous operation ended a block that the next aligned
+  // operation extends.
+  bool extend_block = false;
+  for (const CigarOperation operation : operations) {
+    summarizer.Add(operation);
+    if (operation.length == 0) {
+      continue;
+    }
+    if (IsAligned(operation.type)) {
+      if (extend_block) {
+        blocks_.back().length += operation.length;
+      } else {
+        blocks_.push_back({
+            .reference_start = reference_position,
+            .query_start = query_position,
+            .length = operation.length,
+        });
+      }
+      extend_block = true;
+    } else if (ConsumesReference(operation.type) ||
+               ConsumesQuery(operation.type)) {
+      extend_block = false;
+    }
+    if (ConsumesReference(operation.type)) {
+      reference_position += operation.length;
+    }
+    if (ConsumesQuery(operation.type)) {
+      query_position += operation.length;
+    }
+  }
+  summary_ = summarizer.summary();
+}
+
+auto CigarCoordinates::QueryPosition(uint64_t reference_position) const
+    -> std::optional<uint64_t> {
+  // The first block that starts after the position; the block before it is
+  // the only one that can contain the position.
+  const auto it = std::upper_bound(
+      blocks_.begin(), blocks_.end(), reference_position,
+      [](uint64_t position, const AlignedBlock& block) {
+        return position < block.reference_start;
+      });
+  if (it == blocks_.begin()) {
+    return std::nullopt;
+  }
+  const AlignedBlock& block = *(it - 1);
+  if (reference_position >= block.reference_end()) {
+    return std::nullopt;
+  }
+  return block.query_start + (reference_position - block.reference_start);
+}
+
+auto CigarCoordinates::ReferencePosition(uint64_t query_position) const
+    -> std::optional<uint64_t> {
+  const auto it = std::upper_bound(
+      blocks_.begin(), blocks_.end(), query_position,
+      [](uint64_t position, const AlignedBlock& block) {
+        return position < block.query_start;
+      });
+  if (it == blocks_.begin()) {
+    return std::nullopt;
+  }
+  const AlignedBlock& block = *(it - 1);
+  if (query_position >= block.query_end()) {
+    return std::nullopt;
+  }
+  return block.reference_start + (query_position - block.query_start);
+}
+
+}  // namespace bio
@@ -0,0 +1,162 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_SAM_CIGAR_COORDINATES_H_
+#define BIO_SAM_CIGAR_COORDINATES_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/packed-cigar.h"
+
+namespace bio {
+
+// Lengths derived from a CIGAR.
+struct CigarSummary {
+  // The number of reference bases covered, by M, D, N, = and X operations.
+  uint64_t reference_length = 0;
+
+  // The number of query bases, by M, I, S, = and X operations. This is the
+  // length of SEQ.
+  uint64_t query_length = 0;
+
+  // The number of query bases aligned to a reference base, by M, = and X
+  // operations.
+  uint64_t aligned_length = 0;
+
+  // The number of soft-clipped bases at the start and end of the query.
+  uint64_t leading_soft_clip = 0;
+  uint64_t trailing_soft_clip = 0;
+
+  // The number of hard-clipped bases at the start and end of the query.
+  uint64_t leading_hard_clip = 0;
+  uint64_t trailing_hard_clip = 0;
+
+  // Checks for equality.
+  auto operator==(const CigarSummary& rhs) const -> bool {
+    return reference_length == rhs.reference_length &&
+           query_length == rhs.query_length &&
+           aligned_length == rhs.aligned_length &&
+           leading_soft_clip == rhs.leading_soft_clip &&
+           trailing_soft_clip == rhs.trailing_soft_clip &&
+           leading_hard_clip == rhs.leading_hard_clip &&
+           trailing_hard_clip == rhs.trailing_hard_clip;
+  }
+};
+
+// Summarizes `cigar` in a single pass. Clipping operations before the first
+// other operation are leading and those after the last are trailing.
+auto SummarizeCigar(const Cigar& cigar) -> CigarSummary;
+auto SummarizeCigar(const PackedCigar& cigar) -> CigarSummary;
+
+// A gapless run of query bases aligned to reference bases, made of
+// consecutive M, = and X operations.
+struct AlignedBlock {
+  // The 0-based reference position of the first base.
+  uint64_t reference_start;
+
+  // The 0-based offset in SEQ of the first base.
+  uint64_t query_start;
+
+  // The number of bases.
+  uint64_t length;
+
+  // Returns the reference position just past the block.
+  auto reference_end() const -> uint64_t { return reference_start + length; }
+
+  // Returns the offset in SEQ just past the block.
+  auto query_end() const -> uint64_t { return query_start + length; }
+
+  // Checks for equality.
+  auto operator==(const AlignedBlock& rhs) const -> bool {
+    return reference_start == rhs.reference_start &&
+           query_start == rhs.query_start && length == rhs.length;
+  }
+};
+
+// The coordinates of an alignment on the reference and the query, computed
+// from its CIGAR in a single pass. The aligned blocks are kept in order, and
+// act as a prefix-sum table over the operations, so positions are mapped
+// between the reference and the query in O(log n) of the number of blocks.
+//
+// Reference positions are 0-based, i.e. POS - 1, and query positions are
+// 0-based offsets in SEQ, so they count soft-clipped bases but not
+// hard-clipped ones.
+//
+// Example usage:
+//
+// ```
+// const CigarCoordinates coordinates(entry.cigar, entry.pos - 1);
+// for (const AlignedBlock& block : coordinates.blocks()) {
+//   // Add coverage over [block.reference_start, block.reference_end()).
+// }
+// std::optional<uint64_t> offset = coordinates.QueryPosition(snp_position);
+// if (offset.has_value()) {
+//   const char base = (*entry.seq)[*offset];
+// }
+// ```
+class CigarCoordinates {
+ public:
+  // The number of aligned blocks stored without a heap allocation.
+  static constexpr size_t kInlineBlocks = 4;
+
+  // Computes the coordinates of an alignment with `cigar` whose first
+  // reference base is at 0-based `reference_start`.
+  CigarCoordinates(const Cigar& cigar, uint64_t reference_start);
+  CigarCoordinates(const PackedCigar& cigar, uint64_t reference_start);
+
+  // Returns the lengths derived from the CIGAR.
+  auto summary() const -> const CigarSummary& { return summary_; }
+
+  // Returns the 0-based reference position of the first aligned base.
+  auto reference_start() const -> uint64_t { return reference_start_; }
+
+  // Returns the reference position just past the alignment.
+  auto reference_end() const -> uint64_t {
+    return reference_start_ + summary_.reference_length;
+  }
+
+  // Returns the aligned blocks, in reference and query order. Deletions,
+  // skipped regions and insertions separate blocks.
+  auto blocks() const -> absl::Span<const AlignedBlock> { return blocks_; }
+
+  // Returns the query position aligned to `reference_position`, or
+  // std::nullopt if it is outside the alignment or in a deletion or skipped
+  // region.
+  auto QueryPosition(uint64_t reference_position) const
+      -> std::optional<uint64_t>;
+
+  // Returns the reference position aligned to `query_position`, or
+  // std::nullopt if it is clipped, inserted or past the end of the query.
+  auto ReferencePosition(uint64_t query_position) const
+      -> std::optional<uint64_t>;
+
+ private:
+  // Computes the summary and blocks from `operations`, an iterable of
+  // CigarOperation.
+  template <typename Operations>
+  auto Build(const Operations& operations) -> void;
+
+  uint64_t reference_start_;
+  CigarSummary summary_;
+  absl::InlinedVector<AlignedBlock, kInlineBlocks> blocks_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_SAM_CIGAR_COORDINATES_H_
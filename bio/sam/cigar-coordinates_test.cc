@@ -0,0 +1,182 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/cigar-coordinates.h"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "bio/sam/cigar-parser.h"
+#include "bio/sam/cigar.h"
+#include "bio/sam/packed-cigar.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(SummarizeCigar, Lengths) {
+  const Cigar cigar = ParseCigarOrDie("2H5S10M2I3M1D4=1X100N6M3S4H");
+  const CigarSummary expected = {
+      .reference_length = 10 + 3 + 1 + 4 + 1 + 100 + 6,
+      .query_length = 5 + 10 + 2 + 3 + 4 + 1 + 6 + 3,
+      .aligned_length = 10 + 3 + 4 + 1 + 6,
+      .leading_soft_clip = 5,
+      .trailing_soft_clip = 3,
+      .leading_hard_clip = 2,
+      .trailing_hard_clip = 4,
+  };
+  EXPECT_EQ(SummarizeCigar(cigar), expected);
+  EXPECT_EQ(SummarizeCigar(*PackedCigar::FromCigar(cigar)), expected);
+}
+
+TEST(SummarizeCigar, OnlyClipping) {
+  const CigarSummary summary = SummarizeCigar(ParseCigarOrDie("10S"));
+  EXPECT_EQ(summary.query_length, 10);
+  EXPECT_EQ(summary.reference_length, 0);
+  EXPECT_EQ(summary.leading_soft_clip, 10);
+  EXPECT_EQ(summary.trailing_soft_clip, 0);
+}
+
+TEST(SummarizeCigar, Empty) {
+  EXPECT_EQ(SummarizeCigar(Cigar()), CigarSummary());
+}
+
+TEST(CigarCoordinates, Blocks) {
+  const CigarCoordinates coordinates(
+      ParseCigarOrDie("5S10M2I3M1D4=1X100N6M3S"), 1000);
+  EXPECT_EQ(coordinates.reference_start(), 1000);
+  EXPECT_EQ(coordinates.reference_end(), 1000 + 125);
+  EXPECT_EQ(coordinates.summary().query_length, 34);
+  EXPECT_THAT(
+      coordinates.blocks(),
+      ElementsAre(
+          AlignedBlock{.reference_start = 1000, .query_start = 5, .length = 10},
+          AlignedBlock{.reference_start = 1010, .query_start = 17, .length = 3},
+          AlignedBlock{.reference_start = 1014, .query_start = 20, .length = 5},
+          AlignedBlock{
+              .reference_start = 1119, .query_start = 25, .length = 6}));
+}
+
+TEST(CigarCoordinates, PaddingDoesNotSplitBlocks) {
+  const CigarCoordinates coordinates(ParseCigarOrDie("3M2P3M"), 0);
+  EXPECT_THAT(coordinates.blocks(),
+              ElementsAre(AlignedBlock{
+                  .reference_start = 0, .query_start = 0, .length = 6}));
+}
+
+TEST(CigarCoordinates, MapPositions) {
+  const CigarCoordinates coordinates(ParseCigarOrDie("2S3M1I2M2D2M"), 100);
+  // Reference: 100-102 aligned to query 2-4, 103-104 to 6-7, 105-106
+  // deleted and 107-108 to 8-9.
+  EXPECT_EQ(coordinates.QueryPosition(99), std::nullopt);
+  EXPECT_EQ(coordinates.QueryPosition(100), 2);
+  EXPECT_EQ(coordinates.QueryPosition(102), 4);
+  EXPECT_EQ(coordinates.QueryPosition(103), 6);
+  EXPECT_EQ(coordinates.QueryPosition(105), std::nullopt);
+  EXPECT_EQ(coordinates.QueryPosition(106), std::nullopt);
+  EXPECT_EQ(coordinates.QueryPosition(108), 9);
+  EXPECT_EQ(coordinates.QueryPosition(109), std::nullopt);
+
+  EXPECT_EQ(coordinates.ReferencePosition(0), std::nullopt);
+  EXPECT_EQ(coordinates.ReferencePosition(2), 100);
+  EXPECT_EQ(coordinates.ReferencePosition(5), std::nullopt);
+  EXPECT_EQ(coordinates.ReferencePosition(6), 103);
+  EXPECT_EQ(coordinates.ReferencePosition(8), 107);
+  EXPECT_EQ(coordinates.ReferencePosition(9), 108);
+  EXPECT_EQ(coordinates.ReferencePosition(10), std::nullopt);
+}
+
+TEST(CigarCoordinates, Unmapped) {
+  const CigarCoordinates coordinates(Cigar(), 0);
+  EXPECT_TRUE(coordinates.blocks().empty());
+  EXPECT_EQ(coordinates.reference_end(), 0);
+  EXPECT_EQ(coordinates.QueryPosition(0), std::nullopt);
+  EXPECT_EQ(coordinates.ReferencePosition(0), std::nullopt);
+}
+
+// Checks the position mapping against a walk over every base of random
+// CIGARs.
+TEST(CigarCoordinates, MatchesCigarWalk) {
+  static constexpr char kTypes[] = "MIDNSHP=X";
+  std::mt19937 rng(11);
+  for (int i = 0; i < 2000; ++i) {
+    std::string text;
+    const int num_operations = 1 + rng() % 12;
+    for (int j = 0; j < num_operations; ++j) {
+      absl::StrAppend(&text, rng() % 5, std::string(1, kTypes[rng() % 9]));
+    }
+    const Cigar cigar = ParseCigarOrDie(text);
+    const uint64_t start = rng() % 1000;
+
+    std::vector<std::optional<uint64_t>> query_positions;
+    std::vector<std::optional<uint64_t>> reference_positions;
+    uint64_t reference = start;
+    for (const CigarOperation& operation : cigar.operations) {
+      for (size_t k = 0; k < operation.length; ++k) {
+        switch (operation.type) {
+          case CigarType::kAlignmentMatch:
+          case CigarType::kSequenceMatch:
+          case CigarType::kSequenceMismatch:
+            query_positions.push_back(reference_positions.size());
+            reference_positions.push_back(reference++);
+            break;
+          case CigarType::kInsertion:
+          case CigarType::kSoftClipping:
+            reference_positions.push_back(std::nullopt);
+            break;
+          case CigarType::kDeletion:
+          case CigarType::kSkippedRegion:
+            query_positions.push_back(std::nullopt);
+            ++reference;
+            break;
+          default:
+            break;
+        }
+      }
+    }
+
+    for (const CigarCoordinates& coordinates :
+         {CigarCoordinates(cigar, start),
+          CigarCoordinates(*PackedCigar::FromCigar(cigar), start)}) {
+      ASSERT_EQ(coordinates.reference_end(), reference) << text;
+      ASSERT_EQ(coordinates.summary().query_length,
+                reference_positions.size())
+          << text;
+      for (uint64_t r = 0; r < reference + 5; ++r) {
+        const std::optional<uint64_t> expected =
+            r >= start && r < reference ? query_positions[r - start]
+                                        : std::nullopt;
+        ASSERT_EQ(coordinates.QueryPosition(r), expected)
+            << text << " reference " << r;
+      }
+      for (uint64_t q = 0; q < reference_positions.size() + 5; ++q) {
+        const std::optional<uint64_t> expected =
+            q < reference_positions.size() ? reference_positions[q]
+                                           : std::nullopt;
+        ASSERT_EQ(coordinates.ReferencePosition(q), expected)
+            << text << " query " << q;
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace bio
@@ -14,9 +14,10 @@
 
 #include "bio/sam/cigar-parser.h"
 
-#include <memory>
-#include <optional>
-#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 
 #include "absl/log/check.h"
 #include "absl/status/status.h"
@@ -24,59 +25,87 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "bio/sam/cigar.h"
-#include "bio/sam/internal/cigar-lexer.h"
+#include "bio/sam/packed-cigar.h"
 #include "gxl/status/status_macros.h"
 
 namespace bio {
 namespace {
 
-using ::bio::internal::CigarLengthToken;
-using ::bio::internal::CigarLexer;
-using ::bio::internal::CigarOperationToken;
-using ::bio::internal::CigarToken;
-using ::bio::internal::CigarTokenType;
+constexpr auto MakeCigarTypeTable() -> std::array<CigarType, 256> {
+  constexpr absl::string_view kOperations = "MIDNSHP=X";
+  std::array<CigarType, 256> table = {};
+  for (CigarType& type : table) {
+    type = CigarType::kInvalid;
+  }
+  for (size_t i = 0; i < kOperations.size(); ++i) {
+    table[static_cast<uint8_t>(kOperations[i])] = static_cast<CigarType>(i);
+  }
+  return table;
+}
+
+// The operation type of each character.
+static constexpr std::array<CigarType, 256> kCigarTypes = MakeCigarTypeTable();
+
+// Parses `cigar`, calling `append` with each operation in turn. `append`
+// returns an absl::Status.
+template <typename Append>
+auto ParseOperations(absl::string_view cigar, Append append) -> absl::Status {
+  size_t length = 0;
+  bool has_length = false;
+  for (const char c : cigar) {
+    const uint32_t digit = static_cast<uint8_t>(c) - uint32_t{'0'};
+    if (digit < 10) {
+      if (length > (std::numeric_limits<size_t>::max() - digit) / 10) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Failed to parse CIGAR string: '%s': length overflow", cigar));
+      }
+      length = length * 10 + digit;
+      has_length = true;
+      continue;
+    }
+    const CigarType type = kCigarTypes[static_cast<uint8_t>(c)];
+    if (type == CigarType::kInvalid) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid cigar operation type: %c", c));
+    }
+    if (!has_length) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Failed to parse CIGAR string: '%s': consecutive operations found",
+          cigar));
+    }
+    RETURN_IF_ERROR(append(CigarOperation{.type = type, .length = length}));
+    length = 0;
+    has_length = false;
+  }
+  return absl::OkStatus();
+}
 
 }  // namespace
 
 auto CigarParser::Parse(absl::string_view cigar) -> absl::StatusOr<Cigar> {
-  CigarLexer lexer(cigar);
-  std::vector<CigarOperation> operations;
-  std::optional<CigarOperation> operation;
-  while (true) {
-    ASSIGN_OR_RETURN(std::unique_ptr<CigarToken> token, lexer.Next());
-    if (token == nullptr) {
-      break;
-    }
+  Cigar result;
+  RETURN_IF_ERROR(Parse(cigar, &result));
+  return result;
+}
 
-    if (token->token_type() == CigarTokenType::kOperation) {
-      const CigarOperationToken* op_token =
-          dynamic_cast<CigarOperationToken*>(token.get());
-      CigarType type = op_token->type();
-      if (type == CigarType::kInvalid) {
-        return absl::InvalidArgumentError(
-            absl::StrFormat("Invalid cigar operation type: %s", token->text()));
-      }
-      if (operation == std::nullopt) {
-        return absl::InvalidArgumentError(absl::StrFormat(
-            "Failed to parse CIGAR string: '%s': consecutive operations found",
-            cigar));
-      }
-      operation->type = type;
-      operations.push_back(*operation);
-      operation = std::nullopt;
+auto CigarParser::Parse(absl::string_view cigar, Cigar* out) -> absl::Status {
+  out->operations.clear();
+  return ParseOperations(cigar, [out](const CigarOperation& operation) {
+    out->operations.push_back(operation);
+    return absl::OkStatus();
+  });
+}
 
-    } else if (token->token_type() == CigarTokenType::kLength) {
-      const CigarLengthToken* length_token =
-          dynamic_cast<CigarLengthToken*>(token.get());
-      if (operation.has_value()) {
-        return absl::InternalError(absl::StrFormat(
-            "Failed to parse CIGAR string: '%s': consecutive lengths found",
-            cigar));
-      }
-      operation = {.length = length_token->length()};
+auto CigarParser::Parse(absl::string_view cigar, PackedCigar* out)
+    -> absl::Status {
+  out->clear();
+  return ParseOperations(cigar, [cigar, out](const CigarOperation& operation) {
+    if (absl::Status status = out->Append(operation); !status.ok()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "Failed to parse CIGAR string: '%s': %s", cigar, status.message()));
     }
-  }
-  return Cigar{.operations = operations};
+    return absl::OkStatus();
+  });
 }
 
 auto ParseCigarOrDie(absl::string_view cigar_str) -> Cigar {
@@ -17,13 +17,19 @@
 
 #include <string>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "bio/sam/cigar.h"
+#include "bio/sam/packed-cigar.h"
 
 namespace bio {
 
 // Parser for CIGAR strings.
+//
+// The string is decoded in a single pass, with the operation of each character
+// looked up in a table. A length that is not followed by an operation at the
+// end of the string is ignored.
 class CigarParser {
  public:
   CigarParser() = default;
@@ -31,6 +37,16 @@ class CigarParser {
 
   // Parses the CIGAR string into a vector of operations.
   auto Parse(absl::string_view cigar) -> absl::StatusOr<Cigar>;
+
+  // Parses the CIGAR string into `out`, replacing its operations. The capacity
+  // of `out` is reused, so parsing many strings into the same Cigar does not
+  // allocate once it has grown large enough.
+  auto Parse(absl::string_view cigar, Cigar* out) -> absl::Status;
+
+  // Parses the CIGAR string into `out`, replacing its operations. Returns an
+  // InvalidArgument error if an operation is longer than
+  // PackedCigar::kMaxLength.
+  auto Parse(absl::string_view cigar, PackedCigar* out) -> absl::Status;
 };
 
 // Parses the CIGAR string or kills the program if parsing fails.
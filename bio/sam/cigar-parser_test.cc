@@ -14,12 +14,21 @@
 
 #include "bio/sam/cigar-parser.h"
 
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "bio/sam/cigar.h"
+#include "bio/sam/internal/cigar-lexer.h"
+#include "bio/sam/packed-cigar.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -31,6 +40,45 @@ using ::absl_testing::StatusIs;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 
+// The token-based parser that CigarParser replaced, kept to check that both
+// accept the same strings and report the same errors.
+auto ParseWithLexer(absl::string_view cigar) -> absl::StatusOr<Cigar> {
+  internal::CigarLexer lexer(cigar);
+  std::vector<CigarOperation> operations;
+  std::optional<CigarOperation> operation;
+  while (true) {
+    absl::StatusOr<std::unique_ptr<internal::CigarToken>> token = lexer.Next();
+    if (!token.ok()) {
+      return token.status();
+    }
+    if (*token == nullptr) {
+      break;
+    }
+    if ((*token)->token_type() == internal::CigarTokenType::kOperation) {
+      const CigarType type =
+          static_cast<internal::CigarOperationToken*>(token->get())->type();
+      if (type == CigarType::kInvalid) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Invalid cigar operation type: %s", (*token)->text()));
+      }
+      if (!operation.has_value()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Failed to parse CIGAR string: '%s': consecutive operations found",
+            cigar));
+      }
+      operation->type = type;
+      operations.push_back(*operation);
+      operation = std::nullopt;
+    } else {
+      operation = {
+          .length =
+              static_cast<internal::CigarLengthToken*>(token->get())->length(),
+      };
+    }
+  }
+  return Cigar{.operations = operations};
+}
+
 TEST(CigarParser, ParseEmpty) {
   CigarParser parser;
   absl::StatusOr<Cigar> cigar = parser.Parse("");
@@ -97,5 +145,81 @@ TEST(CigarParser, Parse) {
   }
 }
 
+TEST(CigarParser, ParseIntoReusedCigar) {
+  CigarParser parser;
+  Cigar cigar;
+  ASSERT_THAT(parser.Parse("10M5I10M", &cigar), IsOk());
+  EXPECT_EQ(cigar.string(), "10M5I10M");
+  ASSERT_THAT(parser.Parse("4S6M", &cigar), IsOk());
+  EXPECT_EQ(cigar.string(), "4S6M");
+  EXPECT_THAT(parser.Parse("4S6Q", &cigar),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("Invalid cigar operation type: Q")));
+  ASSERT_THAT(parser.Parse("", &cigar), IsOk());
+  EXPECT_TRUE(cigar.operations.empty());
+}
+
+TEST(CigarParser, ParseIntoPackedCigar) {
+  CigarParser parser;
+  PackedCigar cigar;
+  ASSERT_THAT(parser.Parse("3M20I30D200N3S4H99P10=11X", &cigar), IsOk());
+  EXPECT_EQ(cigar.string(), "3M20I30D200N3S4H99P10=11X");
+  ASSERT_THAT(parser.Parse("4S6M", &cigar), IsOk());
+  EXPECT_EQ(cigar.ToCigar(), ParseCigarOrDie("4S6M"));
+  EXPECT_THAT(parser.Parse("MM", &cigar),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("consecutive operations found")));
+  EXPECT_THAT(parser.Parse("268435456M", &cigar),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("exceeds the maximum")));
+}
+
+TEST(CigarParser, ParseTrailingLength) {
+  CigarParser parser;
+  absl::StatusOr<Cigar> cigar = parser.Parse("3M25");
+  ASSERT_THAT(cigar, IsOk());
+  EXPECT_EQ(cigar->string(), "3M");
+}
+
+TEST(CigarParser, ParseLengthOverflow) {
+  CigarParser parser;
+  EXPECT_THAT(parser.Parse("99999999999999999999999M"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("length overflow")));
+}
+
+TEST(CigarParser, MatchesLexer) {
+  static constexpr absl::string_view kAlphabet = "0123456789MIDNSHP=X*m";
+  std::mt19937 rng(7);
+  CigarParser parser;
+  for (int i = 0; i < 20000; ++i) {
+    // Mostly well-formed strings, with the occasional stray character.
+    std::string cigar;
+    const int num_operations = rng() % 6;
+    for (int j = 0; j < num_operations; ++j) {
+      cigar += std::to_string(rng() % 1000);
+      cigar += kAlphabet[10 + rng() % 9];
+    }
+    if (i % 2 == 0) {
+      const int num_stray = 1 + rng() % 3;
+      for (int j = 0; j < num_stray; ++j) {
+        cigar.insert(rng() % (cigar.size() + 1), 1,
+                     kAlphabet[rng() % kAlphabet.size()]);
+      }
+    }
+    // The lexer reads past the end of a single digit.
+    if (cigar.size() == 1 && absl::ascii_isdigit(cigar[0])) {
+      continue;
+    }
+
+    const absl::StatusOr<Cigar> expected = ParseWithLexer(cigar);
+    const absl::StatusOr<Cigar> actual = parser.Parse(cigar);
+    ASSERT_EQ(actual.status(), expected.status()) << cigar;
+    if (expected.ok()) {
+      EXPECT_EQ(*actual, *expected) << cigar;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace bio
@@ -0,0 +1,92 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/packed-cigar.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "bio/sam/cigar.h"
+#include "gxl/status/status_macros.h"
+
+namespace bio {
+namespace {
+
+// The number of valid operation types, which are packed as 0 (M) to 8 (X).
+static constexpr uint32_t kNumCigarTypes =
+    static_cast<uint32_t>(CigarType::kInvalid);
+
+}  // namespace
+
+auto PackedCigar::FromCigar(const Cigar& cigar)
+    -> absl::StatusOr<PackedCigar> {
+  PackedCigar packed;
+  packed.operations_.reserve(cigar.operations.size());
+  for (const CigarOperation& operation : cigar.operations) {
+    RETURN_IF_ERROR(packed.Append(operation));
+  }
+  return packed;
+}
+
+auto PackedCigar::FromPacked(absl::Span<const uint32_t> packed)
+    -> absl::StatusOr<PackedCigar> {
+  for (const uint32_t operation : packed) {
+    if ((operation & 0xf) >= kNumCigarTypes) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid packed CIGAR operation type %d",
+                          operation & 0xf));
+    }
+  }
+  PackedCigar cigar;
+  cigar.operations_.assign(packed.begin(), packed.end());
+  return cigar;
+}
+
+auto PackedCigar::ToCigar() const -> Cigar {
+  Cigar cigar;
+  cigar.operations.reserve(size());
+  for (const CigarOperation operation : *this) {
+    cigar.operations.push_back(operation);
+  }
+  return cigar;
+}
+
+auto PackedCigar::Append(const CigarOperation& operation) -> absl::Status {
+  if (operation.type == CigarType::kInvalid) {
+    return absl::InvalidArgumentError("Invalid CIGAR operation type");
+  }
+  if (operation.length > kMaxLength) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "CIGAR operation length %d exceeds the maximum of %d",
+        operation.length, kMaxLength));
+  }
+  operations_.push_back(static_cast<uint32_t>(operation.length) << 4 |
+                        static_cast<uint32_t>(operation.type));
+  return absl::OkStatus();
+}
+
+auto PackedCigar::string() const -> std::string {
+  std::string output;
+  for (const CigarOperation operation : *this) {
+    absl::StrAppend(&output, operation.string());
+  }
+  return output;
+}
+
+}  // namespace bio
@@ -0,0 +1,161 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIO_SAM_PACKED_CIGAR_H_
+#define BIO_SAM_PACKED_CIGAR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "bio/sam/cigar.h"
+
+namespace bio {
+
+// A CIGAR stored as packed operations, as in BAM: each operation is a
+// uint32_t holding the length in its upper 28 bits and the CigarType in its
+// lower 4 bits. Up to kInlineOperations operations are stored inline, so most
+// CIGARs need no heap allocation.
+//
+// Iteration yields CigarOperation values, and equality and string() behave as
+// for Cigar.
+//
+// Example usage:
+//
+// ```
+// PackedCigar cigar;
+// RETURN_IF_ERROR(CigarParser().Parse("5S6M", &cigar));
+// for (const CigarOperation operation : cigar) {
+//   // Do stuff with operation.
+// }
+// ```
+class PackedCigar {
+ public:
+  // The number of operations stored without a heap allocation.
+  static constexpr size_t kInlineOperations = 6;
+
+  // The maximum length of an operation.
+  static constexpr size_t kMaxLength = (size_t{1} << 28) - 1;
+
+  // Iterator over the operations, which are unpacked as they are read.
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = CigarOperation;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = CigarOperation;
+
+    const_iterator() = default;
+
+    auto operator*() const -> CigarOperation { return Unpack(*operation_); }
+
+    auto operator++() -> const_iterator& {
+      ++operation_;
+      return *this;
+    }
+
+    auto operator++(int) -> const_iterator {
+      const_iterator previous = *this;
+      ++operation_;
+      return previous;
+    }
+
+    auto operator==(const const_iterator& rhs) const -> bool {
+      return operation_ == rhs.operation_;
+    }
+
+   private:
+    friend class PackedCigar;
+
+    explicit const_iterator(const uint32_t* operation)
+        : operation_(operation) {}
+
+    const uint32_t* operation_ = nullptr;
+  };
+
+  using value_type = CigarOperation;
+  using iterator = const_iterator;
+
+  PackedCigar() = default;
+
+  // Packs `cigar`. Returns an InvalidArgument error if an operation is invalid
+  // or longer than kMaxLength.
+  static auto FromCigar(const Cigar& cigar) -> absl::StatusOr<PackedCigar>;
+
+  // Copies operations packed as in a BAM record. Returns an InvalidArgument
+  // error if an operation type is invalid.
+  static auto FromPacked(absl::Span<const uint32_t> packed)
+      -> absl::StatusOr<PackedCigar>;
+
+  // Returns the operations as a Cigar.
+  auto ToCigar() const -> Cigar;
+
+  // Appends `operation`. Returns an InvalidArgument error if it is invalid or
+  // longer than kMaxLength.
+  auto Append(const CigarOperation& operation) -> absl::Status;
+
+  // Removes all operations, keeping any allocated storage.
+  auto clear() -> void { operations_.clear(); }
+
+  // Returns the number of operations.
+  auto size() const -> size_t { return operations_.size(); }
+
+  // Returns whether there are no operations.
+  auto empty() const -> bool { return operations_.empty(); }
+
+  // Returns operation `i`.
+  auto operator[](size_t i) const -> CigarOperation {
+    return Unpack(operations_[i]);
+  }
+
+  auto begin() const -> const_iterator {
+    return const_iterator(operations_.data());
+  }
+
+  auto end() const -> const_iterator {
+    return const_iterator(operations_.data() + operations_.size());
+  }
+
+  // Returns the packed operations.
+  auto packed() const -> absl::Span<const uint32_t> { return operations_; }
+
+  // Checks for equality.
+  auto operator==(const PackedCigar& rhs) const -> bool {
+    return operations_ == rhs.operations_;
+  }
+
+  // Serializes the PackedCigar into a string.
+  auto string() const -> std::string;
+
+ private:
+  static auto Unpack(uint32_t operation) -> CigarOperation {
+    return {
+        .type = static_cast<CigarType>(operation & 0xf),
+        .length = operation >> 4,
+    };
+  }
+
+  absl::InlinedVector<uint32_t, kInlineOperations> operations_;
+};
+
+}  // namespace bio
+
+#endif  // BIO_SAM_PACKED_CIGAR_H_
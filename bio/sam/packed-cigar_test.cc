@@ -0,0 +1,139 @@
+// Copyright 2017 The Bio Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bio/sam/packed-cigar.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "bio/sam/cigar-parser.h"
+#include "bio/sam/cigar.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace bio {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(PackedCigar, FromCigar) {
+  const Cigar cigar = ParseCigarOrDie("3M20I30D200N3S4H99P10=11X");
+  absl::StatusOr<PackedCigar> packed = PackedCigar::FromCigar(cigar);
+  ASSERT_THAT(packed, IsOk());
+  EXPECT_EQ(packed->size(), 9);
+  EXPECT_FALSE(packed->empty());
+  EXPECT_EQ(packed->string(), cigar.string());
+  EXPECT_EQ(packed->ToCigar(), cigar);
+  EXPECT_EQ((*packed)[3], (CigarOperation{.type = CigarType::kSkippedRegion,
+                                          .length = 200}));
+  EXPECT_THAT(packed->packed(),
+              ElementsAre(3 << 4 | 0, 20 << 4 | 1, 30 << 4 | 2, 200 << 4 | 3,
+                          3 << 4 | 4, 4 << 4 | 5, 99 << 4 | 6, 10 << 4 | 7,
+                          11 << 4 | 8));
+}
+
+TEST(PackedCigar, Iteration) {
+  const PackedCigar packed = *PackedCigar::FromCigar(ParseCigarOrDie("5S6M"));
+  std::vector<CigarOperation> operations;
+  for (const CigarOperation operation : packed) {
+    operations.push_back(operation);
+  }
+  EXPECT_EQ(operations, ParseCigarOrDie("5S6M").operations);
+  EXPECT_THAT(
+      packed,
+      ElementsAre(
+          CigarOperation{.type = CigarType::kSoftClipping, .length = 5},
+          CigarOperation{.type = CigarType::kAlignmentMatch, .length = 6}));
+}
+
+TEST(PackedCigar, Empty) {
+  const PackedCigar packed;
+  EXPECT_TRUE(packed.empty());
+  EXPECT_EQ(packed.begin(), packed.end());
+  EXPECT_EQ(packed.string(), "");
+  EXPECT_EQ(packed, *PackedCigar::FromCigar(Cigar()));
+}
+
+TEST(PackedCigar, Equality) {
+  const PackedCigar a = *PackedCigar::FromCigar(ParseCigarOrDie("5S6M"));
+  const PackedCigar b = *PackedCigar::FromCigar(ParseCigarOrDie("5S6M"));
+  const PackedCigar c = *PackedCigar::FromCigar(ParseCigarOrDie("5S7M"));
+  const PackedCigar d = *PackedCigar::FromCigar(ParseCigarOrDie("5S6M1I"));
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  EXPECT_NE(a, d);
+}
+
+TEST(PackedCigar, SmallCigarsAreInline) {
+  PackedCigar packed;
+  const CigarOperation operation = {.type = CigarType::kAlignmentMatch,
+                                    .length = 1};
+  for (size_t i = 0; i < PackedCigar::kInlineOperations; ++i) {
+    ASSERT_THAT(packed.Append(operation), IsOk());
+  }
+  const auto* data = reinterpret_cast<const char*>(packed.packed().data());
+  const auto* object = reinterpret_cast<const char*>(&packed);
+  EXPECT_GE(data, object);
+  EXPECT_LT(data, object + sizeof(packed));
+}
+
+TEST(PackedCigar, LongCigar) {
+  Cigar cigar;
+  for (int i = 0; i < 100; ++i) {
+    cigar.operations.push_back(
+        {.type = i % 2 == 0 ? CigarType::kAlignmentMatch
+                            : CigarType::kDeletion,
+         .length = static_cast<size_t>(i + 1)});
+  }
+  const PackedCigar packed = *PackedCigar::FromCigar(cigar);
+  EXPECT_EQ(packed.ToCigar(), cigar);
+  EXPECT_EQ(packed.string(), cigar.string());
+}
+
+TEST(PackedCigar, InvalidOperations) {
+  Cigar cigar;
+  cigar.operations.push_back(
+      {.type = CigarType::kAlignmentMatch, .length = PackedCigar::kMaxLength});
+  ASSERT_THAT(PackedCigar::FromCigar(cigar), IsOk());
+
+  cigar.operations.push_back({.type = CigarType::kAlignmentMatch,
+                              .length = PackedCigar::kMaxLength + 1});
+  EXPECT_THAT(PackedCigar::FromCigar(cigar),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("exceeds the maximum")));
+
+  cigar.operations = {{.type = CigarType::kInvalid, .length = 1}};
+  EXPECT_THAT(PackedCigar::FromCigar(cigar),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PackedCigar, FromPacked) {
+  const std::vector<uint32_t> ops = {5 << 4 | 4, 6 << 4 | 0};
+  absl::StatusOr<PackedCigar> packed = PackedCigar::FromPacked(ops);
+  ASSERT_THAT(packed, IsOk());
+  EXPECT_EQ(packed->string(), "5S6M");
+
+  const std::vector<uint32_t> invalid = {5 << 4 | 9};
+  EXPECT_THAT(PackedCigar::FromPacked(invalid),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace bio
@@ -28,6 +28,7 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "bio/common/sampler.h"
 #include "bio/sam/cigar-parser.h"
 #include "bio/sam/sam.h"
 #include "gxl/file/file.h"
@@ -58,8 +59,32 @@ auto SamParser::Next() -> absl::StatusOr<std::unique_ptr<SamEntry>> {
   if (eof()) {
     return nullptr;
   }
+  std::optional<std::string> line = NextAlignmentLine();
+  if (!line.has_value()) {
+    return nullptr;
+  }
+  return ParseLine(*line);
+}
 
-  auto entry = std::make_unique<SamEntry>();
+auto SamParser::NextSampled(const FractionalSampler& sampler)
+    -> absl::StatusOr<std::unique_ptr<SamEntry>> {
+  for (std::optional<std::string> line = NextAlignmentLine();
+       line.has_value(); line = NextAlignmentLine()) {
+    const absl::string_view qname =
+        absl::string_view(*line).substr(0, line->find('\t'));
+    if (sampler.Keep(qname)) {
+      return ParseLine(*line);
+    }
+  }
+  return nullptr;
+}
+
+auto SamParser::Skip() -> absl::Status {
+  NextAlignmentLine();
+  return absl::OkStatus();
+}
+
+auto SamParser::NextAlignmentLine() -> std::optional<std::string> {
   for (std::optional<std::string> line = NextLine(); line.has_value();
        line = NextLine()) {
     if (line->empty()) {
@@ -68,39 +93,44 @@ auto SamParser::Next() -> absl::StatusOr<std::unique_ptr<SamEntry>> {
     if (absl::StartsWith(*line, kHeaderLinePrefix)) {
       continue;
     }
+    return line;
+  }
+  return std::nullopt;
+}
 
-    const std::vector<std::string> fields = absl::StrSplit(*line, "\t");
-    if (fields.size() < kMinSamFields) {
-      return absl::InvalidArgumentError(absl::StrFormat(
-          "Line %d: Invalid number of fields: '%s'", line_number(), *line));
-    }
-    entry->qname = fields[0];
-    ASSIGN_OR_RETURN(entry->flags, ParseInt<uint64_t>(fields[1], "flags"));
-    entry->rname = fields[2];
-    ASSIGN_OR_RETURN(entry->pos, ParseInt<uint32_t>(fields[3], "pos"));
-    ASSIGN_OR_RETURN(entry->mapq, ParseUInt8(fields[4], "mapq"));
-
-    CigarParser cigar_parser;
-    ASSIGN_OR_RETURN(entry->cigar, cigar_parser.Parse(fields[5]));
-    entry->rnext = fields[6];
-    ASSIGN_OR_RETURN(entry->pnext, ParseInt<uint32_t>(fields[7], "pnext"));
-    ASSIGN_OR_RETURN(entry->tlen, ParseInt<int32_t>(fields[8], "tlen"));
-
-    if (fields[9] != "*") {
-      entry->seq = fields[9];
-    }
-    if (fields[10] != "*") {
-      entry->qual = fields[10];
-    }
+auto SamParser::ParseLine(absl::string_view line)
+    -> absl::StatusOr<std::unique_ptr<SamEntry>> {
+  auto entry = std::make_unique<SamEntry>();
+  const std::vector<std::string> fields = absl::StrSplit(line, "\t");
+  if (fields.size() < kMinSamFields) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Line %d: Invalid number of fields: '%s'", line_number(), line));
+  }
+  entry->qname = fields[0];
+  ASSIGN_OR_RETURN(entry->flags, ParseInt<uint64_t>(fields[1], "flags"));
+  entry->rname = fields[2];
+  ASSIGN_OR_RETURN(entry->pos, ParseInt<uint32_t>(fields[3], "pos"));
+  ASSIGN_OR_RETURN(entry->mapq, ParseUInt8(fields[4], "mapq"));
 
-    if (fields.size() > kMinSamFields) {
-      for (int i = kMinSamFields; i < fields.size(); ++i) {
-        entry->tags.push_back(fields[i]);
-      }
+  CigarParser cigar_parser;
+  RETURN_IF_ERROR(cigar_parser.Parse(fields[5], &entry->cigar));
+  entry->rnext = fields[6];
+  ASSIGN_OR_RETURN(entry->pnext, ParseInt<uint32_t>(fields[7], "pnext"));
+  ASSIGN_OR_RETURN(entry->tlen, ParseInt<int32_t>(fields[8], "tlen"));
+
+  if (fields[9] != "*") {
+    entry->seq = fields[9];
+  }
+  if (fields[10] != "*") {
+    entry->qual = fields[10];
+  }
+
+  if (fields.size() > kMinSamFields) {
+    for (int i = kMinSamFields; i < fields.size(); ++i) {
+      entry->tags.push_back(fields[i]);
     }
-    return entry;
   }
-  return nullptr;
+  return entry;
 }
 
 }  // namespace bio
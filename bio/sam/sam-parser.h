@@ -17,12 +17,16 @@
 
 #include <cstdlib>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "bio/common/line-parser-base.h"
+#include "bio/common/sampler.h"
 #include "bio/sam/sam.h"
 #include "gxl/file/file.h"
 
@@ -77,6 +81,25 @@ class SamParser : public LineParserBase {
 
   // Returns the next SAM entry from the file.
   auto Next() -> absl::StatusOr<std::unique_ptr<SamEntry>>;
+
+  // Returns the next SAM entry whose QNAME `sampler` keeps, or nullptr at the
+  // end of the file. All alignments of a read are kept or dropped together.
+  // Rejected lines are not split into fields or parsed.
+  auto NextSampled(const FractionalSampler& sampler)
+      -> absl::StatusOr<std::unique_ptr<SamEntry>>;
+
+  // Skips the next SAM entry without parsing it. Always returns OK; the
+  // status matches FastqParser::Skip(), which can fail on a truncated entry.
+  auto Skip() -> absl::Status;
+
+ private:
+  // Returns the next alignment line, skipping header and empty lines, or
+  // std::nullopt at the end of the file.
+  auto NextAlignmentLine() -> std::optional<std::string>;
+
+  // Parses an alignment line.
+  auto ParseLine(absl::string_view line)
+      -> absl::StatusOr<std::unique_ptr<SamEntry>>;
 };
 
 }  // namespace bio
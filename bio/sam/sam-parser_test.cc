@@ -14,11 +14,13 @@
 
 #include "bio/sam/sam-parser.h"
 
+#include <cstdint>
 #include <memory>
 
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "bio/common/sampler.h"
 #include "bio/sam/cigar-parser.h"
 #include "bio/sam/sam.h"
 #include "gmock/gmock.h"
@@ -203,5 +205,59 @@ TEST(SamParser, NextMultipleEntries) {
   }
 }
 
+TEST(SamParser, NextSampled) {
+  for (double fraction : {0.0, 1.0}) {
+    std::unique_ptr<SamParser> parser =
+        SamParser::NewOrDie("bio/sam/testdata/multiple-entries.sam");
+    const FractionalSampler sampler = *FractionalSampler::New(fraction);
+    int num_entries = 0;
+    while (true) {
+      absl::StatusOr<std::unique_ptr<SamEntry>> entry =
+          parser->NextSampled(sampler);
+      ASSERT_THAT(entry, IsOk());
+      if (*entry == nullptr) {
+        break;
+      }
+      EXPECT_EQ((*entry)->qname, "r003");
+      ++num_entries;
+    }
+    EXPECT_EQ(num_entries, fraction == 0.0 ? 0 : 2);
+  }
+}
+
+TEST(SamParser, NextSampledKeepsAlignmentsTogether) {
+  // Both entries share a QNAME, so every seed keeps both or neither.
+  for (uint64_t seed = 0; seed < 16; ++seed) {
+    std::unique_ptr<SamParser> parser =
+        SamParser::NewOrDie("bio/sam/testdata/multiple-entries.sam");
+    const FractionalSampler sampler = *FractionalSampler::New(0.5, seed);
+    int num_entries = 0;
+    while (true) {
+      absl::StatusOr<std::unique_ptr<SamEntry>> entry =
+          parser->NextSampled(sampler);
+      ASSERT_THAT(entry, IsOk());
+      if (*entry == nullptr) {
+        break;
+      }
+      ++num_entries;
+    }
+    EXPECT_EQ(num_entries, sampler.Keep("r003") ? 2 : 0) << seed;
+  }
+}
+
+TEST(SamParser, Skip) {
+  std::unique_ptr<SamParser> parser =
+      SamParser::NewOrDie("bio/sam/testdata/multiple-entries.sam");
+  ASSERT_THAT(parser->Skip(), IsOk());
+  absl::StatusOr<std::unique_ptr<SamEntry>> entry = parser->Next();
+  ASSERT_THAT(entry, IsOk());
+  ASSERT_NE(*entry, nullptr);
+  EXPECT_EQ((*entry)->flags, 2064);
+  ASSERT_THAT(parser->Skip(), IsOk());
+  entry = parser->Next();
+  ASSERT_THAT(entry, IsOk());
+  EXPECT_EQ(*entry, nullptr);
+}
+
 }  // namespace
 }  // namespace bio
@@ -43,6 +43,26 @@ namespace bio {
 #define SAM_DUPLICATE 0x0400       // Read is PCR or optical duplicate
 #define SAM_SUPPLEMENTARY 0x800    // Supplementary alignment
 
+// A reference sequence listed in the header of a SAM or BAM file.
+struct SamReference {
+  std::string name;  // Reference sequence name
+  uint32_t length;   // Reference sequence length
+
+  // Checks for equality.
+  auto operator==(const SamReference& rhs) const -> bool {
+    return name == rhs.name && length == rhs.length;
+  }
+};
+
+// Represents the header of a SAM or BAM file.
+struct SamHeader {
+  // The header lines, each starting with '@' and ending with a newline.
+  std::string text;
+
+  // The reference sequences, in the order in which BAM records refer to them.
+  std::vector<SamReference> references;
+};
+
 // Represents a SAM entry.
 struct SamEntry {
   std::string qname;  // Query name